@@ -0,0 +1,2090 @@
+/*
+ * This file was generated automatically by ExtUtils::ParseXS version 3.45 from the
+ * contents of Digest.xs. Do not edit this file, edit Digest.xs instead.
+ *
+ *    ANY CHANGES MADE HERE WILL BE LOST!
+ *
+ */
+
+#line 1 "Digest.xs"
+/*
+**	Perl Extension for the
+**
+**	RSA Data Security Inc. MD4 Message-Digest Algorithm
+**
+**	This module originally by Neil Winton (N.Winton@axion.bt.co.uk)
+**      Adapted by Mike McCauley mikem@open.com.au
+**	$Id: MD4.xs,v 1.3 2001/07/30 23:39:57 mikem Exp $	
+**
+**	This extension may be distributed under the same terms
+**	as Perl. The MD4 code is covered by separate copyright and
+**	licence, but this does not prohibit distribution under the
+**	GNU or Artistic licences. See the file md4c.c or MD4.pm
+**	for more details.
+*/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include "EXTERN.h"
+#include "perl.h"
+#include "XSUB.h"
+
+#include "global.h"
+#include "md4.h"
+#include "rsync_lib.h"
+#include "delta.h"
+
+typedef RsyncMD4_CTX	*File__RsyncP__Digest;
+typedef rsync_delta	*File__RsyncP__Digest__Delta;
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ * The block digest functions write their output directly into an
+ * SV.  If the caller supplied outV the output is appended to it,
+ * otherwise a new SV is returned in *retV.  Returns a pointer to room
+ * for size bytes; digest_out_done() then sets the length.
+ */
+static unsigned char *digest_out_start(SV *outV, SV *dataV, STRLEN size,
+                                       SV **retV)
+{
+    if ( outV ) {
+        STRLEN cur, need;
+
+        if ( outV == dataV )
+            croak("File::RsyncP::Digest: output can't be the input data");
+        if ( !SvOK(outV) )
+            sv_setpvn(outV, "", 0);
+        SvPV_force_nolen(outV);
+        sv_utf8_downgrade(outV, 0);
+        cur  = SvCUR(outV);
+        need = cur + size + 1;
+        if ( need > SvLEN(outV) ) {
+            /*
+             * Grow geometrically, since the caller is likely to keep
+             * appending to the same buffer.
+             */
+            if ( need < 2 * SvLEN(outV) )
+                need = 2 * SvLEN(outV);
+            SvGROW(outV, need);
+        }
+        return (unsigned char *)SvPVX(outV) + cur;
+    }
+    *retV = newSV(size + 1);
+    SvPOK_on(*retV);
+    return (unsigned char *)SvPVX(*retV);
+}
+
+/*
+ * Finish the output started with digest_out_start().  Returns the new
+ * SV, or the number of bytes appended to outV.
+ */
+static SV *digest_out_done(SV *outV, SV *retV, STRLEN size)
+{
+    if ( outV ) {
+        SvCUR_set(outV, SvCUR(outV) + size);
+        *SvEND(outV) = '\0';
+        SvSETMAGIC(outV);
+        return sv_2mortal(newSVuv(size));
+    }
+    SvCUR_set(retV, size);
+    *SvEND(retV) = '\0';
+    return sv_2mortal(retV);
+}
+
+/*
+ * An explicit undef for the optional output SV is the same as
+ * not passing one.
+ */
+#define DIGEST_OUT_ARG(sv)	((sv) && (SvOK(sv) || !SvREADONLY(sv)) \
+					? (sv) : NULL)
+
+/*
+ * Return the context of an optional File::RsyncP::Digest argument,
+ * or NULL if it is undef.
+ */
+static RsyncMD4_CTX *digest_ctx_arg(SV *sv, char *func)
+{
+    if ( !sv || !SvOK(sv) )
+	return NULL;
+    if ( !sv_derived_from(sv, "File::RsyncP::Digest") )
+	croak("%s: argument is not of type File::RsyncP::Digest", func);
+    return INT2PTR(RsyncMD4_CTX *, SvIV((SV *)SvRV(sv)));
+}
+
+
+#line 120 "Digest.c"
+#ifndef PERL_UNUSED_VAR
+#  define PERL_UNUSED_VAR(var) if (0) var = var
+#endif
+
+#ifndef dVAR
+#  define dVAR		dNOOP
+#endif
+
+
+/* This stuff is not part of the API! You have been warned. */
+#ifndef PERL_VERSION_DECIMAL
+#  define PERL_VERSION_DECIMAL(r,v,s) (r*1000000 + v*1000 + s)
+#endif
+#ifndef PERL_DECIMAL_VERSION
+#  define PERL_DECIMAL_VERSION \
+	  PERL_VERSION_DECIMAL(PERL_REVISION,PERL_VERSION,PERL_SUBVERSION)
+#endif
+#ifndef PERL_VERSION_GE
+#  define PERL_VERSION_GE(r,v,s) \
+	  (PERL_DECIMAL_VERSION >= PERL_VERSION_DECIMAL(r,v,s))
+#endif
+#ifndef PERL_VERSION_LE
+#  define PERL_VERSION_LE(r,v,s) \
+	  (PERL_DECIMAL_VERSION <= PERL_VERSION_DECIMAL(r,v,s))
+#endif
+
+/* XS_INTERNAL is the explicit static-linkage variant of the default
+ * XS macro.
+ *
+ * XS_EXTERNAL is the same as XS_INTERNAL except it does not include
+ * "STATIC", ie. it exports XSUB symbols. You probably don't want that
+ * for anything but the BOOT XSUB.
+ *
+ * See XSUB.h in core!
+ */
+
+
+/* TODO: This might be compatible further back than 5.10.0. */
+#if PERL_VERSION_GE(5, 10, 0) && PERL_VERSION_LE(5, 15, 1)
+#  undef XS_EXTERNAL
+#  undef XS_INTERNAL
+#  if defined(__CYGWIN__) && defined(USE_DYNAMIC_LOADING)
+#    define XS_EXTERNAL(name) __declspec(dllexport) XSPROTO(name)
+#    define XS_INTERNAL(name) STATIC XSPROTO(name)
+#  endif
+#  if defined(__SYMBIAN32__)
+#    define XS_EXTERNAL(name) EXPORT_C XSPROTO(name)
+#    define XS_INTERNAL(name) EXPORT_C STATIC XSPROTO(name)
+#  endif
+#  ifndef XS_EXTERNAL
+#    if defined(HASATTRIBUTE_UNUSED) && !defined(__cplusplus)
+#      define XS_EXTERNAL(name) void name(pTHX_ CV* cv __attribute__unused__)
+#      define XS_INTERNAL(name) STATIC void name(pTHX_ CV* cv __attribute__unused__)
+#    else
+#      ifdef __cplusplus
+#        define XS_EXTERNAL(name) extern "C" XSPROTO(name)
+#        define XS_INTERNAL(name) static XSPROTO(name)
+#      else
+#        define XS_EXTERNAL(name) XSPROTO(name)
+#        define XS_INTERNAL(name) STATIC XSPROTO(name)
+#      endif
+#    endif
+#  endif
+#endif
+
+/* perl >= 5.10.0 && perl <= 5.15.1 */
+
+
+/* The XS_EXTERNAL macro is used for functions that must not be static
+ * like the boot XSUB of a module. If perl didn't have an XS_EXTERNAL
+ * macro defined, the best we can do is assume XS is the same.
+ * Dito for XS_INTERNAL.
+ */
+#ifndef XS_EXTERNAL
+#  define XS_EXTERNAL(name) XS(name)
+#endif
+#ifndef XS_INTERNAL
+#  define XS_INTERNAL(name) XS(name)
+#endif
+
+/* Now, finally, after all this mess, we want an ExtUtils::ParseXS
+ * internal macro that we're free to redefine for varying linkage due
+ * to the EXPORT_XSUB_SYMBOLS XS keyword. This is internal, use
+ * XS_EXTERNAL(name) or XS_INTERNAL(name) in your code if you need to!
+ */
+
+#undef XS_EUPXS
+#if defined(PERL_EUPXS_ALWAYS_EXPORT)
+#  define XS_EUPXS(name) XS_EXTERNAL(name)
+#else
+   /* default to internal */
+#  define XS_EUPXS(name) XS_INTERNAL(name)
+#endif
+
+#ifndef PERL_ARGS_ASSERT_CROAK_XS_USAGE
+#define PERL_ARGS_ASSERT_CROAK_XS_USAGE assert(cv); assert(params)
+
+/* prototype to pass -Wmissing-prototypes */
+STATIC void
+S_croak_xs_usage(const CV *const cv, const char *const params);
+
+STATIC void
+S_croak_xs_usage(const CV *const cv, const char *const params)
+{
+    const GV *const gv = CvGV(cv);
+
+    PERL_ARGS_ASSERT_CROAK_XS_USAGE;
+
+    if (gv) {
+        const char *const gvname = GvNAME(gv);
+        const HV *const stash = GvSTASH(gv);
+        const char *const hvname = stash ? HvNAME(stash) : NULL;
+
+        if (hvname)
+	    Perl_croak_nocontext("Usage: %s::%s(%s)", hvname, gvname, params);
+        else
+	    Perl_croak_nocontext("Usage: %s(%s)", gvname, params);
+    } else {
+        /* Pants. I don't think that it should be possible to get here. */
+	Perl_croak_nocontext("Usage: CODE(0x%" UVxf ")(%s)", PTR2UV(cv), params);
+    }
+}
+#undef  PERL_ARGS_ASSERT_CROAK_XS_USAGE
+
+#define croak_xs_usage        S_croak_xs_usage
+
+#endif
+
+/* NOTE: the prototype of newXSproto() is different in versions of perls,
+ * so we define a portable version of newXSproto()
+ */
+#ifdef newXS_flags
+#define newXSproto_portable(name, c_impl, file, proto) newXS_flags(name, c_impl, file, proto, 0)
+#else
+#define newXSproto_portable(name, c_impl, file, proto) (PL_Sv=(SV*)newXS(name, c_impl, file), sv_setpv(PL_Sv, proto), (CV*)PL_Sv)
+#endif /* !defined(newXS_flags) */
+
+#if PERL_VERSION_LE(5, 21, 5)
+#  define newXS_deffile(a,b) Perl_newXS(aTHX_ a,b,file)
+#else
+#  define newXS_deffile(a,b) Perl_newXS_deffile(aTHX_ a,b)
+#endif
+
+#line 264 "Digest.c"
+
+XS_EUPXS(XS_File__RsyncP__Digest_new); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_new)
+{
+    dVAR; dXSARGS;
+    if (items < 0 || items > 2)
+       croak_xs_usage(cv,  "packname = \"File::RsyncP::Digest\", protocol=26");
+    {
+	char *	packname;
+	int	protocol;
+	File__RsyncP__Digest	RETVAL;
+
+	if (items < 1)
+	    packname = "File::RsyncP::Digest";
+	else {
+	    packname = (char *)SvPV_nolen(ST(0))
+;
+	}
+
+	if (items < 2)
+	    protocol = 26;
+	else {
+	    protocol = (int)SvIV(ST(1))
+;
+	}
+#line 119 "Digest.xs"
+	{
+	    RETVAL = (RsyncMD4_CTX *)safemalloc(sizeof(RsyncMD4_CTX));
+	    RsyncMD4Init(RETVAL);
+	    if ( protocol <= 26 ) {
+		RETVAL->rsyncMD4Bug = 1;
+	    } else {
+		RETVAL->rsyncMD4Bug = 0;
+	    }
+	}
+#line 300 "Digest.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = sv_newmortal();
+	    sv_setref_pv(RETVALSV, "File::RsyncP::Digest", (void*)RETVAL);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_DESTROY); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_DESTROY)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "context");
+    {
+	File__RsyncP__Digest	context;
+
+	if (SvROK(ST(0))) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else
+	    Perl_croak_nocontext("%s: %s is not a reference",
+			"File::RsyncP::Digest::DESTROY",
+			"context")
+;
+#line 135 "Digest.xs"
+	{
+	    safefree((char *)context);
+	}
+#line 334 "Digest.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_reset); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_reset)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "context");
+    {
+	File__RsyncP__Digest	context;
+	File__RsyncP__Digest	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::reset",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+#line 144 "Digest.xs"
+	{
+	    RsyncMD4Init(context);
+	    RETVAL = context;
+	}
+#line 368 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_protocol); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_protocol)
+{
+    dVAR; dXSARGS;
+    if (items < 1 || items > 2)
+       croak_xs_usage(cv,  "context, protocol=26");
+    {
+	File__RsyncP__Digest	context;
+	unsigned int	protocol;
+	File__RsyncP__Digest	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::protocol",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 2)
+	    protocol = 26;
+	else {
+	    protocol = (unsigned int)SvUV(ST(1))
+;
+	}
+#line 155 "Digest.xs"
+	{
+	    if ( protocol <= 26 ) {
+		context->rsyncMD4Bug = 1;
+	    } else {
+		context->rsyncMD4Bug = 0;
+	    }
+	    RETVAL = context;
+	}
+#line 414 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_add); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_add)
+{
+    dVAR; dXSARGS;
+    if (items < 1)
+       croak_xs_usage(cv,  "context, ...");
+    {
+	File__RsyncP__Digest	context;
+	File__RsyncP__Digest	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::add",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+#line 168 "Digest.xs"
+	{
+	    STRLEN len;
+	    unsigned char *data;
+	    int i;
+
+	    for (i = 1; i < items; i++)
+	    {
+		data = (unsigned char *)(SvPV(ST(i), len));
+		RsyncMD4Update(context, data, len);
+	    }
+	    RETVAL = context;
+	}
+#line 456 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_digest); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_digest)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "context");
+    {
+	File__RsyncP__Digest	context;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::digest",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+#line 185 "Digest.xs"
+	{
+	    unsigned char digeststr[16];
+
+	    RsyncMD4FinalRsync(digeststr, context);
+	    ST(0) = sv_2mortal(newSVpvn((char *)digeststr, 16));
+	}
+#line 492 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_digest2); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_digest2)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "context");
+    {
+	File__RsyncP__Digest	context;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::digest2",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+#line 196 "Digest.xs"
+	{
+	    unsigned char digeststr[32];
+	    RsyncMD4_CTX context2 = *context;
+            int rsyncMD4Bug = context->rsyncMD4Bug;
+
+	    /*
+	     * Return 2 MD4s (32 bytes): first is rsync buggy version
+	     * (protocol <= 26) and second is correct version (>= 27).
+	     */
+	    context2.rsyncMD4Bug = !rsyncMD4Bug;
+	    RsyncMD4FinalRsync(digeststr + 0,
+			rsyncMD4Bug ? context : &context2);
+	    RsyncMD4FinalRsync(digeststr + 16,
+			rsyncMD4Bug ? &context2 : context);
+	    ST(0) = sv_2mortal(newSVpvn((char *)digeststr, 32));
+	}
+#line 538 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_blockDigest); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_blockDigest)
+{
+    dVAR; dXSARGS;
+    if (items < 2 || items > 6)
+       croak_xs_usage(cv,  "context, dataV, blockSize=700, md4DigestLen=16, seed=0, outV=NULL");
+    {
+#line 216 "Digest.xs"
+	STRLEN len;
+#line 553 "Digest.c"
+	File__RsyncP__Digest	context;
+	SV *	dataV = ST(1)
+;
+	unsigned char *	data = (unsigned char *)SvPV(dataV, len);
+	size_t	blockSize;
+	int	md4DigestLen;
+	unsigned int	seed;
+	SV *	outV;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::blockDigest",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 3)
+	    blockSize = 700;
+	else {
+	    blockSize = (size_t)SvUV(ST(2))
+;
+	}
+
+	if (items < 4)
+	    md4DigestLen = 16;
+	else {
+	    md4DigestLen = (int)SvIV(ST(3))
+;
+	}
+
+	if (items < 5)
+	    seed = 0;
+	else {
+	    seed = (unsigned int)SvUV(ST(4))
+;
+	}
+
+	if (items < 6)
+	    outV = NULL;
+	else {
+	    outV = ST(5)
+;
+	}
+#line 226 "Digest.xs"
+	{
+	    UINT4 digestSize;
+	    unsigned char *digest;
+	    SV *retV = NULL;
+
+	    if ( blockSize == 0 ) blockSize = 700;
+            /* 
+             * If md4DigestLen < 0, this is a special case: save the
+             * entire MD4 state, so it can be cached.  That's 4+16=20
+             * bytes per block, plus the used part of the 64 byte buffer.
+             */
+	    digestSize = rsync_checksum_size(len, blockSize, md4DigestLen);
+	    outV   = DIGEST_OUT_ARG(outV);
+	    digest = digest_out_start(outV, dataV, digestSize, &retV);
+	    rsync_checksum(data, len, blockSize, seed, digest, md4DigestLen);
+	    ST(0) = digest_out_done(outV, retV, digestSize);
+	}
+#line 623 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_blockDigestParallel); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_blockDigestParallel)
+{
+    dVAR; dXSARGS;
+    if (items < 2 || items > 7)
+       croak_xs_usage(cv,  "context, dataV, blockSize=700, md4DigestLen=16, seed=0, threads=0, outV=NULL");
+    {
+#line 247 "Digest.xs"
+	STRLEN len;
+#line 638 "Digest.c"
+	File__RsyncP__Digest	context;
+	SV *	dataV = ST(1)
+;
+	unsigned char *	data = (unsigned char *)SvPV(dataV, len);
+	size_t	blockSize;
+	int	md4DigestLen;
+	unsigned int	seed;
+	int	threads;
+	SV *	outV;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::blockDigestParallel",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 3)
+	    blockSize = 700;
+	else {
+	    blockSize = (size_t)SvUV(ST(2))
+;
+	}
+
+	if (items < 4)
+	    md4DigestLen = 16;
+	else {
+	    md4DigestLen = (int)SvIV(ST(3))
+;
+	}
+
+	if (items < 5)
+	    seed = 0;
+	else {
+	    seed = (unsigned int)SvUV(ST(4))
+;
+	}
+
+	if (items < 6)
+	    threads = 0;
+	else {
+	    threads = (int)SvIV(ST(5))
+;
+	}
+
+	if (items < 7)
+	    outV = NULL;
+	else {
+	    outV = ST(6)
+;
+	}
+#line 258 "Digest.xs"
+	{
+	    UINT4 digestSize;
+	    unsigned char *digest;
+	    SV *retV = NULL;
+
+	    if ( blockSize == 0 ) blockSize = 700;
+	    digestSize = rsync_checksum_size(len, blockSize, md4DigestLen);
+	    outV   = DIGEST_OUT_ARG(outV);
+	    digest = digest_out_start(outV, dataV, digestSize, &retV);
+	    rsync_checksum_parallel(data, len, blockSize, seed, digest,
+				    md4DigestLen, threads, NULL);
+	    ST(0) = digest_out_done(outV, retV, digestSize);
+	}
+#line 712 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_blockDigestAdd); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_blockDigestAdd)
+{
+    dVAR; dXSARGS;
+    if (items < 2 || items > 6)
+       croak_xs_usage(cv,  "context, dataV, blockSize=700, md4DigestLen=16, seed=0, outV=NULL");
+    {
+#line 275 "Digest.xs"
+	STRLEN len;
+#line 727 "Digest.c"
+	File__RsyncP__Digest	context;
+	SV *	dataV = ST(1)
+;
+	unsigned char *	data = (unsigned char *)SvPV(dataV, len);
+	size_t	blockSize;
+	int	md4DigestLen;
+	unsigned int	seed;
+	SV *	outV;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::blockDigestAdd",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 3)
+	    blockSize = 700;
+	else {
+	    blockSize = (size_t)SvUV(ST(2))
+;
+	}
+
+	if (items < 4)
+	    md4DigestLen = 16;
+	else {
+	    md4DigestLen = (int)SvIV(ST(3))
+;
+	}
+
+	if (items < 5)
+	    seed = 0;
+	else {
+	    seed = (unsigned int)SvUV(ST(4))
+;
+	}
+
+	if (items < 6)
+	    outV = NULL;
+	else {
+	    outV = ST(5)
+;
+	}
+#line 285 "Digest.xs"
+	{
+	    UINT4 digestSize;
+	    unsigned char *digest;
+	    SV *retV = NULL;
+
+	    /*
+	     * Same as add() followed by blockDigest(), in one pass.
+	     */
+	    if ( blockSize == 0 ) blockSize = 700;
+	    digestSize = rsync_checksum_size(len, blockSize, md4DigestLen);
+	    outV   = DIGEST_OUT_ARG(outV);
+	    digest = digest_out_start(outV, dataV, digestSize, &retV);
+	    rsync_checksum_file(data, len, blockSize, seed, digest,
+				md4DigestLen, context);
+	    ST(0) = digest_out_done(outV, retV, digestSize);
+	}
+#line 796 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_blockDigestUpdate); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_blockDigestUpdate)
+{
+    dVAR; dXSARGS;
+    if (items < 2 || items > 7)
+       croak_xs_usage(cv,  "context, dataV, blockSize=700, blockLastLen=0, md4DigestLen=16, seed=0, outV=NULL");
+    {
+#line 305 "Digest.xs"
+	STRLEN len;
+#line 811 "Digest.c"
+	File__RsyncP__Digest	context;
+	SV *	dataV = ST(1)
+;
+	unsigned char *	data = (unsigned char *)SvPV(dataV, len);
+	size_t	blockSize;
+	size_t	blockLastLen;
+	int	md4DigestLen;
+	unsigned int	seed;
+	SV *	outV;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::blockDigestUpdate",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 3)
+	    blockSize = 700;
+	else {
+	    blockSize = (size_t)SvUV(ST(2))
+;
+	}
+
+	if (items < 4)
+	    blockLastLen = 0;
+	else {
+	    blockLastLen = (size_t)SvUV(ST(3))
+;
+	}
+
+	if (items < 5)
+	    md4DigestLen = 16;
+	else {
+	    md4DigestLen = (int)SvIV(ST(4))
+;
+	}
+
+	if (items < 6)
+	    seed = 0;
+	else {
+	    seed = (unsigned int)SvUV(ST(5))
+;
+	}
+
+	if (items < 7)
+	    outV = NULL;
+	else {
+	    outV = ST(6)
+;
+	}
+#line 316 "Digest.xs"
+	{
+	    UINT4 digestSize, blockCnt;
+	    unsigned char *digest;
+	    SV *retV = NULL;
+
+	    if ( blockSize == 0 ) blockSize = 700;
+            /*
+             * There are 20 + (blockSize % 64) bytes per block,
+             * plus 20 + (blockLastLen % 64) bytes for the last block.
+             */
+	    blockCnt = 1 + (len - (20 + (blockLastLen % 64)))
+                                    / (20 + (blockSize % 64));
+            if ( len == 0 || len != 20 * blockCnt
+                           + (blockCnt > 1 ? (blockSize % 64) * (blockCnt - 1)
+                                          : 0)
+                           + (blockLastLen % 64) ) {
+                /* TODO: provide a decent error message */
+                printf("len = %u is wrong\n", (unsigned int)len);
+                blockCnt = 0;
+            }
+	    if ( md4DigestLen > 16 || md4DigestLen < 0 ) md4DigestLen = 16;
+	    digestSize = (4 + md4DigestLen) * blockCnt;
+	    outV   = DIGEST_OUT_ARG(outV);
+	    digest = digest_out_start(outV, dataV, digestSize, &retV);
+	    rsync_checksum_update(data, blockCnt, blockSize, 
+		    blockLastLen, seed, digest, md4DigestLen);
+	    ST(0) = digest_out_done(outV, retV, digestSize);
+	}
+#line 900 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_blockDigestExtract); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_blockDigestExtract)
+{
+    dVAR; dXSARGS;
+    if (items < 2 || items > 4)
+       croak_xs_usage(cv,  "context, dataV, md4DigestLen=16, outV=NULL");
+    {
+#line 348 "Digest.xs"
+	STRLEN len;
+#line 915 "Digest.c"
+	File__RsyncP__Digest	context;
+	SV *	dataV = ST(1)
+;
+	unsigned char *	data = (unsigned char *)SvPV(dataV, len);
+	int	md4DigestLen;
+	SV *	outV;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::blockDigestExtract",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 3)
+	    md4DigestLen = 16;
+	else {
+	    md4DigestLen = (int)SvIV(ST(2))
+;
+	}
+
+	if (items < 4)
+	    outV = NULL;
+	else {
+	    outV = ST(3)
+;
+	}
+#line 356 "Digest.xs"
+	{
+	    unsigned char *p;
+            UINT4 blockCnt = len / 20;
+            UINT4 digestSize;
+	    SV *retV = NULL;
+
+            if ( md4DigestLen < 0 || md4DigestLen > 16 ) {
+                md4DigestLen = 16;
+            }
+	    digestSize = (4 + md4DigestLen) * blockCnt;
+	    outV = DIGEST_OUT_ARG(outV);
+	    p = digest_out_start(outV, dataV, digestSize, &retV);
+            while ( blockCnt-- > 0 ) {
+                memcpy(p, data, 4);
+                p += 4;
+                data += 4;
+                memcpy(p, data, md4DigestLen);
+                p += md4DigestLen;
+                data += 16;
+            }
+	    ST(0) = digest_out_done(outV, retV, digestSize);
+	}
+#line 974 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_blockDigestFd); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_blockDigestFd)
+{
+    dVAR; dXSARGS;
+    if (items < 3 || items > 9)
+       croak_xs_usage(cv,  "context, fd, blockCnt, blockSize=700, md4DigestLen=16, seed=0, fileDigestV=NULL, threads=1, outV=NULL");
+    {
+	File__RsyncP__Digest	context;
+	int	fd = (int)SvIV(ST(1))
+;
+	UV	blockCnt = (UV)SvUV(ST(2))
+;
+	size_t	blockSize;
+	int	md4DigestLen;
+	unsigned int	seed;
+	SV *	fileDigestV;
+	int	threads;
+	SV *	outV;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::blockDigestFd",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 4)
+	    blockSize = 700;
+	else {
+	    blockSize = (size_t)SvUV(ST(3))
+;
+	}
+
+	if (items < 5)
+	    md4DigestLen = 16;
+	else {
+	    md4DigestLen = (int)SvIV(ST(4))
+;
+	}
+
+	if (items < 6)
+	    seed = 0;
+	else {
+	    seed = (unsigned int)SvUV(ST(5))
+;
+	}
+
+	if (items < 7)
+	    fileDigestV = NULL;
+	else {
+	    fileDigestV = ST(6)
+;
+	}
+
+	if (items < 8)
+	    threads = 1;
+	else {
+	    threads = (int)SvIV(ST(7))
+;
+	}
+
+	if (items < 9)
+	    outV = NULL;
+	else {
+	    outV = ST(8)
+;
+	}
+#line 391 "Digest.xs"
+	{
+	    RsyncMD4_CTX *fileCtx;
+	    UINT4 digestSize;
+	    unsigned char *digest;
+	    fd_chunk chunk;
+	    SV *retV = NULL;
+
+	    if ( blockSize == 0 ) blockSize = 700;
+	    if ( blockCnt == 0 ) blockCnt = 100;
+	    if ( blockCnt > 0xffffffff / blockSize )
+		blockCnt = 0xffffffff / blockSize;
+	    fileCtx = digest_ctx_arg(fileDigestV,
+			    "File::RsyncP::Digest::blockDigestFd");
+	    if ( fd_chunk_get(fd, blockCnt * blockSize, &chunk) ) {
+		XSRETURN_UNDEF;
+	    }
+	    if ( chunk.len == 0 ) {
+		fd_chunk_free(&chunk);
+		XSRETURN_UNDEF;
+	    }
+	    digestSize = rsync_checksum_size(chunk.len, blockSize,
+					     md4DigestLen);
+	    outV   = DIGEST_OUT_ARG(outV);
+	    digest = digest_out_start(outV, NULL, digestSize, &retV);
+	    rsync_checksum_parallel(chunk.data, chunk.len, blockSize, seed,
+				    digest, md4DigestLen, threads, fileCtx);
+	    fd_chunk_free(&chunk);
+	    ST(0) = digest_out_done(outV, retV, digestSize);
+	}
+#line 1085 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_addFd); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_addFd)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "context, fd");
+    {
+	File__RsyncP__Digest	context;
+	int	fd = (int)SvIV(ST(1))
+;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::addFd",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+#line 426 "Digest.xs"
+	{
+	    fd_chunk chunk;
+	    double total = 0;
+
+	    /*
+	     * Add the rest of the file to the digest.  Returns the
+	     * number of bytes added, or undef on a read error.
+	     */
+	    for ( ;; ) {
+		if ( fd_chunk_get(fd, FD_CHUNK_MAX_LEN, &chunk) ) {
+		    XSRETURN_UNDEF;
+		}
+		if ( chunk.len == 0 )
+		    break;
+		RsyncMD4Update(context, chunk.data, chunk.len);
+		total += chunk.len;
+		fd_chunk_free(&chunk);
+	    }
+	    fd_chunk_free(&chunk);
+	    ST(0) = sv_2mortal(newSVnv(total));
+	}
+#line 1138 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_copyRangeFd); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_copyRangeFd)
+{
+    dVAR; dXSARGS;
+    if (items < 5 || items > 6)
+       croak_xs_usage(cv,  "context, inFd, offset, len, outFd, copyState=NULL");
+    {
+	File__RsyncP__Digest	context;
+	int	inFd = (int)SvIV(ST(1))
+;
+	double	offset = (double)SvNV(ST(2))
+;
+	double	len = (double)SvNV(ST(3))
+;
+	int	outFd = (int)SvIV(ST(4))
+;
+	SV *	copyState;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::copyRangeFd",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 6)
+	    copyState = NULL;
+	else {
+	    copyState = ST(5)
+;
+	}
+#line 457 "Digest.xs"
+	{
+	    /*
+	     * Copy len bytes at offset in inFd to the current offset of
+	     * outFd, adding them to the digest.  If outFd is -1 the
+	     * data is just added to the digest.  copyState, if given,
+	     * is updated with the kernel copies that failed, so they
+	     * aren't retried for the same output file.  Returns the
+	     * number of bytes copied, or undef on error.
+	     */
+	    int state = copyState && SvOK(copyState) ? SvIV(copyState) : 0;
+	    int err   = offset < 0 || len < 0
+		    || fd_copy_range(inFd, (off_t)offset, (off_t)len, outFd,
+				     context, &state);
+
+	    if ( copyState && !SvREADONLY(copyState) )
+		sv_setiv(copyState, state);
+	    if ( err ) {
+		XSRETURN_UNDEF;
+	    }
+	    ST(0) = sv_2mortal(newSVnv(len));
+	}
+#line 1205 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_literalFd); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_literalFd)
+{
+    dVAR; dXSARGS;
+    if (items < 2 || items > 3)
+       croak_xs_usage(cv,  "context, fd, maxLen=262144");
+    {
+	File__RsyncP__Digest	context;
+	int	fd = (int)SvIV(ST(1))
+;
+	UV	maxLen;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::literalFd",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 3)
+	    maxLen = 262144;
+	else {
+	    maxLen = (UV)SvUV(ST(2))
+;
+	}
+#line 485 "Digest.xs"
+	{
+	    fd_chunk chunk;
+	    unsigned char *p;
+	    SV *out;
+
+	    /*
+	     * Read up to maxLen bytes from fd, add them to the digest
+	     * and return them as an rsync literal data token (a 4 byte
+	     * length and the data), ie: pack("V a*", length($d), $d).
+	     * Returns undef at EOF or on a read error.
+	     */
+	    if ( maxLen > FD_CHUNK_MAX_LEN )
+		maxLen = FD_CHUNK_MAX_LEN;
+	    if ( fd_chunk_get(fd, maxLen, &chunk) || chunk.len == 0 ) {
+		fd_chunk_free(&chunk);
+		XSRETURN_UNDEF;
+	    }
+	    RsyncMD4Update(context, chunk.data, chunk.len);
+	    /*
+	     * Leave room after the string so perl can share the buffer
+	     * (copy-on-write) when it is queued for writing.
+	     */
+	    out = newSV(chunk.len + 8);
+	    SvPOK_only(out);
+	    p = (unsigned char *)SvPVX(out);
+	    p[0] = chunk.len & 0xff;
+	    p[1] = (chunk.len >> 8) & 0xff;
+	    p[2] = (chunk.len >> 16) & 0xff;
+	    p[3] = (chunk.len >> 24) & 0xff;
+	    memcpy(p + 4, chunk.data, chunk.len);
+	    SvCUR_set(out, chunk.len + 4);
+	    *SvEND(out) = '\0';
+	    fd_chunk_free(&chunk);
+	    ST(0) = sv_2mortal(out);
+	}
+#line 1280 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_adler32Kernels); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_adler32Kernels)
+{
+    dVAR; dXSARGS;
+    if (items < 0 || items > 1)
+       croak_xs_usage(cv,  "packname = \"File::RsyncP::Digest\"");
+    PERL_UNUSED_VAR(ax); /* -Wall */
+    SP -= items;
+    {
+	char *	packname;
+
+	if (items < 1)
+	    packname = "File::RsyncP::Digest";
+	else {
+	    packname = (char *)SvPV_nolen(ST(0))
+;
+	}
+#line 525 "Digest.xs"
+	{
+	    char *name;
+	    int i;
+
+	    for ( i = 0 ; (name = adler32_kernel_name(i)) ; i++ ) {
+		XPUSHs(sv_2mortal(newSVpv(name, 0)));
+	    }
+	}
+#line 1312 "Digest.c"
+	PUTBACK;
+	return;
+    }
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_adler32KernelSet); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_adler32KernelSet)
+{
+    dVAR; dXSARGS;
+    if (items < 0 || items > 2)
+       croak_xs_usage(cv,  "packname = \"File::RsyncP::Digest\", name = NULL");
+    {
+	char *	packname;
+	char *	name;
+	int	RETVAL;
+	dXSTARG;
+
+	if (items < 1)
+	    packname = "File::RsyncP::Digest";
+	else {
+	    packname = (char *)SvPV_nolen(ST(0))
+;
+	}
+
+	if (items < 2)
+	    name = NULL;
+	else {
+	    name = (char *)SvPV_nolen(ST(1))
+;
+	}
+#line 539 "Digest.xs"
+	{
+	    RETVAL = adler32_kernel_set(name) == 0;
+	}
+#line 1348 "Digest.c"
+	XSprePUSH;
+	PUSHi((IV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_md4Kernels); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_md4Kernels)
+{
+    dVAR; dXSARGS;
+    if (items < 0 || items > 1)
+       croak_xs_usage(cv,  "packname = \"File::RsyncP::Digest\"");
+    PERL_UNUSED_VAR(ax); /* -Wall */
+    SP -= items;
+    {
+	char *	packname;
+
+	if (items < 1)
+	    packname = "File::RsyncP::Digest";
+	else {
+	    packname = (char *)SvPV_nolen(ST(0))
+;
+	}
+#line 549 "Digest.xs"
+	{
+	    char *name;
+	    int i;
+
+	    for ( i = 0 ; (name = md4_mb_kernel_name(i)) ; i++ ) {
+		XPUSHs(sv_2mortal(newSVpv(name, 0)));
+	    }
+	}
+#line 1382 "Digest.c"
+	PUTBACK;
+	return;
+    }
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_md4KernelSet); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_md4KernelSet)
+{
+    dVAR; dXSARGS;
+    if (items < 0 || items > 2)
+       croak_xs_usage(cv,  "packname = \"File::RsyncP::Digest\", name = NULL");
+    {
+	char *	packname;
+	char *	name;
+	int	RETVAL;
+	dXSTARG;
+
+	if (items < 1)
+	    packname = "File::RsyncP::Digest";
+	else {
+	    packname = (char *)SvPV_nolen(ST(0))
+;
+	}
+
+	if (items < 2)
+	    name = NULL;
+	else {
+	    name = (char *)SvPV_nolen(ST(1))
+;
+	}
+#line 563 "Digest.xs"
+	{
+	    RETVAL = md4_mb_kernel_set(name) == 0;
+	}
+#line 1418 "Digest.c"
+	XSprePUSH;
+	PUSHi((IV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_adler32Start); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_adler32Start)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "context, dataV");
+    PERL_UNUSED_VAR(ax); /* -Wall */
+    SP -= items;
+    {
+#line 572 "Digest.xs"
+	STRLEN len;
+#line 1437 "Digest.c"
+	File__RsyncP__Digest	context;
+	SV *	dataV = ST(1)
+;
+	unsigned char *	data = (unsigned char *)SvPV(dataV, len);
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::adler32Start",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+#line 578 "Digest.xs"
+	{
+	    UINT4 s1, s2;
+
+	    adler32_parts((char *)data, len, &s1, &s2);
+	    EXTEND(SP, 2);
+	    PUSHs(sv_2mortal(newSVuv(s1 & 0xffffffff)));
+	    PUSHs(sv_2mortal(newSVuv(s2 & 0xffffffff)));
+	}
+#line 1465 "Digest.c"
+	PUTBACK;
+	return;
+    }
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_adler32Roll); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_adler32Roll)
+{
+    dVAR; dXSARGS;
+    if (items < 4 || items > 6)
+       croak_xs_usage(cv,  "context, s1, s2, len, outV=&PL_sv_undef, inV=&PL_sv_undef");
+    PERL_UNUSED_VAR(ax); /* -Wall */
+    SP -= items;
+    {
+	File__RsyncP__Digest	context;
+	UV	s1 = (UV)SvUV(ST(1))
+;
+	UV	s2 = (UV)SvUV(ST(2))
+;
+	UV	len = (UV)SvUV(ST(3))
+;
+	SV *	outV;
+	SV *	inV;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::adler32Roll",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 5)
+	    outV = &PL_sv_undef;
+	else {
+	    outV = ST(4)
+;
+	}
+
+	if (items < 6)
+	    inV = &PL_sv_undef;
+	else {
+	    inV = ST(5)
+;
+	}
+#line 596 "Digest.xs"
+	{
+	    /*
+	     * An undefined out byte grows the window by one; an undefined
+	     * in byte shrinks it by one.
+	     */
+	    UINT4 r1 = s1, r2 = s2;
+	    STRLEN l;
+	    int haveOut, haveIn;
+	    signed char out, in;
+
+	    SvGETMAGIC(outV);
+	    SvGETMAGIC(inV);
+	    haveOut = SvOK(outV);
+	    haveIn  = SvOK(inV);
+	    out = haveOut ? *(signed char *)SvPV_nomg(outV, l) : 0;
+	    in  = haveIn  ? *(signed char *)SvPV_nomg(inV, l)  : 0;
+
+	    if ( haveOut && haveIn ) {
+		ADLER32_ROLL(r1, r2, len, out, in);
+	    } else if ( haveIn ) {
+		ADLER32_ROLL_IN(r1, r2, in);
+	    } else if ( haveOut ) {
+		ADLER32_ROLL_OUT(r1, r2, len, out);
+	    }
+	    EXTEND(SP, 2);
+	    PUSHs(sv_2mortal(newSVuv(r1 & 0xffffffff)));
+	    PUSHs(sv_2mortal(newSVuv(r2 & 0xffffffff)));
+	}
+#line 1547 "Digest.c"
+	PUTBACK;
+	return;
+    }
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_adler32Sum); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_adler32Sum)
+{
+    dVAR; dXSARGS;
+    if (items != 3)
+       croak_xs_usage(cv,  "context, s1, s2");
+    {
+	File__RsyncP__Digest	context;
+	UV	s1 = (UV)SvUV(ST(1))
+;
+	UV	s2 = (UV)SvUV(ST(2))
+;
+	UV	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::adler32Sum",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+#line 631 "Digest.xs"
+	{
+	    RETVAL = ADLER32_SUM(s1, s2);
+	}
+#line 1586 "Digest.c"
+	XSprePUSH;
+	PUSHu((UV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_adler32Scan); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_adler32Scan)
+{
+    dVAR; dXSARGS;
+    if (items < 4 || items > 5)
+       croak_xs_usage(cv,  "context, dataV, blockSize, sumsV, stride=4");
+    {
+#line 640 "Digest.xs"
+	STRLEN len, sumsLen;
+#line 1603 "Digest.c"
+	File__RsyncP__Digest	context;
+	SV *	dataV = ST(1)
+;
+	unsigned char *	data = (unsigned char *)SvPV(dataV, len);
+	size_t	blockSize = (size_t)SvUV(ST(2))
+;
+	SV *	sumsV = ST(3)
+;
+	unsigned char *	sums = (unsigned char *)SvPV(sumsV, sumsLen);
+	size_t	stride;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::adler32Scan",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 5)
+	    stride = 4;
+	else {
+	    stride = (size_t)SvUV(ST(4))
+;
+	}
+#line 650 "Digest.xs"
+	{
+	    adler32_set *set;
+	    adler32_scan_state state;
+	    UINT4 result[2 * 1024];
+	    SV *out = newSVpvn("", 0);
+
+	    if ( stride < 4 ) stride = 4;
+	    if ( !(set = adler32_set_new(sums, sumsLen / stride, stride)) ) {
+		croak("File::RsyncP::Digest::adler32Scan: out of memory");
+	    }
+	    memset(&state, 0, sizeof(state));
+	    while ( blockSize > 0 && state.offset + blockSize <= len ) {
+		UINT4 i, n = adler32_scan((char *)data, len, blockSize, set,
+					  &state, result, 1024);
+		for ( i = 0 ; i < 2 * n ; i++ ) {
+		    unsigned char buf[4];
+
+		    RsyncMD4Encode(buf, &result[i], 4);
+		    sv_catpvn(out, (char *)buf, 4);
+		}
+	    }
+	    adler32_set_free(set);
+	    ST(0) = sv_2mortal(out);
+	}
+#line 1661 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_deltaNew); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_deltaNew)
+{
+    dVAR; dXSARGS;
+    if (items < 2 || items > 6)
+       croak_xs_usage(cv,  "context, sumsV, blockSize=700, remainder=0, csumLen=16, seed=0");
+    {
+#line 678 "Digest.xs"
+	STRLEN len;
+#line 1676 "Digest.c"
+	File__RsyncP__Digest	context;
+	SV *	sumsV = ST(1)
+;
+	unsigned char *	sums = (unsigned char *)SvPV(sumsV, len);
+	size_t	blockSize;
+	size_t	remainder;
+	int	csumLen;
+	unsigned int	seed;
+	File__RsyncP__Digest__Delta	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    context = INT2PTR(File__RsyncP__Digest,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::deltaNew",
+			"context", "File::RsyncP::Digest",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 3)
+	    blockSize = 700;
+	else {
+	    blockSize = (size_t)SvUV(ST(2))
+;
+	}
+
+	if (items < 4)
+	    remainder = 0;
+	else {
+	    remainder = (size_t)SvUV(ST(3))
+;
+	}
+
+	if (items < 5)
+	    csumLen = 16;
+	else {
+	    csumLen = (int)SvIV(ST(4))
+;
+	}
+
+	if (items < 6)
+	    seed = 0;
+	else {
+	    seed = (unsigned int)SvUV(ST(5))
+;
+	}
+#line 688 "Digest.xs"
+	{
+	    if ( csumLen < 0 || csumLen > 16 ) csumLen = 16;
+	    RETVAL = rsync_delta_new(sums, len / (4 + csumLen), blockSize,
+			    remainder, csumLen, seed, context->rsyncMD4Bug);
+	    if ( !RETVAL ) {
+		croak("File::RsyncP::Digest::deltaNew: out of memory");
+	    }
+	}
+#line 1737 "Digest.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = sv_newmortal();
+	    sv_setref_pv(RETVALSV, "File::RsyncP::Digest::Delta", (void*)RETVAL);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_matchTokens); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_matchTokens)
+{
+    dVAR; dXSARGS;
+    if (items < 2 || items > 4)
+       croak_xs_usage(cv,  "packname = \"File::RsyncP::Digest\", blk, cnt, outV=NULL");
+    {
+	char *	packname;
+	UV	blk = (UV)SvUV(ST(1))
+;
+	UV	cnt = (UV)SvUV(ST(2))
+;
+	SV *	outV;
+	SV *	RETVAL;
+
+	if (items < 1)
+	    packname = "File::RsyncP::Digest";
+	else {
+	    packname = (char *)SvPV_nolen(ST(0))
+;
+	}
+
+	if (items < 4)
+	    outV = NULL;
+	else {
+	    outV = ST(3)
+;
+	}
+#line 706 "Digest.xs"
+	{
+	    unsigned char *out;
+	    SV *retV = NULL;
+
+	    /*
+	     * Return (or append to outV) the match tokens for blocks
+	     * blk .. blk + cnt - 1.
+	     */
+	    PERL_UNUSED_VAR(packname);
+	    outV = DIGEST_OUT_ARG(outV);
+	    out  = digest_out_start(outV, NULL, 4 * cnt, &retV);
+	    rsync_match_tokens(out, blk, cnt);
+	    ST(0) = digest_out_done(outV, retV, 4 * cnt);
+	}
+#line 1792 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest_prefetchFile); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest_prefetchFile)
+{
+    dVAR; dXSARGS;
+    if (items < 1 || items > 3)
+       croak_xs_usage(cv,  "packname = \"File::RsyncP::Digest\", path, len = 0");
+    {
+	char *	packname;
+	char *	path = (char *)SvPV_nolen(ST(1))
+;
+	double	len;
+	int	RETVAL;
+	dXSTARG;
+
+	if (items < 1)
+	    packname = "File::RsyncP::Digest";
+	else {
+	    packname = (char *)SvPV_nolen(ST(0))
+;
+	}
+
+	if (items < 3)
+	    len = 0;
+	else {
+	    len = (double)SvNV(ST(2))
+;
+	}
+#line 727 "Digest.xs"
+	{
+	    /*
+	     * Start reading the file into the page cache.  Returns 1 if
+	     * the hint was given.
+	     */
+	    PERL_UNUSED_VAR(packname);
+	    RETVAL = len >= 0 && fd_prefetch(path, (off_t)len) == 0;
+	}
+#line 1834 "Digest.c"
+	XSprePUSH;
+	PUSHi((IV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest__Delta_DESTROY); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest__Delta_DESTROY)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "delta");
+    {
+	File__RsyncP__Digest__Delta	delta;
+
+	if (SvROK(ST(0))) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    delta = INT2PTR(File__RsyncP__Digest__Delta,tmp);
+	}
+	else
+	    Perl_croak_nocontext("%s: %s is not a reference",
+			"File::RsyncP::Digest::Delta::DESTROY",
+			"delta")
+;
+#line 745 "Digest.xs"
+	{
+	    rsync_delta_free(delta);
+	}
+#line 1864 "Digest.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest__Delta_add); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest__Delta_add)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "delta, dataV");
+    {
+#line 752 "Digest.xs"
+	STRLEN len;
+#line 1879 "Digest.c"
+	File__RsyncP__Digest__Delta	delta;
+	SV *	dataV = ST(1)
+;
+	unsigned char *	data = (unsigned char *)SvPV(dataV, len);
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest::Delta")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    delta = INT2PTR(File__RsyncP__Digest__Delta,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::Delta::add",
+			"delta", "File::RsyncP::Digest::Delta",
+			refstr, ST(0)
+		);
+	}
+;
+#line 758 "Digest.xs"
+	{
+	    if ( rsync_delta_add(delta, data, len) ) {
+		croak("File::RsyncP::Digest::Delta::add: out of memory");
+	    }
+	    ST(0) = sv_2mortal(newSVpvn((char *)delta->out, delta->outLen));
+	    delta->outLen = 0;
+	}
+#line 1907 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest__Delta_finish); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest__Delta_finish)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "delta");
+    {
+	File__RsyncP__Digest__Delta	delta;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest::Delta")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    delta = INT2PTR(File__RsyncP__Digest__Delta,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::Delta::finish",
+			"delta", "File::RsyncP::Digest::Delta",
+			refstr, ST(0)
+		);
+	}
+;
+#line 770 "Digest.xs"
+	{
+	    if ( rsync_delta_finish(delta) ) {
+		croak("File::RsyncP::Digest::Delta::finish: out of memory");
+	    }
+	    ST(0) = sv_2mortal(newSVpvn((char *)delta->out, delta->outLen));
+	    delta->outLen = 0;
+	}
+#line 1944 "Digest.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest__Delta_matchCnt); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest__Delta_matchCnt)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "delta");
+    {
+	File__RsyncP__Digest__Delta	delta;
+	unsigned int	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest::Delta")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    delta = INT2PTR(File__RsyncP__Digest__Delta,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::Delta::matchCnt",
+			"delta", "File::RsyncP::Digest::Delta",
+			refstr, ST(0)
+		);
+	}
+;
+#line 782 "Digest.xs"
+	{
+	    RETVAL = delta->matchCnt;
+	}
+#line 1978 "Digest.c"
+	XSprePUSH;
+	PUSHu((UV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Digest__Delta_literalBytes); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Digest__Delta_literalBytes)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "delta");
+    {
+	File__RsyncP__Digest__Delta	delta;
+	double	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Digest::Delta")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    delta = INT2PTR(File__RsyncP__Digest__Delta,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Digest::Delta::literalBytes",
+			"delta", "File::RsyncP::Digest::Delta",
+			refstr, ST(0)
+		);
+	}
+;
+#line 792 "Digest.xs"
+	{
+	    RETVAL = delta->literalBytes;
+	}
+#line 2014 "Digest.c"
+	XSprePUSH;
+	PUSHn((double)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+#ifdef __cplusplus
+extern "C"
+#endif
+XS_EXTERNAL(boot_File__RsyncP__Digest); /* prototype to pass -Wmissing-prototypes */
+XS_EXTERNAL(boot_File__RsyncP__Digest)
+{
+#if PERL_VERSION_LE(5, 21, 5)
+    dVAR; dXSARGS;
+#else
+    dVAR; dXSBOOTARGSXSAPIVERCHK;
+#endif
+#if PERL_VERSION_LE(5, 8, 999) /* PERL_VERSION_LT is 5.33+ */
+    char* file = __FILE__;
+#else
+    const char* file = __FILE__;
+#endif
+
+    PERL_UNUSED_VAR(file);
+
+    PERL_UNUSED_VAR(cv); /* -W */
+    PERL_UNUSED_VAR(items); /* -W */
+#if PERL_VERSION_LE(5, 21, 5)
+    XS_VERSION_BOOTCHECK;
+#  ifdef XS_APIVERSION_BOOTCHECK
+    XS_APIVERSION_BOOTCHECK;
+#  endif
+#endif
+
+        newXS_deffile("File::RsyncP::Digest::new", XS_File__RsyncP__Digest_new);
+        newXS_deffile("File::RsyncP::Digest::DESTROY", XS_File__RsyncP__Digest_DESTROY);
+        newXS_deffile("File::RsyncP::Digest::reset", XS_File__RsyncP__Digest_reset);
+        newXS_deffile("File::RsyncP::Digest::protocol", XS_File__RsyncP__Digest_protocol);
+        newXS_deffile("File::RsyncP::Digest::add", XS_File__RsyncP__Digest_add);
+        newXS_deffile("File::RsyncP::Digest::digest", XS_File__RsyncP__Digest_digest);
+        newXS_deffile("File::RsyncP::Digest::digest2", XS_File__RsyncP__Digest_digest2);
+        newXS_deffile("File::RsyncP::Digest::blockDigest", XS_File__RsyncP__Digest_blockDigest);
+        newXS_deffile("File::RsyncP::Digest::blockDigestParallel", XS_File__RsyncP__Digest_blockDigestParallel);
+        newXS_deffile("File::RsyncP::Digest::blockDigestAdd", XS_File__RsyncP__Digest_blockDigestAdd);
+        newXS_deffile("File::RsyncP::Digest::blockDigestUpdate", XS_File__RsyncP__Digest_blockDigestUpdate);
+        newXS_deffile("File::RsyncP::Digest::blockDigestExtract", XS_File__RsyncP__Digest_blockDigestExtract);
+        newXS_deffile("File::RsyncP::Digest::blockDigestFd", XS_File__RsyncP__Digest_blockDigestFd);
+        newXS_deffile("File::RsyncP::Digest::addFd", XS_File__RsyncP__Digest_addFd);
+        newXS_deffile("File::RsyncP::Digest::copyRangeFd", XS_File__RsyncP__Digest_copyRangeFd);
+        newXS_deffile("File::RsyncP::Digest::literalFd", XS_File__RsyncP__Digest_literalFd);
+        newXS_deffile("File::RsyncP::Digest::adler32Kernels", XS_File__RsyncP__Digest_adler32Kernels);
+        newXS_deffile("File::RsyncP::Digest::adler32KernelSet", XS_File__RsyncP__Digest_adler32KernelSet);
+        newXS_deffile("File::RsyncP::Digest::md4Kernels", XS_File__RsyncP__Digest_md4Kernels);
+        newXS_deffile("File::RsyncP::Digest::md4KernelSet", XS_File__RsyncP__Digest_md4KernelSet);
+        newXS_deffile("File::RsyncP::Digest::adler32Start", XS_File__RsyncP__Digest_adler32Start);
+        newXS_deffile("File::RsyncP::Digest::adler32Roll", XS_File__RsyncP__Digest_adler32Roll);
+        newXS_deffile("File::RsyncP::Digest::adler32Sum", XS_File__RsyncP__Digest_adler32Sum);
+        newXS_deffile("File::RsyncP::Digest::adler32Scan", XS_File__RsyncP__Digest_adler32Scan);
+        newXS_deffile("File::RsyncP::Digest::deltaNew", XS_File__RsyncP__Digest_deltaNew);
+        newXS_deffile("File::RsyncP::Digest::matchTokens", XS_File__RsyncP__Digest_matchTokens);
+        newXS_deffile("File::RsyncP::Digest::prefetchFile", XS_File__RsyncP__Digest_prefetchFile);
+        newXS_deffile("File::RsyncP::Digest::Delta::DESTROY", XS_File__RsyncP__Digest__Delta_DESTROY);
+        newXS_deffile("File::RsyncP::Digest::Delta::add", XS_File__RsyncP__Digest__Delta_add);
+        newXS_deffile("File::RsyncP::Digest::Delta::finish", XS_File__RsyncP__Digest__Delta_finish);
+        newXS_deffile("File::RsyncP::Digest::Delta::matchCnt", XS_File__RsyncP__Digest__Delta_matchCnt);
+        newXS_deffile("File::RsyncP::Digest::Delta::literalBytes", XS_File__RsyncP__Digest__Delta_literalBytes);
+#if PERL_VERSION_LE(5, 21, 5)
+#  if PERL_VERSION_GE(5, 9, 0)
+    if (PL_unitcheckav)
+        call_list(PL_scopestack_ix, PL_unitcheckav);
+#  endif
+    XSRETURN_YES;
+#else
+    Perl_xs_boot_epilog(aTHX_ ax);
+#endif
+}
+
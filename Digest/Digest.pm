@@ -158,11 +158,45 @@ File::RsyncP::Digest - Perl interface to rsync message digest algorithms
     $digests = $rsDigest->blockDigest($data, $blockSize, $md4DigestLen,
                                       $checksumSeed);
 
+    $digests = $rsDigest->blockDigestParallel($data, $blockSize,
+                                $md4DigestLen, $checksumSeed, $threads);
+
     $digests = $rsDigest->blockDigestUpdate($state, $blockSize,
                                 $blockLastLen, $md4DigestLen, $checksumSeed);
 
     $digests2 = $rsDigest->blockDigestExtract($digests16, $md4DigestLen);
 
+    # add $data to the file digest and return its block digests
+    $digests = $fileDigest->blockDigestAdd($data, $blockSize,
+                                $md4DigestLen, $checksumSeed);
+
+    # block digests read directly from a file descriptor
+    $digests = $rsDigest->blockDigestFd(fileno(FH), $blockCnt, $blockSize,
+                                $md4DigestLen, $checksumSeed, $fileDigest,
+                                $threads);
+    $rsDigest->addFd(fileno(FH));
+    $token = $fileDigest->literalFd(fileno(FH), $maxLen);
+    $fileDigest->copyRangeFd(fileno(IN), $offset, $len, fileno(OUT), $state);
+    File::RsyncP::Digest->prefetchFile($path, $len);
+    @kernels  = File::RsyncP::Digest->md4Kernels();
+    File::RsyncP::Digest->md4KernelSet($kernel);
+
+    # rolling adler32 checksums
+    ($s1, $s2) = $rsDigest->adler32Start($data);
+    ($s1, $s2) = $rsDigest->adler32Roll($s1, $s2, $len, $outChar, $inChar);
+    $adler32   = $rsDigest->adler32Sum($s1, $s2);
+    $hits      = $rsDigest->adler32Scan($data, $blockSize, $digests, $stride);
+    @kernels   = File::RsyncP::Digest->adler32Kernels();
+    File::RsyncP::Digest->adler32KernelSet($kernel);
+
+    # file deltas against remote block digests
+    $delta  = $rsDigest->deltaNew($digests, $blockSize, $remainder,
+                                  $md4DigestLen, $checksumSeed);
+    $tokens = $delta->add($data);
+    $tokens = $delta->finish();
+    $tokens = File::RsyncP::Digest->matchTokens($blk, $cnt);
+    File::RsyncP::Digest->matchTokens($blk, $cnt, $tokens);
+
 =head1 DESCRIPTION
 
 The B<File::RsyncP::Digest> module allows you to compute rsync digests,
@@ -275,6 +309,98 @@ times the number of blocks:
 
     (4 + md4DigestLen) * ceil(length(data) / blockSize);
 
+For large amounts of data, the blocks can be split across several
+threads:
+
+    $digests = $rsDigest->blockDigestParallel($data, $blockSize,
+                                $md4DigestLen, $checksumSeed, $threads);
+
+The arguments and the returned data are the same as blockDigest.
+$threads is the maximum number of threads (default 0, meaning one
+per CPU).  Each thread does at least 256K of the data, so smaller
+buffers are done in the calling thread.  If POSIX threads are not
+available this is the same as blockDigest.
+
+blockDigest, blockDigestParallel, blockDigestUpdate,
+blockDigestExtract and blockDigestFd all take an optional extra argument, $out.  If it
+is given, the digests are appended to $out (in place, without an
+extra copy), and the number of bytes appended is returned instead of
+the digests.  This allows one buffer to be reused for a whole file:
+
+    my $out = "";
+    while ( ... ) {
+        $rsDigest->blockDigest($data, $blockSize, $md4DigestLen,
+                               $checksumSeed, $out);
+    }
+
+The file MD4 digest and the block digests of the same data can be
+computed in one pass with:
+
+    $digests = $fileDigest->blockDigestAdd($data, $blockSize,
+                                $md4DigestLen, $checksumSeed);
+
+This is the same as $fileDigest->add($data) followed by blockDigest,
+except the data is done a cache-sized slice at a time, so it is only
+loaded from memory once.
+
+When the data comes from a file, the file can be read in C rather
+than into a perl string first:
+
+    $digests = $rsDigest->blockDigestFd($fd, $blockCnt, $blockSize,
+                                $md4DigestLen, $checksumSeed, $fileDigest,
+                                $threads);
+
+Up to $blockCnt * $blockSize bytes are read from the current offset
+of the file descriptor $fd (eg: fileno(FH)), and the file offset is
+advanced past them, just like sysread.  If $fileDigest is a File::RsyncP::Digest object,
+the same data is added to it, as with blockDigestAdd.  With several
+threads the calling thread computes the file digest while the others
+do the block digests.  $threads is as for blockDigestParallel, but defaults
+to 1.  undef is returned at end of file or on a read error.  The
+rest of a file can be added to a file digest with:
+
+    $fileDigest->addFd($fd);
+
+which returns the number of bytes added, or undef on error.
+
+When a file is sent whole, each piece can be read, added to the file
+digest and turned into an rsync literal data token in one step:
+
+    $token = $fileDigest->literalFd($fd, $maxLen);
+
+This reads up to $maxLen bytes (default 256K) and returns the same
+string as pack("V a*", length($data), $data), or undef at end of file
+or on a read error.  The token is built in a single buffer, which
+File::RsyncP::Mux::Writer can queue without copying it again.
+
+When a file is received, the blocks that match the old file can be
+copied to the new file with:
+
+    $fileDigest->copyRangeFd($inFd, $offset, $len, $outFd, $state);
+
+This copies $len bytes at $offset in $inFd to the current offset of
+$outFd (advancing it), and adds them to the file digest.  On linux the
+data is cloned (FICLONERANGE, eg: on btrfs or XFS, when both offsets
+and the length are multiples of the file system block size, or the
+range ends at the end of $inFd) or copied with copy_file_range() in
+the kernel, falling back to writing the data read for the digest.
+If $outFd is -1 the data is only added to the digest.  Returns $len,
+or undef on error (including if $inFd is too short).
+
+The optional $state variable remembers which kernel copies failed,
+so they aren't tried again.  Set it to 0 for each output file and
+pass the same variable to every copyRangeFd() call for that file.
+
+A file that will be read soon can be prefetched with:
+
+    File::RsyncP::Digest->prefetchFile($path, $len);
+
+This asks the kernel (with posix_fadvise(POSIX_FADV_WILLNEED)) to start
+reading the first $len bytes (or all, if $len is 0 or omitted) of the
+regular file $path into the page cache, and returns without waiting.
+It returns 1 if the hint was given, and 0 if the file can't be opened
+or isn't a regular file, or the system doesn't support posix_fadvise.
+
 To allow block checksums to be cached (when checksumSeed is unknown),
 and then quickly updated with the known checksumSeed, the checksum
 data should be first computed with a digest length of -1 and a
@@ -322,6 +448,107 @@ and for phase 1 the 2 byte MD4 substrings can be extracted with:
 The original $digests16 does not need any additional processing
 for phase 2.
 
+The block MD4 digests computed by blockDigest and blockDigestUpdate
+are independent, so with SSE2 or AVX2 they are computed 4 or 8 at a
+time.  The results are identical to the scalar MD4 code.  Like the
+Adler32 checksum (see below), the available versions are returned by:
+
+    @kernels = File::RsyncP::Digest->md4Kernels();
+
+and one can be selected with:
+
+    File::RsyncP::Digest->md4KernelSet($kernel);
+
+=head2 Rolling Checksums
+
+The Adler32 checksum can be updated in constant time as a window
+slides over the data.  The two 32 bit halves of the checksum of
+$data are returned by:
+
+    ($s1, $s2) = $rsDigest->adler32Start($data);
+
+and the window of length $len is moved by one byte with:
+
+    ($s1, $s2) = $rsDigest->adler32Roll($s1, $s2, $len, $outChar, $inChar);
+
+$outChar is the single character leaving the start of the window
+and $inChar is the character added at the end.  If $outChar is
+undef the window grows by one character; if $inChar is undef the
+window shrinks by one.  The 32 bit checksum (the same value as the
+first 4 bytes of each blockDigest) is:
+
+    $adler32 = $rsDigest->adler32Sum($s1, $s2);
+
+Calling adler32Roll for every byte from perl is slow.  To search
+a buffer for blocks, use:
+
+    $hits = $rsDigest->adler32Scan($data, $blockSize, $digests, $stride);
+
+Every $blockSize window of $data is checked in C against the set
+of Adler32 checksums in $digests, which are the first 4 bytes of
+every $stride bytes (default 4).  For example, the output of
+blockDigest with an $md4DigestLen of 2 can be used with a $stride
+of 6.  $hits is a packed string of (offset, adler32) pairs, which
+can be unpacked with unpack("V*", $hits).  The MD4 digest should be
+used to confirm each candidate.
+
+The Adler32 checksum is computed with SSE2 or AVX2 instructions if
+the CPU supports them.  The results are identical to the portable C
+version.  The available versions (slowest first) are returned by:
+
+    @kernels = File::RsyncP::Digest->adler32Kernels();
+
+and one can be selected (eg: for testing) with:
+
+    File::RsyncP::Digest->adler32KernelSet($kernel);
+
+With no argument, the fastest one is selected.  This is a global
+setting, rather than per-object.  Defining RSYNCP_NO_SIMD when
+compiling disables the SIMD versions.
+
+=head2 Computing File Deltas
+
+When sending a file, the remote side sends the block digests of its
+version of the file.  A delta object is created from those digests
+with:
+
+    $delta = $rsDigest->deltaNew($digests, $blockSize, $remainder,
+                                 $md4DigestLen, $checksumSeed);
+
+$digests is the concatenation of the remote block digests, each
+4 + $md4DigestLen bytes long (ie: the same format returned by
+blockDigest).  $remainder is the length of the last remote block
+(zero means a full block).  The MD4 finalization follows the
+protocol version of $rsDigest.
+
+The local file data is then passed in, in pieces of any size:
+
+    $tokens = $delta->add($data);
+    ...
+    $tokens = $delta->finish();
+
+A rolling Adler32 checksum is slid over the data and each candidate
+block is confirmed with the MD4 digest.  The returned $tokens are in
+rsync's wire format: literal data is a 32 bit little-endian length
+followed by the data, and a matching block is sent as -(blockNum+1).
+The caller must send the final 0 token and the file digest.
+The number of matched blocks and literal bytes are available via
+$delta->matchCnt() and $delta->literalBytes().
+
+After a match, the following blocks are first checked in order
+against the next remote blocks, several at a time with the
+multi-buffer MD4 code, so an unchanged file or a long unchanged
+region isn't searched one window at a time.
+
+The match tokens for a run of blocks can also be generated directly:
+
+    $tokens = File::RsyncP::Digest->matchTokens($blk, $cnt);
+
+returns the tokens for blocks $blk to $blk + $cnt - 1, ie:
+pack("V*", map { 0xffffffff - $_ } ($blk .. $blk + $cnt - 1)).  If a
+third argument is given the tokens are appended to it instead, and the
+number of bytes appended is returned.
+
 =head2 Computing File Digests
 
 In addition, functions identical to B<Digest::MD4> are provided that
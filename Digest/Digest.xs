@@ -23,13 +23,89 @@ extern "C" {
 
 #include "global.h"
 #include "md4.h"
+#include "rsync_lib.h"
+#include "delta.h"
 
 typedef RsyncMD4_CTX	*File__RsyncP__Digest;
+typedef rsync_delta	*File__RsyncP__Digest__Delta;
 
 #ifdef __cplusplus
 }
 #endif
 
+/*
+ * The block digest functions write their output directly into an
+ * SV.  If the caller supplied outV the output is appended to it,
+ * otherwise a new SV is returned in *retV.  Returns a pointer to room
+ * for size bytes; digest_out_done() then sets the length.
+ */
+static unsigned char *digest_out_start(SV *outV, SV *dataV, STRLEN size,
+                                       SV **retV)
+{
+    if ( outV ) {
+        STRLEN cur, need;
+
+        if ( outV == dataV )
+            croak("File::RsyncP::Digest: output can't be the input data");
+        if ( !SvOK(outV) )
+            sv_setpvn(outV, "", 0);
+        SvPV_force_nolen(outV);
+        sv_utf8_downgrade(outV, 0);
+        cur  = SvCUR(outV);
+        need = cur + size + 1;
+        if ( need > SvLEN(outV) ) {
+            /*
+             * Grow geometrically, since the caller is likely to keep
+             * appending to the same buffer.
+             */
+            if ( need < 2 * SvLEN(outV) )
+                need = 2 * SvLEN(outV);
+            SvGROW(outV, need);
+        }
+        return (unsigned char *)SvPVX(outV) + cur;
+    }
+    *retV = newSV(size + 1);
+    SvPOK_on(*retV);
+    return (unsigned char *)SvPVX(*retV);
+}
+
+/*
+ * Finish the output started with digest_out_start().  Returns the new
+ * SV, or the number of bytes appended to outV.
+ */
+static SV *digest_out_done(SV *outV, SV *retV, STRLEN size)
+{
+    if ( outV ) {
+        SvCUR_set(outV, SvCUR(outV) + size);
+        *SvEND(outV) = '\0';
+        SvSETMAGIC(outV);
+        return sv_2mortal(newSVuv(size));
+    }
+    SvCUR_set(retV, size);
+    *SvEND(retV) = '\0';
+    return sv_2mortal(retV);
+}
+
+/*
+ * An explicit undef for the optional output SV is the same as
+ * not passing one.
+ */
+#define DIGEST_OUT_ARG(sv)	((sv) && (SvOK(sv) || !SvREADONLY(sv)) \
+					? (sv) : NULL)
+
+/*
+ * Return the context of an optional File::RsyncP::Digest argument,
+ * or NULL if it is undef.
+ */
+static RsyncMD4_CTX *digest_ctx_arg(SV *sv, char *func)
+{
+    if ( !sv || !SvOK(sv) )
+	return NULL;
+    if ( !sv_derived_from(sv, "File::RsyncP::Digest") )
+	croak("%s: argument is not of type File::RsyncP::Digest", func);
+    return INT2PTR(RsyncMD4_CTX *, SvIV((SV *)SvRV(sv)));
+}
+
 
 MODULE = File::RsyncP::Digest		PACKAGE = File::RsyncP::Digest
 
@@ -135,7 +211,7 @@ digest2(context)
 	}
 
 SV *
-blockDigest(context, dataV, blockSize=700, md4DigestLen=16, seed=0)
+blockDigest(context, dataV, blockSize=700, md4DigestLen=16, seed=0, outV=NULL)
     PREINIT:
 	STRLEN len;
     INPUT:
@@ -145,38 +221,86 @@ blockDigest(context, dataV, blockSize=700, md4DigestLen=16, seed=0)
 	size_t blockSize
 	int md4DigestLen
 	unsigned int seed
+	SV *outV
     CODE:
 	{
 	    UINT4 digestSize;
 	    unsigned char *digest;
-	    extern void rsync_checksum(unsigned char *buf, UINT4 len,
-		    UINT4 blockSize, UINT4 seed, unsigned char *digest,
-		    int md4DigestLen);
+	    SV *retV = NULL;
 
 	    if ( blockSize == 0 ) blockSize = 700;
-            if ( md4DigestLen < 0 ) {
-                /* 
-                 * special case: save the entire MD4 state, so it can
-                 * be cached.  That's 4+16=20 bytes per block, plus the
-                 * used part of the 64 byte buffer.
-                 */
-                int nBlocks = (len + blockSize - 1) / blockSize;
-                digestSize = 20 * nBlocks
-                           + (nBlocks > 1 ? (blockSize % 64) * (nBlocks - 1)
-                                          : 0)
-                           + ((len % blockSize) % 64);
-            } else {
-                digestSize = (4 + (md4DigestLen > 16 ? 16 : md4DigestLen))
-				* ((len + blockSize - 1) / blockSize);
-            }
-	    digest = safemalloc(1 + digestSize);
+            /* 
+             * If md4DigestLen < 0, this is a special case: save the
+             * entire MD4 state, so it can be cached.  That's 4+16=20
+             * bytes per block, plus the used part of the 64 byte buffer.
+             */
+	    digestSize = rsync_checksum_size(len, blockSize, md4DigestLen);
+	    outV   = DIGEST_OUT_ARG(outV);
+	    digest = digest_out_start(outV, dataV, digestSize, &retV);
 	    rsync_checksum(data, len, blockSize, seed, digest, md4DigestLen);
-	    ST(0) = sv_2mortal(newSVpvn((char *)digest, digestSize));
-	    safefree(digest);
+	    ST(0) = digest_out_done(outV, retV, digestSize);
 	}
 
 SV *
-blockDigestUpdate(context, dataV, blockSize=700, blockLastLen=0, md4DigestLen=16, seed=0)
+blockDigestParallel(context, dataV, blockSize=700, md4DigestLen=16, seed=0, threads=0, outV=NULL)
+    PREINIT:
+	STRLEN len;
+    INPUT:
+	File::RsyncP::Digest	context
+	SV *dataV
+	unsigned char *data = (unsigned char *)SvPV(dataV, len);
+	size_t blockSize
+	int md4DigestLen
+	unsigned int seed
+	int threads
+	SV *outV
+    CODE:
+	{
+	    UINT4 digestSize;
+	    unsigned char *digest;
+	    SV *retV = NULL;
+
+	    if ( blockSize == 0 ) blockSize = 700;
+	    digestSize = rsync_checksum_size(len, blockSize, md4DigestLen);
+	    outV   = DIGEST_OUT_ARG(outV);
+	    digest = digest_out_start(outV, dataV, digestSize, &retV);
+	    rsync_checksum_parallel(data, len, blockSize, seed, digest,
+				    md4DigestLen, threads, NULL);
+	    ST(0) = digest_out_done(outV, retV, digestSize);
+	}
+
+SV *
+blockDigestAdd(context, dataV, blockSize=700, md4DigestLen=16, seed=0, outV=NULL)
+    PREINIT:
+	STRLEN len;
+    INPUT:
+	File::RsyncP::Digest	context
+	SV *dataV
+	unsigned char *data = (unsigned char *)SvPV(dataV, len);
+	size_t blockSize
+	int md4DigestLen
+	unsigned int seed
+	SV *outV
+    CODE:
+	{
+	    UINT4 digestSize;
+	    unsigned char *digest;
+	    SV *retV = NULL;
+
+	    /*
+	     * Same as add() followed by blockDigest(), in one pass.
+	     */
+	    if ( blockSize == 0 ) blockSize = 700;
+	    digestSize = rsync_checksum_size(len, blockSize, md4DigestLen);
+	    outV   = DIGEST_OUT_ARG(outV);
+	    digest = digest_out_start(outV, dataV, digestSize, &retV);
+	    rsync_checksum_file(data, len, blockSize, seed, digest,
+				md4DigestLen, context);
+	    ST(0) = digest_out_done(outV, retV, digestSize);
+	}
+
+SV *
+blockDigestUpdate(context, dataV, blockSize=700, blockLastLen=0, md4DigestLen=16, seed=0, outV=NULL)
     PREINIT:
 	STRLEN len;
     INPUT:
@@ -187,13 +311,12 @@ blockDigestUpdate(context, dataV, blockSize=700, blockLastLen=0, md4DigestLen=16
 	size_t blockLastLen
 	int md4DigestLen
 	unsigned int seed
+	SV *outV
     CODE:
 	{
 	    UINT4 digestSize, blockCnt;
 	    unsigned char *digest;
-	    extern void rsync_checksum_update(unsigned char *digestIn,
-		UINT4 blockCnt, UINT4 blockSize, UINT4 blockLastLen,
-		UINT4 seed, unsigned char *digestOut, int md4DigestLen);
+	    SV *retV = NULL;
 
 	    if ( blockSize == 0 ) blockSize = 700;
             /*
@@ -212,15 +335,15 @@ blockDigestUpdate(context, dataV, blockSize=700, blockLastLen=0, md4DigestLen=16
             }
 	    if ( md4DigestLen > 16 || md4DigestLen < 0 ) md4DigestLen = 16;
 	    digestSize = (4 + md4DigestLen) * blockCnt;
-	    digest = safemalloc(1 + digestSize);
+	    outV   = DIGEST_OUT_ARG(outV);
+	    digest = digest_out_start(outV, dataV, digestSize, &retV);
 	    rsync_checksum_update(data, blockCnt, blockSize, 
 		    blockLastLen, seed, digest, md4DigestLen);
-	    ST(0) = sv_2mortal(newSVpvn((char *)digest, digestSize));
-	    safefree(digest);
+	    ST(0) = digest_out_done(outV, retV, digestSize);
 	}
 
 SV *
-blockDigestExtract(context, dataV, md4DigestLen=16)
+blockDigestExtract(context, dataV, md4DigestLen=16, outV=NULL)
     PREINIT:
 	STRLEN len;
     INPUT:
@@ -228,17 +351,20 @@ blockDigestExtract(context, dataV, md4DigestLen=16)
 	SV *dataV
 	unsigned char *data = (unsigned char *)SvPV(dataV, len);
 	int md4DigestLen
+	SV *outV
     CODE:
 	{
-	    unsigned char *digest, *p;
+	    unsigned char *p;
             UINT4 blockCnt = len / 20;
             UINT4 digestSize;
+	    SV *retV = NULL;
 
             if ( md4DigestLen < 0 || md4DigestLen > 16 ) {
                 md4DigestLen = 16;
             }
 	    digestSize = (4 + md4DigestLen) * blockCnt;
-	    p = digest = safemalloc(1 + digestSize);
+	    outV = DIGEST_OUT_ARG(outV);
+	    p = digest_out_start(outV, dataV, digestSize, &retV);
             while ( blockCnt-- > 0 ) {
                 memcpy(p, data, 4);
                 p += 4;
@@ -247,6 +373,424 @@ blockDigestExtract(context, dataV, md4DigestLen=16)
                 p += md4DigestLen;
                 data += 16;
             }
-	    ST(0) = sv_2mortal(newSVpvn((char *)digest, digestSize));
-	    safefree(digest);
+	    ST(0) = digest_out_done(outV, retV, digestSize);
+	}
+
+SV *
+blockDigestFd(context, fd, blockCnt, blockSize=700, md4DigestLen=16, seed=0, fileDigestV=NULL, threads=1, outV=NULL)
+	File::RsyncP::Digest	context
+	int fd
+	UV blockCnt
+	size_t blockSize
+	int md4DigestLen
+	unsigned int seed
+	SV *fileDigestV
+	int threads
+	SV *outV
+    CODE:
+	{
+	    RsyncMD4_CTX *fileCtx;
+	    UINT4 digestSize;
+	    unsigned char *digest;
+	    fd_chunk chunk;
+	    SV *retV = NULL;
+
+	    if ( blockSize == 0 ) blockSize = 700;
+	    if ( blockCnt == 0 ) blockCnt = 100;
+	    if ( blockCnt > 0xffffffff / blockSize )
+		blockCnt = 0xffffffff / blockSize;
+	    fileCtx = digest_ctx_arg(fileDigestV,
+			    "File::RsyncP::Digest::blockDigestFd");
+	    if ( fd_chunk_get(fd, blockCnt * blockSize, &chunk) ) {
+		XSRETURN_UNDEF;
+	    }
+	    if ( chunk.len == 0 ) {
+		fd_chunk_free(&chunk);
+		XSRETURN_UNDEF;
+	    }
+	    digestSize = rsync_checksum_size(chunk.len, blockSize,
+					     md4DigestLen);
+	    outV   = DIGEST_OUT_ARG(outV);
+	    digest = digest_out_start(outV, NULL, digestSize, &retV);
+	    rsync_checksum_parallel(chunk.data, chunk.len, blockSize, seed,
+				    digest, md4DigestLen, threads, fileCtx);
+	    fd_chunk_free(&chunk);
+	    ST(0) = digest_out_done(outV, retV, digestSize);
+	}
+
+SV *
+addFd(context, fd)
+	File::RsyncP::Digest	context
+	int fd
+    CODE:
+	{
+	    fd_chunk chunk;
+	    double total = 0;
+
+	    /*
+	     * Add the rest of the file to the digest.  Returns the
+	     * number of bytes added, or undef on a read error.
+	     */
+	    for ( ;; ) {
+		if ( fd_chunk_get(fd, FD_CHUNK_MAX_LEN, &chunk) ) {
+		    XSRETURN_UNDEF;
+		}
+		if ( chunk.len == 0 )
+		    break;
+		RsyncMD4Update(context, chunk.data, chunk.len);
+		total += chunk.len;
+		fd_chunk_free(&chunk);
+	    }
+	    fd_chunk_free(&chunk);
+	    ST(0) = sv_2mortal(newSVnv(total));
+	}
+
+SV *
+copyRangeFd(context, inFd, offset, len, outFd, copyState=NULL)
+	File::RsyncP::Digest	context
+	int inFd
+	double offset
+	double len
+	int outFd
+	SV *copyState
+    CODE:
+	{
+	    /*
+	     * Copy len bytes at offset in inFd to the current offset of
+	     * outFd, adding them to the digest.  If outFd is -1 the
+	     * data is just added to the digest.  copyState, if given,
+	     * is updated with the kernel copies that failed, so they
+	     * aren't retried for the same output file.  Returns the
+	     * number of bytes copied, or undef on error.
+	     */
+	    int state = copyState && SvOK(copyState) ? SvIV(copyState) : 0;
+	    int err   = offset < 0 || len < 0
+		    || fd_copy_range(inFd, (off_t)offset, (off_t)len, outFd,
+				     context, &state);
+
+	    if ( copyState && !SvREADONLY(copyState) )
+		sv_setiv(copyState, state);
+	    if ( err ) {
+		XSRETURN_UNDEF;
+	    }
+	    ST(0) = sv_2mortal(newSVnv(len));
+	}
+
+SV *
+literalFd(context, fd, maxLen=262144)
+	File::RsyncP::Digest	context
+	int fd
+	UV maxLen
+    CODE:
+	{
+	    fd_chunk chunk;
+	    unsigned char *p;
+	    SV *out;
+
+	    /*
+	     * Read up to maxLen bytes from fd, add them to the digest
+	     * and return them as an rsync literal data token (a 4 byte
+	     * length and the data), ie: pack("V a*", length($d), $d).
+	     * Returns undef at EOF or on a read error.
+	     */
+	    if ( maxLen > FD_CHUNK_MAX_LEN )
+		maxLen = FD_CHUNK_MAX_LEN;
+	    if ( fd_chunk_get(fd, maxLen, &chunk) || chunk.len == 0 ) {
+		fd_chunk_free(&chunk);
+		XSRETURN_UNDEF;
+	    }
+	    RsyncMD4Update(context, chunk.data, chunk.len);
+	    /*
+	     * Leave room after the string so perl can share the buffer
+	     * (copy-on-write) when it is queued for writing.
+	     */
+	    out = newSV(chunk.len + 8);
+	    SvPOK_only(out);
+	    p = (unsigned char *)SvPVX(out);
+	    p[0] = chunk.len & 0xff;
+	    p[1] = (chunk.len >> 8) & 0xff;
+	    p[2] = (chunk.len >> 16) & 0xff;
+	    p[3] = (chunk.len >> 24) & 0xff;
+	    memcpy(p + 4, chunk.data, chunk.len);
+	    SvCUR_set(out, chunk.len + 4);
+	    *SvEND(out) = '\0';
+	    fd_chunk_free(&chunk);
+	    ST(0) = sv_2mortal(out);
+	}
+
+void
+adler32Kernels(packname = "File::RsyncP::Digest")
+	char *packname
+    PPCODE:
+	{
+	    char *name;
+	    int i;
+
+	    for ( i = 0 ; (name = adler32_kernel_name(i)) ; i++ ) {
+		XPUSHs(sv_2mortal(newSVpv(name, 0)));
+	    }
+	}
+
+int
+adler32KernelSet(packname = "File::RsyncP::Digest", name = NULL)
+	char *packname
+	char *name
+    CODE:
+	{
+	    RETVAL = adler32_kernel_set(name) == 0;
+	}
+    OUTPUT:
+	RETVAL
+
+void
+md4Kernels(packname = "File::RsyncP::Digest")
+	char *packname
+    PPCODE:
+	{
+	    char *name;
+	    int i;
+
+	    for ( i = 0 ; (name = md4_mb_kernel_name(i)) ; i++ ) {
+		XPUSHs(sv_2mortal(newSVpv(name, 0)));
+	    }
+	}
+
+int
+md4KernelSet(packname = "File::RsyncP::Digest", name = NULL)
+	char *packname
+	char *name
+    CODE:
+	{
+	    RETVAL = md4_mb_kernel_set(name) == 0;
 	}
+    OUTPUT:
+	RETVAL
+
+void
+adler32Start(context, dataV)
+    PREINIT:
+	STRLEN len;
+    INPUT:
+	File::RsyncP::Digest	context
+	SV *dataV
+	unsigned char *data = (unsigned char *)SvPV(dataV, len);
+    PPCODE:
+	{
+	    UINT4 s1, s2;
+
+	    adler32_parts((char *)data, len, &s1, &s2);
+	    EXTEND(SP, 2);
+	    PUSHs(sv_2mortal(newSVuv(s1 & 0xffffffff)));
+	    PUSHs(sv_2mortal(newSVuv(s2 & 0xffffffff)));
+	}
+
+void
+adler32Roll(context, s1, s2, len, outV=&PL_sv_undef, inV=&PL_sv_undef)
+	File::RsyncP::Digest	context
+	UV s1
+	UV s2
+	UV len
+	SV *outV
+	SV *inV
+    PPCODE:
+	{
+	    /*
+	     * An undefined out byte grows the window by one; an undefined
+	     * in byte shrinks it by one.
+	     */
+	    UINT4 r1 = s1, r2 = s2;
+	    STRLEN l;
+	    int haveOut, haveIn;
+	    signed char out, in;
+
+	    SvGETMAGIC(outV);
+	    SvGETMAGIC(inV);
+	    haveOut = SvOK(outV);
+	    haveIn  = SvOK(inV);
+	    out = haveOut ? *(signed char *)SvPV_nomg(outV, l) : 0;
+	    in  = haveIn  ? *(signed char *)SvPV_nomg(inV, l)  : 0;
+
+	    if ( haveOut && haveIn ) {
+		ADLER32_ROLL(r1, r2, len, out, in);
+	    } else if ( haveIn ) {
+		ADLER32_ROLL_IN(r1, r2, in);
+	    } else if ( haveOut ) {
+		ADLER32_ROLL_OUT(r1, r2, len, out);
+	    }
+	    EXTEND(SP, 2);
+	    PUSHs(sv_2mortal(newSVuv(r1 & 0xffffffff)));
+	    PUSHs(sv_2mortal(newSVuv(r2 & 0xffffffff)));
+	}
+
+UV
+adler32Sum(context, s1, s2)
+	File::RsyncP::Digest	context
+	UV s1
+	UV s2
+    CODE:
+	{
+	    RETVAL = ADLER32_SUM(s1, s2);
+	}
+    OUTPUT:
+	RETVAL
+
+SV *
+adler32Scan(context, dataV, blockSize, sumsV, stride=4)
+    PREINIT:
+	STRLEN len, sumsLen;
+    INPUT:
+	File::RsyncP::Digest	context
+	SV *dataV
+	unsigned char *data = (unsigned char *)SvPV(dataV, len);
+	size_t blockSize
+	SV *sumsV
+	unsigned char *sums = (unsigned char *)SvPV(sumsV, sumsLen);
+	size_t stride
+    CODE:
+	{
+	    adler32_set *set;
+	    adler32_scan_state state;
+	    UINT4 result[2 * 1024];
+	    SV *out = newSVpvn("", 0);
+
+	    if ( stride < 4 ) stride = 4;
+	    if ( !(set = adler32_set_new(sums, sumsLen / stride, stride)) ) {
+		croak("File::RsyncP::Digest::adler32Scan: out of memory");
+	    }
+	    memset(&state, 0, sizeof(state));
+	    while ( blockSize > 0 && state.offset + blockSize <= len ) {
+		UINT4 i, n = adler32_scan((char *)data, len, blockSize, set,
+					  &state, result, 1024);
+		for ( i = 0 ; i < 2 * n ; i++ ) {
+		    unsigned char buf[4];
+
+		    RsyncMD4Encode(buf, &result[i], 4);
+		    sv_catpvn(out, (char *)buf, 4);
+		}
+	    }
+	    adler32_set_free(set);
+	    ST(0) = sv_2mortal(out);
+	}
+
+File::RsyncP::Digest::Delta
+deltaNew(context, sumsV, blockSize=700, remainder=0, csumLen=16, seed=0)
+    PREINIT:
+	STRLEN len;
+    INPUT:
+	File::RsyncP::Digest	context
+	SV *sumsV
+	unsigned char *sums = (unsigned char *)SvPV(sumsV, len);
+	size_t blockSize
+	size_t remainder
+	int csumLen
+	unsigned int seed
+    CODE:
+	{
+	    if ( csumLen < 0 || csumLen > 16 ) csumLen = 16;
+	    RETVAL = rsync_delta_new(sums, len / (4 + csumLen), blockSize,
+			    remainder, csumLen, seed, context->rsyncMD4Bug);
+	    if ( !RETVAL ) {
+		croak("File::RsyncP::Digest::deltaNew: out of memory");
+	    }
+	}
+    OUTPUT:
+	RETVAL
+
+SV *
+matchTokens(packname = "File::RsyncP::Digest", blk, cnt, outV=NULL)
+	char *packname
+	UV blk
+	UV cnt
+	SV *outV
+    CODE:
+	{
+	    unsigned char *out;
+	    SV *retV = NULL;
+
+	    /*
+	     * Return (or append to outV) the match tokens for blocks
+	     * blk .. blk + cnt - 1.
+	     */
+	    PERL_UNUSED_VAR(packname);
+	    outV = DIGEST_OUT_ARG(outV);
+	    out  = digest_out_start(outV, NULL, 4 * cnt, &retV);
+	    rsync_match_tokens(out, blk, cnt);
+	    ST(0) = digest_out_done(outV, retV, 4 * cnt);
+	}
+
+int
+prefetchFile(packname = "File::RsyncP::Digest", path, len = 0)
+	char *packname
+	char *path
+	double len
+    CODE:
+	{
+	    /*
+	     * Start reading the file into the page cache.  Returns 1 if
+	     * the hint was given.
+	     */
+	    PERL_UNUSED_VAR(packname);
+	    RETVAL = len >= 0 && fd_prefetch(path, (off_t)len) == 0;
+	}
+    OUTPUT:
+	RETVAL
+
+
+MODULE = File::RsyncP::Digest		PACKAGE = File::RsyncP::Digest::Delta
+
+void
+DESTROY(delta)
+	File::RsyncP::Digest::Delta	delta
+    CODE:
+	{
+	    rsync_delta_free(delta);
+	}
+
+SV *
+add(delta, dataV)
+    PREINIT:
+	STRLEN len;
+    INPUT:
+	File::RsyncP::Digest::Delta	delta
+	SV *dataV
+	unsigned char *data = (unsigned char *)SvPV(dataV, len);
+    CODE:
+	{
+	    if ( rsync_delta_add(delta, data, len) ) {
+		croak("File::RsyncP::Digest::Delta::add: out of memory");
+	    }
+	    ST(0) = sv_2mortal(newSVpvn((char *)delta->out, delta->outLen));
+	    delta->outLen = 0;
+	}
+
+SV *
+finish(delta)
+	File::RsyncP::Digest::Delta	delta
+    CODE:
+	{
+	    if ( rsync_delta_finish(delta) ) {
+		croak("File::RsyncP::Digest::Delta::finish: out of memory");
+	    }
+	    ST(0) = sv_2mortal(newSVpvn((char *)delta->out, delta->outLen));
+	    delta->outLen = 0;
+	}
+
+unsigned int
+matchCnt(delta)
+	File::RsyncP::Digest::Delta	delta
+    CODE:
+	{
+	    RETVAL = delta->matchCnt;
+	}
+    OUTPUT:
+	RETVAL
+
+double
+literalBytes(delta)
+	File::RsyncP::Digest::Delta	delta
+    CODE:
+	{
+	    RETVAL = delta->literalBytes;
+	}
+    OUTPUT:
+	RETVAL
@@ -0,0 +1,243 @@
+/*
+ * Adler32 checksum kernels for File::RsyncP.
+ *
+ * rsync's adler32 variant treats the data as signed chars (with
+ * CHAR_OFFSET 0) and keeps two 32 bit running sums:
+ *
+ *     s1 += buf[i];  s2 += s1;
+ *
+ * For a chunk of L bytes c[0..L-1] this is the same as
+ *
+ *     s2 += L * s1 + sum((L - i) * c[i]);  s1 += sum(c[i]);
+ *
+ * which is what the SIMD kernels compute, 16 (SSE2) or 32 (AVX2)
+ * bytes at a time.  All the arithmetic is modulo 2^32, so the
+ * results are bit-exact with the scalar version.  The fastest
+ * kernel supported by the CPU is picked at run time.
+ *
+ * Copyright (C) 2002-2010 Craig Barratt.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "global.h"
+#include "md4.h"
+#include "rsync_lib.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+        && !defined(RSYNCP_NO_SIMD)
+#define ADLER32_X86 1
+#include <immintrin.h>
+#endif
+
+/*
+ * CHAR_OFFSET is 0 for rsync, and 31 for librsync.
+ */
+#define CHAR_OFFSET 0
+
+/*
+ * Portable version; this is the original loop from adler32_checksum().
+ */
+static void adler32_update_c(signed char *buf, UINT4 len,
+			     UINT4 *s1p, UINT4 *s2p)
+{
+    UINT4 i, s1 = *s1p, s2 = *s2p;
+
+    for ( i = 0 ; i + 4 < len ; i += 4 ) {
+        s2 += 4 * (s1 + buf[i]) + 3 * buf[i+1] + 2 * buf[i+2] + buf[i+3] +
+	      10 * CHAR_OFFSET;
+        s1 += (buf[i+0] + buf[i+1] + buf[i+2] + buf[i+3] + 4 * CHAR_OFFSET);
+    }
+    for ( ; i < len ; i++ ) {
+        s1 += (buf[i] + CHAR_OFFSET);
+	s2 += s1;
+    }
+    *s1p = s1;
+    *s2p = s2;
+}
+
+#ifdef ADLER32_X86
+
+/*
+ * Horizontal sum of four 32 bit lanes
+ */
+__attribute__((target("sse2")))
+static UINT4 adler32_hsum128(__m128i v)
+{
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(1, 0, 3, 2)));
+    v = _mm_add_epi32(v, _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (UINT4)(unsigned int)_mm_cvtsi128_si32(v);
+}
+
+/*
+ * SSE2: 16 bytes per iteration.  The bytes are sign extended to
+ * 16 bits and multiplied/added into 32 bit lanes with pmaddwd.
+ */
+__attribute__((target("sse2")))
+static void adler32_update_sse2(signed char *buf, UINT4 len,
+				UINT4 *s1p, UINT4 *s2p)
+{
+    UINT4 s1 = *s1p, s2 = *s2p, n = len / 16, i;
+    const __m128i wLo  = _mm_setr_epi16(16, 15, 14, 13, 12, 11, 10, 9);
+    const __m128i wHi  = _mm_setr_epi16(8, 7, 6, 5, 4, 3, 2, 1);
+    const __m128i ones = _mm_set1_epi16(1);
+    __m128i vs1 = _mm_setzero_si128();	/* sum of bytes */
+    __m128i vps = _mm_setzero_si128();	/* sum of vs1 before each chunk */
+    __m128i vs2 = _mm_setzero_si128();	/* weighted sum of bytes */
+
+    if ( n == 0 ) {
+        adler32_update_c(buf, len, s1p, s2p);
+        return;
+    }
+    for ( i = 0 ; i < n ; i++ ) {
+        __m128i v  = _mm_loadu_si128((const __m128i *)(buf + 16 * i));
+        __m128i lo = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+        __m128i hi = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+
+        vps = _mm_add_epi32(vps, vs1);
+        vs1 = _mm_add_epi32(vs1, _mm_madd_epi16(_mm_add_epi16(lo, hi), ones));
+        vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(lo, wLo));
+        vs2 = _mm_add_epi32(vs2, _mm_madd_epi16(hi, wHi));
+    }
+    s2 += 16 * n * s1 + 16 * adler32_hsum128(vps) + adler32_hsum128(vs2);
+    s1 += adler32_hsum128(vs1);
+    *s1p = s1;
+    *s2p = s2;
+    if ( len > 16 * n )
+        adler32_update_c(buf + 16 * n, len - 16 * n, s1p, s2p);
+}
+
+/*
+ * AVX2: 32 bytes per iteration using pmaddubsw with unsigned weights
+ * and signed data (the pair sums fit easily in 16 bits).
+ */
+__attribute__((target("avx2")))
+static UINT4 adler32_hsum256(__m256i v)
+{
+    __m128i x = _mm_add_epi32(_mm256_castsi256_si128(v),
+                              _mm256_extracti128_si256(v, 1));
+
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2)));
+    x = _mm_add_epi32(x, _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1)));
+    return (UINT4)(unsigned int)_mm_cvtsi128_si32(x);
+}
+
+__attribute__((target("avx2")))
+static void adler32_update_avx2(signed char *buf, UINT4 len,
+				UINT4 *s1p, UINT4 *s2p)
+{
+    UINT4 s1 = *s1p, s2 = *s2p, n = len / 32, i;
+    const __m256i w = _mm256_setr_epi8(32, 31, 30, 29, 28, 27, 26, 25,
+                                       24, 23, 22, 21, 20, 19, 18, 17,
+                                       16, 15, 14, 13, 12, 11, 10, 9,
+                                       8, 7, 6, 5, 4, 3, 2, 1);
+    const __m256i ones8  = _mm256_set1_epi8(1);
+    const __m256i ones16 = _mm256_set1_epi16(1);
+    __m256i vs1 = _mm256_setzero_si256();
+    __m256i vps = _mm256_setzero_si256();
+    __m256i vs2 = _mm256_setzero_si256();
+
+    if ( n == 0 ) {
+        adler32_update_sse2(buf, len, s1p, s2p);
+        return;
+    }
+    for ( i = 0 ; i < n ; i++ ) {
+        __m256i v = _mm256_loadu_si256((const __m256i *)(buf + 32 * i));
+
+        vps = _mm256_add_epi32(vps, vs1);
+        vs1 = _mm256_add_epi32(vs1, _mm256_madd_epi16(
+                        _mm256_maddubs_epi16(ones8, v), ones16));
+        vs2 = _mm256_add_epi32(vs2, _mm256_madd_epi16(
+                        _mm256_maddubs_epi16(w, v), ones16));
+    }
+    s2 += 32 * n * s1 + 32 * adler32_hsum256(vps) + adler32_hsum256(vs2);
+    s1 += adler32_hsum256(vs1);
+    *s1p = s1;
+    *s2p = s2;
+    if ( len > 32 * n )
+        adler32_update_sse2(buf + 32 * n, len - 32 * n, s1p, s2p);
+}
+
+#endif /* ADLER32_X86 */
+
+typedef void (*adler32_kernel)(signed char *, UINT4, UINT4 *, UINT4 *);
+
+static struct {
+    char *name;
+    adler32_kernel func;
+} adler32_kernels[] = {
+    { "c",    adler32_update_c },
+#ifdef ADLER32_X86
+    { "sse2", adler32_update_sse2 },
+    { "avx2", adler32_update_avx2 },
+#endif
+};
+
+#define ADLER32_NKERNELS	((int)(sizeof(adler32_kernels) \
+				      / sizeof(adler32_kernels[0])))
+
+static adler32_kernel adler32_update_func;
+
+/*
+ * Returns non-zero if the CPU can run the i'th kernel.
+ */
+static int adler32_kernel_ok(int i)
+{
+#ifdef ADLER32_X86
+    __builtin_cpu_init();
+    if ( adler32_kernels[i].func == adler32_update_sse2 )
+        return __builtin_cpu_supports("sse2");
+    if ( adler32_kernels[i].func == adler32_update_avx2 )
+        return __builtin_cpu_supports("avx2");
+#endif
+    return i >= 0 && i < ADLER32_NKERNELS;
+}
+
+/*
+ * Return the name of the n'th kernel supported by this CPU (the
+ * last one is the fastest, and is the default), or NULL if there
+ * are fewer than n + 1.
+ */
+char *adler32_kernel_name(int n)
+{
+    int i;
+
+    for ( i = 0 ; i < ADLER32_NKERNELS ; i++ ) {
+        if ( adler32_kernel_ok(i) && n-- == 0 )
+            return adler32_kernels[i].name;
+    }
+    return NULL;
+}
+
+/*
+ * Select the kernel called name.  If name is NULL the fastest one is
+ * selected.  Returns 0 on success, -1 if name is not supported.
+ */
+int adler32_kernel_set(char *name)
+{
+    int i;
+
+    for ( i = ADLER32_NKERNELS - 1 ; i >= 0 ; i-- ) {
+        if ( !adler32_kernel_ok(i) )
+            continue;
+        if ( !name || !strcmp(name, adler32_kernels[i].name) ) {
+            adler32_update_func = adler32_kernels[i].func;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Add len bytes of buf to the adler32 halves *s1p and *s2p.
+ */
+void adler32_update(char *buf, UINT4 len, UINT4 *s1p, UINT4 *s2p)
+{
+    if ( !adler32_update_func )
+        adler32_kernel_set(NULL);
+    (*adler32_update_func)((signed char *)buf, len, s1p, s2p);
+}
@@ -0,0 +1,60 @@
+#!/bin/perl
+#
+# Microbenchmark for the fused block + file digest.  Compares
+#
+#     $md4->add($data); $md4->blockDigest($data, ...)
+#
+# with the single pass
+#
+#     $md4->blockDigestAdd($data, ...)
+#
+# and reports the time per byte for each.  If the CPU clock rate
+# is given (in GHz) the cycles per byte are shown too.
+#
+# Usage: perl -Mblib bench/fused.pl [MBytes [GHz]]
+#
+use strict;
+use File::RsyncP::Digest;
+use Time::HiRes qw(time);
+
+my $mbytes = $ARGV[0] || 64;
+my $ghz    = $ARGV[1];
+my $data   = join("", map { chr(int(rand(256))) } (1..65536))
+           x int($mbytes * 16);
+my $md4    = File::RsyncP::Digest->new(28);
+
+sub bench
+{
+    my($name, $sub) = @_;
+    my $best;
+
+    for ( my $i = 0 ; $i < 5 ; $i++ ) {
+        my $t0 = time;
+        &$sub();
+        my $t = time - $t0;
+        $best = $t if ( !defined($best) || $t < $best );
+    }
+    my $ns = 1e9 * $best / length($data);
+    printf("%-32s %6.3f ns/byte %8.1f MB/s", $name, $ns,
+                length($data) / $best / 1e6);
+    printf(" %6.3f cycles/byte", $ns * $ghz) if ( $ghz );
+    print("\n");
+    return $ns;
+}
+
+foreach my $blockSize ( 700, 2048, 16384 ) {
+    foreach my $md4DigestLen ( 16, 0 ) {
+        print("blockSize $blockSize, md4DigestLen $md4DigestLen:\n");
+        my $sep = bench("  add + blockDigest", sub {
+            $md4->reset;
+            $md4->add($data);
+            $md4->blockDigest($data, $blockSize, $md4DigestLen, 1);
+        });
+        my $fused = bench("  blockDigestAdd", sub {
+            $md4->reset;
+            $md4->blockDigestAdd($data, $blockSize, $md4DigestLen, 1);
+        });
+        printf("  saved %.3f ns/byte (%.1f%%)\n", $sep - $fused,
+                    100 * ($sep - $fused) / $sep);
+    }
+}
@@ -0,0 +1,383 @@
+/*
+ * Rsync sender-side delta generation for File::RsyncP.
+ *
+ * This is the equivalent of rsync's match.c: the block checksums
+ * sent by the remote generator are put in a hash table keyed on
+ * the adler32 checksum, and a rolling adler32 window is slid over
+ * the local file.  Each candidate is confirmed with the (truncated)
+ * MD4 block checksum before a match token is emitted.
+ *
+ * Copyright (C) 2002-2010 Craig Barratt.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "global.h"
+#include "md4.h"
+#include "rsync_lib.h"
+#include "delta.h"
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Hash table index: the top 24 bits of a multiplicative hash of
+ * the adler32 sum (the table has at most 1 << 24 entries).
+ */
+#define HASH32(sum)	((((UINT4)(sum) * (UINT4)0x9e3779b1) & 0xffffffff) >> 8)
+
+/*
+ * Make sure there is room for len more bytes in the output buffer.
+ */
+static int delta_out_room(rsync_delta *d, UINT4 len)
+{
+    unsigned char *p;
+    UINT4 size;
+
+    if ( d->outLen + len <= d->outSize )
+        return 0;
+    size = d->outSize ? d->outSize : 4096;
+    while ( size < d->outLen + len )
+        size *= 2;
+    if ( !(p = realloc(d->out, size)) )
+        return -1;
+    d->out = p;
+    d->outSize = size;
+    return 0;
+}
+
+static int delta_out_int(rsync_delta *d, UINT4 x)
+{
+    if ( delta_out_room(d, 4) )
+        return -1;
+    RsyncMD4Encode(d->out + d->outLen, &x, 4);
+    d->outLen += 4;
+    return 0;
+}
+
+/*
+ * Emit the pending literal data up to end as one or more
+ * literal tokens.
+ */
+static int delta_literal(rsync_delta *d, UINT4 end)
+{
+    while ( d->litStart < end ) {
+        UINT4 n = end - d->litStart;
+
+        if ( n > DELTA_CHUNK_SIZE )
+            n = DELTA_CHUNK_SIZE;
+        if ( delta_out_int(d, n) || delta_out_room(d, n) )
+            return -1;
+        memcpy(d->out + d->outLen, d->buf + d->litStart, n);
+        d->outLen       += n;
+        d->litStart     += n;
+        d->literalBytes += n;
+    }
+    return 0;
+}
+
+/*
+ * Write the match tokens for the cnt blocks starting at blk to out,
+ * which must have room for 4 * cnt bytes.
+ */
+void rsync_match_tokens(unsigned char *out, UINT4 blk, UINT4 cnt)
+{
+    UINT4 i;
+
+    for ( i = 0 ; i < cnt ; i++, out += 4 ) {
+        UINT4 x = ~(blk + i);
+
+        out[0] = x & 0xff;
+        out[1] = (x >> 8) & 0xff;
+        out[2] = (x >> 16) & 0xff;
+        out[3] = (x >> 24) & 0xff;
+    }
+}
+
+/*
+ * After a match the local file usually continues with the following
+ * remote blocks.  Check the next full blocks in the buffer against
+ * blocks wantBlk, wantBlk + 1, ... directly, hashing up to
+ * MD4_MB_LANES of them at once, and emit the run of matches as one
+ * piece of output.  The result is the same as matching the blocks one
+ * at a time, since delta_match() prefers wantBlk.  Returns the number
+ * of blocks matched, or -1 if out of memory.
+ */
+static long delta_run(rsync_delta *d)
+{
+    unsigned char *data[MD4_MB_LANES];
+    unsigned char digest[MD4_MB_LANES][16];
+    unsigned char seedBytes[4];
+    UINT4 state[MD4_MB_LANES][4];
+    UINT4 lanes = md4_mb_lanes(), n, i;
+
+    for ( n = 0 ; n < lanes ; n++ ) {
+        UINT4 blk = d->wantBlk + n;
+        UINT4 s1, s2;
+
+        if ( blk >= d->blkCnt
+                || (blk == d->blkCnt - 1 && d->lastLen != d->blkSize)
+                || d->pos + (n + 1) * d->blkSize > d->bufLen )
+            break;
+        data[n] = d->buf + d->pos + n * d->blkSize;
+        adler32_parts((char *)data[n], d->blkSize, &s1, &s2);
+        if ( n == 0 ) {
+            /*
+             * This is the window delta_scan() checks next
+             */
+            d->s1 = s1;
+            d->s2 = s2;
+            d->sumValid = 1;
+        }
+        if ( ADLER32_SUM(s1, s2) != d->sum1[blk] )
+            break;
+    }
+    if ( n < 2 )
+        return 0;
+    if ( d->seed )
+        RsyncMD4Encode(seedBytes, &d->seed, 4);
+    md4_mb_init(state, n);
+    md4_mb_final(state, data, n, d->blkSize, 0, d->seed ? seedBytes : NULL,
+                 d->rsyncMD4Bug, digest);
+    for ( i = 0 ; i < n ; i++ ) {
+        if ( memcmp(digest[i], d->sum2 + (d->wantBlk + i) * d->csumLen,
+                    d->csumLen) )
+            break;
+    }
+    if ( i == 0 )
+        return 0;
+    if ( delta_out_room(d, 4 * i) )
+        return -1;
+    rsync_match_tokens(d->out + d->outLen, d->wantBlk, i);
+    d->outLen   += 4 * i;
+    d->matchCnt += i;
+    d->wantBlk  += i;
+    d->pos      += i * d->blkSize;
+    d->litStart  = d->pos;
+    d->sumValid  = 0;
+    return i;
+}
+
+/*
+ * Look for a remote block matching the window of length len at d->pos.
+ * Returns the block number, or -1 if there is no match.  Like rsync,
+ * the block following the previous match is preferred if several
+ * blocks have the same checksums.
+ */
+static long delta_match(rsync_delta *d, UINT4 len)
+{
+    UINT4 sum = ADLER32_SUM(d->s1, d->s2);
+    UINT4 i = d->hashHead[HASH32(sum) & d->hashMask];
+    unsigned char md4Digest[16];
+    int haveDigest = 0;
+    long found = -1;
+
+    for ( ; i ; i = d->hashNext[i - 1] ) {
+        UINT4 blk = i - 1;
+
+        if ( d->sum1[blk] != sum
+                || len != (blk == d->blkCnt - 1 ? d->lastLen : d->blkSize) )
+            continue;
+        if ( !haveDigest ) {
+            RsyncMD4_CTX md4;
+
+            RsyncMD4Init(&md4);
+            md4.rsyncMD4Bug = d->rsyncMD4Bug;
+            RsyncMD4Update(&md4, d->buf + d->pos, len);
+            if ( d->seed ) {
+                unsigned char seedBytes[4];
+
+                RsyncMD4Encode(seedBytes, &d->seed, 4);
+                RsyncMD4Update(&md4, seedBytes, 4);
+            }
+            RsyncMD4FinalRsync(md4Digest, &md4);
+            haveDigest = 1;
+        }
+        if ( memcmp(md4Digest, d->sum2 + blk * d->csumLen, d->csumLen) )
+            continue;
+        if ( blk == d->wantBlk )
+            return blk;
+        if ( found < 0 )
+            found = blk;
+    }
+    return found;
+}
+
+/*
+ * Scan the buffered data.  If final is zero, only full-size windows
+ * are considered and the scan stops when there is not enough data
+ * for the next one.  If final is set, this is the end of the file:
+ * the window shrinks down to the length of the last remote block,
+ * and whatever is left over is sent as literal data.
+ */
+static int delta_scan(rsync_delta *d, int final)
+{
+    signed char *buf = (signed char *)d->buf;
+
+    while ( d->blkCnt > 0 && d->pos < d->bufLen ) {
+        UINT4 len = d->bufLen - d->pos;
+        long blk;
+
+        if ( len > d->blkSize ) {
+            len = d->blkSize;
+        } else if ( len < d->blkSize && !final ) {
+            break;
+        }
+        if ( len < d->lastLen )
+            break;
+        if ( !d->sumValid && d->litStart == d->pos ) {
+            long n = delta_run(d);
+
+            if ( n < 0 )
+                return -1;
+            if ( n > 0 )
+                continue;
+        }
+        if ( !d->sumValid ) {
+            adler32_parts((char *)buf + d->pos, len, &d->s1, &d->s2);
+            d->sumValid = 1;
+        }
+        if ( (blk = delta_match(d, len)) >= 0 ) {
+            if ( delta_literal(d, d->pos) || delta_out_int(d, ~(UINT4)blk) )
+                return -1;
+            d->matchCnt++;
+            d->wantBlk  = blk + 1;
+            d->pos     += len;
+            d->litStart = d->pos;
+            d->sumValid = 0;
+            continue;
+        }
+
+        /*
+         * No match: roll the window forward one byte.  Without a new
+         * byte to add we can only continue if this is the end of file,
+         * in which case the window shrinks.
+         */
+        if ( d->pos + len < d->bufLen ) {
+            ADLER32_ROLL(d->s1, d->s2, len, buf[d->pos], buf[d->pos + len]);
+        } else if ( final ) {
+            ADLER32_ROLL_OUT(d->s1, d->s2, len, buf[d->pos]);
+        } else {
+            break;
+        }
+        d->pos++;
+        if ( d->pos - d->litStart >= DELTA_CHUNK_SIZE
+                && delta_literal(d, d->pos) )
+            return -1;
+    }
+    if ( final ) {
+        d->pos = d->bufLen;
+        return delta_literal(d, d->bufLen);
+    }
+    if ( d->blkCnt == 0 && delta_literal(d, d->bufLen) )
+        return -1;
+    return 0;
+}
+
+/*
+ * Create a delta context from the remote block checksums in sums,
+ * which contains blkCnt entries of 4 + csumLen bytes (adler32 followed
+ * by the truncated MD4).  remainder is the length of the last block;
+ * zero means it is a full block.  Returns NULL if out of memory.
+ */
+rsync_delta *rsync_delta_new(unsigned char *sums, UINT4 blkCnt,
+		UINT4 blkSize, UINT4 remainder, int csumLen, UINT4 seed,
+		int rsyncMD4Bug)
+{
+    rsync_delta *d;
+    UINT4 i, hashSize;
+
+    if ( csumLen > 16 ) csumLen = 16;
+    if ( csumLen < 0 )  csumLen = 0;
+    if ( !(d = calloc(1, sizeof(*d))) )
+        return NULL;
+    d->blkCnt      = blkCnt;
+    d->blkSize     = blkSize ? blkSize : 700;
+    d->lastLen     = remainder ? remainder : d->blkSize;
+    d->seed        = seed;
+    d->csumLen     = csumLen;
+    d->rsyncMD4Bug = rsyncMD4Bug;
+    for ( hashSize = 1024 ; hashSize < 2 * blkCnt && hashSize < (1 << 24) ; )
+        hashSize *= 2;
+    d->hashMask = hashSize - 1;
+    d->sum1     = malloc((blkCnt ? blkCnt : 1) * sizeof(UINT4));
+    d->sum2     = malloc((blkCnt ? blkCnt : 1) * (csumLen ? csumLen : 1));
+    d->hashHead = calloc(hashSize, sizeof(UINT4));
+    d->hashNext = malloc((blkCnt ? blkCnt : 1) * sizeof(UINT4));
+    if ( !d->sum1 || !d->sum2 || !d->hashHead || !d->hashNext ) {
+        rsync_delta_free(d);
+        return NULL;
+    }
+    for ( i = 0 ; i < blkCnt ; i++ ) {
+        unsigned char *p = sums + i * (4 + csumLen);
+
+        RsyncMD4Decode(&d->sum1[i], p, 4);
+        memcpy(d->sum2 + i * csumLen, p + 4, csumLen);
+    }
+    /*
+     * Insert in reverse order so each chain is in ascending block order
+     */
+    for ( i = blkCnt ; i-- > 0 ; ) {
+        UINT4 h = HASH32(d->sum1[i]) & d->hashMask;
+
+        d->hashNext[i] = d->hashHead[h];
+        d->hashHead[h] = i + 1;
+    }
+    return d;
+}
+
+/*
+ * Add the next len bytes of local file data.  Any tokens that can
+ * be generated are appended to d->out.  Returns 0 on success and
+ * -1 if out of memory.
+ */
+int rsync_delta_add(rsync_delta *d, unsigned char *data, UINT4 len)
+{
+    /*
+     * Discard the data we have already sent
+     */
+    if ( d->litStart > 0 ) {
+        memmove(d->buf, d->buf + d->litStart, d->bufLen - d->litStart);
+        d->bufLen -= d->litStart;
+        d->pos    -= d->litStart;
+        d->litStart = 0;
+    }
+    if ( d->bufLen + len > d->bufSize ) {
+        unsigned char *p;
+        UINT4 size = d->bufSize ? d->bufSize : 65536;
+
+        while ( size < d->bufLen + len )
+            size *= 2;
+        if ( !(p = realloc(d->buf, size)) )
+            return -1;
+        d->buf = p;
+        d->bufSize = size;
+    }
+    memcpy(d->buf + d->bufLen, data, len);
+    d->bufLen += len;
+    return delta_scan(d, 0);
+}
+
+/*
+ * Finish the delta at the end of the local file.  Returns 0 on
+ * success and -1 if out of memory.
+ */
+int rsync_delta_finish(rsync_delta *d)
+{
+    return delta_scan(d, 1);
+}
+
+void rsync_delta_free(rsync_delta *d)
+{
+    if ( !d )
+        return;
+    free(d->sum1);
+    free(d->sum2);
+    free(d->hashHead);
+    free(d->hashNext);
+    free(d->buf);
+    free(d->out);
+    free(d);
+}
@@ -0,0 +1,54 @@
+/*
+ * Rsync sender-side delta generation.
+ *
+ * Given the block checksums received from the remote generator, the
+ * local file data is scanned with a rolling adler32 window and turned
+ * into a stream of rsync tokens: literal runs (a positive 32 bit
+ * length followed by the data) and block matches (-(blockNum+1)).
+ * The caller is responsible for the terminating 0 token and the file
+ * MD4 digest.
+ */
+
+/*
+ * Maximum length of a single literal token (same as rsync's CHUNK_SIZE).
+ */
+#define DELTA_CHUNK_SIZE	(32 * 1024)
+
+typedef struct {
+    UINT4 blkCnt;		/* number of remote blocks */
+    UINT4 blkSize;		/* remote block size */
+    UINT4 lastLen;		/* length of the last remote block */
+    UINT4 seed;			/* checksum seed */
+    int csumLen;		/* strong checksum length (<= 16) */
+    unsigned char rsyncMD4Bug;	/* MD4 finalization for protocol <= 26 */
+
+    UINT4 *sum1;		/* remote adler32 checksums */
+    unsigned char *sum2;	/* remote MD4 checksums, csumLen each */
+    UINT4 hashMask;		/* hash table size - 1 */
+    UINT4 *hashHead;		/* block number + 1 of first block in chain */
+    UINT4 *hashNext;		/* block number + 1 of next block in chain */
+
+    unsigned char *buf;		/* unprocessed local data */
+    UINT4 bufLen;
+    UINT4 bufSize;
+    UINT4 litStart;		/* start of pending literal data in buf */
+    UINT4 pos;			/* start of current window in buf */
+    UINT4 s1, s2;		/* rolling checksum of the current window */
+    int sumValid;		/* s1, s2 are valid for the window at pos */
+    UINT4 wantBlk;		/* block following the last match */
+
+    unsigned char *out;		/* token output */
+    UINT4 outLen;
+    UINT4 outSize;
+
+    UINT4 matchCnt;		/* statistics */
+    double literalBytes;
+} rsync_delta;
+
+rsync_delta *rsync_delta_new(unsigned char *sums, UINT4 blkCnt,
+		UINT4 blkSize, UINT4 remainder, int csumLen, UINT4 seed,
+		int rsyncMD4Bug);
+int rsync_delta_add(rsync_delta *d, unsigned char *data, UINT4 len);
+int rsync_delta_finish(rsync_delta *d);
+void rsync_delta_free(rsync_delta *d);
+void rsync_match_tokens(unsigned char *out, UINT4 blk, UINT4 cnt);
@@ -0,0 +1,234 @@
+/*
+ * Read file data directly from a file descriptor for File::RsyncP,
+ * so the block and file digests can be computed without first
+ * copying the data into perl strings.
+ *
+ * The data is read() into a malloc()ed buffer, advancing the file
+ * offset past it, so calls can be mixed with sysread().  Files aren't
+ * mmap()ed: if another process truncated a file while it was being
+ * read, touching the pages past the new end would raise SIGBUS,
+ * whereas read() just returns less data.
+ *
+ * fd_copy_range() copies part of one file to another, cloning or
+ * copying the data in the kernel where possible.
+ *
+ * fd_prefetch() asks the kernel to start reading a file that will be
+ * read soon.
+ *
+ * Copyright (C) 2002-2010 Craig Barratt.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "global.h"
+#include "md4.h"
+#include "rsync_lib.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fcntl.h>
+#ifdef HAVE_COPY_FILE_RANGE
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <linux/fs.h>
+#endif
+
+/*
+ * Get the next chunk of up to maxLen bytes from fd.  At end of file
+ * chunk->len is 0.  Returns 0 on success and -1 on a read error.
+ * fd_chunk_free() must be called after each successful call.
+ */
+int fd_chunk_get(int fd, UINT4 maxLen, fd_chunk *chunk)
+{
+    UINT4 done = 0;
+
+    memset(chunk, 0, sizeof(*chunk));
+    if ( maxLen == 0 )
+	return 0;
+    if ( !(chunk->buf = malloc(maxLen)) )
+	return -1;
+    while ( done < maxLen ) {
+	ssize_t n = read(fd, chunk->buf + done, maxLen - done);
+
+	if ( n < 0 && errno == EINTR )
+	    continue;
+	if ( n < 0 ) {
+	    free(chunk->buf);
+	    chunk->buf = NULL;
+	    return -1;
+	}
+	if ( n == 0 )
+	    break;
+	done += n;
+    }
+    chunk->data = chunk->buf;
+    chunk->len  = done;
+    return 0;
+}
+
+void fd_chunk_free(fd_chunk *chunk)
+{
+    if ( chunk->buf )
+	free(chunk->buf);
+    memset(chunk, 0, sizeof(*chunk));
+}
+
+#ifdef HAVE_COPY_FILE_RANGE
+/*
+ * Copy len bytes from inFd at inOff to outFd at outOff in the kernel:
+ * first try sharing the extents (FICLONERANGE, eg: on btrfs or XFS),
+ * then copy_file_range().  The extents are only cloned if inOff,
+ * outOff and len are multiples of blkSize, except for a tail that ends
+ * at inSize.  *state remembers what failed so it isn't retried.
+ * Returns the number of bytes copied, which might be less than len.
+ */
+static size_t fd_copy_kernel(int inFd, off_t inOff, int outFd, off_t outOff,
+			     size_t len, off_t inSize, off_t blkSize,
+			     int *state)
+{
+    size_t done = 0;
+
+#ifdef FICLONERANGE
+    if ( !(*state & FD_COPY_NO_CLONE) && blkSize > 0
+	    && inOff % blkSize == 0 && outOff % blkSize == 0
+	    && ((off_t)len % blkSize == 0 || inOff + (off_t)len == inSize) ) {
+	struct file_clone_range range;
+
+	range.src_fd      = inFd;
+	range.src_offset  = inOff;
+	range.src_length  = len;
+	range.dest_offset = outOff;
+	if ( ioctl(outFd, FICLONERANGE, &range) == 0 )
+	    return len;
+	*state |= FD_COPY_NO_CLONE;
+    }
+#endif
+#ifdef SYS_copy_file_range
+    while ( done < len && !(*state & FD_COPY_NO_RANGE) ) {
+	loff_t in = inOff + done, out = outOff + done;
+	long n = syscall(SYS_copy_file_range, inFd, &in, outFd, &out,
+			 len - done, 0);
+
+	if ( n < 0 && errno == EINTR )
+	    continue;
+	if ( n <= 0 ) {
+	    *state |= FD_COPY_NO_RANGE;
+	    break;
+	}
+	done += n;
+    }
+#endif
+    return done;
+}
+#endif
+
+/*
+ * Copy len bytes at offset in inFd to the current offset of outFd,
+ * and advance the outFd offset past them.  If ctx isn't NULL the
+ * data is added to it too.  If outFd is -1 the data is only added
+ * to ctx.  The data is cloned or copied in the
+ * kernel where possible, otherwise it is written from the chunks
+ * read for the digest.  If state isn't NULL it should start at 0 for
+ * each output file, and remembers which kernel copies failed (the
+ * FD_COPY_* flags) across calls for that file.  Returns 0 on success,
+ * -1 on a read or write error or if inFd is too short.
+ */
+int fd_copy_range(int inFd, off_t offset, off_t len, int outFd,
+		RsyncMD4_CTX *ctx, int *state)
+{
+    off_t outOffset = 0;
+    int localState = 0;
+#ifdef HAVE_COPY_FILE_RANGE
+    off_t inSize = 0, blkSize = 0;
+#endif
+
+    if ( !state )
+	state = &localState;
+    if ( (outFd >= 0 && (outOffset = lseek(outFd, 0, SEEK_CUR)) < 0)
+		|| lseek(inFd, offset, SEEK_SET) < 0 )
+	return -1;
+#ifdef HAVE_COPY_FILE_RANGE
+    if ( outFd >= 0 && !(*state & FD_COPY_NO_CLONE) ) {
+	struct stat inSt, outSt;
+
+	if ( fstat(inFd, &inSt) == 0 && fstat(outFd, &outSt) == 0 ) {
+	    inSize  = inSt.st_size;
+	    blkSize = outSt.st_blksize;
+	}
+    }
+#endif
+    while ( len > 0 ) {
+	fd_chunk chunk;
+	size_t done = 0;
+
+	if ( fd_chunk_get(inFd, len > FD_CHUNK_MAX_LEN ? FD_CHUNK_MAX_LEN
+						       : (UINT4)len, &chunk) )
+	    return -1;
+	if ( chunk.len == 0 ) {
+	    fd_chunk_free(&chunk);
+	    return -1;
+	}
+	if ( ctx )
+	    RsyncMD4Update(ctx, chunk.data, chunk.len);
+	if ( outFd < 0 )
+	    done = chunk.len;
+#ifdef HAVE_COPY_FILE_RANGE
+	else
+	    done = fd_copy_kernel(inFd, offset, outFd, outOffset, chunk.len,
+				  inSize, blkSize, state);
+#endif
+	while ( done < chunk.len ) {
+	    ssize_t n = pwrite(outFd, chunk.data + done, chunk.len - done,
+			       outOffset + done);
+
+	    if ( n < 0 && errno == EINTR )
+		continue;
+	    if ( n <= 0 ) {
+		fd_chunk_free(&chunk);
+		return -1;
+	    }
+	    done += n;
+	}
+	offset    += chunk.len;
+	outOffset += chunk.len;
+	len       -= chunk.len;
+	fd_chunk_free(&chunk);
+    }
+    return outFd >= 0 && lseek(outFd, outOffset, SEEK_SET) < 0 ? -1 : 0;
+}
+
+/*
+ * Start reading the first len bytes (all if len is 0) of the regular
+ * file path into the page cache, without waiting for them.  Returns 0
+ * if the hint was given, or -1 if the file can't be opened or isn't
+ * a regular file, or the system doesn't support the hint.
+ */
+int fd_prefetch(char *path, off_t len)
+{
+#ifdef POSIX_FADV_WILLNEED
+    struct stat st;
+    int fd, ret = -1;
+
+#ifdef O_NONBLOCK
+    fd = open(path, O_RDONLY | O_NONBLOCK);
+#else
+    fd = open(path, O_RDONLY);
+#endif
+    if ( fd < 0 )
+	return -1;
+    if ( !fstat(fd, &st) && S_ISREG(st.st_mode) )
+	ret = posix_fadvise(fd, 0, len, POSIX_FADV_WILLNEED) ? -1 : 0;
+    close(fd);
+    return ret;
+#else
+    (void)path;
+    (void)len;
+    return -1;
+#endif
+}
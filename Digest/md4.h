@@ -47,3 +47,5 @@ void RsyncMD4Encode PROTO_LIST
 void RsyncMD4FinalRsync PROTO_LIST ((unsigned char [16], RsyncMD4_CTX *));
 void RsyncMD4Decode PROTO_LIST
   ((UINT4 *, unsigned char *, unsigned int));
+void RsyncMD4Blocks PROTO_LIST
+  ((UINT4 [4], unsigned char *, unsigned int));
@@ -0,0 +1,414 @@
+/*
+ * Multi-buffer MD4 for File::RsyncP.
+ *
+ * Every rsync block checksum is an independent MD4 of a short
+ * message (the block data plus the optional seed).  Instead of
+ * hashing the blocks one after the other, the SIMD kernels here run
+ * 4 (SSE2) or 8 (AVX2) MD4 computations side by side, one per 32 bit
+ * lane.  All the lanes must have the same message length, which is
+ * the case for every block except the last one.
+ *
+ * The padding is built exactly the way RsyncMD4FinalRsync() does it,
+ * including the rsyncMD4Bug finalisation for protocol <= 26, so the
+ * digests are identical to the scalar code.  The fastest kernel
+ * supported by the CPU is picked at run time; the "c" kernel has one
+ * lane, and rsync_lib.c then uses its original scalar loops.
+ *
+ * Copyright (C) 2002-2010 Craig Barratt.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "global.h"
+#include "md4.h"
+#include "rsync_lib.h"
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) \
+        && !defined(RSYNCP_NO_SIMD)
+#define MD4_MB_X86 1
+#include <immintrin.h>
+#endif
+
+/*
+ * Portable version: one lane, using the scalar MD4 transform.
+ */
+static void md4_mb_c(UINT4 state[][4], unsigned char **data, UINT4 cnt)
+{
+    RsyncMD4Blocks(state[0], data[0], cnt);
+}
+
+#ifdef MD4_MB_X86
+
+/*
+ * The 48 MD4 steps, written in terms of the vector operations
+ * VADD, VAND, VANDNOT, VOR, VXOR, VSLL and VSRL, which are defined
+ * before each kernel.  x[] holds the 16 message words,
+ * with one lane per message.
+ */
+#define VROTL(v, n)	VOR(VSLL((v), (n)), VSRL((v), 32 - (n)))
+#define VF(x, y, z)	VOR(VAND((x), (y)), VANDNOT((x), (z)))
+#define VG(x, y, z)	VOR(VAND((x), (y)), VAND((z), VOR((x), (y))))
+#define VH(x, y, z)	VXOR(VXOR((x), (y)), (z))
+
+#define VFF(a, b, c, d, k, s) { \
+    (a) = VROTL(VADD(VADD((a), VF((b), (c), (d))), x[k]), (s)); \
+  }
+#define VGG(a, b, c, d, k, s) { \
+    (a) = VROTL(VADD(VADD(VADD((a), VG((b), (c), (d))), x[k]), k2), (s)); \
+  }
+#define VHH(a, b, c, d, k, s) { \
+    (a) = VROTL(VADD(VADD(VADD((a), VH((b), (c), (d))), x[k]), k3), (s)); \
+  }
+
+#define MD4_MB_ROUNDS { \
+    VFF(a, b, c, d,  0,  3); VFF(d, a, b, c,  1,  7); \
+    VFF(c, d, a, b,  2, 11); VFF(b, c, d, a,  3, 19); \
+    VFF(a, b, c, d,  4,  3); VFF(d, a, b, c,  5,  7); \
+    VFF(c, d, a, b,  6, 11); VFF(b, c, d, a,  7, 19); \
+    VFF(a, b, c, d,  8,  3); VFF(d, a, b, c,  9,  7); \
+    VFF(c, d, a, b, 10, 11); VFF(b, c, d, a, 11, 19); \
+    VFF(a, b, c, d, 12,  3); VFF(d, a, b, c, 13,  7); \
+    VFF(c, d, a, b, 14, 11); VFF(b, c, d, a, 15, 19); \
+    VGG(a, b, c, d,  0,  3); VGG(d, a, b, c,  4,  5); \
+    VGG(c, d, a, b,  8,  9); VGG(b, c, d, a, 12, 13); \
+    VGG(a, b, c, d,  1,  3); VGG(d, a, b, c,  5,  5); \
+    VGG(c, d, a, b,  9,  9); VGG(b, c, d, a, 13, 13); \
+    VGG(a, b, c, d,  2,  3); VGG(d, a, b, c,  6,  5); \
+    VGG(c, d, a, b, 10,  9); VGG(b, c, d, a, 14, 13); \
+    VGG(a, b, c, d,  3,  3); VGG(d, a, b, c,  7,  5); \
+    VGG(c, d, a, b, 11,  9); VGG(b, c, d, a, 15, 13); \
+    VHH(a, b, c, d,  0,  3); VHH(d, a, b, c,  8,  9); \
+    VHH(c, d, a, b,  4, 11); VHH(b, c, d, a, 12, 15); \
+    VHH(a, b, c, d,  2,  3); VHH(d, a, b, c, 10,  9); \
+    VHH(c, d, a, b,  6, 11); VHH(b, c, d, a, 14, 15); \
+    VHH(a, b, c, d,  1,  3); VHH(d, a, b, c,  9,  9); \
+    VHH(c, d, a, b,  5, 11); VHH(b, c, d, a, 13, 15); \
+    VHH(a, b, c, d,  3,  3); VHH(d, a, b, c, 11,  9); \
+    VHH(c, d, a, b,  7, 11); VHH(b, c, d, a, 15, 15); \
+  }
+
+/*
+ * SSE2: 4 lanes.  Each 64 byte block is loaded 16 bytes at a time
+ * from the four messages and transposed so that x[k] holds word k
+ * of every lane.
+ */
+#define VADD(a, b)	_mm_add_epi32((a), (b))
+#define VAND(a, b)	_mm_and_si128((a), (b))
+#define VANDNOT(a, b)	_mm_andnot_si128((a), (b))
+#define VOR(a, b)	_mm_or_si128((a), (b))
+#define VXOR(a, b)	_mm_xor_si128((a), (b))
+#define VSLL(a, n)	_mm_slli_epi32((a), (n))
+#define VSRL(a, n)	_mm_srli_epi32((a), (n))
+
+__attribute__((target("sse2")))
+static void md4_mb_sse2(UINT4 state[][4], unsigned char **data, UINT4 cnt)
+{
+    const __m128i k2 = _mm_set1_epi32(0x5a827999);
+    const __m128i k3 = _mm_set1_epi32(0x6ed9eba1);
+    __m128i sa, sb, sc, sd, x[16];
+    unsigned int out[4][4];
+    UINT4 i, j;
+
+    sa = _mm_setr_epi32(state[0][0], state[1][0], state[2][0], state[3][0]);
+    sb = _mm_setr_epi32(state[0][1], state[1][1], state[2][1], state[3][1]);
+    sc = _mm_setr_epi32(state[0][2], state[1][2], state[2][2], state[3][2]);
+    sd = _mm_setr_epi32(state[0][3], state[1][3], state[2][3], state[3][3]);
+    for ( i = 0 ; i < cnt ; i++ ) {
+        __m128i a = sa, b = sb, c = sc, d = sd;
+
+        for ( j = 0 ; j < 4 ; j++ ) {
+            __m128i w0 = _mm_loadu_si128((__m128i *)(data[0] + 64*i + 16*j));
+            __m128i w1 = _mm_loadu_si128((__m128i *)(data[1] + 64*i + 16*j));
+            __m128i w2 = _mm_loadu_si128((__m128i *)(data[2] + 64*i + 16*j));
+            __m128i w3 = _mm_loadu_si128((__m128i *)(data[3] + 64*i + 16*j));
+            __m128i t0 = _mm_unpacklo_epi32(w0, w1);
+            __m128i t1 = _mm_unpacklo_epi32(w2, w3);
+            __m128i t2 = _mm_unpackhi_epi32(w0, w1);
+            __m128i t3 = _mm_unpackhi_epi32(w2, w3);
+
+            x[4*j + 0] = _mm_unpacklo_epi64(t0, t1);
+            x[4*j + 1] = _mm_unpackhi_epi64(t0, t1);
+            x[4*j + 2] = _mm_unpacklo_epi64(t2, t3);
+            x[4*j + 3] = _mm_unpackhi_epi64(t2, t3);
+        }
+        MD4_MB_ROUNDS;
+        sa = _mm_add_epi32(sa, a);
+        sb = _mm_add_epi32(sb, b);
+        sc = _mm_add_epi32(sc, c);
+        sd = _mm_add_epi32(sd, d);
+    }
+    _mm_storeu_si128((__m128i *)out[0], sa);
+    _mm_storeu_si128((__m128i *)out[1], sb);
+    _mm_storeu_si128((__m128i *)out[2], sc);
+    _mm_storeu_si128((__m128i *)out[3], sd);
+    for ( i = 0 ; i < 4 ; i++ ) {
+        for ( j = 0 ; j < 4 ; j++ )
+            state[i][j] = out[j][i];
+    }
+}
+
+#undef VADD
+#undef VAND
+#undef VANDNOT
+#undef VOR
+#undef VXOR
+#undef VSLL
+#undef VSRL
+
+/*
+ * AVX2: 8 lanes.  Lanes i and i + 4 share a 256 bit register, so
+ * the in-lane unpacks give the same transpose as SSE2 in each half.
+ */
+#define VADD(a, b)	_mm256_add_epi32((a), (b))
+#define VAND(a, b)	_mm256_and_si256((a), (b))
+#define VANDNOT(a, b)	_mm256_andnot_si256((a), (b))
+#define VOR(a, b)	_mm256_or_si256((a), (b))
+#define VXOR(a, b)	_mm256_xor_si256((a), (b))
+#define VSLL(a, n)	_mm256_slli_epi32((a), (n))
+#define VSRL(a, n)	_mm256_srli_epi32((a), (n))
+
+__attribute__((target("avx2")))
+static __m256i md4_mb_load2(unsigned char *p0, unsigned char *p1)
+{
+    return _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128((__m128i *)p0)),
+                _mm_loadu_si128((__m128i *)p1), 1);
+}
+
+__attribute__((target("avx2")))
+static void md4_mb_avx2(UINT4 state[][4], unsigned char **data, UINT4 cnt)
+{
+    const __m256i k2 = _mm256_set1_epi32(0x5a827999);
+    const __m256i k3 = _mm256_set1_epi32(0x6ed9eba1);
+    __m256i sa, sb, sc, sd, x[16];
+    unsigned int out[4][8];
+    UINT4 i, j;
+
+#define MD4_MB_STATE8(k) _mm256_setr_epi32(state[0][k], state[1][k], \
+                state[2][k], state[3][k], state[4][k], state[5][k], \
+                state[6][k], state[7][k])
+    sa = MD4_MB_STATE8(0);
+    sb = MD4_MB_STATE8(1);
+    sc = MD4_MB_STATE8(2);
+    sd = MD4_MB_STATE8(3);
+#undef MD4_MB_STATE8
+    for ( i = 0 ; i < cnt ; i++ ) {
+        __m256i a = sa, b = sb, c = sc, d = sd;
+        UINT4 off = 64 * i;
+
+        for ( j = 0 ; j < 4 ; j++, off += 16 ) {
+            __m256i w0 = md4_mb_load2(data[0] + off, data[4] + off);
+            __m256i w1 = md4_mb_load2(data[1] + off, data[5] + off);
+            __m256i w2 = md4_mb_load2(data[2] + off, data[6] + off);
+            __m256i w3 = md4_mb_load2(data[3] + off, data[7] + off);
+            __m256i t0 = _mm256_unpacklo_epi32(w0, w1);
+            __m256i t1 = _mm256_unpacklo_epi32(w2, w3);
+            __m256i t2 = _mm256_unpackhi_epi32(w0, w1);
+            __m256i t3 = _mm256_unpackhi_epi32(w2, w3);
+
+            x[4*j + 0] = _mm256_unpacklo_epi64(t0, t1);
+            x[4*j + 1] = _mm256_unpackhi_epi64(t0, t1);
+            x[4*j + 2] = _mm256_unpacklo_epi64(t2, t3);
+            x[4*j + 3] = _mm256_unpackhi_epi64(t2, t3);
+        }
+        MD4_MB_ROUNDS;
+        sa = _mm256_add_epi32(sa, a);
+        sb = _mm256_add_epi32(sb, b);
+        sc = _mm256_add_epi32(sc, c);
+        sd = _mm256_add_epi32(sd, d);
+    }
+    _mm256_storeu_si256((__m256i *)out[0], sa);
+    _mm256_storeu_si256((__m256i *)out[1], sb);
+    _mm256_storeu_si256((__m256i *)out[2], sc);
+    _mm256_storeu_si256((__m256i *)out[3], sd);
+    for ( i = 0 ; i < 8 ; i++ ) {
+        for ( j = 0 ; j < 4 ; j++ )
+            state[i][j] = out[j][i];
+    }
+}
+
+#undef VADD
+#undef VAND
+#undef VANDNOT
+#undef VOR
+#undef VXOR
+#undef VSLL
+#undef VSRL
+
+#endif /* MD4_MB_X86 */
+
+typedef void (*md4_mb_kernel)(UINT4 [][4], unsigned char **, UINT4);
+
+static struct {
+    char *name;
+    UINT4 lanes;
+    md4_mb_kernel func;
+} md4_mb_kernels[] = {
+    { "c",    1, md4_mb_c },
+#ifdef MD4_MB_X86
+    { "sse2", 4, md4_mb_sse2 },
+    { "avx2", 8, md4_mb_avx2 },
+#endif
+};
+
+#define MD4_MB_NKERNELS	((int)(sizeof(md4_mb_kernels) \
+				      / sizeof(md4_mb_kernels[0])))
+
+static int md4_mb_kernel_cur = -1;
+
+/*
+ * Returns non-zero if the CPU can run the i'th kernel.
+ */
+static int md4_mb_kernel_ok(int i)
+{
+#ifdef MD4_MB_X86
+    __builtin_cpu_init();
+    if ( md4_mb_kernels[i].func == md4_mb_sse2 )
+        return __builtin_cpu_supports("sse2");
+    if ( md4_mb_kernels[i].func == md4_mb_avx2 )
+        return __builtin_cpu_supports("avx2");
+#endif
+    return i >= 0 && i < MD4_MB_NKERNELS;
+}
+
+/*
+ * Return the name of the n'th kernel supported by this CPU (the
+ * last one is the fastest, and is the default), or NULL if there
+ * are fewer than n + 1.
+ */
+char *md4_mb_kernel_name(int n)
+{
+    int i;
+
+    for ( i = 0 ; i < MD4_MB_NKERNELS ; i++ ) {
+        if ( md4_mb_kernel_ok(i) && n-- == 0 )
+            return md4_mb_kernels[i].name;
+    }
+    return NULL;
+}
+
+/*
+ * Select the kernel called name.  If name is NULL the fastest one is
+ * selected.  Returns 0 on success, -1 if name is not supported.
+ */
+int md4_mb_kernel_set(char *name)
+{
+    int i;
+
+    for ( i = MD4_MB_NKERNELS - 1 ; i >= 0 ; i-- ) {
+        if ( !md4_mb_kernel_ok(i) )
+            continue;
+        if ( !name || !strcmp(name, md4_mb_kernels[i].name) ) {
+            md4_mb_kernel_cur = i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Number of messages the current kernel hashes at once.
+ */
+UINT4 md4_mb_lanes(void)
+{
+    if ( md4_mb_kernel_cur < 0 )
+        md4_mb_kernel_set(NULL);
+    return md4_mb_kernels[md4_mb_kernel_cur].lanes;
+}
+
+/*
+ * Set the n states to the MD4 initial values.
+ */
+void md4_mb_init(UINT4 state[][4], UINT4 n)
+{
+    UINT4 i;
+
+    for ( i = 0 ; i < n ; i++ ) {
+        state[i][0] = 0x67452301;
+        state[i][1] = 0xefcdab89;
+        state[i][2] = 0x98badcfe;
+        state[i][3] = 0x10325476;
+    }
+}
+
+/*
+ * Run cnt 64 byte blocks from each of the n (<= MD4_MB_LANES) buffers
+ * data[] through the MD4 transform, updating state[].
+ */
+void md4_mb_blocks(UINT4 state[][4], unsigned char **data, UINT4 n, UINT4 cnt)
+{
+    UINT4 lanes = md4_mb_lanes(), i, j;
+    md4_mb_kernel func = md4_mb_kernels[md4_mb_kernel_cur].func;
+    UINT4 laneState[MD4_MB_LANES][4];
+    unsigned char *laneData[MD4_MB_LANES];
+
+    if ( cnt == 0 )
+        return;
+    for ( i = 0 ; i < n ; i += lanes ) {
+        /*
+         * Unused lanes just repeat the first message
+         */
+        for ( j = 0 ; j < lanes ; j++ ) {
+            UINT4 k = i + j < n ? i + j : i;
+
+            memcpy(laneState[j], state[k], sizeof(laneState[j]));
+            laneData[j] = data[k];
+        }
+        (*func)(laneState, laneData, cnt);
+        for ( j = 0 ; j < lanes && i + j < n ; j++ )
+            memcpy(state[i + j], laneState[j], sizeof(laneState[j]));
+    }
+}
+
+/*
+ * Finish n (<= MD4_MB_LANES) MD4 digests.  Each message has had done
+ * bytes (a multiple of 64) hashed into state[], and has len more bytes
+ * in data[], followed by the 4 bytes seedBytes if it is not NULL.
+ * The padding matches RsyncMD4FinalRsync(), including the rsyncMD4Bug
+ * behaviour.  The 16 byte digests are written to digest[].
+ */
+void md4_mb_final(UINT4 state[][4], unsigned char **data, UINT4 n, UINT4 len,
+		  UINT4 done, unsigned char *seedBytes, int rsyncMD4Bug,
+		  unsigned char digest[][16])
+{
+    unsigned char tail[MD4_MB_LANES][128];
+    unsigned char *tailData[MD4_MB_LANES];
+    UINT4 full = len / 64, rem = len % 64, total, tailLen = 0, i;
+    UINT4 bits[2];
+
+    md4_mb_blocks(state, data, n, full);
+
+    /*
+     * Total message length in bits: like rsync <= 2.5.6 we only keep
+     * a 32 bit count if rsyncMD4Bug is set.
+     */
+    total   = done + len + (seedBytes ? 4 : 0);
+    bits[0] = TO32(total << 3);
+    bits[1] = rsyncMD4Bug ? 0 : TO32(total >> 29);
+    for ( i = 0 ; i < n ; i++ ) {
+        tailLen = rem;
+        memcpy(tail[i], data[i] + 64 * full, rem);
+        if ( seedBytes ) {
+            memcpy(tail[i] + tailLen, seedBytes, 4);
+            tailLen += 4;
+        }
+        if ( !rsyncMD4Bug || total % 64 > 0 ) {
+            UINT4 index = total % 64;
+            UINT4 padLen = (index < 56) ? (56 - index) : (120 - index);
+
+            tail[i][tailLen] = 0x80;
+            memset(tail[i] + tailLen + 1, 0, padLen - 1);
+            tailLen += padLen;
+            RsyncMD4Encode(tail[i] + tailLen, bits, 8);
+            tailLen += 8;
+        }
+        tailData[i] = tail[i];
+    }
+    md4_mb_blocks(state, tailData, n, tailLen / 64);
+    for ( i = 0 ; i < n ; i++ )
+        RsyncMD4Encode(digest[i], state[i], 16);
+}
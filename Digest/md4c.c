@@ -284,6 +284,21 @@ unsigned char block[64];
   RsyncMD4_memset ((POINTER)x, 0, sizeof (x));
 }
 
+/* Runs the MD4 basic transformation on cnt consecutive 64 byte blocks
+     of input, without any length accounting.  Used by the multi-buffer
+     code in md4_mb.c.
+ */
+void RsyncMD4Blocks (state, input, cnt)
+UINT4 state[4];
+unsigned char *input;
+unsigned int cnt;
+{
+  while (cnt-- > 0) {
+    RsyncMD4Transform (state, input);
+    input += 64;
+  }
+}
+
 /* Encodes input (UINT4) into output (unsigned char). Assumes len is
      a multiple of 4.
  */
@@ -21,34 +21,209 @@
 
 #include "global.h"
 #include "md4.h"
+#include "rsync_lib.h"
+#include <stdlib.h>
 #include <string.h>
-
-/*
- * CHAR_OFFSET is 0 for rsync, and 31 for librsync.
- */
-#define CHAR_OFFSET 0
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#include <unistd.h>
+#endif
 
 /*
  * a simple 32 bit checksum that can be updated from either end
  * (inspired by Mark Adler's Adler-32 checksum)
+ *
+ * The loop itself is adler32_update() in adler32.c, which picks
+ * a SIMD version if the CPU supports it.
  */
 UINT4 adler32_checksum(char *buf1, int len)
 {
-    int i;
     UINT4 s1, s2;
-    signed char *buf = (signed char*)buf1;
 
     s1 = s2 = 0;
-    for ( i = 0 ; i < len - 4; i += 4 ) {
-        s2 += 4 * (s1 + buf[i]) + 3 * buf[i+1] + 2 * buf[i+2] + buf[i+3] +
-	      10 * CHAR_OFFSET;
-        s1 += (buf[i+0] + buf[i+1] + buf[i+2] + buf[i+3] + 4 * CHAR_OFFSET);
+    adler32_update(buf1, len, &s1, &s2);
+    return (s1 & 0xffff) + (s2 << 16);
+}
+
+/*
+ * Compute the two halves (s1, s2) of the adler32 checksum of buf,
+ * so the window can then be updated one byte at a time with the
+ * ADLER32_ROLL macros in rsync_lib.h.
+ */
+void adler32_parts(char *buf1, UINT4 len, UINT4 *s1p, UINT4 *s2p)
+{
+    *s1p = *s2p = 0;
+    adler32_update(buf1, len, s1p, s2p);
+}
+
+#define ADLER32_SET_BIT(sum)	(((sum) ^ ((sum) >> 16)) & 0xffff)
+
+static int adler32_cmp(const void *a, const void *b)
+{
+    UINT4 x = *(const UINT4 *)a, y = *(const UINT4 *)b;
+
+    return x < y ? -1 : x > y ? 1 : 0;
+}
+
+/*
+ * Build a set of cnt adler32 checksums.  The checksums are the
+ * first 4 bytes (little endian) of every stride bytes of sums, so
+ * the output of blockDigest() can be used directly.  Returns NULL
+ * if out of memory.
+ */
+adler32_set *adler32_set_new(unsigned char *sums, UINT4 cnt, UINT4 stride)
+{
+    adler32_set *set;
+    UINT4 i, bit;
+
+    if ( !(set = calloc(1, sizeof(*set)))
+            || !(set->sums = malloc((cnt ? cnt : 1) * sizeof(UINT4))) ) {
+        free(set);
+        return NULL;
     }
-    for ( ; i < len ; i++ ) {
-        s1 += (buf[i] + CHAR_OFFSET);
-	s2 += s1;
+    set->cnt = cnt;
+    for ( i = 0 ; i < cnt ; i++ ) {
+        UINT4 sum;
+
+        RsyncMD4Decode(&sum, sums + i * stride, 4);
+        set->sums[i] = sum;
+        bit = ADLER32_SET_BIT(sum);
+        set->bits[bit >> 3] |= 1 << (bit & 7);
+    }
+    qsort(set->sums, cnt, sizeof(UINT4), adler32_cmp);
+    return set;
+}
+
+int adler32_set_member(adler32_set *set, UINT4 sum)
+{
+    UINT4 lo = 0, hi = set->cnt, bit = ADLER32_SET_BIT(sum);
+
+    if ( !(set->bits[bit >> 3] & (1 << (bit & 7))) )
+        return 0;
+    while ( lo < hi ) {
+        UINT4 mid = lo + (hi - lo) / 2;
+
+        if ( set->sums[mid] < sum ) {
+            lo = mid + 1;
+        } else if ( set->sums[mid] > sum ) {
+            hi = mid;
+        } else {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+void adler32_set_free(adler32_set *set)
+{
+    if ( !set )
+        return;
+    free(set->sums);
+    free(set);
+}
+
+/*
+ * Slide a window of blockSize bytes over buf, starting at
+ * state->offset, and report the offsets whose adler32 checksum
+ * is in set.  Each hit is stored as an (offset, checksum) pair in
+ * result, which has room for maxResult pairs.  Returns the number
+ * of pairs stored; the scan is finished when state->offset has
+ * passed len - blockSize, otherwise call again to continue.
+ */
+UINT4 adler32_scan(char *buf1, UINT4 len, UINT4 blockSize, adler32_set *set,
+		adler32_scan_state *state, UINT4 *result, UINT4 maxResult)
+{
+    signed char *buf = (signed char*)buf1;
+    UINT4 n = 0, offset = state->offset, s1 = state->s1, s2 = state->s2;
+
+    if ( blockSize == 0 || len < blockSize )
+        return 0;
+    if ( !state->valid && offset + blockSize <= len ) {
+        adler32_parts(buf1 + offset, blockSize, &s1, &s2);
+        state->valid = 1;
+    }
+    while ( offset + blockSize <= len && n < maxResult ) {
+        UINT4 sum = ADLER32_SUM(s1, s2);
+
+        if ( adler32_set_member(set, sum) ) {
+            result[2 * n]     = offset;
+            result[2 * n + 1] = sum;
+            n++;
+        }
+        if ( offset + blockSize < len ) {
+            ADLER32_ROLL(s1, s2, blockSize, buf[offset],
+                         buf[offset + blockSize]);
+        }
+        offset++;
+    }
+    state->offset = offset;
+    state->s1 = s1;
+    state->s2 = s2;
+    return n;
+}
+
+/*
+ * rsync_checksum() using the multi-buffer MD4 code: runs of up to
+ * MD4_MB_LANES blocks of the same length are hashed together.
+ */
+static void rsync_checksum_mb(unsigned char *buf, UINT4 len, UINT4 blockSize,
+    unsigned char *seedBytes, unsigned char *digest, int md4DigestLen,
+    UINT4 lanes)
+{
+    UINT4 state[MD4_MB_LANES][4];
+    unsigned char *data[MD4_MB_LANES];
+    unsigned char md4Digest[MD4_MB_LANES][16];
+
+    while ( len > 0 ) {
+	UINT4 thisLen = len < blockSize ? len : blockSize;
+	UINT4 n = len / thisLen, i;
+
+	if ( n > lanes ) n = lanes;
+	md4_mb_init(state, n);
+	for ( i = 0 ; i < n ; i++ ) {
+	    data[i] = buf + i * thisLen;
+	}
+	if ( md4DigestLen < 0 ) {
+	    /*
+	     * Save the state and the partial buffer (no finish).  Only
+	     * the whole 64 byte blocks are done in parallel.
+	     */
+	    md4_mb_blocks(state, data, n, thisLen / 64);
+	    for ( i = 0 ; i < n ; i++ ) {
+		UINT4 adler32 = adler32_checksum((char*)data[i], thisLen);
+		RsyncMD4_CTX md4;
+
+		RsyncMD4Init(&md4);
+		memcpy(md4.state, state[i], sizeof(md4.state));
+		md4.count[0] = TO32((thisLen - thisLen % 64) << 3);
+		RsyncMD4Update(&md4, data[i] + thisLen - thisLen % 64,
+			       thisLen % 64);
+		if ( seedBytes ) {
+		    RsyncMD4Update(&md4, seedBytes, 4);
+		}
+		RsyncMD4Encode(digest, &adler32, 1);
+		RsyncMD4Encode(digest + 4, md4.state, 16);
+		memcpy(digest + 20, md4.buffer, thisLen % 64);
+		digest += 20 + thisLen % 64;
+	    }
+	} else {
+	    int digestLen = md4DigestLen > 16 ? 16 : md4DigestLen;
+
+	    /*
+	     * RsyncMD4Init() always sets rsyncMD4Bug
+	     */
+	    md4_mb_final(state, data, n, thisLen, 0, seedBytes, 1, md4Digest);
+	    for ( i = 0 ; i < n ; i++ ) {
+		UINT4 adler32 = adler32_checksum((char*)data[i], thisLen);
+
+		RsyncMD4Encode(digest, &adler32, 1);
+		memcpy(digest + 4, md4Digest[i], digestLen);
+		digest += 4 + digestLen;
+	    }
+	}
+	len -= n * thisLen;
+	buf += n * thisLen;
     }
-    return (s1 & 0xffff) + (s2 << 16);
 }
 
 /*
@@ -67,10 +242,16 @@ void rsync_checksum(unsigned char *buf, UINT4 len, UINT4 blockSize, UINT4 seed,
     unsigned char *digest, int md4DigestLen)
 {
     unsigned char seedBytes[4];
+    UINT4 lanes;
 
-    if ( md4DigestLen > 0 && seed ) {
+    if ( md4DigestLen != 0 && seed ) {
 	RsyncMD4Encode(seedBytes, &seed, 1);
     }
+    if ( md4DigestLen != 0 && blockSize > 0 && (lanes = md4_mb_lanes()) > 1 ) {
+	rsync_checksum_mb(buf, len, blockSize, seed ? seedBytes : NULL,
+			  digest, md4DigestLen, lanes);
+	return;
+    }
     while ( len > 0 ) {
 	int thisLen = len < blockSize ? len : blockSize;
 	UINT4 adler32 = adler32_checksum((char*)buf, thisLen);
@@ -113,6 +294,221 @@ void rsync_checksum(unsigned char *buf, UINT4 len, UINT4 blockSize, UINT4 seed,
     }
 }
 
+/*
+ * Returns the number of bytes of output rsync_checksum() writes for
+ * a buffer of length len.
+ */
+UINT4 rsync_checksum_size(UINT4 len, UINT4 blockSize, int md4DigestLen)
+{
+    UINT4 nBlocks = (len + blockSize - 1) / blockSize;
+
+    if ( md4DigestLen < 0 ) {
+	/*
+	 * 4 + 16 = 20 bytes per block, plus the used part of the
+	 * 64 byte MD4 buffer.
+	 */
+	if ( nBlocks == 0 )
+	    return 0;
+	return 20 * nBlocks + (blockSize % 64) * (nBlocks - 1)
+		    + ((len - (nBlocks - 1) * blockSize) % 64);
+    }
+    return (4 + (md4DigestLen > 16 ? 16 : md4DigestLen)) * nBlocks;
+}
+
+/*
+ * Same as rsync_checksum(), but the data is also added to the file
+ * digest fileCtx.  The buffer is done in slices of whole blocks
+ * around RSYNC_CHECKSUM_FUSED_LEN bytes: each slice is still in the
+ * cache when the file MD4 reads it, so the data is only loaded from
+ * memory once.
+ */
+void rsync_checksum_file(unsigned char *buf, UINT4 len, UINT4 blockSize,
+    UINT4 seed, unsigned char *digest, int md4DigestLen,
+    RsyncMD4_CTX *fileCtx)
+{
+    UINT4 sliceBlocks, sliceLen;
+
+    if ( blockSize == 0 )
+	blockSize = 700;
+    sliceBlocks = RSYNC_CHECKSUM_FUSED_LEN / blockSize;
+    /*
+     * Keep at least one run of multi-buffer MD4 blocks per slice.
+     */
+    if ( md4DigestLen != 0 && sliceBlocks < md4_mb_lanes() )
+	sliceBlocks = md4_mb_lanes();
+    if ( sliceBlocks == 0 || blockSize > 0xffffffff / sliceBlocks )
+	sliceBlocks = 1;
+    sliceLen = sliceBlocks * blockSize;
+    while ( len > 0 ) {
+	UINT4 thisLen = len < sliceLen ? len : sliceLen;
+
+	rsync_checksum(buf, thisLen, blockSize, seed, digest, md4DigestLen);
+	RsyncMD4Update(fileCtx, buf, thisLen);
+	digest += rsync_checksum_size(thisLen, blockSize, md4DigestLen);
+	len    -= thisLen;
+	buf    += thisLen;
+    }
+}
+
+#ifdef HAVE_PTHREAD
+
+/*
+ * The work for one rsync_checksum_parallel() thread.
+ */
+typedef struct {
+    unsigned char *buf;
+    UINT4 len;
+    UINT4 blockSize;
+    UINT4 seed;
+    unsigned char *digest;
+    int md4DigestLen;
+} rsync_checksum_job;
+
+static void *rsync_checksum_thread(void *arg)
+{
+    rsync_checksum_job *job = (rsync_checksum_job *)arg;
+
+    rsync_checksum(job->buf, job->len, job->blockSize, job->seed,
+		   job->digest, job->md4DigestLen);
+    return NULL;
+}
+
+#endif
+
+/*
+ * Same as rsync_checksum(), but the blocks are split into nThreads
+ * contiguous runs which are done by separate threads, each writing
+ * to its own part of digest.  nThreads <= 0 means one thread per
+ * CPU.  Each thread gets at least RSYNC_CHECKSUM_MIN_THREAD_LEN bytes,
+ * so small buffers are done in the calling thread.
+ *
+ * If fileCtx is not NULL the data is also added to that file digest.
+ * The file MD4 can't be split, so the calling thread does it (fused
+ * with its own run) while the other threads do theirs.
+ */
+void rsync_checksum_parallel(unsigned char *buf, UINT4 len, UINT4 blockSize,
+    UINT4 seed, unsigned char *digest, int md4DigestLen, int nThreads,
+    RsyncMD4_CTX *fileCtx)
+{
+#ifdef HAVE_PTHREAD
+    rsync_checksum_job job[RSYNC_CHECKSUM_MAX_THREADS];
+    pthread_t tid[RSYNC_CHECKSUM_MAX_THREADS];
+    int started[RSYNC_CHECKSUM_MAX_THREADS];
+    UINT4 nBlocks, blk = 0, i, adler32Init[2] = {0, 0};
+
+    if ( blockSize == 0 )
+	blockSize = 700;
+    if ( nThreads <= 0 ) {
+	long nCpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+	nThreads = nCpu > 0 ? nCpu : 1;
+    }
+    if ( nThreads > RSYNC_CHECKSUM_MAX_THREADS )
+	nThreads = RSYNC_CHECKSUM_MAX_THREADS;
+    if ( (UINT4)nThreads > len / RSYNC_CHECKSUM_MIN_THREAD_LEN )
+	nThreads = len / RSYNC_CHECKSUM_MIN_THREAD_LEN;
+    nBlocks = (len + blockSize - 1) / blockSize;
+    if ( (UINT4)nThreads > nBlocks )
+	nThreads = nBlocks;
+    if ( nThreads <= 1 ) {
+	if ( fileCtx ) {
+	    rsync_checksum_file(buf, len, blockSize, seed, digest,
+				md4DigestLen, fileCtx);
+	} else {
+	    rsync_checksum(buf, len, blockSize, seed, digest, md4DigestLen);
+	}
+	return;
+    }
+
+    /*
+     * Pick the SIMD kernels now, rather than racing to do it in
+     * each thread.
+     */
+    md4_mb_lanes();
+    adler32_update((char *)buf, 0, &adler32Init[0], &adler32Init[1]);
+
+    for ( i = 0 ; i < (UINT4)nThreads ; i++ ) {
+	UINT4 cnt   = nBlocks / nThreads + (i < nBlocks % nThreads ? 1 : 0);
+	UINT4 start = blk * blockSize;
+	UINT4 end   = (blk + cnt) * blockSize;
+
+	if ( end > len ) end = len;
+	job[i].buf          = buf + start;
+	job[i].len          = end - start;
+	job[i].blockSize    = blockSize;
+	job[i].seed         = seed;
+	job[i].digest       = digest
+			    + rsync_checksum_size(start, blockSize, md4DigestLen);
+	job[i].md4DigestLen = md4DigestLen;
+	blk += cnt;
+    }
+    /*
+     * The calling thread does the first run.  If a thread can't be
+     * started its run is done here too.
+     */
+    for ( i = 1 ; i < (UINT4)nThreads ; i++ ) {
+	started[i] = pthread_create(&tid[i], NULL, rsync_checksum_thread,
+				    &job[i]) == 0;
+    }
+    if ( fileCtx ) {
+	rsync_checksum_file(job[0].buf, job[0].len, blockSize, seed,
+			    job[0].digest, md4DigestLen, fileCtx);
+	RsyncMD4Update(fileCtx, buf + job[0].len, len - job[0].len);
+    } else {
+	rsync_checksum_thread(&job[0]);
+    }
+    for ( i = 1 ; i < (UINT4)nThreads ; i++ ) {
+	if ( started[i] ) {
+	    pthread_join(tid[i], NULL);
+	} else {
+	    rsync_checksum_thread(&job[i]);
+	}
+    }
+#else
+    if ( fileCtx ) {
+	rsync_checksum_file(buf, len, blockSize, seed, digest,
+			    md4DigestLen, fileCtx);
+    } else {
+	rsync_checksum(buf, len, blockSize, seed, digest, md4DigestLen);
+    }
+#endif
+}
+
+/*
+ * rsync_checksum_update() using the multi-buffer MD4 code.
+ */
+static void rsync_checksum_update_mb(unsigned char *digestIn, UINT4 blockCnt,
+    UINT4 blockSize, UINT4 blockLastLen, unsigned char *seedBytes,
+    unsigned char *digestOut, int md4DigestLen, UINT4 lanes)
+{
+    UINT4 state[MD4_MB_LANES][4];
+    unsigned char *data[MD4_MB_LANES];
+    unsigned char md4Digest[MD4_MB_LANES][16];
+
+    while ( blockCnt > 0 ) {
+	/*
+	 * All but the last block have length blockSize
+	 */
+	UINT4 thisLen = blockCnt > 1 ? blockSize : blockLastLen;
+	UINT4 n = blockCnt > 1 ? blockCnt - 1 : 1, i;
+
+	if ( n > lanes ) n = lanes;
+	for ( i = 0 ; i < n ; i++ ) {
+	    memcpy(digestOut + i * (4 + md4DigestLen), digestIn, 4);
+	    RsyncMD4Decode(state[i], digestIn + 4, 16);
+	    data[i]   = digestIn + 20;
+	    digestIn += 20 + thisLen % 64;
+	}
+	md4_mb_final(state, data, n, thisLen % 64, thisLen - thisLen % 64,
+		     seedBytes, 1, md4Digest);
+	for ( i = 0 ; i < n ; i++ ) {
+	    memcpy(digestOut + 4, md4Digest[i], md4DigestLen);
+	    digestOut += 4 + md4DigestLen;
+	}
+	blockCnt -= n;
+    }
+}
+
 /*
  * Update the MD4 digest by adding the seed to the data.  Since
  * the rsync seed changes each time we need to add the seed.
@@ -134,6 +530,7 @@ void rsync_checksum_update(unsigned char *digestIn, UINT4 blockCnt,
     unsigned char *digestOut, int md4DigestLen)
 {
     unsigned char seedBytes[4];
+    UINT4 lanes;
 
     if ( seed ) {
 	RsyncMD4Encode(seedBytes, &seed, 1);
@@ -141,6 +538,11 @@ void rsync_checksum_update(unsigned char *digestIn, UINT4 blockCnt,
     if ( md4DigestLen > 16 || md4DigestLen < 0 ) {
 	md4DigestLen = 16;
     }
+    if ( (lanes = md4_mb_lanes()) > 1 ) {
+	rsync_checksum_update_mb(digestIn, blockCnt, blockSize, blockLastLen,
+			seed ? seedBytes : NULL, digestOut, md4DigestLen, lanes);
+	return;
+    }
     while ( blockCnt-- ) {
         RsyncMD4_CTX md4;
 	/*
@@ -0,0 +1,133 @@
+/*
+ * RSYNC_LIB.H - prototypes and rolling checksum macros for rsync_lib.c
+ */
+
+#include <stddef.h>
+#include <sys/types.h>
+
+/*
+ * Combine the two halves of the adler32 checksum into the 32 bit
+ * value that rsync sends (same as adler32_checksum()).
+ */
+#define ADLER32_SUM(s1, s2)	TO32(((s1) & 0xffff) + (((s2) & 0xffff) << 16))
+
+/*
+ * Roll a window of length len forward one byte: remove the signed
+ * char out from the start and append the signed char in at the end.
+ */
+#define ADLER32_ROLL(s1, s2, len, out, in) { \
+    (s1) += (in) - (out); \
+    (s2) += (s1) - (UINT4)(len) * (out); \
+  }
+
+/*
+ * Append the signed char in to the end of the window (window grows).
+ */
+#define ADLER32_ROLL_IN(s1, s2, in) { \
+    (s1) += (in); \
+    (s2) += (s1); \
+  }
+
+/*
+ * Remove the signed char out from the start of a window of length
+ * len (window shrinks to len - 1).
+ */
+#define ADLER32_ROLL_OUT(s1, s2, len, out) { \
+    (s1) -= (out); \
+    (s2) -= (UINT4)(len) * (out); \
+  }
+
+/*
+ * A set of adler32 checksums for adler32_scan().  The bitmap is a
+ * quick filter on 16 bits of the checksum; candidates are confirmed
+ * with a binary search of the sorted checksums.
+ */
+typedef struct {
+    UINT4 cnt;
+    UINT4 *sums;
+    unsigned char bits[65536 / 8];
+} adler32_set;
+
+/*
+ * Position of a scan through a buffer with adler32_scan().
+ */
+typedef struct {
+    UINT4 offset;		/* next window start to check */
+    UINT4 s1, s2;		/* checksum of the window at offset */
+    int valid;			/* s1, s2 are valid */
+} adler32_scan_state;
+
+/*
+ * Maximum number of messages hashed at once by md4_mb_blocks().
+ */
+#define MD4_MB_LANES	8
+
+/*
+ * Limits on the threads used by rsync_checksum_parallel()
+ */
+#define RSYNC_CHECKSUM_MAX_THREADS	64
+#define RSYNC_CHECKSUM_MIN_THREAD_LEN	(256 * 1024)
+
+/*
+ * Slice size for rsync_checksum_file(), small enough that each slice
+ * stays in the cache between the block and file digests.
+ */
+#define RSYNC_CHECKSUM_FUSED_LEN	(32 * 1024)
+
+/*
+ * A chunk of file data returned by fd_chunk_get(), read into a
+ * malloc()ed buffer.
+ */
+typedef struct {
+    unsigned char *data;	/* start of the file data */
+    UINT4 len;			/* bytes of data; 0 at end of file */
+    unsigned char *buf;		/* malloc()ed buffer, if any */
+} fd_chunk;
+
+/*
+ * Largest chunk read at once when adding the rest of a file to a
+ * file digest.
+ */
+#define FD_CHUNK_MAX_LEN	(1024 * 1024)
+
+int fd_chunk_get(int fd, UINT4 maxLen, fd_chunk *chunk);
+void fd_chunk_free(fd_chunk *chunk);
+/*
+ * fd_copy_range() state flags: the kernel copies that failed for a file
+ */
+#define FD_COPY_NO_CLONE	(1 << 0)
+#define FD_COPY_NO_RANGE	(1 << 1)
+
+int fd_copy_range(int inFd, off_t offset, off_t len, int outFd,
+		RsyncMD4_CTX *ctx, int *state);
+int fd_prefetch(char *path, off_t len);
+void adler32_update(char *buf, UINT4 len, UINT4 *s1p, UINT4 *s2p);
+char *adler32_kernel_name(int n);
+int adler32_kernel_set(char *name);
+char *md4_mb_kernel_name(int n);
+int md4_mb_kernel_set(char *name);
+UINT4 md4_mb_lanes(void);
+void md4_mb_init(UINT4 state[][4], UINT4 n);
+void md4_mb_blocks(UINT4 state[][4], unsigned char **data, UINT4 n, UINT4 cnt);
+void md4_mb_final(UINT4 state[][4], unsigned char **data, UINT4 n, UINT4 len,
+		UINT4 done, unsigned char *seedBytes, int rsyncMD4Bug,
+		unsigned char digest[][16]);
+UINT4 adler32_checksum(char *buf1, int len);
+void adler32_parts(char *buf1, UINT4 len, UINT4 *s1p, UINT4 *s2p);
+adler32_set *adler32_set_new(unsigned char *sums, UINT4 cnt, UINT4 stride);
+int adler32_set_member(adler32_set *set, UINT4 sum);
+void adler32_set_free(adler32_set *set);
+UINT4 adler32_scan(char *buf1, UINT4 len, UINT4 blockSize, adler32_set *set,
+		adler32_scan_state *state, UINT4 *result, UINT4 maxResult);
+void rsync_checksum(unsigned char *buf, UINT4 len, UINT4 blockSize,
+		UINT4 seed, unsigned char *digest, int md4DigestLen);
+UINT4 rsync_checksum_size(UINT4 len, UINT4 blockSize, int md4DigestLen);
+void rsync_checksum_file(unsigned char *buf, UINT4 len, UINT4 blockSize,
+		UINT4 seed, unsigned char *digest, int md4DigestLen,
+		RsyncMD4_CTX *fileCtx);
+void rsync_checksum_parallel(unsigned char *buf, UINT4 len, UINT4 blockSize,
+		UINT4 seed, unsigned char *digest, int md4DigestLen,
+		int nThreads, RsyncMD4_CTX *fileCtx);
+void rsync_checksum_update(unsigned char *digestIn, UINT4 blockCnt,
+		UINT4 blockSize, UINT4 blockLastLen, UINT4 seed,
+		unsigned char *digestOut, int md4DigestLen);
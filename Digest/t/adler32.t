@@ -0,0 +1,111 @@
+#!/bin/perl
+
+BEGIN {print "1..6\n";}
+END {print "not ok 1\n" unless $loaded;}
+use File::RsyncP::Digest;
+$loaded = 1;
+print "ok 1\n";
+
+my $rsDigest = new File::RsyncP::Digest;
+
+srand(1);
+my $data = join("", map { chr(int(rand(256))) } (1..5000));
+
+#
+# The adler32 of a block, as returned by blockDigest with no MD4
+#
+sub adler32
+{
+    my($str) = @_;
+
+    return unpack("V", $rsDigest->blockDigest($str, length($str), 0, 0));
+}
+
+#
+# adler32Start + adler32Sum agrees with blockDigest
+#
+my($s1, $s2) = $rsDigest->adler32Start(substr($data, 0, 700));
+if ( $rsDigest->adler32Sum($s1, $s2) == adler32(substr($data, 0, 700)) ) {
+    print "ok 2\n";
+} else {
+    print "not ok 2\n";
+}
+
+#
+# Rolling the window forward agrees with recomputing it
+#
+my $failed = 0;
+for ( my $i = 0 ; $i + 700 < length($data) ; $i++ ) {
+    ($s1, $s2) = $rsDigest->adler32Roll($s1, $s2, 700, substr($data, $i, 1),
+                                        substr($data, $i + 700, 1));
+    next if ( $i % 97 );
+    $failed++ if ( $rsDigest->adler32Sum($s1, $s2)
+                        != adler32(substr($data, $i + 1, 700)) );
+}
+print $failed ? "not ok 3\n" : "ok 3\n";
+
+#
+# Growing and shrinking the window
+#
+($s1, $s2) = $rsDigest->adler32Start("");
+for ( my $i = 0 ; $i < 100 ; $i++ ) {
+    ($s1, $s2) = $rsDigest->adler32Roll($s1, $s2, $i, undef,
+                                        substr($data, $i, 1));
+}
+my $grow = $rsDigest->adler32Sum($s1, $s2) == adler32(substr($data, 0, 100));
+for ( my $i = 0 ; $i < 40 ; $i++ ) {
+    ($s1, $s2) = $rsDigest->adler32Roll($s1, $s2, 100 - $i,
+                                        substr($data, $i, 1), undef);
+}
+if ( $grow
+        && $rsDigest->adler32Sum($s1, $s2) == adler32(substr($data, 40, 60)) ) {
+    print "ok 4\n";
+} else {
+    print "not ok 4\n";
+}
+
+#
+# Scanning for block checksums finds the shifted blocks
+#
+my $sums = $rsDigest->blockDigest($data, 500, 2, 0);
+my %hits = unpack("V*", $rsDigest->adler32Scan("xyz" . $data, 500, $sums, 6));
+$failed = 0;
+for ( my $blk = 0 ; $blk < 10 ; $blk++ ) {
+    my $sum = unpack("V", substr($sums, $blk * 6, 4));
+    $failed++ if ( $hits{3 + $blk * 500} != $sum );
+}
+print $failed ? "not ok 5\n" : "ok 5\n";
+
+#
+# Every adler32 kernel supported by this CPU (eg: SSE2, AVX2) must
+# agree with the portable C version for all lengths and alignments.
+#
+my @kernels = File::RsyncP::Digest->adler32Kernels();
+File::RsyncP::Digest->adler32KernelSet("c");
+my @lens = (0..100, 255, 256, 257, 700, 1023, 4097, 16384);
+my %ref;
+foreach my $len ( @lens ) {
+    for ( my $off = 0 ; $off < 3 ; $off++ ) {
+        $ref{"$len,$off"} = [$rsDigest->adler32Start(substr($data, $off, $len)),
+                        $rsDigest->blockDigest(substr($data x 4, $off, $len),
+                                               64, 0, 0)];
+    }
+}
+$failed = 0;
+foreach my $kernel ( @kernels ) {
+    if ( !File::RsyncP::Digest->adler32KernelSet($kernel) ) {
+        $failed++;
+        next;
+    }
+    foreach my $len ( @lens ) {
+        for ( my $off = 0 ; $off < 3 ; $off++ ) {
+            my $r = $ref{"$len,$off"};
+            my($s1, $s2) = $rsDigest->adler32Start(substr($data, $off, $len));
+            $failed++ if ( $s1 != $r->[0] || $s2 != $r->[1]
+                    || $rsDigest->blockDigest(substr($data x 4, $off, $len),
+                                              64, 0, 0) ne $r->[2] );
+        }
+    }
+}
+File::RsyncP::Digest->adler32KernelSet();
+print $failed || $kernels[0] ne "c" ? "not ok 6\n" : "ok 6\n";
@@ -1,6 +1,6 @@
 #!/bin/perl
 
-BEGIN {print "1..4\n";}
+BEGIN {print "1..13\n";}
 END {print "not ok 1\n" unless $loaded;}
 use File::RsyncP::Digest;
 $loaded = 1;
@@ -35,3 +35,277 @@ if ( unpack("H*", $digest) eq "3c09a624641bf80b0ce3abd208e8645d5b49" ) {
     print "not ok 4\n";
 }
 
+
+#
+# Every multi-buffer MD4 kernel supported by this CPU (eg: SSE2, AVX2)
+# must agree with the scalar version, for block sizes around multiples
+# of 64 (the rsyncMD4Bug cases), with and without a seed.
+#
+srand(1);
+$data = join("", map { chr(int(rand(256))) } (1..20000));
+my @kernels = File::RsyncP::Digest->md4Kernels();
+my @tests;
+foreach my $blockSize ( 1, 55, 56, 60, 63, 64, 65, 119, 124, 128, 700, 2048 ) {
+    foreach my $len ( 0, 1, $blockSize * 9, $blockSize * 9 + 7, 20000 ) {
+        foreach my $seed ( 0, 0x12345678 ) {
+            push(@tests, [substr($data, 0, $len), $blockSize, $seed]);
+        }
+    }
+}
+sub md4Digests
+{
+    my($d, $blockSize, $seed) = @_;
+    my $state = $rsDigest->blockDigest($d, $blockSize, -1, 0);
+    my @d = ($rsDigest->blockDigest($d, $blockSize, 16, $seed),
+             $rsDigest->blockDigest($d, $blockSize, 2, $seed),
+             $rsDigest->blockDigest($d, $blockSize, -1, $seed),
+             $state);
+
+    push(@d, $rsDigest->blockDigestUpdate($state, $blockSize,
+                           (length($d) % $blockSize) || $blockSize, 16, $seed),
+             $rsDigest->blockDigestUpdate($state, $blockSize,
+                           (length($d) % $blockSize) || $blockSize, 3, 0))
+                if ( length($d) );
+    return join(",", map { unpack("H*", $_) } @d);
+}
+File::RsyncP::Digest->md4KernelSet("c");
+my @ref = map { md4Digests(@$_) } @tests;
+my $failed = 0;
+foreach my $kernel ( @kernels ) {
+    if ( !File::RsyncP::Digest->md4KernelSet($kernel) ) {
+        $failed++;
+        next;
+    }
+    for ( my $i = 0 ; $i < @tests ; $i++ ) {
+        $failed++ if ( md4Digests(@{$tests[$i]}) ne $ref[$i] );
+    }
+}
+File::RsyncP::Digest->md4KernelSet();
+print $failed || $kernels[0] ne "c" ? "not ok 5\n" : "ok 5\n";
+
+#
+# blockDigestParallel gives the same output as blockDigest, however
+# the blocks are split across the threads.
+#
+my $big = $data x 120;
+$failed = 0;
+foreach my $t ( [700, 16, 0x12345678, 4], [700, 2, 0, 3], [4096, -1, 0, 5],
+                [64, 16, 1, 0], [2048, 16, 1, 1] ) {
+    my($blockSize, $md4DigestLen, $seed, $threads) = @$t;
+    foreach my $len ( length($big), length($big) - 1, 300000, 1000 ) {
+        $failed++ if ( $rsDigest->blockDigestParallel(substr($big, 0, $len),
+                                $blockSize, $md4DigestLen, $seed, $threads)
+                    ne $rsDigest->blockDigest(substr($big, 0, $len),
+                                $blockSize, $md4DigestLen, $seed) );
+    }
+}
+print $failed ? "not ok 6\n" : "ok 6\n";
+
+#
+# Appending the output to a caller-supplied buffer
+#
+my($out, $expect) = ("prefix", "prefix");
+$failed = 0;
+for ( my $i = 0 ; $i < length($data) ; $i += 7000 ) {
+    my $d = substr($data, $i, 7000);
+    my $n = $rsDigest->blockDigest($d, 700, 16, 5, $out);
+    $expect .= $rsDigest->blockDigest($d, 700, 16, 5);
+    $failed++ if ( $n != 20 * int((length($d) + 699) / 700) );
+}
+$state = $rsDigest->blockDigest($data, 700, -1, 0);
+$rsDigest->blockDigestUpdate($state, 700, length($data) % 700, 2, 5, $out);
+$rsDigest->blockDigestParallel($data, 700, 16, 5, 2, $out);
+$rsDigest->blockDigestExtract($digest16, 2, $out);
+$expect .= $rsDigest->blockDigestUpdate($state, 700, length($data) % 700, 2, 5)
+         . $rsDigest->blockDigestParallel($data, 700, 16, 5, 2)
+         . $rsDigest->blockDigestExtract($digest16, 2);
+$failed++ if ( $rsDigest->blockDigest($data, 700, 2, 0, undef)
+                    ne $rsDigest->blockDigest($data, 700, 2, 0) );
+print $failed || $out ne $expect ? "not ok 7\n" : "ok 7\n";
+
+#
+# blockDigestFd reads the file itself, and adds the same data to the
+# file digest.  The file offset is shared with sysread.
+#
+my $tmpFile = "blockDigestFd.tmp";
+$failed = 0;
+if ( open(F, ">", $tmpFile) ) {
+    binmode(F);
+    print F $big;
+    close(F);
+}
+if ( open(F, "<", $tmpFile) ) {
+    binmode(F);
+    my $fileDigest = File::RsyncP::Digest->new(28);
+    my $md4        = File::RsyncP::Digest->new(28);
+    my($got, $ref, $offset) = ("", "", 0);
+
+    sysread(F, my $head, 1000);
+    $offset = 1000;
+    $fileDigest->add($head);
+    for ( my $i = 0 ; $i < 3 ; $i++ ) {
+        $got .= $rsDigest->blockDigestFd(fileno(F), 333, 700, 16, 0x1234,
+                                         $fileDigest, 2);
+    }
+    $ref = $rsDigest->blockDigest(substr($big, 1000, 333 * 700 * 3),
+                                  700, 16, 0x1234);
+    $failed++ if ( $got ne $ref );
+    $offset += 333 * 700 * 3;
+    sysread(F, my $mid, 12345);
+    $fileDigest->add($mid);
+    $offset += 12345;
+    $failed++ if ( $rsDigest->blockDigestFd(fileno(F), 100, 700, 2, 0,
+                                            undef, 1, $got) != 600 );
+    $offset += 70000;
+    $failed++ if ( $fileDigest->addFd(fileno(F)) != length($big) - $offset );
+    $failed++ if ( $fileDigest->digest
+                    ne $md4->add(substr($big, 0, $offset - 70000),
+                                 substr($big, $offset))->digest );
+    $failed++ if ( defined($rsDigest->blockDigestFd(fileno(F), 10, 700)) );
+    close(F);
+} else {
+    $failed++;
+}
+print $failed ? "not ok 8\n" : "ok 8\n";
+
+#
+# blockDigestAdd, and blockDigestFd with a file digest and several
+# threads, give the same results as separate add and blockDigest.
+#
+$failed = 0;
+foreach my $t ( [700, 16], [2048, 2], [64, -1], [16384, 0], [1, 16] ) {
+    my($blockSize, $md4DigestLen) = @$t;
+    my $d = $blockSize == 1 ? substr($big, 0, 70001) : $big;
+    my $sep   = File::RsyncP::Digest->new(28);
+    my $fused = File::RsyncP::Digest->new(28);
+
+    $sep->add($d);
+    $failed++ if ( $fused->blockDigestAdd($d, $blockSize, $md4DigestLen, 9)
+                ne $rsDigest->blockDigest($d, $blockSize, $md4DigestLen, 9) );
+    $failed++ if ( $fused->digest ne $sep->digest );
+}
+if ( open(F, "<", $tmpFile) ) {
+    binmode(F);
+    my $fileDigest = File::RsyncP::Digest->new(28);
+
+    $failed++ if ( $rsDigest->blockDigestFd(fileno(F), 3000, 700, 16, 5,
+                                            $fileDigest, 4)
+                    ne $rsDigest->blockDigest(substr($big, 0, 2100000),
+                                              700, 16, 5) );
+    $fileDigest->addFd(fileno(F));
+    $failed++ if ( $fileDigest->digest
+                    ne File::RsyncP::Digest->new(28)->add($big)->digest );
+    close(F);
+} else {
+    $failed++;
+}
+print $failed ? "not ok 9\n" : "ok 9\n";
+
+#
+# literalFd returns literal data tokens and adds the data to the digest
+#
+$failed = 0;
+if ( open(F, "<", $tmpFile) ) {
+    binmode(F);
+    my $fileDigest = File::RsyncP::Digest->new(28);
+    my($got, $expect) = ("", "");
+
+    for ( my $i = 0 ; $i < length($big) ; $i += 100000 ) {
+        my $d = substr($big, $i, 100000);
+        $expect .= pack("V a*", length($d), $d);
+    }
+    while ( defined(my $token = $fileDigest->literalFd(fileno(F), 100000)) ) {
+        $got .= $token;
+    }
+    $failed++ if ( $got ne $expect );
+    $failed++ if ( $fileDigest->digest
+                    ne File::RsyncP::Digest->new(28)->add($big)->digest );
+    close(F);
+} else {
+    $failed++;
+}
+print $failed ? "not ok 10\n" : "ok 10\n";
+
+#
+# copyRangeFd copies part of a file to the current offset of another,
+# and adds the data to the digest.
+#
+$failed = 0;
+my $outFile = "copyRangeFd.tmp";
+if ( open(F, "<", $tmpFile) && open(OUT, "+>", $outFile) ) {
+    binmode(F);
+    binmode(OUT);
+    my $fileDigest = File::RsyncP::Digest->new(28);
+    my $expect = "";
+    my $state = 0;
+
+    foreach my $r ( [0, 4096], [700, 1400000], [8192, 0], [100, 1],
+                    [length($big) - 12345, 12345] ) {
+        $failed++ if ( $fileDigest->copyRangeFd(fileno(F), $r->[0], $r->[1],
+                                                fileno(OUT), $state)
+                            != $r->[1] );
+        $expect .= substr($big, $r->[0], $r->[1]);
+        syswrite(OUT, "gap");
+        $expect .= "gap";
+    }
+    $failed++ if ( defined($fileDigest->copyRangeFd(fileno(F), length($big),
+                                                    1, fileno(OUT))) );
+    $failed++ if ( $state !~ /^[0-3]$/ );
+    sysseek(OUT, 0, 0);
+    my $got = "";
+    while ( sysread(OUT, $got, 65536, length($got)) > 0 ) { }
+    $failed++ if ( $got ne $expect );
+    $expect =~ s/gap//g;
+    $failed++ if ( $fileDigest->digest
+                    ne File::RsyncP::Digest->new(28)->add($expect)->digest );
+    close(F);
+    close(OUT);
+} else {
+    $failed++;
+}
+unlink($tmpFile, $outFile);
+print $failed ? "not ok 11\n" : "ok 11\n";
+
+#
+# prefetchFile only gives the hint for regular files (on linux, which
+# has posix_fadvise).
+#
+$failed = 0;
+if ( open(F, ">", $tmpFile) ) {
+    print F $data;
+    close(F);
+    my $ok = $^O eq "linux" ? 1 : 0;
+    $failed++ if ( File::RsyncP::Digest->prefetchFile($tmpFile) != $ok );
+    $failed++ if ( File::RsyncP::Digest->prefetchFile($tmpFile, 700) != $ok );
+    $failed++ if ( File::RsyncP::Digest->prefetchFile(".") );
+    unlink($tmpFile);
+    $failed++ if ( File::RsyncP::Digest->prefetchFile($tmpFile) );
+} else {
+    $failed++;
+}
+print $failed ? "not ok 12\n" : "ok 12\n";
+
+#
+# A file truncated while it is being read just gives less data.
+#
+$failed = 0;
+if ( open(F, ">", $tmpFile) ) {
+    binmode(F);
+    print F $big;
+    close(F);
+}
+if ( open(F, "<", $tmpFile) ) {
+    binmode(F);
+    my $fileDigest = File::RsyncP::Digest->new(28);
+    my $token = $fileDigest->literalFd(fileno(F), 65536);
+    $failed++ if ( !defined($token) || length($token) != 4 + 65536 );
+    truncate($tmpFile, 100000);
+    $failed++ if ( $fileDigest->addFd(fileno(F)) != 100000 - 65536 );
+    $failed++ if ( $fileDigest->digest ne File::RsyncP::Digest->new(28)
+                                        ->add(substr($big, 0, 100000))->digest );
+    close(F);
+} else {
+    $failed++;
+}
+unlink($tmpFile);
+print $failed ? "not ok 13\n" : "ok 13\n";
@@ -0,0 +1,138 @@
+#!/bin/perl
+
+BEGIN {print "1..8\n";}
+END {print "not ok 1\n" unless $loaded;}
+use File::RsyncP::Digest;
+$loaded = 1;
+print "ok 1\n";
+
+#
+# Rebuild the new file from the basis file and the delta tokens,
+# the same way the remote receiver does.
+#
+sub deltaApply
+{
+    my($basis, $blkSize, $tokens) = @_;
+    my($out, $i) = ("", 0);
+
+    while ( $i < length($tokens) ) {
+        my $n = unpack("V", substr($tokens, $i, 4));
+        $i += 4;
+        if ( $n >= 0x80000000 ) {
+            $out .= substr($basis, (0xffffffff - $n) * $blkSize, $blkSize);
+        } else {
+            $out .= substr($tokens, $i, $n);
+            $i += $n;
+        }
+    }
+    return $out;
+}
+
+sub delta
+{
+    my($basis, $new, $blkSize, $csumLen, $seed, $chunkSize) = @_;
+    my $rsDigest = new File::RsyncP::Digest;
+    my $csums    = $rsDigest->blockDigest($basis, $blkSize, $csumLen, $seed);
+    my $delta    = $rsDigest->deltaNew($csums, $blkSize,
+                                       length($basis) % $blkSize,
+                                       $csumLen, $seed);
+    my $tokens   = "";
+
+    $chunkSize ||= length($new) || 1;
+    for ( my $i = 0 ; $i < length($new) ; $i += $chunkSize ) {
+        $tokens .= $delta->add(substr($new, $i, $chunkSize));
+    }
+    $tokens .= $delta->finish;
+    return ($tokens, $delta->matchCnt, $delta->literalBytes);
+}
+
+srand(1);
+my $basis = join("", map { chr(int(rand(256))) } (1..20000));
+
+#
+# Identical file: every block matches, including the partial last block
+#
+my($tokens, $matchCnt, $literal) = delta($basis, $basis, 700, 2, 0x12345678);
+if ( $matchCnt == 29 && $literal == 0
+        && deltaApply($basis, 700, $tokens) eq $basis ) {
+    print "ok 2\n";
+} else {
+    print "not ok 2\n";
+}
+
+#
+# Insert and delete some bytes: only the touched blocks are literal
+#
+my $new = substr($basis, 0, 5000) . "inserted data"
+        . substr($basis, 5000, 7000) . substr($basis, 12345);
+($tokens, $matchCnt, $literal) = delta($basis, $new, 700, 16, 0x12345678);
+if ( $matchCnt >= 25 && $literal < 2000
+        && deltaApply($basis, 700, $tokens) eq $new ) {
+    print "ok 3\n";
+} else {
+    print "not ok 3\n";
+}
+
+#
+# Feeding the data in odd sized pieces gives the same tokens
+#
+my($tokens2) = delta($basis, $new, 700, 16, 0x12345678, 333);
+print $tokens2 eq $tokens ? "ok 4\n" : "not ok 4\n";
+
+#
+# No remote blocks: the whole file is literal data
+#
+($tokens, $matchCnt, $literal) = delta("", $new, 700, 2, 0);
+if ( $matchCnt == 0 && $literal == length($new)
+        && deltaApply("", 700, $tokens) eq $new ) {
+    print "ok 5\n";
+} else {
+    print "not ok 5\n";
+}
+
+#
+# Block size multiple of 64 (with the seed), protocol 28 MD4
+#
+my $rsDigest = new File::RsyncP::Digest(28);
+my $csums    = $rsDigest->blockDigest($basis, 700, 16, 0);
+my $delta    = $rsDigest->deltaNew($csums, 700, length($basis) % 700, 16, 0);
+$tokens      = $delta->add($basis) . $delta->finish;
+if ( $delta->matchCnt == 29 && deltaApply($basis, 700, $tokens) eq $basis ) {
+    print "ok 6\n";
+} else {
+    print "not ok 6\n";
+}
+
+#
+# Runs of matching blocks, which are checked several at a time with
+# the multi-buffer MD4 kernels, give the same tokens as the scalar
+# kernel, and are the same as the tokens from matchTokens().
+#
+my $failed = 0;
+my $dup = substr($basis, 0, 6400) x 2 . substr($basis, 3000);
+foreach my $t ( [$basis, 700, 2, 0x12345678, 0],
+                [$new, 700, 16, 0x12345678, 333],
+                [$dup, 640, 16, 0, 1000],
+                [$dup, 640, 3, 5, 0] ) {
+    my %tokens;
+    foreach my $kernel ( File::RsyncP::Digest->md4Kernels ) {
+        File::RsyncP::Digest->md4KernelSet($kernel);
+        my($b) = $t->[0] eq $dup ? $dup : $basis;
+        ($tokens{$kernel}) = delta($b, $t->[0], @$t[1..4]);
+        $failed++ if ( deltaApply($b, $t->[1], $tokens{$kernel}) ne $t->[0] );
+    }
+    File::RsyncP::Digest->md4KernelSet();
+    $failed++ if ( keys(%{{map { $_ => 1 } values(%tokens)}}) != 1 );
+}
+($tokens) = delta($basis, $basis, 700, 16, 0);
+$failed++ if ( $tokens ne File::RsyncP::Digest->matchTokens(0, 29) );
+print $failed ? "not ok 7\n" : "ok 7\n";
+
+$failed = 0;
+$failed++ if ( File::RsyncP::Digest->matchTokens(5, 3)
+                    ne pack("V*", 0xfffffffa, 0xfffffff9, 0xfffffff8) );
+my $out = "abc";
+$failed++ if ( File::RsyncP::Digest->matchTokens(0, 2, $out) != 8
+                    || $out ne "abc" . pack("V*", 0xffffffff, 0xfffffffe) );
+$failed++ if ( File::RsyncP::Digest->matchTokens(7, 0) ne "" );
+print $failed ? "not ok 8\n" : "ok 8\n";
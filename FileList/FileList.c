@@ -0,0 +1,1593 @@
+/*
+ * This file was generated automatically by ExtUtils::ParseXS version 3.45 from the
+ * contents of FileList.xs. Do not edit this file, edit FileList.xs instead.
+ *
+ *    ANY CHANGES MADE HERE WILL BE LOST!
+ *
+ */
+
+#line 1 "FileList.xs"
+#include "EXTERN.h"
+#include "perl.h"
+#include "XSUB.h"
+#include "string.h"
+#include "rsync.h"
+#include <sys/stat.h>
+
+typedef struct file_list *File__RsyncP__FileList;
+
+/*
+ * Pick an integer setting out of the hash ref opts.  If the argument
+ * isn't a hash, or doesn't contain param, then returns def.
+ */
+static int getHashInt(SV *opts, char *param, int def)
+{
+    SV **vp;
+
+    if ( !opts || !SvROK(opts)
+               || SvTYPE(SvRV(opts)) != SVt_PVHV
+               || !(vp = hv_fetch((HV*)SvRV(opts), param, strlen(param), 0))
+               || !*vp ) {
+        return def;
+    }
+    return SvIV(*vp);
+}
+
+/*
+ * Pick an unsigned integer setting out of the hash ref opts.  If the
+ * argument isn't a hash, or doesn't contain param, then returns def.
+ */
+static unsigned int getHashUInt(SV *opts, char *param, int def)
+{
+    SV **vp;
+
+    if ( !opts || !SvROK(opts)
+               || SvTYPE(SvRV(opts)) != SVt_PVHV
+               || !(vp = hv_fetch((HV*)SvRV(opts), param, strlen(param), 0))
+               || !*vp ) {
+        return def;
+    }
+    return SvUV(*vp);
+}
+
+/*
+ * Pick a string setting out of the hash ref opts.  If the argument
+ * isn't a hash, or doesn't contain param, then returns def.
+ */
+static int getHashString(SV *opts, char *param, char *def,
+                          char *result, int maxLen)
+{
+    SV **vp;
+    char *str;
+    STRLEN len;
+
+    if ( !opts || !SvROK(opts)
+               || SvTYPE(SvRV(opts)) != SVt_PVHV
+               || !(vp = hv_fetch((HV*)SvRV(opts), param, strlen(param), 0))
+               || !*vp ) {
+        if ( !def )
+            return -1;
+        strcpy(result, def);
+        return 0;
+    } else {
+        str = (char*)SvPV(*vp, len);
+        if ( len >= maxLen ) {
+            return -1;
+        }
+        memcpy(result, str, len);
+        result[len] = '\0';
+    }
+    return 0;
+}
+
+/*
+ * Pick a double setting out of the hash ref opts.  If the argument
+ * isn't a hash, or doesn't contain param, then returns def.
+ */
+static double getHashDouble(SV *opts, char *param, double def)
+{
+    SV **vp;
+
+    if ( !opts || !SvROK(opts)
+               || SvTYPE(SvRV(opts)) != SVt_PVHV
+               || !(vp = hv_fetch((HV*)SvRV(opts), param, strlen(param), 0))
+               || !*vp ) {
+        return def;
+    }
+    return SvNV(*vp);
+}
+
+/*
+ * Check if a hash value defined.
+ */
+static int isHashDefined(SV *opts, char *param)
+{
+    SV **vp;
+
+    if ( !opts || !SvROK(opts)
+               || SvTYPE(SvRV(opts)) != SVt_PVHV
+               || !(vp = hv_fetch((HV*)SvRV(opts), param, strlen(param), 0))
+               || !*vp ) {
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Fields returned by fieldGet(), with the same names and values as
+ * the hash returned by get().
+ */
+enum flist_field {
+    FIELD_NAME, FIELD_BASENAME, FIELD_DIRNAME, FIELD_LINK, FIELD_SUM,
+    FIELD_UID, FIELD_GID, FIELD_MODE, FIELD_MTIME, FIELD_SIZE, FIELD_RDEV,
+    FIELD_DEV, FIELD_INODE, FIELD_HLINK, FIELD_HLINK_SELF, FIELD_FLAG
+};
+
+static char *flist_field_names[] = {
+    "name", "basename", "dirname", "link", "sum",
+    "uid", "gid", "mode", "mtime", "size", "rdev",
+    "dev", "inode", "hlink", "hlink_self", "flag", NULL
+};
+
+/*
+ * Return one field of a file list entry as a new SV, or undef if get()
+ * wouldn't include it.
+ */
+static SV *flist_field_sv(struct file_list *flist, struct file_struct *file,
+			  int field)
+{
+    switch ( field ) {
+      case FIELD_NAME:
+	return newSVpv(f_name(file), 0);
+      case FIELD_BASENAME:
+	return newSVpv(file->basename, 0);
+      case FIELD_DIRNAME:
+	return file->dirname ? newSVpv(file->dirname, 0) : &PL_sv_undef;
+      case FIELD_LINK:
+	return S_ISLNK(file->mode) && file->u.link
+		    ? newSVpv(file->u.link, 0) : &PL_sv_undef;
+      case FIELD_SUM:
+	return S_ISREG(file->mode) && file->u.sum
+		    ? newSVpv(file->u.sum, 0) : &PL_sv_undef;
+      case FIELD_UID:
+	return newSVnv((double)((unsigned)file->uid));
+      case FIELD_GID:
+	return newSVnv((double)((unsigned)file->gid));
+      case FIELD_MODE:
+	return newSVnv((double)((unsigned)file->mode));
+      case FIELD_MTIME:
+	return newSVnv((double)((unsigned)file->modtime));
+      case FIELD_SIZE:
+	return newSVnv(file->length);
+      case FIELD_RDEV:
+	return IS_DEVICE(file->mode) ? newSVnv((double)file->u.rdev)
+				     : &PL_sv_undef;
+      case FIELD_DEV:
+      case FIELD_INODE:
+	if ( !flist->preserve_hard_links || flist->link_idev_data_done
+		|| !file->link_u.idev )
+	    return &PL_sv_undef;
+	return newSVnv(field == FIELD_DEV ? file->link_u.idev->dev
+					  : file->link_u.idev->inode);
+      case FIELD_HLINK:
+      case FIELD_HLINK_SELF:
+	if ( !flist->preserve_hard_links || !flist->link_idev_data_done
+		|| !file->link_u.links )
+	    return &PL_sv_undef;
+	if ( field == FIELD_HLINK )
+	    return newSVpv(f_name(file->link_u.links->to), 0);
+	return file == file->link_u.links->to ? newSVnv((double)1.0)
+					      : &PL_sv_undef;
+      case FIELD_FLAG:
+	return newSVuv(file->flags & FLAG_USER_BOOL ? 1 : 0);
+    }
+    return &PL_sv_undef;
+}
+
+#line 188 "FileList.c"
+#ifndef PERL_UNUSED_VAR
+#  define PERL_UNUSED_VAR(var) if (0) var = var
+#endif
+
+#ifndef dVAR
+#  define dVAR		dNOOP
+#endif
+
+
+/* This stuff is not part of the API! You have been warned. */
+#ifndef PERL_VERSION_DECIMAL
+#  define PERL_VERSION_DECIMAL(r,v,s) (r*1000000 + v*1000 + s)
+#endif
+#ifndef PERL_DECIMAL_VERSION
+#  define PERL_DECIMAL_VERSION \
+	  PERL_VERSION_DECIMAL(PERL_REVISION,PERL_VERSION,PERL_SUBVERSION)
+#endif
+#ifndef PERL_VERSION_GE
+#  define PERL_VERSION_GE(r,v,s) \
+	  (PERL_DECIMAL_VERSION >= PERL_VERSION_DECIMAL(r,v,s))
+#endif
+#ifndef PERL_VERSION_LE
+#  define PERL_VERSION_LE(r,v,s) \
+	  (PERL_DECIMAL_VERSION <= PERL_VERSION_DECIMAL(r,v,s))
+#endif
+
+/* XS_INTERNAL is the explicit static-linkage variant of the default
+ * XS macro.
+ *
+ * XS_EXTERNAL is the same as XS_INTERNAL except it does not include
+ * "STATIC", ie. it exports XSUB symbols. You probably don't want that
+ * for anything but the BOOT XSUB.
+ *
+ * See XSUB.h in core!
+ */
+
+
+/* TODO: This might be compatible further back than 5.10.0. */
+#if PERL_VERSION_GE(5, 10, 0) && PERL_VERSION_LE(5, 15, 1)
+#  undef XS_EXTERNAL
+#  undef XS_INTERNAL
+#  if defined(__CYGWIN__) && defined(USE_DYNAMIC_LOADING)
+#    define XS_EXTERNAL(name) __declspec(dllexport) XSPROTO(name)
+#    define XS_INTERNAL(name) STATIC XSPROTO(name)
+#  endif
+#  if defined(__SYMBIAN32__)
+#    define XS_EXTERNAL(name) EXPORT_C XSPROTO(name)
+#    define XS_INTERNAL(name) EXPORT_C STATIC XSPROTO(name)
+#  endif
+#  ifndef XS_EXTERNAL
+#    if defined(HASATTRIBUTE_UNUSED) && !defined(__cplusplus)
+#      define XS_EXTERNAL(name) void name(pTHX_ CV* cv __attribute__unused__)
+#      define XS_INTERNAL(name) STATIC void name(pTHX_ CV* cv __attribute__unused__)
+#    else
+#      ifdef __cplusplus
+#        define XS_EXTERNAL(name) extern "C" XSPROTO(name)
+#        define XS_INTERNAL(name) static XSPROTO(name)
+#      else
+#        define XS_EXTERNAL(name) XSPROTO(name)
+#        define XS_INTERNAL(name) STATIC XSPROTO(name)
+#      endif
+#    endif
+#  endif
+#endif
+
+/* perl >= 5.10.0 && perl <= 5.15.1 */
+
+
+/* The XS_EXTERNAL macro is used for functions that must not be static
+ * like the boot XSUB of a module. If perl didn't have an XS_EXTERNAL
+ * macro defined, the best we can do is assume XS is the same.
+ * Dito for XS_INTERNAL.
+ */
+#ifndef XS_EXTERNAL
+#  define XS_EXTERNAL(name) XS(name)
+#endif
+#ifndef XS_INTERNAL
+#  define XS_INTERNAL(name) XS(name)
+#endif
+
+/* Now, finally, after all this mess, we want an ExtUtils::ParseXS
+ * internal macro that we're free to redefine for varying linkage due
+ * to the EXPORT_XSUB_SYMBOLS XS keyword. This is internal, use
+ * XS_EXTERNAL(name) or XS_INTERNAL(name) in your code if you need to!
+ */
+
+#undef XS_EUPXS
+#if defined(PERL_EUPXS_ALWAYS_EXPORT)
+#  define XS_EUPXS(name) XS_EXTERNAL(name)
+#else
+   /* default to internal */
+#  define XS_EUPXS(name) XS_INTERNAL(name)
+#endif
+
+#ifndef PERL_ARGS_ASSERT_CROAK_XS_USAGE
+#define PERL_ARGS_ASSERT_CROAK_XS_USAGE assert(cv); assert(params)
+
+/* prototype to pass -Wmissing-prototypes */
+STATIC void
+S_croak_xs_usage(const CV *const cv, const char *const params);
+
+STATIC void
+S_croak_xs_usage(const CV *const cv, const char *const params)
+{
+    const GV *const gv = CvGV(cv);
+
+    PERL_ARGS_ASSERT_CROAK_XS_USAGE;
+
+    if (gv) {
+        const char *const gvname = GvNAME(gv);
+        const HV *const stash = GvSTASH(gv);
+        const char *const hvname = stash ? HvNAME(stash) : NULL;
+
+        if (hvname)
+	    Perl_croak_nocontext("Usage: %s::%s(%s)", hvname, gvname, params);
+        else
+	    Perl_croak_nocontext("Usage: %s(%s)", gvname, params);
+    } else {
+        /* Pants. I don't think that it should be possible to get here. */
+	Perl_croak_nocontext("Usage: CODE(0x%" UVxf ")(%s)", PTR2UV(cv), params);
+    }
+}
+#undef  PERL_ARGS_ASSERT_CROAK_XS_USAGE
+
+#define croak_xs_usage        S_croak_xs_usage
+
+#endif
+
+/* NOTE: the prototype of newXSproto() is different in versions of perls,
+ * so we define a portable version of newXSproto()
+ */
+#ifdef newXS_flags
+#define newXSproto_portable(name, c_impl, file, proto) newXS_flags(name, c_impl, file, proto, 0)
+#else
+#define newXSproto_portable(name, c_impl, file, proto) (PL_Sv=(SV*)newXS(name, c_impl, file), sv_setpv(PL_Sv, proto), (CV*)PL_Sv)
+#endif /* !defined(newXS_flags) */
+
+#if PERL_VERSION_LE(5, 21, 5)
+#  define newXS_deffile(a,b) Perl_newXS(aTHX_ a,b,file)
+#else
+#  define newXS_deffile(a,b) Perl_newXS_deffile(aTHX_ a,b)
+#endif
+
+#line 332 "FileList.c"
+
+XS_EUPXS(XS_File__RsyncP__FileList_new); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_new)
+{
+    dVAR; dXSARGS;
+    if (items < 0 || items > 2)
+       croak_xs_usage(cv,  "packname = \"File::RsyncP::FileList\", opts = NULL");
+    {
+	char *	packname;
+	SV*	opts;
+	File__RsyncP__FileList	RETVAL;
+
+	if (items < 1)
+	    packname = "File::RsyncP::FileList";
+	else {
+	    packname = (char *)SvPV_nolen(ST(0))
+;
+	}
+
+	if (items < 2)
+	    opts = NULL;
+	else {
+	    opts = ST(1)
+;
+	}
+#line 187 "FileList.xs"
+    {
+        int preserve_hard_links = getHashInt(opts, "preserve_hard_links", 0);
+        RETVAL = flist_new(1, "FileList new", preserve_hard_links);
+        RETVAL->preserve_links   = getHashInt(opts, "preserve_links", 1);
+        RETVAL->preserve_uid     = getHashInt(opts, "preserve_uid",   1);
+        RETVAL->preserve_gid     = getHashInt(opts, "preserve_gid",   1);
+        RETVAL->preserve_devices = getHashInt(opts, "preserve_devices", 0);
+        RETVAL->always_checksum  = getHashInt(opts, "always_checksum", 0);
+        RETVAL->preserve_hard_links = preserve_hard_links;
+        RETVAL->protocol_version = getHashInt(opts, "protocol_version", 26);
+        RETVAL->eol_nulls        = getHashInt(opts, "from0", 0);
+        RETVAL->sort_threads     = getHashInt(opts, "sort_threads", 0);
+        RETVAL->sort_parallel_min = getHashInt(opts, "sort_parallel_min",
+                                               FLIST_SORT_PARALLEL_MIN);
+    }
+#line 374 "FileList.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = sv_newmortal();
+	    sv_setref_pv(RETVALSV, "File::RsyncP::FileList", (void*)RETVAL);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_DESTROY); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_DESTROY)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "flist");
+    {
+	File__RsyncP__FileList	flist;
+
+	if (SvROK(ST(0))) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else
+	    Perl_croak_nocontext("%s: %s is not a reference",
+			"File::RsyncP::FileList::DESTROY",
+			"flist")
+;
+#line 209 "FileList.xs"
+    {
+        flist_free(flist);
+    }
+#line 408 "FileList.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_count); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_count)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "flist");
+    {
+	File__RsyncP__FileList	flist;
+	unsigned int	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::count",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 217 "FileList.xs"
+    {
+        RETVAL = flist->count;
+    }
+#line 442 "FileList.c"
+	XSprePUSH;
+	PUSHu((UV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_fatalError); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_fatalError)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "flist");
+    {
+	File__RsyncP__FileList	flist;
+	unsigned int	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::fatalError",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 227 "FileList.xs"
+    {
+        RETVAL = flist->fatalError;
+    }
+#line 478 "FileList.c"
+	XSprePUSH;
+	PUSHu((UV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_decodeDone); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_decodeDone)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "flist");
+    {
+	File__RsyncP__FileList	flist;
+	unsigned int	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::decodeDone",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 237 "FileList.xs"
+    {
+        RETVAL = flist->decodeDone;
+    }
+#line 514 "FileList.c"
+	XSprePUSH;
+	PUSHu((UV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_decode); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_decode)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "flist, bytesSV");
+    {
+#line 246 "FileList.xs"
+	STRLEN nBytes;
+#line 531 "FileList.c"
+	File__RsyncP__FileList	flist;
+	SV *	bytesSV = ST(1)
+;
+	unsigned char *	bytes = (unsigned char *)SvPV(bytesSV, nBytes);
+	int	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::decode",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 252 "FileList.xs"
+    {
+        RETVAL = flistDecodeBytes(flist, bytes, nBytes);
+    }
+#line 556 "FileList.c"
+	XSprePUSH;
+	PUSHi((IV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_get); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_get)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "flist, index");
+    {
+	File__RsyncP__FileList	flist;
+	unsigned int	index = (unsigned int)SvUV(ST(1))
+;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::get",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 264 "FileList.xs"
+    {
+        HV *rh;
+        struct file_struct *file;
+
+        if ( index >= flist->count || !flist->files[index]->basename ) {
+            XSRETURN_UNDEF; 
+        }
+        file = flist->files[index];
+        rh = (HV *)sv_2mortal((SV *)newHV());
+        if ( file->basename )
+            hv_store(rh, "basename", 8, newSVpv(file->basename, 0), 0);
+        if ( file->dirname )
+            hv_store(rh, "dirname",  7, newSVpv(file->dirname, 0), 0);
+        if ( S_ISLNK(file->mode) && file->u.link )
+            hv_store(rh, "link",     4, newSVpv(file->u.link, 0), 0);
+        if ( S_ISREG(file->mode) && file->u.sum )
+            hv_store(rh, "sum",      3, newSVpv(file->u.sum, 0), 0);
+        if ( IS_DEVICE(file->mode) ) {
+            hv_store(rh, "rdev",        4, newSVnv((double)file->u.rdev), 0);
+            hv_store(rh, "rdev_major", 10,
+                            newSVnv((double)major(file->u.rdev)), 0);
+            hv_store(rh, "rdev_minor", 10,
+                            newSVnv((double)minor(file->u.rdev)), 0);
+        }
+        hv_store(rh, "name",    4, newSVpv(f_name(file), 0), 0);
+        hv_store(rh, "uid",     3, newSVnv((double)((unsigned)file->uid)), 0);
+        hv_store(rh, "gid",     3, newSVnv((double)((unsigned)file->gid)), 0);
+        hv_store(rh, "mode",    4, newSVnv((double)((unsigned)file->mode)), 0);
+        hv_store(rh, "mtime",   5,
+			    newSVnv((double)((unsigned)file->modtime)), 0);
+        hv_store(rh, "size",    4, newSVnv(file->length), 0);
+        if ( flist->preserve_hard_links ) {
+            if ( flist->link_idev_data_done ) {
+                /*
+                 * already run the hardlink linking code, so the link_u
+                 * union has the links data in place
+                 */
+                if ( file->link_u.links ) {
+                    /*
+                     * return the name of the file this one is linked to
+                     */
+                    hv_store(rh, "hlink", 5, 
+                        newSVpv(f_name(file->link_u.links->to), 0), 0);
+                    if ( file == file->link_u.links->to ) {
+                        /*
+                         * Add flag if this is ourselves
+                         */
+                        hv_store(rh, "hlink_self", 10, newSVnv((double)1.0), 0);
+                    }
+                }
+            } else {
+                if ( file->link_u.idev ) {
+                    hv_store(rh, "dev", 3, newSVnv(file->link_u.idev->dev), 0);
+                    hv_store(rh, "inode", 5,
+                        newSVnv(file->link_u.idev->inode), 0);
+                }
+            }
+        }
+        RETVAL = newRV((SV*)rh);
+    }
+#line 650 "FileList.c"
+	RETVAL = sv_2mortal(RETVAL);
+	ST(0) = RETVAL;
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_fieldGet); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_fieldGet)
+{
+    dVAR; dXSARGS;
+    if (items < 2 || items > 4)
+       croak_xs_usage(cv,  "flist, fieldName, start = 0, cnt = ~0U");
+    PERL_UNUSED_VAR(ax); /* -Wall */
+    SP -= items;
+    {
+	File__RsyncP__FileList	flist;
+	char *	fieldName = (char *)SvPV_nolen(ST(1))
+;
+	unsigned int	start;
+	unsigned int	cnt;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::fieldGet",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 3)
+	    start = 0;
+	else {
+	    start = (unsigned int)SvUV(ST(2))
+;
+	}
+
+	if (items < 4)
+	    cnt = ~0U;
+	else {
+	    cnt = (unsigned int)SvUV(ST(3))
+;
+	}
+#line 335 "FileList.xs"
+    {
+        unsigned int i;
+        int field;
+
+        /*
+         * Return the field for entries start .. start + cnt - 1,
+         * without building a hash for each one.  Unused entries
+         * give undef.
+         */
+        for ( field = 0 ; flist_field_names[field] ; field++ ) {
+            if ( !strcmp(fieldName, flist_field_names[field]) )
+                break;
+        }
+        if ( !flist_field_names[field] )
+            croak("File::RsyncP::FileList::fieldGet: unknown field %s",
+                  fieldName);
+        if ( start >= flist->count )
+            XSRETURN_EMPTY;
+        if ( cnt > flist->count - start )
+            cnt = flist->count - start;
+        EXTEND(SP, cnt);
+        for ( i = start ; i < start + cnt ; i++ ) {
+            struct file_struct *file = flist->files[i];
+
+            if ( !file->basename ) {
+                PUSHs(&PL_sv_undef);
+            } else {
+                PUSHs(sv_2mortal(flist_field_sv(flist, file, field)));
+            }
+        }
+    }
+#line 732 "FileList.c"
+	PUTBACK;
+	return;
+    }
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_indexGet); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_indexGet)
+{
+    dVAR; dXSARGS;
+    if (items < 1 || items > 4)
+       croak_xs_usage(cv,  "flist, type = \"all\", start = 0, cnt = ~0U");
+    PERL_UNUSED_VAR(ax); /* -Wall */
+    SP -= items;
+    {
+	File__RsyncP__FileList	flist;
+	char *	type;
+	unsigned int	start;
+	unsigned int	cnt;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::indexGet",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 2)
+	    type = "all";
+	else {
+	    type = (char *)SvPV_nolen(ST(1))
+;
+	}
+
+	if (items < 3)
+	    start = 0;
+	else {
+	    start = (unsigned int)SvUV(ST(2))
+;
+	}
+
+	if (items < 4)
+	    cnt = ~0U;
+	else {
+	    cnt = (unsigned int)SvUV(ST(3))
+;
+	}
+#line 375 "FileList.xs"
+    {
+        unsigned int i;
+        int which;
+
+        /*
+         * Return the indices of the used entries in start ..
+         * start + cnt - 1 of the given type: "all", "reg" (regular
+         * files), "special" (everything else) or "hlink" (hard links
+         * to another entry, after init_hard_links()).
+         */
+        if ( !strcmp(type, "all") )
+            which = 0;
+        else if ( !strcmp(type, "reg") )
+            which = 1;
+        else if ( !strcmp(type, "special") )
+            which = 2;
+        else if ( !strcmp(type, "hlink") )
+            which = 3;
+        else
+            croak("File::RsyncP::FileList::indexGet: unknown type %s", type);
+        if ( start >= flist->count )
+            XSRETURN_EMPTY;
+        if ( cnt > flist->count - start )
+            cnt = flist->count - start;
+        for ( i = start ; i < start + cnt ; i++ ) {
+            struct file_struct *file = flist->files[i];
+
+            if ( !file->basename )
+                continue;
+            if ( which == 1 && !S_ISREG(file->mode) )
+                continue;
+            if ( which == 2 && S_ISREG(file->mode) )
+                continue;
+            if ( which == 3 && (!flist->preserve_hard_links
+                        || !flist->link_idev_data_done
+                        || !file->link_u.links
+                        || file == file->link_u.links->to) )
+                continue;
+            XPUSHs(sv_2mortal(newSVuv(i)));
+        }
+    }
+#line 829 "FileList.c"
+	PUTBACK;
+	return;
+    }
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_find); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_find)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "flist, name");
+    {
+	File__RsyncP__FileList	flist;
+	char *	name = (char *)SvPV_nolen(ST(1))
+;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::find",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 423 "FileList.xs"
+    {
+        int index = flist_find_name(flist, name);
+
+        if ( index < 0 ) {
+            XSRETURN_UNDEF;
+        }
+        RETVAL = newSVuv(index);
+    }
+#line 870 "FileList.c"
+	RETVAL = sv_2mortal(RETVAL);
+	ST(0) = RETVAL;
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_flagGet); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_flagGet)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "flist, index");
+    {
+	File__RsyncP__FileList	flist;
+	unsigned int	index = (unsigned int)SvUV(ST(1))
+;
+	unsigned int	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::flagGet",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 440 "FileList.xs"
+    {
+        if ( index >= flist->count ) {
+            XSRETURN_UNDEF; 
+        }
+        RETVAL = flist->files[index]->flags & FLAG_USER_BOOL ? 1 : 0;
+    }
+#line 911 "FileList.c"
+	XSprePUSH;
+	PUSHu((UV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_flagSet); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_flagSet)
+{
+    dVAR; dXSARGS;
+    if (items != 3)
+       croak_xs_usage(cv,  "flist, index, value");
+    {
+	File__RsyncP__FileList	flist;
+	unsigned int	index = (unsigned int)SvUV(ST(1))
+;
+	unsigned int	value = (unsigned int)SvUV(ST(2))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::flagSet",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 456 "FileList.xs"
+    {
+        if ( index < flist->count ) {
+            if ( value ) {
+                flist->files[index]->flags |= FLAG_USER_BOOL;
+            } else {
+                flist->files[index]->flags &= ~FLAG_USER_BOOL;
+            }
+        }
+    }
+#line 955 "FileList.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_clean); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_clean)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "flist");
+    {
+	File__RsyncP__FileList	flist;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::clean",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 471 "FileList.xs"
+    {
+        clean_flist(flist, 0, 1);
+    }
+#line 987 "FileList.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_init_hard_links); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_init_hard_links)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "flist");
+    {
+	File__RsyncP__FileList	flist;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::init_hard_links",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 480 "FileList.xs"
+    {
+        init_hard_links(flist);
+    }
+#line 1019 "FileList.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_encode); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_encode)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "flist, data");
+    {
+	File__RsyncP__FileList	flist;
+	SV*	data = ST(1)
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::encode",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 490 "FileList.xs"
+    {
+        struct file_struct *file;
+        char sum[SUM_LENGTH];
+        char thisname[MAXPATHLEN];
+        char linkname[MAXPATHLEN];
+        int alloc_len, basename_len, dirname_len, linkname_len, sum_len;
+        char *basename, *dirname, *bp;
+        unsigned short flags = 0;
+        unsigned int mode = getHashUInt(data, "mode", 0);
+
+        unsigned int file_struct_len;
+        struct file_struct f_test;
+
+        /* Figure out how big the file_struct is without trailing padding */
+        file_struct_len = offsetof(struct file_struct, flags)
+                        + sizeof f_test.flags;
+
+        if (!flist || !flist->count)    /* Ignore lastdir when invalid. */
+                flist->encode_lastdir_len = -1;
+
+        if ( getHashString(data, "name", NULL, thisname, MAXPATHLEN-1) ) {
+            printf("flist encode: empty or too long name\n");
+            return;
+        }
+        clean_fname(thisname, 0);
+
+        memset(sum, 0, SUM_LENGTH);
+
+        if ( S_ISLNK(mode) && getHashString(data, "link", NULL, linkname,
+                                            MAXPATHLEN-1) ) {
+            printf("flist encode: link name is too long\n");
+            return;
+        }
+
+        if ((basename = strrchr(thisname, '/')) != NULL) {
+            dirname_len = ++basename - thisname; /* counts future '\0' */
+            if (flist->encode_lastdir_len == dirname_len - 1
+                    && strncmp(thisname, flist->encode_lastdir,
+                                   flist->encode_lastdir_len) == 0) {
+                dirname = flist->encode_lastdir;
+                dirname_len = 0; /* indicates no new lastdir */
+            } else
+                dirname = flist_dir_intern(flist, thisname, dirname_len - 1);
+        } else {
+            basename = thisname;
+            dirname = NULL;
+            dirname_len = 0;
+        }
+        basename_len = strlen(basename) + 1; /* count the '\0' */
+
+        linkname_len = S_ISLNK(mode) ? strlen(linkname) + 1 : 0;
+
+        sum_len = flist->always_checksum && S_ISREG(mode) ? MD4_SUM_LENGTH : 0;
+
+        alloc_len = file_struct_len + basename_len + linkname_len + sum_len;
+        if (flist) {
+            bp = pool_alloc(flist->file_pool, alloc_len,
+                "receive_file_entry");
+        } else {
+            if (!(bp = malloc(sizeof(char) * alloc_len))) {
+                printf("out of memory: receive_file_entry");
+                return;
+            }
+        }
+
+        file = (struct file_struct *)bp;
+        memset(bp, 0, file_struct_len);
+        bp += file_struct_len;
+
+        file->flags   = flags;
+        file->modtime = getHashUInt(data, "mtime", 0);
+        file->length  = getHashDouble(data, "size", 0.0);
+        file->mode    = mode;
+        file->uid     = getHashUInt(data, "uid", 0);
+        file->gid     = getHashUInt(data, "gid", 0);
+
+        if (flist->preserve_hard_links && flist->idev_pool) {
+            if (flist->protocol_version < 28) {
+                if (S_ISREG(mode))
+                        file->link_u.idev = pool_talloc(
+                            flist->idev_pool, struct idev, 1,
+                            "inode_table");
+            } else {
+                if (!S_ISDIR(mode) && isHashDefined(data, "inode"))
+                        file->link_u.idev = pool_talloc(
+                            flist->idev_pool, struct idev, 1,
+                            "inode_table");
+            }
+        }
+        if (file->link_u.idev) {
+            file->F_DEV = getHashDouble(data, "dev", 0.0);
+            file->F_INODE = getHashDouble(data, "inode", 0.0);
+        }
+
+        file->dirname = dirname;
+        if (dirname_len) {
+            flist->encode_lastdir = dirname;
+            flist->encode_lastdir_len = dirname_len - 1;
+        }
+
+        file->basename = bp;
+        memcpy(bp, basename, basename_len);
+        bp += basename_len;
+
+        if (flist->preserve_devices && IS_DEVICE(mode)) {
+            if ( isHashDefined(data, "rdev_major") ) {
+                file->u.rdev = makedev(getHashUInt(data, "rdev_major", 0),
+                                       getHashUInt(data, "rdev_minor", 0));
+            } else if ( isHashDefined(data, "rdev") ) {
+                file->u.rdev = getHashUInt(data, "rdev", 0);
+            } else {
+                printf("File::RsyncP::FileList::encode: missing rdev on device file %s\n",
+                                thisname);
+                file->u.rdev = 0;
+            }
+        }
+
+        if (linkname_len) {
+            file->u.link = bp;
+            memcpy(bp, linkname, linkname_len);
+            bp += linkname_len;
+        }
+
+        if (sum_len) {
+            file->u.sum = bp;
+            /* TODO */
+            memset(bp, 0, sum_len);
+            /*bp += sum_len;*/
+        }
+
+        file->basedir = NULL;           /* TODO */
+
+        flist_expand(flist);
+
+        if (file->basename[0]) {
+            flist->files[flist->count++] = file;
+            send_file_entry(flist, file, 0 /* TODO base_flags */);
+        }
+    }
+#line 1189 "FileList.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_encodeData); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_encodeData)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "flist");
+    {
+	File__RsyncP__FileList	flist;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::encodeData",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 635 "FileList.xs"
+    {
+        if ( !flist->outBuf || flist->outPosn == 0 ) {
+            ST(0) = sv_2mortal(newSVpv("", 0));
+        } else {
+            ST(0) = sv_2mortal(newSVpv((char*)flist->outBuf, flist->outPosn));
+            flist->outPosn = 0;
+        }
+    }
+#line 1227 "FileList.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_exclude_check); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_exclude_check)
+{
+    dVAR; dXSARGS;
+    if (items != 3)
+       croak_xs_usage(cv,  "flist, pathSV, isDir");
+    {
+#line 647 "FileList.xs"
+	STRLEN pathLen;
+#line 1242 "FileList.c"
+	File__RsyncP__FileList	flist;
+	SV *	pathSV = ST(1)
+;
+	unsigned char *	path = (unsigned char *)SvPV(pathSV, pathLen);
+	unsigned int	isDir = (unsigned int)SvUV(ST(2))
+;
+	int	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::exclude_check",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 654 "FileList.xs"
+    {
+        RETVAL = check_exclude(flist, (char*)path, isDir);
+    }
+#line 1269 "FileList.c"
+	XSprePUSH;
+	PUSHi((IV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_exclude_add); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_exclude_add)
+{
+    dVAR; dXSARGS;
+    if (items != 3)
+       croak_xs_usage(cv,  "flist, patternSV, flags");
+    {
+#line 663 "FileList.xs"
+	STRLEN patternLen;
+#line 1286 "FileList.c"
+	File__RsyncP__FileList	flist;
+	SV *	patternSV = ST(1)
+;
+	unsigned char *	pattern = (unsigned char *)SvPV(patternSV, patternLen);
+	unsigned int	flags = (unsigned int)SvUV(ST(2))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::exclude_add",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 670 "FileList.xs"
+    {
+        add_exclude(flist, (char*)pattern, flags);
+    }
+#line 1311 "FileList.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_exclude_add_file); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_exclude_add_file)
+{
+    dVAR; dXSARGS;
+    if (items != 3)
+       croak_xs_usage(cv,  "flist, fileNameSV, flags");
+    {
+#line 677 "FileList.xs"
+	STRLEN fileNameLen;
+#line 1326 "FileList.c"
+	File__RsyncP__FileList	flist;
+	SV *	fileNameSV = ST(1)
+;
+	unsigned char *	fileName = (unsigned char *)SvPV(fileNameSV, fileNameLen);
+	unsigned int	flags = (unsigned int)SvUV(ST(2))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::exclude_add_file",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 684 "FileList.xs"
+    {
+        add_exclude_file(flist, (char*)fileName, flags);
+    }
+#line 1351 "FileList.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_exclude_cvs_add); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_exclude_cvs_add)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "flist");
+    {
+	File__RsyncP__FileList	flist;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::exclude_cvs_add",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 693 "FileList.xs"
+    {
+        add_cvs_excludes(flist);
+    }
+#line 1383 "FileList.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_exclude_list_send); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_exclude_list_send)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "flist");
+    {
+	File__RsyncP__FileList	flist;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::exclude_list_send",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 702 "FileList.xs"
+    {
+        send_exclude_list(flist);
+    }
+#line 1415 "FileList.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_exclude_list_receive); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_exclude_list_receive)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "flist");
+    {
+	File__RsyncP__FileList	flist;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::exclude_list_receive",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 711 "FileList.xs"
+    {
+        recv_exclude_list(flist);
+    }
+#line 1447 "FileList.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_exclude_list_clear); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_exclude_list_clear)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "flist");
+    {
+	File__RsyncP__FileList	flist;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::exclude_list_clear",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 720 "FileList.xs"
+    {
+        clear_exclude_list(&flist->exclude_list);
+    }
+#line 1479 "FileList.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__FileList_exclude_list_get); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__FileList_exclude_list_get)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "flist");
+    {
+	File__RsyncP__FileList	flist;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::FileList")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    flist = INT2PTR(File__RsyncP__FileList,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::FileList::exclude_list_get",
+			"flist", "File::RsyncP::FileList",
+			refstr, ST(0)
+		);
+	}
+;
+#line 729 "FileList.xs"
+        {
+            AV *result;
+            struct exclude_struct *ent;
+
+            result = (AV *)sv_2mortal((SV *)newAV());
+
+            for (ent = flist->exclude_list.head; ent; ent = ent->next) {
+                HV *rh = (HV *)sv_2mortal((SV *)newHV());
+                hv_store(rh, "pattern", 7,
+                         newSVpvn(ent->pattern, strlen(ent->pattern)), 0);
+                hv_store(rh, "flags", 5,
+                         newSVnv((double)ent->match_flags), 0);
+                av_push(result, newRV((SV *)rh));
+            }
+            RETVAL = newRV((SV *)result);
+        }
+#line 1525 "FileList.c"
+	RETVAL = sv_2mortal(RETVAL);
+	ST(0) = RETVAL;
+    }
+    XSRETURN(1);
+}
+
+#ifdef __cplusplus
+extern "C"
+#endif
+XS_EXTERNAL(boot_File__RsyncP__FileList); /* prototype to pass -Wmissing-prototypes */
+XS_EXTERNAL(boot_File__RsyncP__FileList)
+{
+#if PERL_VERSION_LE(5, 21, 5)
+    dVAR; dXSARGS;
+#else
+    dVAR; dXSBOOTARGSXSAPIVERCHK;
+#endif
+#if PERL_VERSION_LE(5, 8, 999) /* PERL_VERSION_LT is 5.33+ */
+    char* file = __FILE__;
+#else
+    const char* file = __FILE__;
+#endif
+
+    PERL_UNUSED_VAR(file);
+
+    PERL_UNUSED_VAR(cv); /* -W */
+    PERL_UNUSED_VAR(items); /* -W */
+#if PERL_VERSION_LE(5, 21, 5)
+    XS_VERSION_BOOTCHECK;
+#  ifdef XS_APIVERSION_BOOTCHECK
+    XS_APIVERSION_BOOTCHECK;
+#  endif
+#endif
+
+        newXS_deffile("File::RsyncP::FileList::new", XS_File__RsyncP__FileList_new);
+        newXS_deffile("File::RsyncP::FileList::DESTROY", XS_File__RsyncP__FileList_DESTROY);
+        newXS_deffile("File::RsyncP::FileList::count", XS_File__RsyncP__FileList_count);
+        newXS_deffile("File::RsyncP::FileList::fatalError", XS_File__RsyncP__FileList_fatalError);
+        newXS_deffile("File::RsyncP::FileList::decodeDone", XS_File__RsyncP__FileList_decodeDone);
+        newXS_deffile("File::RsyncP::FileList::decode", XS_File__RsyncP__FileList_decode);
+        newXS_deffile("File::RsyncP::FileList::get", XS_File__RsyncP__FileList_get);
+        newXS_deffile("File::RsyncP::FileList::fieldGet", XS_File__RsyncP__FileList_fieldGet);
+        newXS_deffile("File::RsyncP::FileList::indexGet", XS_File__RsyncP__FileList_indexGet);
+        newXS_deffile("File::RsyncP::FileList::find", XS_File__RsyncP__FileList_find);
+        newXS_deffile("File::RsyncP::FileList::flagGet", XS_File__RsyncP__FileList_flagGet);
+        newXS_deffile("File::RsyncP::FileList::flagSet", XS_File__RsyncP__FileList_flagSet);
+        newXS_deffile("File::RsyncP::FileList::clean", XS_File__RsyncP__FileList_clean);
+        newXS_deffile("File::RsyncP::FileList::init_hard_links", XS_File__RsyncP__FileList_init_hard_links);
+        newXS_deffile("File::RsyncP::FileList::encode", XS_File__RsyncP__FileList_encode);
+        newXS_deffile("File::RsyncP::FileList::encodeData", XS_File__RsyncP__FileList_encodeData);
+        newXS_deffile("File::RsyncP::FileList::exclude_check", XS_File__RsyncP__FileList_exclude_check);
+        newXS_deffile("File::RsyncP::FileList::exclude_add", XS_File__RsyncP__FileList_exclude_add);
+        newXS_deffile("File::RsyncP::FileList::exclude_add_file", XS_File__RsyncP__FileList_exclude_add_file);
+        newXS_deffile("File::RsyncP::FileList::exclude_cvs_add", XS_File__RsyncP__FileList_exclude_cvs_add);
+        newXS_deffile("File::RsyncP::FileList::exclude_list_send", XS_File__RsyncP__FileList_exclude_list_send);
+        newXS_deffile("File::RsyncP::FileList::exclude_list_receive", XS_File__RsyncP__FileList_exclude_list_receive);
+        newXS_deffile("File::RsyncP::FileList::exclude_list_clear", XS_File__RsyncP__FileList_exclude_list_clear);
+        newXS_deffile("File::RsyncP::FileList::exclude_list_get", XS_File__RsyncP__FileList_exclude_list_get);
+#if PERL_VERSION_LE(5, 21, 5)
+#  if PERL_VERSION_GE(5, 9, 0)
+    if (PL_unitcheckav)
+        call_list(PL_scopestack_ix, PL_unitcheckav);
+#  endif
+    XSRETURN_YES;
+#else
+    Perl_xs_boot_epilog(aTHX_ ax);
+#endif
+}
+
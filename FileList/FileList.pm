@@ -116,6 +116,13 @@ decoding.
     # get file information, for file number 5:
     $fileInfo = $fileList->get(5);
 
+    # find the index of a file by name
+    $index = $fileList->find($name);
+
+    # get one field, or the matching indices, for a range of files
+    @names   = $fileList->fieldGet("name", $start, $cnt);
+    @regular = $fileList->indexGet("reg", $start, $cnt);
+
     # utility functions
     $numberOfFiles = $fileList->count;
     $gotFatalError = $fileList->fatalError;
@@ -151,6 +158,16 @@ not be compatible and decoding will fail.
         remote_version      => 26,      # remote protocol version
     });
 
+Two more options control how clean() sorts large file lists:
+
+        sort_threads        => 0,       # threads; 0 means one per CPU
+        sort_parallel_min   => 100000,  # min entries to use threads
+
+Lists of at least sort_parallel_min entries are sorted in pieces by
+sort_threads threads (if POSIX threads are available), which are then
+merged in parallel.  The result is exactly the same as a single
+threaded sort.
+
 =head2 Decoding
 
 The decoding functions take a stream of bytes from the remote rsync
@@ -221,6 +238,37 @@ For example, to dump out each of hash you could do this:
         print Dumper($fileList->get($i));
     }
 
+Building a hash for every file is slow for large file lists, so a
+single field of a range of files can be fetched with:
+
+    @values = $fileList->fieldGet($field, $start, $cnt);
+
+which returns one value for each index from $start to $start+$cnt-1
+(all of them if $start and $cnt are omitted), with the same name and
+value as the get() hash.  The value is undef if get() would return
+undef for the index or wouldn't include the field.  The fields are name,
+basename, dirname, link, sum, uid, gid, mode, mtime, size, rdev,
+dev, inode, hlink and hlink_self, plus flag (as returned by flagGet).
+
+The indices of a type of file can be fetched with:
+
+    @indices = $fileList->indexGet($type, $start, $cnt);
+
+where $type is "all" (every index get() returns a file for), "reg"
+(regular files), "special" (everything else) or "hlink" (hard links
+to another file, after init_hard_links()).  Callers can then call
+get() for just the files they need.
+
+The index of a file can be found from its name (as returned in the
+name field) with:
+
+    $index = $fileList->find($name);
+
+which returns undef if there is no such file.  A hash index of the
+names is built on the first call (and again if the file list changes),
+so each later lookup takes constant time.  If a name appears more than
+once (before clean() is called) the first index is returned.
+
 =head2 Encoding
 
 The encode() function is used to build a file list in preparation for
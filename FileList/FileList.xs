@@ -104,6 +104,77 @@ static int isHashDefined(SV *opts, char *param)
     return 1;
 }
 
+/*
+ * Fields returned by fieldGet(), with the same names and values as
+ * the hash returned by get().
+ */
+enum flist_field {
+    FIELD_NAME, FIELD_BASENAME, FIELD_DIRNAME, FIELD_LINK, FIELD_SUM,
+    FIELD_UID, FIELD_GID, FIELD_MODE, FIELD_MTIME, FIELD_SIZE, FIELD_RDEV,
+    FIELD_DEV, FIELD_INODE, FIELD_HLINK, FIELD_HLINK_SELF, FIELD_FLAG
+};
+
+static char *flist_field_names[] = {
+    "name", "basename", "dirname", "link", "sum",
+    "uid", "gid", "mode", "mtime", "size", "rdev",
+    "dev", "inode", "hlink", "hlink_self", "flag", NULL
+};
+
+/*
+ * Return one field of a file list entry as a new SV, or undef if get()
+ * wouldn't include it.
+ */
+static SV *flist_field_sv(struct file_list *flist, struct file_struct *file,
+			  int field)
+{
+    switch ( field ) {
+      case FIELD_NAME:
+	return newSVpv(f_name(file), 0);
+      case FIELD_BASENAME:
+	return newSVpv(file->basename, 0);
+      case FIELD_DIRNAME:
+	return file->dirname ? newSVpv(file->dirname, 0) : &PL_sv_undef;
+      case FIELD_LINK:
+	return S_ISLNK(file->mode) && file->u.link
+		    ? newSVpv(file->u.link, 0) : &PL_sv_undef;
+      case FIELD_SUM:
+	return S_ISREG(file->mode) && file->u.sum
+		    ? newSVpv(file->u.sum, 0) : &PL_sv_undef;
+      case FIELD_UID:
+	return newSVnv((double)((unsigned)file->uid));
+      case FIELD_GID:
+	return newSVnv((double)((unsigned)file->gid));
+      case FIELD_MODE:
+	return newSVnv((double)((unsigned)file->mode));
+      case FIELD_MTIME:
+	return newSVnv((double)((unsigned)file->modtime));
+      case FIELD_SIZE:
+	return newSVnv(file->length);
+      case FIELD_RDEV:
+	return IS_DEVICE(file->mode) ? newSVnv((double)file->u.rdev)
+				     : &PL_sv_undef;
+      case FIELD_DEV:
+      case FIELD_INODE:
+	if ( !flist->preserve_hard_links || flist->link_idev_data_done
+		|| !file->link_u.idev )
+	    return &PL_sv_undef;
+	return newSVnv(field == FIELD_DEV ? file->link_u.idev->dev
+					  : file->link_u.idev->inode);
+      case FIELD_HLINK:
+      case FIELD_HLINK_SELF:
+	if ( !flist->preserve_hard_links || !flist->link_idev_data_done
+		|| !file->link_u.links )
+	    return &PL_sv_undef;
+	if ( field == FIELD_HLINK )
+	    return newSVpv(f_name(file->link_u.links->to), 0);
+	return file == file->link_u.links->to ? newSVnv((double)1.0)
+					      : &PL_sv_undef;
+      case FIELD_FLAG:
+	return newSVuv(file->flags & FLAG_USER_BOOL ? 1 : 0);
+    }
+    return &PL_sv_undef;
+}
+
 MODULE = File::RsyncP::FileList		PACKAGE = File::RsyncP::FileList		
 
 PROTOTYPES: DISABLE
@@ -124,6 +195,9 @@ new(packname = "File::RsyncP::FileList", opts = NULL)
         RETVAL->preserve_hard_links = preserve_hard_links;
         RETVAL->protocol_version = getHashInt(opts, "protocol_version", 26);
         RETVAL->eol_nulls        = getHashInt(opts, "from0", 0);
+        RETVAL->sort_threads     = getHashInt(opts, "sort_threads", 0);
+        RETVAL->sort_parallel_min = getHashInt(opts, "sort_parallel_min",
+                                               FLIST_SORT_PARALLEL_MIN);
     }
     OUTPUT:
 	RETVAL
@@ -250,6 +324,113 @@ get(flist, index)
     OUTPUT:
         RETVAL
 
+void
+fieldGet(flist, fieldName, start = 0, cnt = ~0U)
+    INPUT:
+	File::RsyncP::FileList	flist
+	char *fieldName
+	unsigned int start
+	unsigned int cnt
+    PPCODE:
+    {
+        unsigned int i;
+        int field;
+
+        /*
+         * Return the field for entries start .. start + cnt - 1,
+         * without building a hash for each one.  Unused entries
+         * give undef.
+         */
+        for ( field = 0 ; flist_field_names[field] ; field++ ) {
+            if ( !strcmp(fieldName, flist_field_names[field]) )
+                break;
+        }
+        if ( !flist_field_names[field] )
+            croak("File::RsyncP::FileList::fieldGet: unknown field %s",
+                  fieldName);
+        if ( start >= flist->count )
+            XSRETURN_EMPTY;
+        if ( cnt > flist->count - start )
+            cnt = flist->count - start;
+        EXTEND(SP, cnt);
+        for ( i = start ; i < start + cnt ; i++ ) {
+            struct file_struct *file = flist->files[i];
+
+            if ( !file->basename ) {
+                PUSHs(&PL_sv_undef);
+            } else {
+                PUSHs(sv_2mortal(flist_field_sv(flist, file, field)));
+            }
+        }
+    }
+
+void
+indexGet(flist, type = "all", start = 0, cnt = ~0U)
+    INPUT:
+	File::RsyncP::FileList	flist
+	char *type
+	unsigned int start
+	unsigned int cnt
+    PPCODE:
+    {
+        unsigned int i;
+        int which;
+
+        /*
+         * Return the indices of the used entries in start ..
+         * start + cnt - 1 of the given type: "all", "reg" (regular
+         * files), "special" (everything else) or "hlink" (hard links
+         * to another entry, after init_hard_links()).
+         */
+        if ( !strcmp(type, "all") )
+            which = 0;
+        else if ( !strcmp(type, "reg") )
+            which = 1;
+        else if ( !strcmp(type, "special") )
+            which = 2;
+        else if ( !strcmp(type, "hlink") )
+            which = 3;
+        else
+            croak("File::RsyncP::FileList::indexGet: unknown type %s", type);
+        if ( start >= flist->count )
+            XSRETURN_EMPTY;
+        if ( cnt > flist->count - start )
+            cnt = flist->count - start;
+        for ( i = start ; i < start + cnt ; i++ ) {
+            struct file_struct *file = flist->files[i];
+
+            if ( !file->basename )
+                continue;
+            if ( which == 1 && !S_ISREG(file->mode) )
+                continue;
+            if ( which == 2 && S_ISREG(file->mode) )
+                continue;
+            if ( which == 3 && (!flist->preserve_hard_links
+                        || !flist->link_idev_data_done
+                        || !file->link_u.links
+                        || file == file->link_u.links->to) )
+                continue;
+            XPUSHs(sv_2mortal(newSVuv(i)));
+        }
+    }
+
+SV*
+find(flist, name)
+    INPUT:
+	File::RsyncP::FileList	flist
+	char *name
+    CODE:
+    {
+        int index = flist_find_name(flist, name);
+
+        if ( index < 0 ) {
+            XSRETURN_UNDEF;
+        }
+        RETVAL = newSVuv(index);
+    }
+    OUTPUT:
+        RETVAL
+
 unsigned int
 flagGet(flist, index)
     INPUT:
@@ -346,9 +527,9 @@ encode(flist, data)
                     && strncmp(thisname, flist->encode_lastdir,
                                    flist->encode_lastdir_len) == 0) {
                 dirname = flist->encode_lastdir;
-                dirname_len = 0; /* indicates no copy is needed */
+                dirname_len = 0; /* indicates no new lastdir */
             } else
-                dirname = thisname;
+                dirname = flist_dir_intern(flist, thisname, dirname_len - 1);
         } else {
             basename = thisname;
             dirname = NULL;
@@ -360,8 +541,7 @@ encode(flist, data)
 
         sum_len = flist->always_checksum && S_ISREG(mode) ? MD4_SUM_LENGTH : 0;
 
-        alloc_len = file_struct_len + dirname_len + basename_len
-            + linkname_len + sum_len;
+        alloc_len = file_struct_len + basename_len + linkname_len + sum_len;
         if (flist) {
             bp = pool_alloc(flist->file_pool, alloc_len,
                 "receive_file_entry");
@@ -401,14 +581,11 @@ encode(flist, data)
             file->F_INODE = getHashDouble(data, "inode", 0.0);
         }
 
+        file->dirname = dirname;
         if (dirname_len) {
-            file->dirname = flist->encode_lastdir = bp;
+            flist->encode_lastdir = dirname;
             flist->encode_lastdir_len = dirname_len - 1;
-            memcpy(bp, dirname, dirname_len - 1);
-            bp += dirname_len;
-            bp[-1] = '\0';
-        } else if (dirname)
-            file->dirname = dirname;
+        }
 
         file->basename = bp;
         memcpy(bp, basename, basename_len);
@@ -39,6 +39,9 @@
 #include <XSUB.h>
 
 #include "rsync.h"
+#ifdef HAVE_PTHREAD
+#include <pthread.h>
+#endif
 
 extern struct stats stats;
 
@@ -236,9 +239,9 @@ void receive_file_entry(struct file_list *f, struct file_struct **fptr,
         if (lastdir_len == dirname_len - 1
             && strncmp(thisname, lastdir, lastdir_len) == 0) {
                 dirname = lastdir;
-                dirname_len = 0; /* indicates no copy is needed */
+                dirname_len = 0; /* indicates no new lastdir */
         } else
-                dirname = thisname;
+                dirname = flist_dir_intern(f, thisname, dirname_len - 1);
     } else {
         basename = thisname;
         dirname = NULL;
@@ -291,8 +294,7 @@ void receive_file_entry(struct file_list *f, struct file_struct **fptr,
 
     sum_len = f->always_checksum && S_ISREG(mode) ? MD4_SUM_LENGTH : 0;
 
-    alloc_len = file_struct_len + dirname_len + basename_len
-              + linkname_len + sum_len;
+    alloc_len = file_struct_len + basename_len + linkname_len + sum_len;
 
     /*
      * make sure we have enough input data left to complete the file
@@ -314,16 +316,12 @@ void receive_file_entry(struct file_list *f, struct file_struct **fptr,
     file->uid = uid;
     file->gid = gid;
 
+    file->dirname = dirname;
     if (dirname_len) {
-        file->dirname = lastdir = bp;
+        lastdir = dirname;
         lastdir_len = dirname_len - 1;
-        memcpy(bp, dirname, dirname_len - 1);
-        bp += dirname_len;
-        bp[-1] = '\0';
         if (f->sanitize_paths)
             lastdir_depth = count_dir_elements(lastdir);
-    } else if (dirname) {
-        file->dirname = dirname;
     }
 
     file->basename = bp;
@@ -775,6 +773,15 @@ int flist_find(struct file_list *flist, struct file_struct *f)
 {
     int low = 0, high = flist->count - 1;
 
+    /*
+     * Use the name hash index if it has been built
+     */
+    if (flist->name_index && flist->name_index_count == flist->count) {
+        char *name = f_name(f);
+
+        return name ? flist_find_name(flist, name) : -1;
+    }
+
     while (high >= 0 && !flist->files[high]->basename) high--;
 
     if (high < 0)
@@ -796,12 +803,227 @@ int flist_find(struct file_list *flist, struct file_struct *f)
     return -1;
 }
 
+/*
+ * FNV-1a hash of the full name of an entry (dirname/basename), as
+ * built by f_name(), without building it.
+ */
+static uint32 flist_name_hash(struct file_struct *f)
+{
+    uint32 h = 2166136261U;
+    const uchar *p;
+
+    if (f->dirname) {
+        for (p = (const uchar *)f->dirname; *p; p++)
+            h = (h ^ *p) * 16777619U;
+        h = (h ^ '/') * 16777619U;
+    }
+    for (p = (const uchar *)f->basename; *p; p++)
+        h = (h ^ *p) * 16777619U;
+    return h;
+}
+
+static uint32 flist_str_hash(const char *name)
+{
+    uint32 h = 2166136261U;
+    const uchar *p;
+
+    for (p = (const uchar *)name; *p; p++)
+        h = (h ^ *p) * 16777619U;
+    return h;
+}
+
+/*
+ * Return true if the full name of f is name.
+ */
+static int flist_name_eq(struct file_struct *f, const char *name)
+{
+    if (f->dirname) {
+        size_t len = strlen(f->dirname);
+
+        if (strncmp(f->dirname, name, len) || name[len] != '/')
+            return 0;
+        name += len + 1;
+    }
+    return !strcmp(f->basename, name);
+}
+
+void flist_name_index_free(struct file_list *flist)
+{
+    free(flist->name_index);
+    free(flist->name_index_hash);
+    flist->name_index      = NULL;
+    flist->name_index_hash = NULL;
+    flist->name_index_size = 0;
+}
+
+/*
+ * Build the name hash index: an open addressing table with linear
+ * probing, at most half full.  Entries are added in order, so the
+ * first of any repeated names is found.  Returns -1 if memory can't
+ * be allocated.
+ */
+static int flist_name_index_build(struct file_list *flist)
+{
+    uint32 size = 16, mask;
+    int i;
+
+    flist_name_index_free(flist);
+    while (size < 2 * (uint32)flist->count)
+        size *= 2;
+    flist->name_index      = calloc(size, sizeof(uint32));
+    flist->name_index_hash = malloc(size * sizeof(uint32));
+    if (!flist->name_index || !flist->name_index_hash) {
+        flist_name_index_free(flist);
+        return -1;
+    }
+    mask = size - 1;
+    for (i = 0; i < flist->count; i++) {
+        struct file_struct *f = flist->files[i];
+        uint32 h, slot;
+
+        if (!f->basename)
+            continue;
+        h = flist_name_hash(f);
+        for (slot = h & mask; flist->name_index[slot]; slot = (slot + 1) & mask)
+            ;
+        flist->name_index[slot]      = i + 1;
+        flist->name_index_hash[slot] = h;
+    }
+    flist->name_index_size  = size;
+    flist->name_index_count = flist->count;
+    return 0;
+}
+
+/*
+ * Return the index of the entry whose full name (as returned by
+ * f_name()) is name, or -1 if there isn't one.  The hash index is
+ * built on the first call, and again if entries have been added or
+ * the list has been cleaned since.
+ */
+int flist_find_name(struct file_list *flist, const char *name)
+{
+    uint32 h = flist_str_hash(name), mask, slot;
+    int i;
+
+    if ((!flist->name_index || flist->name_index_count != flist->count)
+            && flist_name_index_build(flist) < 0) {
+        /*
+         * No memory for the index: search the list
+         */
+        for (i = 0; i < flist->count; i++) {
+            if (flist->files[i]->basename
+                    && flist_name_eq(flist->files[i], name))
+                return i;
+        }
+        return -1;
+    }
+    mask = flist->name_index_size - 1;
+    for (slot = h & mask; flist->name_index[slot]; slot = (slot + 1) & mask) {
+        struct file_struct *f;
+
+        if (flist->name_index_hash[slot] != h)
+            continue;
+        f = flist->files[flist->name_index[slot] - 1];
+        if (f->basename && flist_name_eq(f, name))
+            return flist->name_index[slot] - 1;
+    }
+    return -1;
+}
+
+/*
+ * Forget the interned directory names.  The names stay in dir_pool,
+ * since entries still point at them.
+ */
+void flist_dir_index_free(struct file_list *flist)
+{
+    free(flist->dir_index);
+    free(flist->dir_index_hash);
+    flist->dir_index       = NULL;
+    flist->dir_index_hash  = NULL;
+    flist->dir_index_size  = 0;
+    flist->dir_index_count = 0;
+}
+
+/*
+ * Double the size of the directory name table (at least 64 slots),
+ * moving the names to their new slots.  Returns -1 if memory can't
+ * be allocated, leaving the table as it was.
+ */
+static int flist_dir_index_grow(struct file_list *flist)
+{
+    uint32 size = flist->dir_index_size ? 2 * flist->dir_index_size : 64;
+    uint32 mask = size - 1, i, slot;
+    char **index = calloc(size, sizeof(char *));
+    uint32 *hash = malloc(size * sizeof(uint32));
+
+    if (!index || !hash) {
+        free(index);
+        free(hash);
+        return -1;
+    }
+    for (i = 0; i < flist->dir_index_size; i++) {
+        if (!flist->dir_index[i])
+            continue;
+        for (slot = flist->dir_index_hash[i] & mask; index[slot];
+                slot = (slot + 1) & mask)
+            ;
+        index[slot] = flist->dir_index[i];
+        hash[slot]  = flist->dir_index_hash[i];
+    }
+    free(flist->dir_index);
+    free(flist->dir_index_hash);
+    flist->dir_index      = index;
+    flist->dir_index_hash = hash;
+    flist->dir_index_size = size;
+    return 0;
+}
+
+/*
+ * Return the interned copy of the len byte directory name dir,
+ * adding it to the table (at most half full, with linear probing)
+ * if it isn't there.  Every entry in a directory then shares one
+ * dirname, however the entries are ordered.  If the table can't
+ * grow, the name is just copied.
+ */
+char *flist_dir_intern(struct file_list *flist, const char *dir, int len)
+{
+    uint32 h = 2166136261U, mask, slot;
+    char *d;
+    int i;
+
+    for (i = 0; i < len; i++)
+        h = (h ^ (uchar)dir[i]) * 16777619U;
+    if (flist->dir_index) {
+        mask = flist->dir_index_size - 1;
+        for (slot = h & mask; (d = flist->dir_index[slot]);
+                slot = (slot + 1) & mask) {
+            if (flist->dir_index_hash[slot] == h
+                    && strncmp(d, dir, len) == 0 && !d[len])
+                return d;
+        }
+    }
+    d = pool_alloc(flist->dir_pool, len + 1, "flist_dir_intern");
+    memcpy(d, dir, len);
+    d[len] = '\0';
+    if (2 * (flist->dir_index_count + 1) > flist->dir_index_size
+            && flist_dir_index_grow(flist) < 0)
+        return d;
+    mask = flist->dir_index_size - 1;
+    for (slot = h & mask; flist->dir_index[slot]; slot = (slot + 1) & mask)
+        ;
+    flist->dir_index[slot]      = d;
+    flist->dir_index_hash[slot] = h;
+    flist->dir_index_count++;
+    return d;
+}
+
 /*
  * Free up any resources a file_struct has allocated
  * and clear the file.
  */
 void clear_file(int i, struct file_list *flist)
 {
+    flist_name_index_free(flist);
     if (flist->idev_pool && flist->files[i]->link_u.idev)
         pool_free(flist->idev_pool, 0, flist->files[i]->link_u.idev);
     memset(flist->files[i], 0, file_struct_len);
@@ -817,11 +1039,16 @@ struct file_list *flist_new(int with_hlink, char *msg, int preserve_hard_links)
         out_of_memory(msg);
     
     memset(flist, 0, sizeof (struct file_list)); 
+    flist->sort_parallel_min = FLIST_SORT_PARALLEL_MIN;
             
     if (!(flist->file_pool = pool_create(FILE_EXTENT, 0,
         out_of_memory, POOL_INTERN)))
             out_of_memory(msg);
                        
+    if (!(flist->dir_pool = pool_create(DIR_EXTENT, 1,
+        out_of_memory, POOL_INTERN)))
+            out_of_memory(msg);
+
     if (with_hlink && preserve_hard_links) {
         if (!(flist->idev_pool = pool_create(HLINK_EXTENT,
             sizeof (struct idev), out_of_memory, POOL_INTERN)))
@@ -839,6 +1066,9 @@ void flist_free(struct file_list *flist)
         pool_destroy(flist->file_pool);
         pool_destroy(flist->idev_pool);
         pool_destroy(flist->hlink_pool);
+        pool_destroy(flist->dir_pool);
+        flist_name_index_free(flist);
+        flist_dir_index_free(flist);
         free(flist->files);
         if ( flist->hlink_list )
             free(flist->hlink_list);
@@ -847,6 +1077,365 @@ void flist_free(struct file_list *flist)
         free(flist);
 }
 
+/*
+ * A file list entry being sorted by flist_sort(): its full name, as
+ * compared by f_name_cmp(), and its position before sorting.
+ */
+struct flist_sort_item {
+    const uchar *key;
+    struct file_struct *file;
+    int idx;
+};
+
+#define FLIST_SORT_SMALL 16	/* insertion sort below this many items */
+
+/*
+ * Compare two items from byte depth on, with equal names in their
+ * original order.
+ */
+static int flist_sort_cmp(struct flist_sort_item *a,
+                          struct flist_sort_item *b, int depth)
+{
+    int dif = u_strcmp((const char *)a->key + depth,
+                       (const char *)b->key + depth);
+
+    return dif ? dif : a->idx - b->idx;
+}
+
+static int flist_sort_idx_cmp(const void *a, const void *b)
+{
+    return ((const struct flist_sort_item *)a)->idx
+         - ((const struct flist_sort_item *)b)->idx;
+}
+
+/*
+ * Sort items whose names are equal up to byte depth.  This is a
+ * multikey quicksort (Bentley and Sedgewick): items are split on the
+ * byte at depth into less, equal and greater parts, and the equal part
+ * moves on to the next byte, so common prefixes such as directory
+ * names are only looked at once per level rather than on every
+ * comparison.
+ */
+static void flist_sort_mkqs(struct flist_sort_item *items, int n, int depth)
+{
+    int i, j;
+
+    while (n >= FLIST_SORT_SMALL) {
+        struct flist_sort_item tmp;
+        int lt = 0, gt = n;
+        int a = items[0].key[depth];
+        int b = items[n / 2].key[depth];
+        int c = items[n - 1].key[depth];
+        int pivot = a < b ? (b < c ? b : (a < c ? c : a))
+                          : (a < c ? a : (b < c ? c : b));
+
+        /*
+         * Partition into [0, lt) < pivot, [lt, gt) == pivot and
+         * [gt, n) > pivot.  The original order is lost, but it is
+         * restored from idx for equal names.
+         */
+        i = 0;
+        while (i < gt) {
+            int ch = items[i].key[depth];
+
+            if (ch < pivot) {
+                tmp = items[lt]; items[lt++] = items[i]; items[i++] = tmp;
+            } else if (ch > pivot) {
+                tmp = items[--gt]; items[gt] = items[i]; items[i] = tmp;
+            } else {
+                i++;
+            }
+        }
+        flist_sort_mkqs(items, lt, depth);
+        flist_sort_mkqs(items + gt, n - gt, depth);
+        items += lt;
+        n = gt - lt;
+        if (pivot == 0) {
+            /*
+             * The names in the equal part are identical: put
+             * them back in their original order.
+             */
+            qsort(items, n, sizeof(items[0]), flist_sort_idx_cmp);
+            return;
+        }
+        depth++;
+    }
+    /*
+     * Insertion sort for small parts
+     */
+    for (i = 1; i < n; i++) {
+        struct flist_sort_item tmp = items[i];
+
+        j = i;
+        while (j > 0 && flist_sort_cmp(&items[j - 1], &tmp, depth) > 0) {
+            items[j] = items[j - 1];
+            j--;
+        }
+        items[j] = tmp;
+    }
+}
+
+/*
+ * A piece of a parallel sort: sort items[0, n), or write the part
+ * [outStart, outEnd) of the merge of the sorted runs a[0, na) and
+ * b[0, nb) to out[outStart, outEnd).
+ */
+struct flist_sort_job {
+    struct flist_sort_item *items;
+    int n;
+    struct flist_sort_item *a, *b, *out;
+    int na, nb, outStart, outEnd;
+};
+
+/*
+ * Return how many of the first k items of the merge of a and b come
+ * from a.  There are no equal items, since ties are broken by idx.
+ */
+static int flist_sort_corank(struct flist_sort_item *a, int na,
+                             struct flist_sort_item *b, int nb, int k)
+{
+    int lo = k > nb ? k - nb : 0, hi = k < na ? k : na;
+
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+
+        if (flist_sort_cmp(&a[mid], &b[k - mid - 1], 0) > 0)
+            hi = mid;
+        else
+            lo = mid + 1;
+    }
+    return lo;
+}
+
+static void *flist_sort_job_run(void *arg)
+{
+    struct flist_sort_job *job = arg;
+    int i, j, k;
+
+    if (job->items) {
+        flist_sort_mkqs(job->items, job->n, 0);
+        return NULL;
+    }
+    i = flist_sort_corank(job->a, job->na, job->b, job->nb, job->outStart);
+    j = job->outStart - i;
+    for (k = job->outStart; k < job->outEnd; k++) {
+        if (j >= job->nb
+                || (i < job->na
+                    && flist_sort_cmp(&job->a[i], &job->b[j], 0) < 0))
+            job->out[k] = job->a[i++];
+        else
+            job->out[k] = job->b[j++];
+    }
+    return NULL;
+}
+
+/*
+ * Run the jobs, one per thread.  The calling thread runs the first
+ * one, and any that a thread can't be started for.
+ */
+static void flist_sort_jobs(struct flist_sort_job *jobs, int nJobs)
+{
+#ifdef HAVE_PTHREAD
+    pthread_t tid[FLIST_SORT_MAX_THREADS];
+    int started[FLIST_SORT_MAX_THREADS];
+    int i;
+
+    for (i = 1; i < nJobs; i++)
+        started[i] = pthread_create(&tid[i], NULL, flist_sort_job_run,
+                                    &jobs[i]) == 0;
+    flist_sort_job_run(&jobs[0]);
+    for (i = 1; i < nJobs; i++) {
+        if (started[i])
+            pthread_join(tid[i], NULL);
+        else
+            flist_sort_job_run(&jobs[i]);
+    }
+#else
+    int i;
+
+    for (i = 0; i < nJobs; i++)
+        flist_sort_job_run(&jobs[i]);
+#endif
+}
+
+/*
+ * Sort the items with nThreads threads: each thread sorts a run of
+ * items, then pairs of runs are merged, with the threads splitting the
+ * output of each merge, until there is one run.  The result is the
+ * same as flist_sort_mkqs(), since the order is total.  Returns -1 if
+ * memory couldn't be allocated.
+ */
+static int flist_sort_parallel(struct flist_sort_item *items, int n,
+                               int nThreads)
+{
+    struct flist_sort_job jobs[FLIST_SORT_MAX_THREADS];
+    int bounds[FLIST_SORT_MAX_THREADS + 1];
+    struct flist_sort_item *src = items, *dst, *tmp;
+    int i, nRuns = nThreads;
+
+    if (!(tmp = malloc(n * sizeof(items[0]))))
+        return -1;
+    dst = tmp;
+    for (i = 0; i <= nRuns; i++)
+        bounds[i] = (int)((double)n * i / nRuns);
+    memset(jobs, 0, sizeof(jobs));
+    for (i = 0; i < nRuns; i++) {
+        jobs[i].items = items + bounds[i];
+        jobs[i].n     = bounds[i + 1] - bounds[i];
+    }
+    flist_sort_jobs(jobs, nRuns);
+
+    while (nRuns > 1) {
+        int nPairs = (nRuns + 1) / 2, nJobs = 0, p;
+
+        for (p = 0; p < nPairs; p++) {
+            int r   = 2 * p;
+            int end = r + 1 < nRuns ? bounds[r + 2] : bounds[r + 1];
+            int len = end - bounds[r];
+            int q   = nThreads / nPairs + (p < nThreads % nPairs ? 1 : 0);
+
+            for (i = 0; i < q; i++) {
+                struct flist_sort_job *job = &jobs[nJobs++];
+
+                memset(job, 0, sizeof(*job));
+                job->a        = src + bounds[r];
+                job->na       = bounds[r + 1] - bounds[r];
+                job->b        = src + bounds[r + 1];
+                job->nb       = end - bounds[r + 1];
+                job->out      = dst + bounds[r];
+                job->outStart = (int)((double)len * i / q);
+                job->outEnd   = (int)((double)len * (i + 1) / q);
+            }
+        }
+        flist_sort_jobs(jobs, nJobs);
+        for (p = 0; p <= nPairs; p++)
+            bounds[p] = p < nPairs ? bounds[2 * p] : bounds[nRuns];
+        nRuns = nPairs;
+        tmp = src; src = dst; dst = tmp;
+    }
+    if (src != items) {
+        memcpy(items, src, n * sizeof(items[0]));
+        free(src);
+    } else {
+        free(dst);
+    }
+    return 0;
+}
+
+/*
+ * Sort the file list into the same order as qsort() with file_compare(),
+ * with entries that have the same name kept in their original order.
+ * Each full name is built once in one buffer and sorted with a multikey
+ * quicksort, rather than being rebuilt by f_name_cmp() on every
+ * comparison.  Lists of at least sort_parallel_min entries are sorted
+ * with sort_threads threads.  Unused entries (no basename) go first.
+ * If keys isn't
+ * NULL, *keys is set to the sorted names, which the caller must free
+ * (along with the returned buffer).  Returns the key buffer, or NULL
+ * if memory couldn't be allocated (and the list is sorted with qsort()).
+ */
+static uchar *flist_sort(struct file_list *flist, const uchar ***keys)
+{
+    struct flist_sort_item *items;
+    uchar *buf, *p;
+    const char *lastDir = NULL;
+    size_t lastDirLen = 0, bufLen = 0;
+    int i, n = 0, nUnused = 0;
+
+    for (i = 0; i < flist->count; i++) {
+        struct file_struct *file = flist->files[i];
+
+        if (!file->basename) {
+            nUnused++;
+            continue;
+        }
+        if (file->dirname) {
+            if (file->dirname != lastDir) {
+                lastDir = file->dirname;
+                lastDirLen = strlen(lastDir);
+            }
+            bufLen += lastDirLen + 1;
+        }
+        bufLen += strlen(file->basename) + 1;
+    }
+    items = malloc((flist->count - nUnused + 1) * sizeof(items[0]));
+    buf   = malloc(bufLen + 1);
+    if (keys)
+        *keys = malloc((flist->count + 1) * sizeof((*keys)[0]));
+    if (!items || !buf || (keys && !*keys)) {
+        free(items);
+        free(buf);
+        if (keys) {
+            free(*keys);
+            *keys = NULL;
+        }
+        qsort(flist->files, flist->count,
+            sizeof flist->files[0], (int (*)())file_compare);
+        return NULL;
+    }
+
+    /*
+     * Unused entries stay at the front, in order; the keys of the
+     * others are dirname/basename (or basename if there is no
+     * dirname), as compared by f_name_cmp().
+     */
+    p = buf;
+    lastDir = NULL;
+    for (i = 0; i < flist->count; i++) {
+        struct file_struct *file = flist->files[i];
+        size_t len;
+
+        if (!file->basename) {
+            flist->files[i - n] = file;
+            continue;
+        }
+        items[n].key  = p;
+        items[n].file = file;
+        items[n].idx  = i;
+        n++;
+        if (file->dirname) {
+            if (file->dirname != lastDir) {
+                lastDir = file->dirname;
+                lastDirLen = strlen(lastDir);
+            }
+            memcpy(p, lastDir, lastDirLen);
+            p += lastDirLen;
+            *p++ = '/';
+        }
+        len = strlen(file->basename) + 1;
+        memcpy(p, file->basename, len);
+        p += len;
+    }
+    if (n >= flist->sort_parallel_min && n >= 2 * FLIST_SORT_SMALL) {
+        int nThreads = flist->sort_threads;
+
+        if (nThreads <= 0) {
+            long nCpu = sysconf(_SC_NPROCESSORS_ONLN);
+
+            nThreads = nCpu > 0 ? nCpu : 1;
+        }
+        if (nThreads > FLIST_SORT_MAX_THREADS)
+            nThreads = FLIST_SORT_MAX_THREADS;
+        if (nThreads > n / FLIST_SORT_SMALL)
+            nThreads = n / FLIST_SORT_SMALL;
+        if (nThreads <= 1 || flist_sort_parallel(items, n, nThreads) < 0)
+            flist_sort_mkqs(items, n, 0);
+    } else {
+        flist_sort_mkqs(items, n, 0);
+    }
+    for (i = 0; i < n; i++) {
+        flist->files[nUnused + i] = items[i].file;
+        if (keys)
+            (*keys)[nUnused + i] = items[i].key;
+    }
+    if (keys) {
+        for (i = 0; i < nUnused; i++)
+            (*keys)[i] = NULL;
+    }
+    free(items);
+    return buf;
+}
+
 /*
  * This routine ensures we don't have any duplicate names in our file list.
  * duplicate names can cause corruption because of the pipelining
@@ -854,12 +1443,14 @@ void flist_free(struct file_list *flist)
 void clean_flist(struct file_list *flist, int strip_root, int no_dups)
 {
     int i, prev_i = 0;
+    const uchar **keys = NULL;
+    uchar *keyBuf;
 
     if (!flist || flist->count == 0)
         return;
 
-    qsort(flist->files, flist->count,
-        sizeof flist->files[0], (int (*)())file_compare);
+    flist_name_index_free(flist);
+    keyBuf = flist_sort(flist, no_dups ? &keys : NULL);
 
     for (i = no_dups? 0 : flist->count; i < flist->count; i++) {
         if (flist->files[i]->basename) {
@@ -870,7 +1461,9 @@ void clean_flist(struct file_list *flist, int strip_root, int no_dups)
     while (++i < flist->count) {
         if (!flist->files[i]->basename)
             continue;
-        if (f_name_cmp(flist->files[i], flist->files[prev_i]) == 0) {
+        if (keys ? u_strcmp((const char *)keys[i],
+                            (const char *)keys[prev_i]) == 0
+                 : f_name_cmp(flist->files[i], flist->files[prev_i]) == 0) {
 /*
             fprintf(stderr, "removing duplicate name %s from file list %d\n",
                     f_name(flist->files[i]), i);
@@ -885,6 +1478,8 @@ void clean_flist(struct file_list *flist, int strip_root, int no_dups)
         } else
             prev_i = i;
     }
+    free(keys);
+    free(keyBuf);
 
     if (strip_root) {
         /* we need to strip off the root directory in the case
@@ -903,6 +1498,9 @@ void clean_flist(struct file_list *flist, int strip_root, int no_dups)
                     flist->files[i]->dirname = NULL;
             }
         }
+        /* the interned names were changed in place, so their
+           hashes are stale */
+        flist_dir_index_free(flist);
     }
 }
 
@@ -64,6 +64,10 @@ struct file_list *send_file_list(int f, int argc, char *argv[]);
 struct file_list *recv_file_list(int f);
 int file_compare(struct file_struct **file1, struct file_struct **file2);
 int flist_find(struct file_list *flist, struct file_struct *f);
+int flist_find_name(struct file_list *flist, const char *name);
+void flist_name_index_free(struct file_list *flist);
+char *flist_dir_intern(struct file_list *flist, const char *dir, int len);
+void flist_dir_index_free(struct file_list *flist);
 void clear_file(int i, struct file_list *flist);
 struct file_list *flist_new(int with_hlink, char *msg, int preserve_hard_links);
 void flist_free(struct file_list *flist);
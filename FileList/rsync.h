@@ -464,10 +464,14 @@ struct exclude_list_struct {
  */
 #define FILE_EXTENT	(256 * 1024)
 #define HLINK_EXTENT	(128 * 1024)
+#define DIR_EXTENT	(32 * 1024)
 
 #define WITH_HLINK	1
 #define WITHOUT_HLINK	0
 
+#define FLIST_SORT_PARALLEL_MIN	100000	/* default sort_parallel_min */
+#define FLIST_SORT_MAX_THREADS	64
+
 struct file_list {
 	int count;
 	int malloced;
@@ -491,6 +495,13 @@ struct file_list {
         int sanitize_paths;
         int eol_nulls;
 
+        /*
+         * clean_flist() sorts lists of at least sort_parallel_min
+         * entries with sort_threads threads (<= 0: one per CPU)
+         */
+        int sort_threads;
+        int sort_parallel_min;
+
         /* 
          * incoming (decoded) string being processed
          */
@@ -524,10 +535,33 @@ struct file_list {
         char *encode_lastdir;
         int encode_lastdir_len;
 
+        /*
+         * Interned directory names, built by flist_dir_intern() so
+         * that all the entries in a directory share one dirname: each
+         * of the dir_index_size slots holds a name from dir_pool (NULL
+         * if empty) and its hash.
+         */
+        alloc_pool_t dir_pool;
+        char **dir_index;
+        uint32 *dir_index_hash;
+        uint32 dir_index_size;
+        uint32 dir_index_count;
+
         struct file_struct **hlink_list;
         unsigned int hlink_count;
         int link_idev_data_done;
 
+        /*
+         * Hash index of the full names, built by flist_find_name():
+         * each of the name_index_size slots holds a file index + 1
+         * (0 if empty) and its name hash.  It covers the first
+         * name_index_count entries.
+         */
+        uint32 *name_index;
+        uint32 *name_index_hash;
+        uint32 name_index_size;
+        int name_index_count;
+
         /*
          * Exclude state variables
          */
@@ -1,6 +1,6 @@
 #!/bin/perl
 
-BEGIN {print "1..21\n";}
+BEGIN {print "1..29\n";}
 END {print "not ok 1\n" unless $loaded;}
 use File::RsyncP::FileList;
 $loaded = 1;
@@ -113,6 +113,103 @@ for my $protocol ( qw(26 28) ) {
     }
 }
 
+#
+# clean() sorts the names like strcmp() on the full path (so "a.b/c"
+# sorts before "a/b") and keeps the first of any repeated names.
+#
+{
+    my $fList = File::RsyncP::FileList->new({protocol_version => 28});
+    my(@names, @sizes, %first);
+    srand(1);
+    for ( my $i = 0 ; $i < 3000 ; $i++ ) {
+        my $name = join("/", map { join("", map { ("a", "b", ".", "-")[rand(4)] }
+                                                (0 .. rand(3))) }
+                             (0 .. rand(3)));
+        next if ( $name =~ m{(^|/)\.\.?(/|$)} );
+        $fList->encode({name => $name, mode => 0100644, size => $i, mtime => 1});
+        push(@names, $name);
+        push(@sizes, $i);
+        $first{$name} = $i if ( !defined($first{$name}) );
+    }
+    $fList->clean;
+    my %seen;
+    my @expect = grep { !$seen{$_}++ } sort(@names);
+    my @name = grep { defined($_) } $fList->fieldGet("name");
+    my @size = grep { defined($_) } $fList->fieldGet("size");
+    my $ok = "@name" eq "@expect";
+    for ( my $i = 0 ; $i < @name ; $i++ ) {
+        $ok = 0 if ( $size[$i] != $first{$name[$i]} );
+    }
+    print($ok ? "ok $testNum\n" : "not ok $testNum\n");
+    $testNum++;
+
+    #
+    # A parallel sort gives exactly the same list
+    #
+    $ok = 1;
+    foreach my $threads ( 2, 3, 8 ) {
+        my $fList2 = File::RsyncP::FileList->new({
+                                protocol_version  => 28,
+                                sort_threads      => $threads,
+                                sort_parallel_min => 1,
+                            });
+        for ( my $i = 0 ; $i < @names ; $i++ ) {
+            $fList2->encode({name => $names[$i], mode => 0100644,
+                             size => $sizes[$i], mtime => 1});
+        }
+        $fList2->clean;
+        foreach my $k ( qw(name size) ) {
+            my @v1 = map { defined($_) ? $_ : "-" } $fList->fieldGet($k);
+            my @v2 = map { defined($_) ? $_ : "-" } $fList2->fieldGet($k);
+            $ok = 0 if ( "@v1" ne "@v2" );
+        }
+    }
+    print($ok ? "ok $testNum\n" : "not ok $testNum\n");
+    $testNum++;
+
+    #
+    # find() returns the index of each name, and undef for others
+    #
+    $ok = 1;
+    foreach my $name ( @names ) {
+        my $n = $fList->find($name);
+        $ok = 0 if ( !defined($n) || $fList->get($n)->{name} ne $name
+                                  || $fList->get($n)->{size} != $first{$name} );
+    }
+    $ok = 0 if ( defined($fList->find("x")) || defined($fList->find("a/")) );
+    $fList->encode({name => "x", mode => 0100644, size => 0, mtime => 1});
+    $ok = 0 if ( $fList->find("x") != $fList->count - 1 );
+    print($ok ? "ok $testNum\n" : "not ok $testNum\n");
+    $testNum++;
+
+    #
+    # Names in interleaved and repeated directories (which share one
+    # interned dirname) decode to the same names, and clean() and
+    # find() still work on them.
+    #
+    my $fList3 = File::RsyncP::FileList->new({protocol_version => 28});
+    my @dirNames;
+    for ( my $i = 0 ; $i < 2000 ; $i++ ) {
+        my $name = ("d", "d/e", "f", "d/e/g", "dd")[$i % 5] . "/n" . int($i / 3);
+        $fList3->encode({name => $name, mode => 0100644, size => $i, mtime => 1});
+        push(@dirNames, $name);
+    }
+    my $fList4 = File::RsyncP::FileList->new({protocol_version => 28});
+    $fList4->decode($fList3->encodeData . pack("C", 0));
+    my @name3 = $fList3->fieldGet("name");
+    my @name4 = $fList4->fieldGet("name");
+    $ok = "@name3" eq "@dirNames" && "@name4" eq "@dirNames";
+    foreach my $l ( $fList3, $fList4 ) {
+        $l->clean;
+        %seen = ();
+        my @name = grep { defined($_) } $l->fieldGet("name");
+        $ok = 0 if ( "@name" ne join(" ", grep { !$seen{$_}++ } sort(@dirNames)) );
+        $ok = 0 if ( $l->get($l->find("d/e/n7"))->{dirname} ne "d/e" );
+    }
+    print($ok ? "ok $testNum\n" : "not ok $testNum\n");
+    $testNum++;
+}
+
 sub run_test
 {
     my($testNum, $protocol, $preserve_hard_links) = @_;
@@ -234,5 +331,42 @@ sub run_test
     }
     $testNum++;
 
+    #
+    # fieldGet() and indexGet() give the same values as get()
+    #
+    $fList2->init_hard_links if ( $preserve_hard_links );
+    $ok = 1;
+    my $cnt = $fList2->count;
+    foreach my $k ( qw(name basename dirname link sum uid gid mode mtime
+                       size rdev dev inode hlink hlink_self) ) {
+        my @v = $fList2->fieldGet($k);
+        $ok = 0 if ( @v != $cnt );
+        for ( my $i = 0 ; $i < $cnt ; $i++ ) {
+            my $f = $fList2->get($i);
+            next if ( !defined($f->{$k}) && !defined($v[$i]) );
+            if ( $f->{$k} ne $v[$i] ) {
+                print(STDERR "$i.$k: $f->{$k} vs $v[$i]\n");
+                $ok = 0;
+            }
+        }
+    }
+    my @name = $fList2->fieldGet("name", 2, 3);
+    $ok = 0 if ( "@name" ne join(" ", map { $fList2->get($_)->{name} } 2..4) );
+    my @reg  = grep { ($fList2->get($_)->{mode} & 0170000) == 0100000 }
+                    (0 .. $cnt - 1);
+    my @hlink = grep { defined($fList2->get($_)->{hlink})
+                        && !$fList2->get($_)->{hlink_self} } (0 .. $cnt - 1);
+    my @special = $fList2->indexGet("special");
+    $ok = 0 if ( join(" ", $fList2->indexGet("reg")) ne "@reg"
+              || join(" ", $fList2->indexGet("all", 1)) ne join(" ", 1 .. $cnt - 1)
+              || join(" ", $fList2->indexGet("hlink")) ne "@hlink"
+              || @special + @reg != $cnt );
+    if ( $ok ) {
+        print("ok $testNum\n");
+    } else {
+        print("not ok $testNum\n");
+    }
+    $testNum++;
+
     return $testNum;
 }
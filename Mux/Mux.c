@@ -0,0 +1,1258 @@
+/*
+ * This file was generated automatically by ExtUtils::ParseXS version 3.45 from the
+ * contents of Mux.xs. Do not edit this file, edit Mux.xs instead.
+ *
+ *    ANY CHANGES MADE HERE WILL BE LOST!
+ *
+ */
+
+#line 1 "Mux.xs"
+/*
+ * Perl interface to the rsync multiplexed stream IO in muxio.c.
+ *
+ * Copyright (C) 2002-2010 Craig Barratt.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include "EXTERN.h"
+#include "perl.h"
+#include "XSUB.h"
+
+#include "muxio.h"
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ * A reader plus the perl callback for non-data messages
+ */
+typedef struct {
+    mux_reader *r;
+    SV *msgHandler;
+} mux_reader_perl;
+
+typedef mux_reader_perl	*File__RsyncP__Mux__Reader;
+typedef mux_writer	*File__RsyncP__Mux__Writer;
+
+/*
+ * Pass a non-data message to the perl callback as ($code, $msg).
+ */
+static int mux_reader_msg(void *arg, int code, unsigned char *msg, size_t len)
+{
+    dTHX;
+    dSP;
+    mux_reader_perl *rp = (mux_reader_perl *)arg;
+
+    if ( !rp->msgHandler || !SvOK(rp->msgHandler) )
+	return 0;
+    ENTER;
+    SAVETMPS;
+    PUSHMARK(SP);
+    XPUSHs(sv_2mortal(newSViv(code)));
+    XPUSHs(sv_2mortal(newSVpvn((char *)msg, len)));
+    PUTBACK;
+    call_sv(rp->msgHandler, G_DISCARD);
+    FREETMPS;
+    LEAVE;
+    return 0;
+}
+
+/*
+ * Take len bytes from the front of b and return them as a new SV,
+ * or undef if there aren't enough.
+ */
+static SV *mux_buf_take(pTHX_ mux_buf *b, size_t len)
+{
+    SV *sv;
+
+    if ( MUX_BUF_LEN(b) < len )
+	return &PL_sv_undef;
+    sv = newSVpvn((char *)MUX_BUF_PTR(b), len);
+    mux_buf_skip(b, len);
+    return sv_2mortal(sv);
+}
+
+/*
+ * Called by the writer once a perl string queued in place is written.
+ */
+static void mux_writer_release(void *owner)
+{
+    dTHX;
+
+    SvREFCNT_dec((SV *)owner);
+}
+
+/*
+ * Queue the string in sv.  Long strings are written in place from a
+ * copy of the SV (which shares the string buffer when perl supports
+ * copy-on-write), so they aren't copied again.
+ */
+static void mux_writer_add_sv(pTHX_ mux_writer *w, SV *sv, int code)
+{
+    STRLEN len, off = 0;
+    char *data;
+    SV *copy;
+
+    if ( !SvOK(sv) )
+	return;
+    copy = newSVsv(sv);
+    data = SvPV(copy, len);
+    do {
+	size_t n = len - off;
+
+	if ( code >= 0 ) {
+	    if ( n > MUX_MAX_LEN )
+		n = MUX_MAX_LEN;
+	    if ( mux_writer_header(w, code, n) < 0 )
+		croak("File::RsyncP::Mux::Writer::add: out of memory");
+	}
+	if ( off + n < len )
+	    SvREFCNT_inc_simple_void_NN(copy);
+	if ( mux_writer_add(w, (unsigned char *)data + off, n, copy) < 0 )
+	    croak("File::RsyncP::Mux::Writer::add: out of memory");
+	off += n;
+    } while ( off < len );
+}
+
+
+#line 127 "Mux.c"
+#ifndef PERL_UNUSED_VAR
+#  define PERL_UNUSED_VAR(var) if (0) var = var
+#endif
+
+#ifndef dVAR
+#  define dVAR		dNOOP
+#endif
+
+
+/* This stuff is not part of the API! You have been warned. */
+#ifndef PERL_VERSION_DECIMAL
+#  define PERL_VERSION_DECIMAL(r,v,s) (r*1000000 + v*1000 + s)
+#endif
+#ifndef PERL_DECIMAL_VERSION
+#  define PERL_DECIMAL_VERSION \
+	  PERL_VERSION_DECIMAL(PERL_REVISION,PERL_VERSION,PERL_SUBVERSION)
+#endif
+#ifndef PERL_VERSION_GE
+#  define PERL_VERSION_GE(r,v,s) \
+	  (PERL_DECIMAL_VERSION >= PERL_VERSION_DECIMAL(r,v,s))
+#endif
+#ifndef PERL_VERSION_LE
+#  define PERL_VERSION_LE(r,v,s) \
+	  (PERL_DECIMAL_VERSION <= PERL_VERSION_DECIMAL(r,v,s))
+#endif
+
+/* XS_INTERNAL is the explicit static-linkage variant of the default
+ * XS macro.
+ *
+ * XS_EXTERNAL is the same as XS_INTERNAL except it does not include
+ * "STATIC", ie. it exports XSUB symbols. You probably don't want that
+ * for anything but the BOOT XSUB.
+ *
+ * See XSUB.h in core!
+ */
+
+
+/* TODO: This might be compatible further back than 5.10.0. */
+#if PERL_VERSION_GE(5, 10, 0) && PERL_VERSION_LE(5, 15, 1)
+#  undef XS_EXTERNAL
+#  undef XS_INTERNAL
+#  if defined(__CYGWIN__) && defined(USE_DYNAMIC_LOADING)
+#    define XS_EXTERNAL(name) __declspec(dllexport) XSPROTO(name)
+#    define XS_INTERNAL(name) STATIC XSPROTO(name)
+#  endif
+#  if defined(__SYMBIAN32__)
+#    define XS_EXTERNAL(name) EXPORT_C XSPROTO(name)
+#    define XS_INTERNAL(name) EXPORT_C STATIC XSPROTO(name)
+#  endif
+#  ifndef XS_EXTERNAL
+#    if defined(HASATTRIBUTE_UNUSED) && !defined(__cplusplus)
+#      define XS_EXTERNAL(name) void name(pTHX_ CV* cv __attribute__unused__)
+#      define XS_INTERNAL(name) STATIC void name(pTHX_ CV* cv __attribute__unused__)
+#    else
+#      ifdef __cplusplus
+#        define XS_EXTERNAL(name) extern "C" XSPROTO(name)
+#        define XS_INTERNAL(name) static XSPROTO(name)
+#      else
+#        define XS_EXTERNAL(name) XSPROTO(name)
+#        define XS_INTERNAL(name) STATIC XSPROTO(name)
+#      endif
+#    endif
+#  endif
+#endif
+
+/* perl >= 5.10.0 && perl <= 5.15.1 */
+
+
+/* The XS_EXTERNAL macro is used for functions that must not be static
+ * like the boot XSUB of a module. If perl didn't have an XS_EXTERNAL
+ * macro defined, the best we can do is assume XS is the same.
+ * Dito for XS_INTERNAL.
+ */
+#ifndef XS_EXTERNAL
+#  define XS_EXTERNAL(name) XS(name)
+#endif
+#ifndef XS_INTERNAL
+#  define XS_INTERNAL(name) XS(name)
+#endif
+
+/* Now, finally, after all this mess, we want an ExtUtils::ParseXS
+ * internal macro that we're free to redefine for varying linkage due
+ * to the EXPORT_XSUB_SYMBOLS XS keyword. This is internal, use
+ * XS_EXTERNAL(name) or XS_INTERNAL(name) in your code if you need to!
+ */
+
+#undef XS_EUPXS
+#if defined(PERL_EUPXS_ALWAYS_EXPORT)
+#  define XS_EUPXS(name) XS_EXTERNAL(name)
+#else
+   /* default to internal */
+#  define XS_EUPXS(name) XS_INTERNAL(name)
+#endif
+
+#ifndef PERL_ARGS_ASSERT_CROAK_XS_USAGE
+#define PERL_ARGS_ASSERT_CROAK_XS_USAGE assert(cv); assert(params)
+
+/* prototype to pass -Wmissing-prototypes */
+STATIC void
+S_croak_xs_usage(const CV *const cv, const char *const params);
+
+STATIC void
+S_croak_xs_usage(const CV *const cv, const char *const params)
+{
+    const GV *const gv = CvGV(cv);
+
+    PERL_ARGS_ASSERT_CROAK_XS_USAGE;
+
+    if (gv) {
+        const char *const gvname = GvNAME(gv);
+        const HV *const stash = GvSTASH(gv);
+        const char *const hvname = stash ? HvNAME(stash) : NULL;
+
+        if (hvname)
+	    Perl_croak_nocontext("Usage: %s::%s(%s)", hvname, gvname, params);
+        else
+	    Perl_croak_nocontext("Usage: %s(%s)", gvname, params);
+    } else {
+        /* Pants. I don't think that it should be possible to get here. */
+	Perl_croak_nocontext("Usage: CODE(0x%" UVxf ")(%s)", PTR2UV(cv), params);
+    }
+}
+#undef  PERL_ARGS_ASSERT_CROAK_XS_USAGE
+
+#define croak_xs_usage        S_croak_xs_usage
+
+#endif
+
+/* NOTE: the prototype of newXSproto() is different in versions of perls,
+ * so we define a portable version of newXSproto()
+ */
+#ifdef newXS_flags
+#define newXSproto_portable(name, c_impl, file, proto) newXS_flags(name, c_impl, file, proto, 0)
+#else
+#define newXSproto_portable(name, c_impl, file, proto) (PL_Sv=(SV*)newXS(name, c_impl, file), sv_setpv(PL_Sv, proto), (CV*)PL_Sv)
+#endif /* !defined(newXS_flags) */
+
+#if PERL_VERSION_LE(5, 21, 5)
+#  define newXS_deffile(a,b) Perl_newXS(aTHX_ a,b,file)
+#else
+#  define newXS_deffile(a,b) Perl_newXS_deffile(aTHX_ a,b)
+#endif
+
+#line 271 "Mux.c"
+
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_new); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_new)
+{
+    dVAR; dXSARGS;
+    if (items < 1 || items > 3)
+       croak_xs_usage(cv,  "packname = \"File::RsyncP::Mux::Reader\", fd, msgHandler = NULL");
+    {
+	char *	packname;
+	int	fd = (int)SvIV(ST(1))
+;
+	SV *	msgHandler;
+	File__RsyncP__Mux__Reader	RETVAL;
+
+	if (items < 1)
+	    packname = "File::RsyncP::Mux::Reader";
+	else {
+	    packname = (char *)SvPV_nolen(ST(0))
+;
+	}
+
+	if (items < 3)
+	    msgHandler = NULL;
+	else {
+	    msgHandler = ST(2)
+;
+	}
+#line 127 "Mux.xs"
+	{
+	    RETVAL = (mux_reader_perl *)safemalloc(sizeof(mux_reader_perl));
+	    if ( !(RETVAL->r = mux_reader_new(fd)) ) {
+		safefree((char *)RETVAL);
+		croak("File::RsyncP::Mux::Reader::new: out of memory");
+	    }
+	    RETVAL->msgHandler = msgHandler ? newSVsv(msgHandler) : NULL;
+	}
+#line 308 "Mux.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = sv_newmortal();
+	    sv_setref_pv(RETVALSV, "File::RsyncP::Mux::Reader", (void*)RETVAL);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_DESTROY); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_DESTROY)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "rp");
+    {
+	File__RsyncP__Mux__Reader	rp;
+
+	if (SvROK(ST(0))) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    rp = INT2PTR(File__RsyncP__Mux__Reader,tmp);
+	}
+	else
+	    Perl_croak_nocontext("%s: %s is not a reference",
+			"File::RsyncP::Mux::Reader::DESTROY",
+			"rp")
+;
+#line 142 "Mux.xs"
+	{
+	    if ( rp->msgHandler )
+		SvREFCNT_dec(rp->msgHandler);
+	    mux_reader_free(rp->r);
+	    safefree((char *)rp);
+	}
+#line 345 "Mux.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_fd); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_fd)
+{
+    dVAR; dXSARGS;
+    if (items < 1 || items > 2)
+       croak_xs_usage(cv,  "rp, fd = -2");
+    {
+	File__RsyncP__Mux__Reader	rp;
+	int	fd;
+	int	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Reader")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    rp = INT2PTR(File__RsyncP__Mux__Reader,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Reader::fd",
+			"rp", "File::RsyncP::Mux::Reader",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 2)
+	    fd = -2;
+	else {
+	    fd = (int)SvIV(ST(1))
+;
+	}
+#line 154 "Mux.xs"
+	{
+	    /*
+	     * Change the fd (eg: after it is dup()ed); buffered data
+	     * is kept.  -1 means no more reading.
+	     */
+	    if ( fd != -2 )
+		rp->r->fd = fd;
+	    RETVAL = rp->r->fd;
+	}
+#line 393 "Mux.c"
+	XSprePUSH;
+	PUSHi((IV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_msgHandlerSet); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_msgHandlerSet)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "rp, msgHandler");
+    {
+	File__RsyncP__Mux__Reader	rp;
+	SV *	msgHandler = ST(1)
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Reader")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    rp = INT2PTR(File__RsyncP__Mux__Reader,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Reader::msgHandlerSet",
+			"rp", "File::RsyncP::Mux::Reader",
+			refstr, ST(0)
+		);
+	}
+;
+#line 171 "Mux.xs"
+	{
+	    if ( rp->msgHandler )
+		SvREFCNT_dec(rp->msgHandler);
+	    rp->msgHandler = newSVsv(msgHandler);
+	}
+#line 431 "Mux.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_fill); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_fill)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "rp");
+    {
+	File__RsyncP__Mux__Reader	rp;
+	IV	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Reader")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    rp = INT2PTR(File__RsyncP__Mux__Reader,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Reader::fill",
+			"rp", "File::RsyncP::Mux::Reader",
+			refstr, ST(0)
+		);
+	}
+;
+#line 181 "Mux.xs"
+	{
+	    /*
+	     * Returns the number of bytes read, 0 on EOF and -1 on
+	     * error, with $! set.
+	     */
+	    RETVAL = mux_reader_fill(rp->r);
+	    if ( RETVAL < 0 )
+		SETERRNO(errno, 0);
+	}
+#line 471 "Mux.c"
+	XSprePUSH;
+	PUSHi((IV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_lastRead); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_lastRead)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "rp");
+    {
+	File__RsyncP__Mux__Reader	rp;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Reader")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    rp = INT2PTR(File__RsyncP__Mux__Reader,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Reader::lastRead",
+			"rp", "File::RsyncP::Mux::Reader",
+			refstr, ST(0)
+		);
+	}
+;
+#line 197 "Mux.xs"
+	{
+	    ST(0) = sv_2mortal(newSVpvn((char *)rp->r->last, rp->r->lastLen));
+	}
+#line 506 "Mux.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_rawLen); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_rawLen)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "rp");
+    {
+	File__RsyncP__Mux__Reader	rp;
+	UV	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Reader")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    rp = INT2PTR(File__RsyncP__Mux__Reader,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Reader::rawLen",
+			"rp", "File::RsyncP::Mux::Reader",
+			refstr, ST(0)
+		);
+	}
+;
+#line 205 "Mux.xs"
+	{
+	    RETVAL = MUX_BUF_LEN(&rp->r->raw);
+	}
+#line 540 "Mux.c"
+	XSprePUSH;
+	PUSHu((UV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_rawGet); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_rawGet)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "rp, len");
+    {
+	File__RsyncP__Mux__Reader	rp;
+	UV	len = (UV)SvUV(ST(1))
+;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Reader")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    rp = INT2PTR(File__RsyncP__Mux__Reader,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Reader::rawGet",
+			"rp", "File::RsyncP::Mux::Reader",
+			refstr, ST(0)
+		);
+	}
+;
+#line 216 "Mux.xs"
+	{
+	    ST(0) = mux_buf_take(aTHX_ &rp->r->raw, len);
+	}
+#line 577 "Mux.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_rawLine); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_rawLine)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "rp");
+    {
+	File__RsyncP__Mux__Reader	rp;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Reader")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    rp = INT2PTR(File__RsyncP__Mux__Reader,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Reader::rawLine",
+			"rp", "File::RsyncP::Mux::Reader",
+			refstr, ST(0)
+		);
+	}
+;
+#line 224 "Mux.xs"
+	{
+	    size_t skip;
+	    ssize_t len = mux_reader_line(rp->r, &skip);
+
+	    if ( len < 0 ) {
+		XSRETURN_UNDEF;
+	    }
+	    ST(0) = sv_2mortal(newSVpvn((char *)MUX_BUF_PTR(&rp->r->raw), len));
+	    mux_buf_skip(&rp->r->raw, skip);
+	}
+#line 617 "Mux.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_demux); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_demux)
+{
+    dVAR; dXSARGS;
+    if (items < 1 || items > 2)
+       croak_xs_usage(cv,  "rp, need = 1");
+    {
+	File__RsyncP__Mux__Reader	rp;
+	UV	need;
+	UV	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Reader")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    rp = INT2PTR(File__RsyncP__Mux__Reader,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Reader::demux",
+			"rp", "File::RsyncP::Mux::Reader",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 2)
+	    need = 1;
+	else {
+	    need = (UV)SvUV(ST(1))
+;
+	}
+#line 240 "Mux.xs"
+	{
+	    /*
+	     * Returns the number of data bytes now available.
+	     */
+	    if ( mux_reader_demux(rp->r, need, mux_reader_msg, rp) < 0 )
+		croak("File::RsyncP::Mux::Reader::demux: out of memory");
+	    RETVAL = MUX_BUF_LEN(&rp->r->data);
+	}
+#line 664 "Mux.c"
+	XSprePUSH;
+	PUSHu((UV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_dataLen); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_dataLen)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "rp");
+    {
+	File__RsyncP__Mux__Reader	rp;
+	UV	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Reader")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    rp = INT2PTR(File__RsyncP__Mux__Reader,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Reader::dataLen",
+			"rp", "File::RsyncP::Mux::Reader",
+			refstr, ST(0)
+		);
+	}
+;
+#line 255 "Mux.xs"
+	{
+	    RETVAL = MUX_BUF_LEN(&rp->r->data);
+	}
+#line 700 "Mux.c"
+	XSprePUSH;
+	PUSHu((UV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_dataGet); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_dataGet)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "rp, len");
+    {
+	File__RsyncP__Mux__Reader	rp;
+	UV	len = (UV)SvUV(ST(1))
+;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Reader")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    rp = INT2PTR(File__RsyncP__Mux__Reader,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Reader::dataGet",
+			"rp", "File::RsyncP::Mux::Reader",
+			refstr, ST(0)
+		);
+	}
+;
+#line 266 "Mux.xs"
+	{
+	    ST(0) = mux_buf_take(aTHX_ &rp->r->data, len);
+	}
+#line 737 "Mux.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_dataPeek); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_dataPeek)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "rp");
+    {
+	File__RsyncP__Mux__Reader	rp;
+	SV *	RETVAL;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Reader")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    rp = INT2PTR(File__RsyncP__Mux__Reader,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Reader::dataPeek",
+			"rp", "File::RsyncP::Mux::Reader",
+			refstr, ST(0)
+		);
+	}
+;
+#line 274 "Mux.xs"
+	{
+	    ST(0) = sv_2mortal(newSVpvn((char *)MUX_BUF_PTR(&rp->r->data),
+				       MUX_BUF_LEN(&rp->r->data)));
+	}
+#line 771 "Mux.c"
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_dataSkip); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_dataSkip)
+{
+    dVAR; dXSARGS;
+    if (items != 2)
+       croak_xs_usage(cv,  "rp, len");
+    {
+	File__RsyncP__Mux__Reader	rp;
+	UV	len = (UV)SvUV(ST(1))
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Reader")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    rp = INT2PTR(File__RsyncP__Mux__Reader,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Reader::dataSkip",
+			"rp", "File::RsyncP::Mux::Reader",
+			refstr, ST(0)
+		);
+	}
+;
+#line 284 "Mux.xs"
+	{
+	    mux_buf_skip(&rp->r->data, len);
+	}
+#line 805 "Mux.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_dataInt); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_dataInt)
+{
+    dVAR; dXSARGS;
+    if (items < 1 || items > 2)
+       croak_xs_usage(cv,  "rp, cnt = 1");
+    PERL_UNUSED_VAR(ax); /* -Wall */
+    SP -= items;
+    {
+	File__RsyncP__Mux__Reader	rp;
+	UV	cnt;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Reader")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    rp = INT2PTR(File__RsyncP__Mux__Reader,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Reader::dataInt",
+			"rp", "File::RsyncP::Mux::Reader",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 2)
+	    cnt = 1;
+	else {
+	    cnt = (UV)SvUV(ST(1))
+;
+	}
+#line 293 "Mux.xs"
+	{
+	    /*
+	     * Take cnt 32 bit little-endian integers from the data,
+	     * like unpack("V$cnt", dataGet(4 * $cnt)).
+	     */
+	    unsigned char *p = MUX_BUF_PTR(&rp->r->data);
+	    UV i;
+
+	    if ( MUX_BUF_LEN(&rp->r->data) < 4 * cnt )
+		XSRETURN_EMPTY;
+	    EXTEND(SP, cnt);
+	    for ( i = 0 ; i < cnt ; i++, p += 4 ) {
+		PUSHs(sv_2mortal(newSVuv(p[0] | (p[1] << 8) | (p[2] << 16)
+					 | ((UV)p[3] << 24))));
+	    }
+	    mux_buf_skip(&rp->r->data, 4 * cnt);
+	}
+#line 861 "Mux.c"
+	PUTBACK;
+	return;
+    }
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_deltaNext); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Reader_deltaNext)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "rp");
+    PERL_UNUSED_VAR(ax); /* -Wall */
+    SP -= items;
+    {
+	File__RsyncP__Mux__Reader	rp;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Reader")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    rp = INT2PTR(File__RsyncP__Mux__Reader,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Reader::deltaNext",
+			"rp", "File::RsyncP::Mux::Reader",
+			refstr, ST(0)
+		);
+	}
+;
+#line 315 "Mux.xs"
+	{
+	    /*
+	     * Return the next file delta event, as ("run", $start, $cnt),
+	     * ("data", $data), ("done", $md4) or ("need", $len).
+	     */
+	    mux_buf *b = &rp->r->data;
+	    mux_delta_event ev;
+
+	    switch ( mux_delta_next(&rp->r->delta, b, &ev) ) {
+	      case MUX_DELTA_RUN:
+		EXTEND(SP, 3);
+		PUSHs(sv_2mortal(newSVpvn("run", 3)));
+		PUSHs(sv_2mortal(newSVuv(ev.start)));
+		PUSHs(sv_2mortal(newSVuv(ev.cnt)));
+		break;
+	      case MUX_DELTA_DATA:
+		EXTEND(SP, 2);
+		PUSHs(sv_2mortal(newSVpvn("data", 4)));
+		PUSHs(mux_buf_take(aTHX_ b, ev.len));
+		break;
+	      case MUX_DELTA_DONE:
+		EXTEND(SP, 2);
+		PUSHs(sv_2mortal(newSVpvn("done", 4)));
+		PUSHs(mux_buf_take(aTHX_ b, ev.len));
+		break;
+	      default:
+		EXTEND(SP, 2);
+		PUSHs(sv_2mortal(newSVpvn("need", 4)));
+		PUSHs(sv_2mortal(newSVuv(ev.len)));
+		break;
+	    }
+	}
+#line 925 "Mux.c"
+	PUTBACK;
+	return;
+    }
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Writer_new); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Writer_new)
+{
+    dVAR; dXSARGS;
+    if (items < 1 || items > 2)
+       croak_xs_usage(cv,  "packname = \"File::RsyncP::Mux::Writer\", fd");
+    {
+	char *	packname;
+	int	fd = (int)SvIV(ST(1))
+;
+	File__RsyncP__Mux__Writer	RETVAL;
+
+	if (items < 1)
+	    packname = "File::RsyncP::Mux::Writer";
+	else {
+	    packname = (char *)SvPV_nolen(ST(0))
+;
+	}
+#line 358 "Mux.xs"
+	{
+	    if ( !(RETVAL = mux_writer_new(fd, mux_writer_release)) )
+		croak("File::RsyncP::Mux::Writer::new: out of memory");
+	}
+#line 955 "Mux.c"
+	{
+	    SV * RETVALSV;
+	    RETVALSV = sv_newmortal();
+	    sv_setref_pv(RETVALSV, "File::RsyncP::Mux::Writer", (void*)RETVAL);
+	    ST(0) = RETVALSV;
+	}
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Writer_DESTROY); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Writer_DESTROY)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "w");
+    {
+	File__RsyncP__Mux__Writer	w;
+
+	if (SvROK(ST(0))) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    w = INT2PTR(File__RsyncP__Mux__Writer,tmp);
+	}
+	else
+	    Perl_croak_nocontext("%s: %s is not a reference",
+			"File::RsyncP::Mux::Writer::DESTROY",
+			"w")
+;
+#line 369 "Mux.xs"
+	{
+	    mux_writer_free(w);
+	}
+#line 989 "Mux.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Writer_fd); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Writer_fd)
+{
+    dVAR; dXSARGS;
+    if (items < 1 || items > 2)
+       croak_xs_usage(cv,  "w, fd = -2");
+    {
+	File__RsyncP__Mux__Writer	w;
+	int	fd;
+	int	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Writer")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    w = INT2PTR(File__RsyncP__Mux__Writer,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Writer::fd",
+			"w", "File::RsyncP::Mux::Writer",
+			refstr, ST(0)
+		);
+	}
+;
+
+	if (items < 2)
+	    fd = -2;
+	else {
+	    fd = (int)SvIV(ST(1))
+;
+	}
+#line 378 "Mux.xs"
+	{
+	    /*
+	     * Change the fd (eg: after it is dup()ed); queued data
+	     * is kept.
+	     */
+	    if ( fd != -2 )
+		w->fd = fd;
+	    RETVAL = w->fd;
+	}
+#line 1037 "Mux.c"
+	XSprePUSH;
+	PUSHi((IV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Writer_add); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Writer_add)
+{
+    dVAR; dXSARGS;
+    if (items < 1)
+       croak_xs_usage(cv,  "w, ...");
+    {
+	File__RsyncP__Mux__Writer	w;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Writer")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    w = INT2PTR(File__RsyncP__Mux__Writer,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Writer::add",
+			"w", "File::RsyncP::Mux::Writer",
+			refstr, ST(0)
+		);
+	}
+;
+#line 394 "Mux.xs"
+	{
+	    int i;
+
+	    for ( i = 1 ; i < items ; i++ )
+		mux_writer_add_sv(aTHX_ w, ST(i), -1);
+	}
+#line 1074 "Mux.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Writer_addMsg); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Writer_addMsg)
+{
+    dVAR; dXSARGS;
+    if (items != 3)
+       croak_xs_usage(cv,  "w, code, data");
+    {
+	File__RsyncP__Mux__Writer	w;
+	int	code = (int)SvIV(ST(1))
+;
+	SV *	data = ST(2)
+;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Writer")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    w = INT2PTR(File__RsyncP__Mux__Writer,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Writer::addMsg",
+			"w", "File::RsyncP::Mux::Writer",
+			refstr, ST(0)
+		);
+	}
+;
+#line 407 "Mux.xs"
+	{
+	    /*
+	     * Queue data as multiplexed messages with the given code.
+	     */
+	    if ( code < 0 || code > 255 - MUX_BASE )
+		croak("File::RsyncP::Mux::Writer::addMsg: bad code %d", code);
+	    mux_writer_add_sv(aTHX_ w, data, code);
+	}
+#line 1115 "Mux.c"
+    }
+    XSRETURN_EMPTY;
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Writer_len); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Writer_len)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "w");
+    {
+	File__RsyncP__Mux__Writer	w;
+	UV	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Writer")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    w = INT2PTR(File__RsyncP__Mux__Writer,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Writer::len",
+			"w", "File::RsyncP::Mux::Writer",
+			refstr, ST(0)
+		);
+	}
+;
+#line 420 "Mux.xs"
+	{
+	    RETVAL = w->len;
+	}
+#line 1149 "Mux.c"
+	XSprePUSH;
+	PUSHu((UV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+
+XS_EUPXS(XS_File__RsyncP__Mux__Writer_flush); /* prototype to pass -Wmissing-prototypes */
+XS_EUPXS(XS_File__RsyncP__Mux__Writer_flush)
+{
+    dVAR; dXSARGS;
+    if (items != 1)
+       croak_xs_usage(cv,  "w");
+    {
+	File__RsyncP__Mux__Writer	w;
+	IV	RETVAL;
+	dXSTARG;
+
+	if (SvROK(ST(0)) && sv_derived_from(ST(0), "File::RsyncP::Mux::Writer")) {
+	    IV tmp = SvIV((SV*)SvRV(ST(0)));
+	    w = INT2PTR(File__RsyncP__Mux__Writer,tmp);
+	}
+	else {
+		const char* refstr = SvROK(ST(0)) ? "" : SvOK(ST(0)) ? "scalar " : "undef";
+	    Perl_croak_nocontext("%s: Expected %s to be of type %s; got %s%" SVf " instead",
+			"File::RsyncP::Mux::Writer::flush",
+			"w", "File::RsyncP::Mux::Writer",
+			refstr, ST(0)
+		);
+	}
+;
+#line 430 "Mux.xs"
+	{
+	    /*
+	     * Returns the number of bytes written, 0 if the fd isn't
+	     * ready, and -1 on error, with $! set.
+	     */
+	    RETVAL = mux_writer_flush(w);
+	    if ( RETVAL < 0 )
+		SETERRNO(errno, 0);
+	}
+#line 1191 "Mux.c"
+	XSprePUSH;
+	PUSHi((IV)RETVAL);
+    }
+    XSRETURN(1);
+}
+
+#ifdef __cplusplus
+extern "C"
+#endif
+XS_EXTERNAL(boot_File__RsyncP__Mux); /* prototype to pass -Wmissing-prototypes */
+XS_EXTERNAL(boot_File__RsyncP__Mux)
+{
+#if PERL_VERSION_LE(5, 21, 5)
+    dVAR; dXSARGS;
+#else
+    dVAR; dXSBOOTARGSXSAPIVERCHK;
+#endif
+#if PERL_VERSION_LE(5, 8, 999) /* PERL_VERSION_LT is 5.33+ */
+    char* file = __FILE__;
+#else
+    const char* file = __FILE__;
+#endif
+
+    PERL_UNUSED_VAR(file);
+
+    PERL_UNUSED_VAR(cv); /* -W */
+    PERL_UNUSED_VAR(items); /* -W */
+#if PERL_VERSION_LE(5, 21, 5)
+    XS_VERSION_BOOTCHECK;
+#  ifdef XS_APIVERSION_BOOTCHECK
+    XS_APIVERSION_BOOTCHECK;
+#  endif
+#endif
+
+        newXS_deffile("File::RsyncP::Mux::Reader::new", XS_File__RsyncP__Mux__Reader_new);
+        newXS_deffile("File::RsyncP::Mux::Reader::DESTROY", XS_File__RsyncP__Mux__Reader_DESTROY);
+        newXS_deffile("File::RsyncP::Mux::Reader::fd", XS_File__RsyncP__Mux__Reader_fd);
+        newXS_deffile("File::RsyncP::Mux::Reader::msgHandlerSet", XS_File__RsyncP__Mux__Reader_msgHandlerSet);
+        newXS_deffile("File::RsyncP::Mux::Reader::fill", XS_File__RsyncP__Mux__Reader_fill);
+        newXS_deffile("File::RsyncP::Mux::Reader::lastRead", XS_File__RsyncP__Mux__Reader_lastRead);
+        newXS_deffile("File::RsyncP::Mux::Reader::rawLen", XS_File__RsyncP__Mux__Reader_rawLen);
+        newXS_deffile("File::RsyncP::Mux::Reader::rawGet", XS_File__RsyncP__Mux__Reader_rawGet);
+        newXS_deffile("File::RsyncP::Mux::Reader::rawLine", XS_File__RsyncP__Mux__Reader_rawLine);
+        newXS_deffile("File::RsyncP::Mux::Reader::demux", XS_File__RsyncP__Mux__Reader_demux);
+        newXS_deffile("File::RsyncP::Mux::Reader::dataLen", XS_File__RsyncP__Mux__Reader_dataLen);
+        newXS_deffile("File::RsyncP::Mux::Reader::dataGet", XS_File__RsyncP__Mux__Reader_dataGet);
+        newXS_deffile("File::RsyncP::Mux::Reader::dataPeek", XS_File__RsyncP__Mux__Reader_dataPeek);
+        newXS_deffile("File::RsyncP::Mux::Reader::dataSkip", XS_File__RsyncP__Mux__Reader_dataSkip);
+        newXS_deffile("File::RsyncP::Mux::Reader::dataInt", XS_File__RsyncP__Mux__Reader_dataInt);
+        newXS_deffile("File::RsyncP::Mux::Reader::deltaNext", XS_File__RsyncP__Mux__Reader_deltaNext);
+        newXS_deffile("File::RsyncP::Mux::Writer::new", XS_File__RsyncP__Mux__Writer_new);
+        newXS_deffile("File::RsyncP::Mux::Writer::DESTROY", XS_File__RsyncP__Mux__Writer_DESTROY);
+        newXS_deffile("File::RsyncP::Mux::Writer::fd", XS_File__RsyncP__Mux__Writer_fd);
+        newXS_deffile("File::RsyncP::Mux::Writer::add", XS_File__RsyncP__Mux__Writer_add);
+        newXS_deffile("File::RsyncP::Mux::Writer::addMsg", XS_File__RsyncP__Mux__Writer_addMsg);
+        newXS_deffile("File::RsyncP::Mux::Writer::len", XS_File__RsyncP__Mux__Writer_len);
+        newXS_deffile("File::RsyncP::Mux::Writer::flush", XS_File__RsyncP__Mux__Writer_flush);
+#if PERL_VERSION_LE(5, 21, 5)
+#  if PERL_VERSION_GE(5, 9, 0)
+    if (PL_unitcheckav)
+        call_list(PL_scopestack_ix, PL_unitcheckav);
+#  endif
+    XSRETURN_YES;
+#else
+    Perl_xs_boot_epilog(aTHX_ ax);
+#endif
+}
+
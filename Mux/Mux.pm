@@ -0,0 +1,231 @@
+#============================================================= -*-perl-*-
+#
+# File::RsyncP::Mux package
+#
+# DESCRIPTION
+#   File::RsyncP::Mux is a perl module that implements the rsync
+#   multiplexed stream IO in C.
+#
+# AUTHOR
+#   Craig Barratt  <cbarratt@users.sourceforge.net>
+#
+# COPYRIGHT
+#   File::RsyncP is Copyright (C) 2002-2010  Craig Barratt.
+#
+#   Rsync is Copyright (C) 1996-2001 by Andrew Tridgell, 1996 by Paul
+#   Mackerras, 2001-2002 by Martin Pool, and 2003-2009 by Wayne Davison,
+#   and others.
+#
+#   This program is free software; you can redistribute it and/or modify
+#   it under the terms of the GNU General Public License as published by
+#   the Free Software Foundation; either version 2 of the License, or
+#   (at your option) any later version.
+#
+#   This program is distributed in the hope that it will be useful,
+#   but WITHOUT ANY WARRANTY; without even the implied warranty of
+#   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#   GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public License
+#   along with this program; if not, write to the Free Software
+#   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+#========================================================================
+#
+# Version 0.70, released 25 Jul 2010.
+#
+# See http://perlrsync.sourceforge.net.
+#
+#========================================================================
+
+package File::RsyncP::Mux;
+
+use strict;
+use vars qw($VERSION @ISA @EXPORT);
+
+require Exporter;
+require DynaLoader;
+
+@ISA = qw(Exporter DynaLoader);
+@EXPORT = qw(
+);
+$VERSION = '0.70';
+
+bootstrap File::RsyncP::Mux $VERSION;
+
+1;
+__END__
+
+=head1 NAME
+
+File::RsyncP::Mux - Rsync multiplexed stream IO
+
+=head1 SYNOPSIS
+
+    use File::RsyncP::Mux;
+
+    $reader = File::RsyncP::Mux::Reader->new(fileno(FH), \&msgHandler);
+
+    $n     = $reader->fill();          # read once from the fd
+
+    # before multiplexing starts
+    $data  = $reader->rawGet($len);
+    $line  = $reader->rawLine();
+
+    # after multiplexing starts
+    $avail = $reader->demux($len);
+    $data  = $reader->dataGet($len);
+    @ints  = $reader->dataInt($cnt);
+    $data  = $reader->dataPeek();
+    $reader->dataSkip($len);
+    ($type, @args) = $reader->deltaNext();
+
+    $writer = File::RsyncP::Mux::Writer->new(fileno(FH));
+    $writer->add($data, ...);
+    $writer->addMsg($code, $data);
+    $n      = $writer->flush();
+
+=head1 DESCRIPTION
+
+File::RsyncP::Mux reads and writes the rsync protocol stream in C.  Once
+multiplexing starts, rsync sends everything as messages with a
+4 byte header giving a message code and length.  Code 0 is file
+data and the other codes are log and error messages from the
+remote rsync.
+
+A File::RsyncP::Mux::Reader keeps the bytes read from the fd in one
+buffer and the demultiplexed file data in another.  Taking data off
+the front of either buffer doesn't copy the rest of the buffer, so
+the cost is proportional to the data read, however it is split up.
+
+The reader doesn't block waiting for a signal or decide what to do on
+EOF; the caller loops calling fill() until there is enough data.
+
+=over 4
+
+=item new($fd, $msgHandler)
+
+Create a reader for the file descriptor $fd.  $msgHandler is called
+as $msgHandler->($code, $msg) for each non-data message.
+
+=item fd($fd)
+
+Return the file descriptor, after setting it to $fd if given.
+Buffered data is kept, so this can be used after the fd is dup()ed.
+An fd of -1 means there is nothing more to read.
+
+=item msgHandlerSet($msgHandler)
+
+Change the non-data message callback.
+
+=item fill()
+
+Read once (up to 64K) from the fd.  Returns the number of bytes read,
+0 on EOF, or -1 on error with $! set (eg: EINTR if a signal arrived).
+The data read is returned by lastRead(), eg: for debug logging.
+
+=item rawLen(), rawGet($len), rawLine()
+
+Return the number of buffered bytes that haven't been demultiplexed,
+take $len of them (or undef if there aren't that many), or take a
+line up to a run of \n or \r characters (or undef if there isn't a
+complete line).  These are used before multiplexing starts.
+
+=item demux($len)
+
+Demultiplex complete messages until at least $len bytes of file
+data are available, and return the number available.  Messages are
+only demultiplexed as needed, so raw data after them is left alone.
+
+=item dataLen(), dataGet($len), dataInt($cnt), dataPeek(), dataSkip($len)
+
+Return the number of data bytes available, take $len bytes (or undef
+if there aren't that many), take $cnt 32 bit little-endian integers
+(or an empty list), return all the available data without taking it,
+or discard $len bytes.
+
+=item deltaNext()
+
+Decode the next event from the file delta tokens of the current file,
+so a whole file is received with a few calls rather than one call per
+token.  Returns one of:
+
+    ("run",  $start, $cnt)  blocks $start .. $start + $cnt - 1 matched
+    ("data", $data)         literal data, at least 32K or the rest
+                            of the literal token
+    ("done", $md4)          the end of the file and its MD4 digest
+    ("need", $len)          at least $len more data bytes are needed
+
+Consecutive matching blocks are returned as one run.  A run is only
+returned once the next token is available.  After "need", the caller
+should demux() more data and call deltaNext() again.
+
+=back
+
+A File::RsyncP::Mux::Writer queues output and writes it with
+writev(), so many small writes go out in one system call, and
+written data is dropped from the queue without copying the rest.
+Strings of 4K or more are queued without copying them (if perl
+supports copy-on-write); smaller ones are copied into 32K chunks.
+
+=over 4
+
+=item new($fd)
+
+Create a writer for the file descriptor $fd, which would normally
+be non-blocking.
+
+=item fd($fd)
+
+Return the file descriptor, after setting it to $fd if given.
+Queued data is kept.
+
+=item add($data, ...)
+
+Queue each of the strings.  Later changes to the strings don't
+affect the queued data.
+
+=item addMsg($code, $data)
+
+Queue $data as multiplexed messages with the message code $code,
+splitting it if it is longer than the maximum message length.
+
+=item len()
+
+Return the number of bytes queued.
+
+=item flush()
+
+Write as much of the queue as possible with one writev().  Returns
+the number of bytes written, 0 if the fd is non-blocking and can't
+be written, or -1 on error with $! set.  The caller should wait
+until the fd is writable (eg: with select) when flush() returns 0.
+
+=back
+
+=head1 AUTHOR
+
+File::RsyncP::Mux was written by Craig Barratt
+<cbarratt@users.sourceforge.net> based on rsync.
+
+Rsync was written by Andrew Tridgell <tridge@samba.org>
+and Paul Mackerras.  It is available under a GPL license.
+See http://rsync.samba.org
+
+=head1 LICENSE
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+=head1 SEE ALSO
+
+See L<File::RsyncP>.
+
+=cut
@@ -0,0 +1,440 @@
+/*
+ * Perl interface to the rsync multiplexed stream IO in muxio.c.
+ *
+ * Copyright (C) 2002-2010 Craig Barratt.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+#include "EXTERN.h"
+#include "perl.h"
+#include "XSUB.h"
+
+#include "muxio.h"
+
+#ifdef __cplusplus
+}
+#endif
+
+/*
+ * A reader plus the perl callback for non-data messages
+ */
+typedef struct {
+    mux_reader *r;
+    SV *msgHandler;
+} mux_reader_perl;
+
+typedef mux_reader_perl	*File__RsyncP__Mux__Reader;
+typedef mux_writer	*File__RsyncP__Mux__Writer;
+
+/*
+ * Pass a non-data message to the perl callback as ($code, $msg).
+ */
+static int mux_reader_msg(void *arg, int code, unsigned char *msg, size_t len)
+{
+    dTHX;
+    dSP;
+    mux_reader_perl *rp = (mux_reader_perl *)arg;
+
+    if ( !rp->msgHandler || !SvOK(rp->msgHandler) )
+	return 0;
+    ENTER;
+    SAVETMPS;
+    PUSHMARK(SP);
+    XPUSHs(sv_2mortal(newSViv(code)));
+    XPUSHs(sv_2mortal(newSVpvn((char *)msg, len)));
+    PUTBACK;
+    call_sv(rp->msgHandler, G_DISCARD);
+    FREETMPS;
+    LEAVE;
+    return 0;
+}
+
+/*
+ * Take len bytes from the front of b and return them as a new SV,
+ * or undef if there aren't enough.
+ */
+static SV *mux_buf_take(pTHX_ mux_buf *b, size_t len)
+{
+    SV *sv;
+
+    if ( MUX_BUF_LEN(b) < len )
+	return &PL_sv_undef;
+    sv = newSVpvn((char *)MUX_BUF_PTR(b), len);
+    mux_buf_skip(b, len);
+    return sv_2mortal(sv);
+}
+
+/*
+ * Called by the writer once a perl string queued in place is written.
+ */
+static void mux_writer_release(void *owner)
+{
+    dTHX;
+
+    SvREFCNT_dec((SV *)owner);
+}
+
+/*
+ * Queue the string in sv.  Long strings are written in place from a
+ * copy of the SV (which shares the string buffer when perl supports
+ * copy-on-write), so they aren't copied again.
+ */
+static void mux_writer_add_sv(pTHX_ mux_writer *w, SV *sv, int code)
+{
+    STRLEN len, off = 0;
+    char *data;
+    SV *copy;
+
+    if ( !SvOK(sv) )
+	return;
+    copy = newSVsv(sv);
+    data = SvPV(copy, len);
+    do {
+	size_t n = len - off;
+
+	if ( code >= 0 ) {
+	    if ( n > MUX_MAX_LEN )
+		n = MUX_MAX_LEN;
+	    if ( mux_writer_header(w, code, n) < 0 )
+		croak("File::RsyncP::Mux::Writer::add: out of memory");
+	}
+	if ( off + n < len )
+	    SvREFCNT_inc_simple_void_NN(copy);
+	if ( mux_writer_add(w, (unsigned char *)data + off, n, copy) < 0 )
+	    croak("File::RsyncP::Mux::Writer::add: out of memory");
+	off += n;
+    } while ( off < len );
+}
+
+
+MODULE = File::RsyncP::Mux		PACKAGE = File::RsyncP::Mux::Reader
+
+PROTOTYPES: DISABLE
+
+File::RsyncP::Mux::Reader
+new(packname = "File::RsyncP::Mux::Reader", fd, msgHandler = NULL)
+	char *packname
+	int fd
+	SV *msgHandler
+    CODE:
+	{
+	    RETVAL = (mux_reader_perl *)safemalloc(sizeof(mux_reader_perl));
+	    if ( !(RETVAL->r = mux_reader_new(fd)) ) {
+		safefree((char *)RETVAL);
+		croak("File::RsyncP::Mux::Reader::new: out of memory");
+	    }
+	    RETVAL->msgHandler = msgHandler ? newSVsv(msgHandler) : NULL;
+	}
+    OUTPUT:
+	RETVAL
+
+void
+DESTROY(rp)
+	File::RsyncP::Mux::Reader	rp
+    CODE:
+	{
+	    if ( rp->msgHandler )
+		SvREFCNT_dec(rp->msgHandler);
+	    mux_reader_free(rp->r);
+	    safefree((char *)rp);
+	}
+
+int
+fd(rp, fd = -2)
+	File::RsyncP::Mux::Reader	rp
+	int fd
+    CODE:
+	{
+	    /*
+	     * Change the fd (eg: after it is dup()ed); buffered data
+	     * is kept.  -1 means no more reading.
+	     */
+	    if ( fd != -2 )
+		rp->r->fd = fd;
+	    RETVAL = rp->r->fd;
+	}
+    OUTPUT:
+	RETVAL
+
+void
+msgHandlerSet(rp, msgHandler)
+	File::RsyncP::Mux::Reader	rp
+	SV *msgHandler
+    CODE:
+	{
+	    if ( rp->msgHandler )
+		SvREFCNT_dec(rp->msgHandler);
+	    rp->msgHandler = newSVsv(msgHandler);
+	}
+
+IV
+fill(rp)
+	File::RsyncP::Mux::Reader	rp
+    CODE:
+	{
+	    /*
+	     * Returns the number of bytes read, 0 on EOF and -1 on
+	     * error, with $! set.
+	     */
+	    RETVAL = mux_reader_fill(rp->r);
+	    if ( RETVAL < 0 )
+		SETERRNO(errno, 0);
+	}
+    OUTPUT:
+	RETVAL
+
+SV *
+lastRead(rp)
+	File::RsyncP::Mux::Reader	rp
+    CODE:
+	{
+	    ST(0) = sv_2mortal(newSVpvn((char *)rp->r->last, rp->r->lastLen));
+	}
+
+UV
+rawLen(rp)
+	File::RsyncP::Mux::Reader	rp
+    CODE:
+	{
+	    RETVAL = MUX_BUF_LEN(&rp->r->raw);
+	}
+    OUTPUT:
+	RETVAL
+
+SV *
+rawGet(rp, len)
+	File::RsyncP::Mux::Reader	rp
+	UV len
+    CODE:
+	{
+	    ST(0) = mux_buf_take(aTHX_ &rp->r->raw, len);
+	}
+
+SV *
+rawLine(rp)
+	File::RsyncP::Mux::Reader	rp
+    CODE:
+	{
+	    size_t skip;
+	    ssize_t len = mux_reader_line(rp->r, &skip);
+
+	    if ( len < 0 ) {
+		XSRETURN_UNDEF;
+	    }
+	    ST(0) = sv_2mortal(newSVpvn((char *)MUX_BUF_PTR(&rp->r->raw), len));
+	    mux_buf_skip(&rp->r->raw, skip);
+	}
+
+UV
+demux(rp, need = 1)
+	File::RsyncP::Mux::Reader	rp
+	UV need
+    CODE:
+	{
+	    /*
+	     * Returns the number of data bytes now available.
+	     */
+	    if ( mux_reader_demux(rp->r, need, mux_reader_msg, rp) < 0 )
+		croak("File::RsyncP::Mux::Reader::demux: out of memory");
+	    RETVAL = MUX_BUF_LEN(&rp->r->data);
+	}
+    OUTPUT:
+	RETVAL
+
+UV
+dataLen(rp)
+	File::RsyncP::Mux::Reader	rp
+    CODE:
+	{
+	    RETVAL = MUX_BUF_LEN(&rp->r->data);
+	}
+    OUTPUT:
+	RETVAL
+
+SV *
+dataGet(rp, len)
+	File::RsyncP::Mux::Reader	rp
+	UV len
+    CODE:
+	{
+	    ST(0) = mux_buf_take(aTHX_ &rp->r->data, len);
+	}
+
+SV *
+dataPeek(rp)
+	File::RsyncP::Mux::Reader	rp
+    CODE:
+	{
+	    ST(0) = sv_2mortal(newSVpvn((char *)MUX_BUF_PTR(&rp->r->data),
+				       MUX_BUF_LEN(&rp->r->data)));
+	}
+
+void
+dataSkip(rp, len)
+	File::RsyncP::Mux::Reader	rp
+	UV len
+    CODE:
+	{
+	    mux_buf_skip(&rp->r->data, len);
+	}
+
+void
+dataInt(rp, cnt = 1)
+	File::RsyncP::Mux::Reader	rp
+	UV cnt
+    PPCODE:
+	{
+	    /*
+	     * Take cnt 32 bit little-endian integers from the data,
+	     * like unpack("V$cnt", dataGet(4 * $cnt)).
+	     */
+	    unsigned char *p = MUX_BUF_PTR(&rp->r->data);
+	    UV i;
+
+	    if ( MUX_BUF_LEN(&rp->r->data) < 4 * cnt )
+		XSRETURN_EMPTY;
+	    EXTEND(SP, cnt);
+	    for ( i = 0 ; i < cnt ; i++, p += 4 ) {
+		PUSHs(sv_2mortal(newSVuv(p[0] | (p[1] << 8) | (p[2] << 16)
+					 | ((UV)p[3] << 24))));
+	    }
+	    mux_buf_skip(&rp->r->data, 4 * cnt);
+	}
+
+void
+deltaNext(rp)
+	File::RsyncP::Mux::Reader	rp
+    PPCODE:
+	{
+	    /*
+	     * Return the next file delta event, as ("run", $start, $cnt),
+	     * ("data", $data), ("done", $md4) or ("need", $len).
+	     */
+	    mux_buf *b = &rp->r->data;
+	    mux_delta_event ev;
+
+	    switch ( mux_delta_next(&rp->r->delta, b, &ev) ) {
+	      case MUX_DELTA_RUN:
+		EXTEND(SP, 3);
+		PUSHs(sv_2mortal(newSVpvn("run", 3)));
+		PUSHs(sv_2mortal(newSVuv(ev.start)));
+		PUSHs(sv_2mortal(newSVuv(ev.cnt)));
+		break;
+	      case MUX_DELTA_DATA:
+		EXTEND(SP, 2);
+		PUSHs(sv_2mortal(newSVpvn("data", 4)));
+		PUSHs(mux_buf_take(aTHX_ b, ev.len));
+		break;
+	      case MUX_DELTA_DONE:
+		EXTEND(SP, 2);
+		PUSHs(sv_2mortal(newSVpvn("done", 4)));
+		PUSHs(mux_buf_take(aTHX_ b, ev.len));
+		break;
+	      default:
+		EXTEND(SP, 2);
+		PUSHs(sv_2mortal(newSVpvn("need", 4)));
+		PUSHs(sv_2mortal(newSVuv(ev.len)));
+		break;
+	    }
+	}
+
+
+MODULE = File::RsyncP::Mux		PACKAGE = File::RsyncP::Mux::Writer
+
+PROTOTYPES: DISABLE
+
+File::RsyncP::Mux::Writer
+new(packname = "File::RsyncP::Mux::Writer", fd)
+	char *packname
+	int fd
+    CODE:
+	{
+	    if ( !(RETVAL = mux_writer_new(fd, mux_writer_release)) )
+		croak("File::RsyncP::Mux::Writer::new: out of memory");
+	}
+    OUTPUT:
+	RETVAL
+
+void
+DESTROY(w)
+	File::RsyncP::Mux::Writer	w
+    CODE:
+	{
+	    mux_writer_free(w);
+	}
+
+int
+fd(w, fd = -2)
+	File::RsyncP::Mux::Writer	w
+	int fd
+    CODE:
+	{
+	    /*
+	     * Change the fd (eg: after it is dup()ed); queued data
+	     * is kept.
+	     */
+	    if ( fd != -2 )
+		w->fd = fd;
+	    RETVAL = w->fd;
+	}
+    OUTPUT:
+	RETVAL
+
+void
+add(w, ...)
+	File::RsyncP::Mux::Writer	w
+    CODE:
+	{
+	    int i;
+
+	    for ( i = 1 ; i < items ; i++ )
+		mux_writer_add_sv(aTHX_ w, ST(i), -1);
+	}
+
+void
+addMsg(w, code, data)
+	File::RsyncP::Mux::Writer	w
+	int code
+	SV *data
+    CODE:
+	{
+	    /*
+	     * Queue data as multiplexed messages with the given code.
+	     */
+	    if ( code < 0 || code > 255 - MUX_BASE )
+		croak("File::RsyncP::Mux::Writer::addMsg: bad code %d", code);
+	    mux_writer_add_sv(aTHX_ w, data, code);
+	}
+
+UV
+len(w)
+	File::RsyncP::Mux::Writer	w
+    CODE:
+	{
+	    RETVAL = w->len;
+	}
+    OUTPUT:
+	RETVAL
+
+IV
+flush(w)
+	File::RsyncP::Mux::Writer	w
+    CODE:
+	{
+	    /*
+	     * Returns the number of bytes written, 0 if the fd isn't
+	     * ready, and -1 on error, with $! set.
+	     */
+	    RETVAL = mux_writer_flush(w);
+	    if ( RETVAL < 0 )
+		SETERRNO(errno, 0);
+	}
+    OUTPUT:
+	RETVAL
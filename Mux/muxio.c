@@ -0,0 +1,423 @@
+/*
+ * Rsync multiplexed stream IO for File::RsyncP.
+ *
+ * The reader keeps the bytes read from the socket in one buffer and
+ * the demultiplexed file data in another, so taking a message or a
+ * piece of data off the front doesn't copy the rest of the buffer.
+ *
+ * Copyright (C) 2002-2010 Craig Barratt.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ */
+
+#include "muxio.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+/*
+ * Make sure there is room for len more bytes at the end of b.
+ * Returns -1 if out of memory.
+ */
+int mux_buf_reserve(mux_buf *b, size_t len)
+{
+    size_t used = MUX_BUF_LEN(b), size;
+    unsigned char *p;
+
+    if ( b->end + len <= b->size )
+	return 0;
+    if ( used + len <= b->size && b->start >= used ) {
+	/*
+	 * Enough room once the valid bytes are moved to the front,
+	 * and the move is no bigger than the space reclaimed.
+	 */
+	memcpy(b->buf, b->buf + b->start, used);
+	b->start = 0;
+	b->end   = used;
+	return 0;
+    }
+    size = b->size ? b->size : 4096;
+    while ( size < used + len )
+	size *= 2;
+    if ( !(p = malloc(size)) )
+	return -1;
+    if ( used )
+	memcpy(p, b->buf + b->start, used);
+    free(b->buf);
+    b->buf   = p;
+    b->start = 0;
+    b->end   = used;
+    b->size  = size;
+    return 0;
+}
+
+void mux_buf_skip(mux_buf *b, size_t len)
+{
+    if ( len > MUX_BUF_LEN(b) )
+	len = MUX_BUF_LEN(b);
+    b->start += len;
+    if ( b->start == b->end )
+	b->start = b->end = 0;
+}
+
+void mux_buf_free(mux_buf *b)
+{
+    free(b->buf);
+    memset(b, 0, sizeof(*b));
+}
+
+mux_reader *mux_reader_new(int fd)
+{
+    mux_reader *r;
+
+    if ( !(r = calloc(1, sizeof(*r))) )
+	return NULL;
+    r->fd = fd;
+    return r;
+}
+
+void mux_reader_free(mux_reader *r)
+{
+    if ( !r )
+	return;
+    mux_buf_free(&r->raw);
+    mux_buf_free(&r->data);
+    free(r);
+}
+
+/*
+ * Read once from the fd into the raw buffer.  Returns the number of
+ * bytes read, 0 on EOF, or -1 on error (with errno set, eg: EINTR
+ * if a signal arrived).
+ */
+ssize_t mux_reader_fill(mux_reader *r)
+{
+    ssize_t n;
+
+    r->lastLen = 0;
+    if ( mux_buf_reserve(&r->raw, MUX_READ_LEN) ) {
+	errno = ENOMEM;
+	return -1;
+    }
+    n = read(r->fd, r->raw.buf + r->raw.end, r->raw.size - r->raw.end);
+    if ( n > 0 ) {
+	r->last    = r->raw.buf + r->raw.end;
+	r->lastLen = n;
+	r->raw.end += n;
+    }
+    return n;
+}
+
+/*
+ * Demultiplex complete messages from the raw buffer until there
+ * are at least need bytes of file data.  Other messages are passed
+ * to msg.  Returns 0 when done (whether or not there is enough
+ * data), -1 if out of memory, or msg's non-zero return value.
+ */
+int mux_reader_demux(mux_reader *r, size_t need, mux_msg_func msg, void *arg)
+{
+    while ( MUX_BUF_LEN(&r->data) < need && MUX_BUF_LEN(&r->raw) >= 4 ) {
+	unsigned char *p = MUX_BUF_PTR(&r->raw);
+	unsigned long hdr = p[0] | (p[1] << 8) | (p[2] << 16)
+			  | ((unsigned long)p[3] << 24);
+	int code   = (int)(hdr >> 24) - MUX_BASE;
+	size_t len = hdr & MUX_MAX_LEN;
+	int ret;
+
+	if ( MUX_BUF_LEN(&r->raw) < 4 + len )
+	    break;
+	if ( code == 0 ) {
+	    if ( mux_buf_reserve(&r->data, len) )
+		return -1;
+	    memcpy(r->data.buf + r->data.end, p + 4, len);
+	    r->data.end += len;
+	    mux_buf_skip(&r->raw, 4 + len);
+	} else {
+	    /*
+	     * Skip the message before the callback, in case it
+	     * reads more data.
+	     */
+	    r->raw.start += 4 + len;
+	    ret = msg ? (*msg)(arg, code, p + 4, len) : 0;
+	    if ( r->raw.start == r->raw.end )
+		r->raw.start = r->raw.end = 0;
+	    if ( ret )
+		return ret;
+	}
+    }
+    return 0;
+}
+
+/*
+ * Look for a line in the raw buffer.  Returns the length of the line
+ * (without the line ending) and sets *skip to the length including
+ * the run of \n and \r characters after it, or -1 if there isn't a
+ * complete line.
+ */
+ssize_t mux_reader_line(mux_reader *r, size_t *skip)
+{
+    unsigned char *p = MUX_BUF_PTR(&r->raw);
+    size_t len = MUX_BUF_LEN(&r->raw), i, j;
+
+    for ( i = 0 ; i < len ; i++ ) {
+	if ( p[i] == '\n' || p[i] == '\r' )
+	    break;
+    }
+    if ( i >= len )
+	return -1;
+    for ( j = i ; j < len && (p[j] == '\n' || p[j] == '\r') ; j++ )
+	;
+    *skip = j;
+    return i;
+}
+
+/*
+ * Decode the next file delta event from the data buffer b.  rsync
+ * sends a 32 bit token for each piece of the file: 0 ends the file
+ * and is followed by its MD4 digest, -(n+1) means block n matched,
+ * and any other value is the length of the literal data that follows.
+ *
+ * Consecutive matching blocks are returned as one MUX_DELTA_RUN, and
+ * literal data as MUX_DELTA_DATA pieces of at least MUX_DELTA_LIT_LEN
+ * bytes (or the rest of the token).  For MUX_DELTA_DATA and
+ * MUX_DELTA_DONE the caller takes ev->len bytes from the front of b.
+ * MUX_DELTA_NEED means at least ev->len more bytes are needed.
+ */
+int mux_delta_next(mux_delta *d, mux_buf *b, mux_delta_event *ev)
+{
+    for ( ;; ) {
+	unsigned char *p = MUX_BUF_PTR(b);
+	size_t avail = MUX_BUF_LEN(b);
+	unsigned long token;
+
+	if ( d->litLeft > 0 ) {
+	    size_t want = d->litLeft < MUX_DELTA_LIT_LEN
+				? d->litLeft : MUX_DELTA_LIT_LEN;
+
+	    if ( avail < want ) {
+		ev->len = want - avail;
+		return MUX_DELTA_NEED;
+	    }
+	    ev->len = avail < d->litLeft ? avail : d->litLeft;
+	    d->litLeft -= ev->len;
+	    return MUX_DELTA_DATA;
+	}
+	if ( avail < 4 ) {
+	    ev->len = 4 - avail;
+	    return MUX_DELTA_NEED;
+	}
+	token = p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned long)p[3] << 24);
+	if ( token > 0x80000000UL ) {
+	    unsigned long blk = 0xffffffffUL - token;
+
+	    if ( d->runCnt == 0 ) {
+		d->runStart = blk;
+	    } else if ( blk != d->runStart + d->runCnt ) {
+		break;
+	    }
+	    d->runCnt++;
+	    mux_buf_skip(b, 4);
+	    continue;
+	}
+	if ( d->runCnt > 0 )
+	    break;
+	if ( token == 0 ) {
+	    if ( avail < 4 + 16 ) {
+		ev->len = 4 + 16 - avail;
+		return MUX_DELTA_NEED;
+	    }
+	    mux_buf_skip(b, 4);
+	    ev->len = 16;
+	    return MUX_DELTA_DONE;
+	}
+	d->litLeft = token;
+	mux_buf_skip(b, 4);
+    }
+    /*
+     * The run ended; the token after it is left in the buffer.
+     */
+    ev->start = d->runStart;
+    ev->cnt   = d->runCnt;
+    d->runCnt = 0;
+    return MUX_DELTA_RUN;
+}
+
+mux_writer *mux_writer_new(int fd, mux_release_func release)
+{
+    mux_writer *w;
+
+    if ( !(w = calloc(1, sizeof(*w))) )
+	return NULL;
+    w->fd      = fd;
+    w->release = release;
+    return w;
+}
+
+static void mux_seg_release(mux_writer *w, mux_seg *seg)
+{
+    if ( seg->owner ) {
+	if ( w->release )
+	    (*w->release)(seg->owner);
+    } else {
+	free(seg->data);
+    }
+}
+
+void mux_writer_free(mux_writer *w)
+{
+    size_t i;
+
+    if ( !w )
+	return;
+    for ( i = w->segStart ; i < w->segEnd ; i++ )
+	mux_seg_release(w, &w->seg[i]);
+    free(w->seg);
+    free(w);
+}
+
+/*
+ * Make room for one more piece at the end of the queue.
+ */
+static mux_seg *mux_writer_seg_new(mux_writer *w)
+{
+    if ( w->segEnd >= w->segSize ) {
+	size_t used = w->segEnd - w->segStart;
+
+	if ( w->segStart > 0 && used < w->segSize / 2 ) {
+	    memmove(w->seg, w->seg + w->segStart, used * sizeof(mux_seg));
+	} else {
+	    size_t size = w->segSize ? 2 * w->segSize : 64;
+	    mux_seg *seg = malloc(size * sizeof(mux_seg));
+
+	    if ( !seg )
+		return NULL;
+	    if ( used )
+		memcpy(seg, w->seg + w->segStart, used * sizeof(mux_seg));
+	    free(w->seg);
+	    w->seg     = seg;
+	    w->segSize = size;
+	}
+	w->segStart = 0;
+	w->segEnd   = used;
+    }
+    memset(&w->seg[w->segEnd], 0, sizeof(mux_seg));
+    return &w->seg[w->segEnd++];
+}
+
+/*
+ * Queue len bytes of data.  If owner is not NULL and the data is
+ * at least MUX_COPY_LEN bytes it is written in place, and the
+ * writer's release function is called with owner once it has been
+ * written.  Otherwise the data is copied and owner is released
+ * straight away.  Returns -1 if out of memory.
+ */
+int mux_writer_add(mux_writer *w, unsigned char *data, size_t len,
+		void *owner)
+{
+    mux_seg *seg;
+
+    if ( owner && len >= MUX_COPY_LEN ) {
+	if ( !(seg = mux_writer_seg_new(w)) ) {
+	    if ( w->release )
+		(*w->release)(owner);
+	    return -1;
+	}
+	seg->data  = data;
+	seg->len   = len;
+	seg->owner = owner;
+	w->len    += len;
+	return 0;
+    }
+    while ( len > 0 ) {
+	size_t n;
+
+	seg = w->segEnd > w->segStart ? &w->seg[w->segEnd - 1] : NULL;
+	if ( !seg || seg->owner || seg->len >= seg->cap ) {
+	    size_t cap = len > MUX_CHUNK_LEN ? len : MUX_CHUNK_LEN;
+
+	    if ( !(seg = mux_writer_seg_new(w)) || !(seg->data = malloc(cap)) ) {
+		if ( seg )
+		    w->segEnd--;
+		if ( owner && w->release )
+		    (*w->release)(owner);
+		return -1;
+	    }
+	    seg->cap = cap;
+	}
+	n = seg->cap - seg->len;
+	if ( n > len )
+	    n = len;
+	memcpy(seg->data + seg->len, data, n);
+	seg->len += n;
+	w->len   += n;
+	data     += n;
+	len      -= n;
+    }
+    if ( owner && w->release )
+	(*w->release)(owner);
+    return 0;
+}
+
+/*
+ * Queue a mux message header for a message with the given code
+ * and payload length.
+ */
+int mux_writer_header(mux_writer *w, int code, size_t len)
+{
+    unsigned long hdr = ((unsigned long)(MUX_BASE + code) << 24)
+		      | (len & MUX_MAX_LEN);
+    unsigned char buf[4];
+
+    buf[0] = hdr & 0xff;
+    buf[1] = (hdr >> 8) & 0xff;
+    buf[2] = (hdr >> 16) & 0xff;
+    buf[3] = (hdr >> 24) & 0xff;
+    return mux_writer_add(w, buf, 4, NULL);
+}
+
+/*
+ * Write as much of the queue as the fd will take with one writev().
+ * Returns the number of bytes written, 0 if the fd is non-blocking
+ * and not ready, or -1 on error (with errno set).
+ */
+ssize_t mux_writer_flush(mux_writer *w)
+{
+    struct iovec iov[MUX_IOV_MAX];
+    size_t i, cnt = 0;
+    ssize_t n, done;
+
+    for ( i = w->segStart ; i < w->segEnd && cnt < MUX_IOV_MAX ; i++ ) {
+	size_t off = i == w->segStart ? w->off : 0;
+
+	iov[cnt].iov_base = w->seg[i].data + off;
+	iov[cnt].iov_len  = w->seg[i].len - off;
+	cnt++;
+    }
+    if ( cnt == 0 )
+	return 0;
+    n = writev(w->fd, iov, cnt);
+    if ( n < 0 )
+	return errno == EAGAIN || errno == EWOULDBLOCK ? 0 : -1;
+    w->len -= n;
+    for ( done = n ; done > 0 && w->segStart < w->segEnd ; ) {
+	mux_seg *seg = &w->seg[w->segStart];
+	size_t left = seg->len - w->off;
+
+	if ( (size_t)done < left ) {
+	    w->off += done;
+	    break;
+	}
+	done -= left;
+	w->off = 0;
+	mux_seg_release(w, seg);
+	w->segStart++;
+    }
+    if ( w->segStart == w->segEnd )
+	w->segStart = w->segEnd = 0;
+    return n;
+}
@@ -0,0 +1,120 @@
+/*
+ * Rsync multiplexed stream IO for File::RsyncP.
+ *
+ * Once multiplexing starts, rsync sends everything as messages with
+ * a 4 byte little-endian header: the top 8 bits are the message tag
+ * (MUX_BASE + code) and the low 24 bits are the payload length.
+ * Code 0 is file data; the others are log messages.
+ */
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#define MUX_BASE	7		/* rsync's MPLEX_BASE */
+#define MUX_MAX_LEN	0xffffff	/* maximum message payload */
+#define MUX_READ_LEN	(64 * 1024)	/* bytes read per mux_reader_fill() */
+
+/*
+ * A byte buffer; the bytes in [start, end) are valid.  Space is
+ * reclaimed by moving the valid bytes to the front when needed,
+ * so each byte is moved at most once per buffer.
+ */
+typedef struct {
+    unsigned char *buf;
+    size_t start;
+    size_t end;
+    size_t size;
+} mux_buf;
+
+#define MUX_BUF_LEN(b)	((b)->end - (b)->start)
+#define MUX_BUF_PTR(b)	((b)->buf + (b)->start)
+
+/*
+ * Decoder state for the file delta tokens of one file: a run of
+ * consecutive matching blocks not yet returned, and the bytes left
+ * in the current literal token.
+ */
+typedef struct {
+    unsigned long runStart;
+    unsigned long runCnt;
+    size_t litLeft;
+} mux_delta;
+
+#define MUX_DELTA_NEED	0		/* need more data */
+#define MUX_DELTA_RUN	1		/* blocks [start, start + cnt) */
+#define MUX_DELTA_DATA	2		/* literal data */
+#define MUX_DELTA_DONE	3		/* end of file; data is the MD4 */
+#define MUX_DELTA_LIT_LEN (32 * 1024)	/* min literal piece returned */
+
+typedef struct {
+    unsigned long start;	/* MUX_DELTA_RUN */
+    unsigned long cnt;
+    size_t len;			/* MUX_DELTA_DATA, DONE: bytes at the */
+				/* front of the data buffer; */
+				/* MUX_DELTA_NEED: more bytes needed */
+} mux_delta_event;
+
+typedef struct {
+    int fd;
+    mux_buf raw;		/* bytes read, not yet demultiplexed */
+    mux_buf data;		/* demultiplexed file data */
+    unsigned char *last;	/* start of the last read, for logging */
+    size_t lastLen;
+    mux_delta delta;		/* file delta decoder */
+} mux_reader;
+
+/*
+ * A piece of output queued in a mux_writer.  Small pieces are copied
+ * into chunks of MUX_CHUNK_LEN bytes owned by the writer (owner is
+ * NULL); larger ones are referenced in place, and release() is called
+ * with owner once they are written.
+ */
+typedef struct {
+    unsigned char *data;
+    size_t len;
+    size_t cap;			/* room in a writer-owned chunk */
+    void *owner;
+} mux_seg;
+
+#define MUX_CHUNK_LEN	(32 * 1024)	/* writer-owned chunk size */
+#define MUX_COPY_LEN	4096		/* smaller pieces are copied */
+#define MUX_IOV_MAX	64		/* pieces per writev() */
+
+typedef void (*mux_release_func)(void *owner);
+
+typedef struct {
+    int fd;
+    mux_seg *seg;		/* queued pieces are [segStart, segEnd) */
+    size_t segStart;
+    size_t segEnd;
+    size_t segSize;
+    size_t off;			/* bytes of seg[segStart] already written */
+    size_t len;			/* total bytes queued */
+    mux_release_func release;
+} mux_writer;
+
+/*
+ * Called by mux_reader_demux() for each non-data message.
+ * A non-zero return stops the demux.
+ */
+typedef int (*mux_msg_func)(void *arg, int code, unsigned char *msg,
+			    size_t len);
+
+int mux_buf_reserve(mux_buf *b, size_t len);
+void mux_buf_skip(mux_buf *b, size_t len);
+void mux_buf_free(mux_buf *b);
+
+mux_reader *mux_reader_new(int fd);
+void mux_reader_free(mux_reader *r);
+ssize_t mux_reader_fill(mux_reader *r);
+int mux_reader_demux(mux_reader *r, size_t need, mux_msg_func msg,
+		void *arg);
+ssize_t mux_reader_line(mux_reader *r, size_t *skip);
+int mux_delta_next(mux_delta *d, mux_buf *b, mux_delta_event *ev);
+
+mux_writer *mux_writer_new(int fd, mux_release_func release);
+void mux_writer_free(mux_writer *w);
+int mux_writer_add(mux_writer *w, unsigned char *data, size_t len,
+		void *owner);
+int mux_writer_header(mux_writer *w, int code, size_t len);
+ssize_t mux_writer_flush(mux_writer *w);
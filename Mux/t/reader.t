@@ -0,0 +1,128 @@
+#!/bin/perl
+
+BEGIN {print "1..6\n";}
+END {print "not ok 1\n" unless $loaded;}
+use File::RsyncP::Mux;
+$loaded = 1;
+print "ok 1\n";
+
+#
+# Return an rsync multiplexed message
+#
+sub mux
+{
+    my($code, $data) = @_;
+    return pack("V", ((7 + $code) << 24) | length($data)) . $data;
+}
+
+sub readAll
+{
+    my($reader) = @_;
+    while ( $reader->fill() > 0 ) { }
+}
+
+#
+# Raw lines and data before multiplexing starts
+#
+my @msgs;
+my $tmpFile = "reader.tmp";
+open(WR, ">", $tmpFile) || die;
+binmode(WR);
+print(WR "\@RSYNCD: 28\r\n\nabc\n" . pack("V", 28)
+           . mux(0, "hello ") . mux(1, "an error\n") . mux(0, "world")
+           . mux(0, pack("V3", 1, 2, 0xfffffffe)) . mux(2, "info")
+           . mux(0, "x" x 100000));
+close(WR);
+open(RD, "<", $tmpFile) || die;
+my $reader = File::RsyncP::Mux::Reader->new(fileno(RD),
+                    sub { push(@msgs, "$_[0]:$_[1]"); });
+readAll($reader);
+close(RD);
+unlink($tmpFile);
+
+print $reader->rawLine() eq "\@RSYNCD: 28"
+      && $reader->rawLine() eq "abc"
+      && $reader->rawGet(4) eq pack("V", 28)
+      && !defined($reader->rawGet(1 << 20))
+      ? "ok 2\n" : "not ok 2\n";
+
+#
+# Demux only as much as needed, with messages going to the callback
+#
+my $failed = 0;
+$failed++ if ( $reader->demux(3) != 6 || @msgs );
+$failed++ if ( $reader->dataGet(3) ne "hel" );
+$failed++ if ( $reader->demux(5) != 8 || "@msgs" ne "1:an error\n" );
+$failed++ if ( $reader->dataPeek() ne "lo world" );
+$reader->dataSkip(3);
+$failed++ if ( $reader->dataGet(5) ne "world" || $reader->dataLen != 0 );
+print $failed ? "not ok 3\n" : "ok 3\n";
+
+$failed = 0;
+$failed++ if ( $reader->dataInt(1) );
+$reader->demux(12);
+$failed++ if ( join(",", $reader->dataInt(3)) ne "1,2,4294967294" );
+$failed++ if ( $reader->demux(100001) != 100000 || @msgs != 2 );
+$failed++ if ( $reader->dataGet(100000) ne "x" x 100000 );
+$failed++ if ( $reader->rawLen != 0 );
+print $failed ? "not ok 4\n" : "ok 4\n";
+
+#
+# Data trickling in one byte at a time
+#
+pipe(RD, WR) || die;
+$reader = File::RsyncP::Mux::Reader->new(fileno(RD));
+my $stream = join("", map { mux(0, "data$_") . mux(3, "msg") } (1..50));
+my $got = "";
+$failed = 0;
+for ( my $i = 0 ; $i < length($stream) ; $i++ ) {
+    syswrite(WR, substr($stream, $i, 1));
+    $failed++ if ( $reader->fill() != 1 );
+    $reader->demux(1000);
+    $got .= $reader->dataGet($reader->dataLen);
+}
+$failed++ if ( $got ne join("", map { "data$_" } (1..50)) );
+close(WR);
+$failed++ if ( $reader->fill() != 0 );
+$reader->fd(-1);
+$failed++ if ( $reader->fill() >= 0 );
+close(RD);
+print $failed ? "not ok 5\n" : "ok 5\n";
+
+#
+# File delta tokens are decoded into runs of blocks, literal data and
+# the final digest, whether the data arrives all at once or a byte at
+# a time.
+#
+my $lit = join("", map { chr($_ & 0xff) } (1..40000));
+my @tokens = ((map { 0xffffffff - $_ } (0..3)), 3, "abc", 0xffffffff - 7,
+              0xffffffff - 9, 0xffffffff - 10, 40000, $lit, 0, "m" x 16);
+$stream = join("", map { /^\d+$/ ? pack("V", $_) : $_ } @tokens);
+my $expect = "run 0 4|data abc|run 7 1|run 9 2|data $lit|done " . "m" x 16;
+$failed = 0;
+foreach my $step ( length($stream), 1 ) {
+    pipe(RD, WR) || die;
+    $reader = File::RsyncP::Mux::Reader->new(fileno(RD));
+    my($off, @events) = (0);
+    while ( 1 ) {
+        my($type, @args) = $reader->deltaNext;
+        if ( $type eq "need" ) {
+            last if ( $off >= length($stream) );
+            syswrite(WR, mux(0, substr($stream, $off, $step)));
+            $off += $step;
+            $reader->fill();
+            $reader->demux(1 << 20);
+            next;
+        }
+        if ( $type eq "data" && @events && $events[-1] =~ /^data / ) {
+            $events[-1] .= $args[0];
+        } else {
+            push(@events, join(" ", $type, @args));
+        }
+        last if ( $type eq "done" );
+    }
+    $failed++ if ( join("|", @events) ne $expect || $reader->dataLen );
+    close(WR);
+    close(RD);
+}
+print $failed ? "not ok 6\n" : "ok 6\n";
@@ -0,0 +1,85 @@
+#!/bin/perl
+
+BEGIN {print "1..4\n";}
+END {print "not ok 1\n" unless $loaded;}
+use File::RsyncP::Mux;
+use Socket;
+use Fcntl;
+$loaded = 1;
+print "ok 1\n";
+
+#
+# Return an rsync multiplexed message
+#
+sub mux
+{
+    my($code, $data) = @_;
+    return pack("V", ((7 + $code) << 24) | length($data)) . $data;
+}
+
+#
+# Raw and multiplexed data of various sizes written to a file
+#
+my $tmpFile = "writer.tmp";
+my $big = join("", map { chr($_ % 251) } (1..200000));
+my $failed = 0;
+open(WR, ">", $tmpFile) || die;
+binmode(WR);
+my $writer = File::RsyncP::Mux::Writer->new(fileno(WR));
+my $expect = "";
+foreach my $len ( 0, 1, 4, 4095, 4096, 70000, 200000 ) {
+    my $d = substr($big, 0, $len);
+    $writer->add($d, pack("V", $len));
+    $writer->addMsg(1, $d);
+    $expect .= $d . pack("V", $len) . mux(1, $d);
+}
+$writer->add(map { pack("V", $_) } (1..1000));
+$expect .= pack("V*", 1..1000);
+$failed++ if ( $writer->len != length($expect) );
+while ( $writer->len ) {
+    if ( $writer->flush <= 0 ) {
+        $failed++;
+        last;
+    }
+}
+close(WR);
+open(RD, "<", $tmpFile) || die;
+binmode(RD);
+my $got = join("", <RD>);
+close(RD);
+unlink($tmpFile);
+print $failed || $got ne $expect ? "not ok 2\n" : "ok 2\n";
+
+#
+# Queued data isn't affected by later changes to the strings
+#
+$failed = 0;
+socketpair(S0, S1, AF_UNIX, SOCK_STREAM, PF_UNSPEC) || die;
+$writer = File::RsyncP::Mux::Writer->new(fileno(S0));
+my $d = "x" x 10000;
+$writer->add($d);
+substr($d, 0, 1) = "y";
+$writer->add($d);
+$d = "z" x 10000;
+$writer->flush while ( $writer->len );
+$got = "";
+sysread(S1, $got, 20000 - length($got), length($got)) while ( length($got) < 20000 );
+print $got eq ("x" x 10000) . "y" . ("x" x 9999) ? "ok 3\n" : "not ok 3\n";
+
+#
+# On a non-blocking fd flush returns 0 once the socket is full and
+# the rest is written as the other end reads.
+#
+$failed = 0;
+fcntl(S0, F_SETFL, fcntl(S0, F_GETFL, 0) | O_NONBLOCK);
+$writer->add($big) for ( 1..20 );
+my($n, $zero) = (0, 0);
+while ( ($n = $writer->flush) > 0 ) { }
+$failed++ if ( $n != 0 || !$writer->len );
+$got = "";
+while ( length($got) < 20 * length($big) ) {
+    sysread(S1, $got, 65536, length($got)) || last;
+    $failed++ if ( $writer->flush < 0 );
+}
+$failed++ if ( $writer->len || $got ne $big x 20 );
+print $failed ? "not ok 4\n" : "ok 4\n";
@@ -0,0 +1,2581 @@
+#============================================================= -*-perl-*-
+#
+# File::RsyncP package
+#
+# DESCRIPTION
+#   File::RsyncP is a perl module that implements a subset of the
+#   Rsync protocol, sufficient for implementing a client that can
+#   talk to a native rsync server or rsyncd daemon.
+#
+# AUTHOR
+#   Craig Barratt  <cbarratt@users.sourceforge.net>
+#
+# COPYRIGHT
+#   File::RsyncP is Copyright (C) 2002-2010  Craig Barratt.
+#
+#   Rsync is Copyright (C) 1996-2001 by Andrew Tridgell, 1996 by Paul
+#   Mackerras, 2001-2002 by Martin Pool, and 2003-2009 by Wayne Davison,
+#   and others.
+#
+#   This program is free software; you can redistribute it and/or modify
+#   it under the terms of the GNU General Public License as published by
+#   the Free Software Foundation; either version 2 of the License, or
+#   (at your option) any later version.
+#
+#   This program is distributed in the hope that it will be useful,
+#   but WITHOUT ANY WARRANTY; without even the implied warranty of
+#   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#   GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public License
+#   along with this program; if not, write to the Free Software
+#   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+#========================================================================
+#
+# Version 0.70, released 25 Jul 2010.
+#
+# See http://perlrsync.sourceforge.net.
+#
+#========================================================================
+
+package File::RsyncP;
+
+use strict;
+use Socket;
+use File::RsyncP::Digest;
+use File::RsyncP::FileIO;
+use File::RsyncP::FileList;
+use File::RsyncP::Mux;
+use Scalar::Util qw(weaken);
+use Storable qw(nfreeze thaw);
+use Getopt::Long;
+use Config;
+use Encode qw/from_to/;
+use Fcntl;
+
+use vars qw($VERSION);
+$VERSION = '0.70';
+
+use constant S_IFMT       => 0170000;	# type of file
+use constant S_IFDIR      => 0040000; 	# directory
+use constant S_IFCHR      => 0020000; 	# character special
+use constant S_IFBLK      => 0060000; 	# block special
+use constant S_IFREG      => 0100000; 	# regular
+use constant S_IFLNK      => 0120000; 	# symbolic link
+use constant S_IFSOCK     => 0140000; 	# socket
+use constant S_IFIFO      => 0010000; 	# fifo
+
+#
+# Message codes from the child to the parent, sent with the rsync
+# multiplexing header (see File::RsyncP::Mux)
+#
+use constant CHILD_DONE   => 1;		# end of phase 0
+use constant CHILD_REDO   => 2;		# packed file numbers to redo
+use constant CHILD_STATS  => 3;		# final stats
+use constant CHILD_LOG    => 4;		# log message
+use constant CHILD_EXIT   => 5;		# child has finished
+
+#
+# Message from the parent to the child (with exactMatchDigest "parent")
+#
+use constant PARENT_DIGEST => 1;	# phase, file number and MD4 digest
+
+sub new
+{
+    my($class, $options) = @_;
+
+    $options ||= {};
+    my $rs = bless {
+        protocol_version => 28,
+	logHandler       => \&logHandler,
+	abort		 => 0,
+	csumPrefetch     => 8,
+	%$options,
+    }, $class;
+
+    #
+    # In recent versions of rsync (eg: 2.6.8) --devices is no
+    # longer identical to -D.  Now -D means --devices --specials.
+    # File::RsyncP assumes --devices behaves the same as -D,
+    # and doesn't currently handle --specials.
+    #
+    # To make sure we don't lie to the remote rsync, we must
+    # send -D instead of --devices.  Therefore, we manually
+    # replace --devices with -D in $rs->{rsyncArgs}.
+    #
+    for ( my $i = 0 ; $i < @{$rs->{rsyncArgs}} ; $i++ ) {
+        $rs->{rsyncArgs}[$i] = "-D"
+                    if ( $rs->{rsyncArgs}[$i] eq "--devices" );
+    }
+
+    #
+    # process rsync options
+    #
+    local(@ARGV);
+    $rs->{rsyncOpts} = {};
+    @ARGV = @{$rs->{rsyncArgs}};
+
+    my $p = new Getopt::Long::Parser(
+		config => ["bundling", "pass_through"],
+	    );
+
+    #
+    # First extract all the exclude related options for processing later
+    #
+    return if ( !$p->getoptions(
+                "exclude=s",       sub { optExclude($rs, @_); },
+                "exclude-from=s",  sub { optExclude($rs, @_); },
+                "include=s",       sub { optExclude($rs, @_); },
+                "include-from=s",  sub { optExclude($rs, @_); },
+                "cvs-exclude|C",   sub { optExclude($rs, @_); },
+	    ) );
+
+    #
+    # Since the exclude arguments are no longer needed (they are
+    # passed via the socket, not the command-line args), update
+    # $rs->{rsyncOpts}
+    #
+    @{$rs->{rsyncArgs}} = @ARGV;
+
+    #
+    # Now process the rest of the arguments we care about
+    #
+    return if ( !$p->getoptions($rs->{rsyncOpts},
+		    "block-size=i",
+		    "devices|D",
+                    "from0|0",
+		    "group|g",
+		    "hard-links|H",
+		    "ignore-times|I",
+		    "inplace",
+		    "links|l",
+		    "numeric-ids",
+		    "owner|o",
+		    "perms|p",
+		    "protocol=i",
+		    "recursive|r",
+		    "relative|R",
+		    "timeout",
+		    "verbose|v+",
+	    ) );
+    $rs->{blockSize}          = $rs->{rsyncOpts}{"block-size"};
+    $rs->{timeout}          ||= $rs->{rsyncOpts}{timeout};
+    $rs->{protocol_version}   = $rs->{rsyncOpts}{protocol}
+		    if ( defined($rs->{rsyncOpts}{protocol}) );
+    $rs->{fio_version} = 1;
+    if ( !defined($rs->{fio}) ) {
+	$rs->{fio} = File::RsyncP::FileIO->new({
+			blockSize           => $rs->{blockSize},
+			logLevel            => $rs->{logLevel},
+                        protocol_version    => $rs->{protocol_version},
+                        preserve_hard_links => $rs->{rsyncOpts}{"hard-links"},
+			inplace             => $rs->{rsyncOpts}{inplace},
+			clientCharset       => $rs->{clientCharset},
+		    });
+	eval { $rs->{fio_version} = $rs->{fio}->version; };
+    } else {
+        #
+        # Tell the existing FileIO module various parameters that
+        # depend upon the parsed rsync args
+        #
+	eval { $rs->{fio_version} = $rs->{fio}->version; };
+	$rs->{fio}->blockSize($rs->{blockSize});
+	if ( $rs->{fio_version} >= 2 ) {
+	    $rs->{fio}->protocol_version($rs->{protocol_version});
+	    $rs->{fio}->preserve_hard_links($rs->{rsyncOpts}{"hard-links"});
+	    $rs->{fio}->inplace($rs->{rsyncOpts}{inplace})
+			if ( $rs->{fio}->can("inplace") );
+	} else {
+	    #
+	    # old version of FileIO: only supports version 26
+	    #
+	    $rs->{protocol_version} = 26 if ( $rs->{protocol_version} > 26 );
+	}
+    }
+
+    #
+    # build signal list in case we do an abort
+    #
+    my $i = 0;
+    foreach my $name ( split(' ', $Config{sig_name}) ) {
+	$rs->{sigName2Num}{$name} = $i;
+	$i++;
+    }
+    return $rs;
+}
+
+sub optExclude
+{
+    my($rs, $argName, $argValue) = @_;
+
+    push(@{$rs->{excludeArgs}}, {name => $argName, value => $argValue});
+}
+
+#
+# Strip the exclude and include arguments from the given argument list
+#
+sub excludeStrip
+{
+    my($rs, $args) = @_;
+    local(@ARGV);
+    my $p = new Getopt::Long::Parser(
+		config => ["bundling", "pass_through"],
+	    );
+
+    @ARGV = @$args;
+
+    #
+    # Extract all the exclude related options
+    #
+    $p->getoptions(
+            "exclude=s",       sub { },
+            "exclude-from=s",  sub { },
+            "include=s",       sub { },
+            "include-from=s",  sub { },
+            "cvs-exclude|C",   sub { },
+        );
+
+    return \@ARGV;
+}
+
+sub serverConnect
+{
+    my($rs, $host, $port) = @_;
+    #local(*FH);
+
+    $port ||= 873;
+    my $proto = getprotobyname('tcp');
+    my $iaddr = inet_aton($host)     || return "unknown host $host";
+    my $paddr = sockaddr_in($port, $iaddr);
+
+    alarm($rs->{timeout}) if ( $rs->{timeout} );
+    socket(FH, PF_INET, SOCK_STREAM, $proto)
+				    || return "inet socket: $!";
+    connect(FH, $paddr)             || return "inet connect: $!";
+    $rs->{fh} = *FH;
+    $rs->muxStart;
+    $rs->writeData("\@RSYNCD: $rs->{protocol_version}\n", 1);
+    my $line = $rs->getLine;
+    alarm(0) if ( $rs->{timeout} );
+    if ( $line !~ /\@RSYNCD:\s*(\d+)/ ) {
+	return "unexpected response $line\n";
+    }
+    $rs->{remote_protocol} = $1;
+    if ( $rs->{remote_protocol} < 20 || $rs->{remote_protocol} > 40 ) {
+        return "Bad protocol version: $rs->{remote_protocol}\n";
+    }
+    $rs->log("Connected to $host:$port, remote version $rs->{remote_protocol}")
+                        if ( $rs->{logLevel} >= 1 );
+    $rs->{protocol_version} = $rs->{remote_protocol}
+                        if ( $rs->{protocol_version} > $rs->{remote_protocol} );
+    $rs->{fio}->protocol_version($rs->{protocol_version})
+			if ( $rs->{fio_version} >= 2 );
+    $rs->log("Negotiated protocol version $rs->{protocol_version}")
+                        if ( $rs->{logLevel} >= 1 );
+    return;
+}
+
+sub serverList
+{
+    my($rs) = @_;
+    my(@service);
+
+    return "not connected" if ( !defined($rs->{fh}) );
+    $rs->writeData("#list\n", 1);
+    while ( 1 ) {
+        my $line = $rs->getLine;
+        $rs->log("Got `$line'") if ( $rs->{logLevel} >= 2 );
+        last if ( $line eq "\@RSYNCD: EXIT" );
+        push(@service, $line);
+    }
+    return @service;
+}
+
+sub serverService
+{
+    my($rs, $service, $user, $passwd, $authRequired) = @_;
+    my($line);
+
+    return "not connected" if ( !defined($rs->{fh}) );
+    $rs->writeData("$service\n", 1);
+    $line = $rs->getLine;
+    return $1 if ( $line =~ /\@ERROR: (.*)/ );
+    if ( $line =~ /\@RSYNCD: AUTHREQD (.{22})/ ) {
+	my $challenge = $1;
+	my $md4 = File::RsyncP::Digest->new($rs->{protocol_version});
+	$md4->add(pack("V", 0));
+	$md4->add($passwd);
+	$md4->add($challenge);
+	my $response = $md4->digest;
+	$rs->log("Got response: " . unpack("H*", $response))
+		    if ( $rs->{logLevel} >= 2 );
+	my $response1 = $rs->encode_base64($response);
+	$rs->log("in mime: " . $response1) if ( $rs->{logLevel} >= 5 );
+	$rs->writeData("$user $response1\n", 1);
+        $rs->log("Auth: got challenge: $challenge, reply: $user $response1")
+		    if ( $rs->{logLevel} >= 2 );
+        $line = $rs->getLine;
+    } elsif ( $authRequired ) {
+        return "auth required, but service $service is open/insecure";
+    }
+    return $1 if ( $line =~ /\@ERROR: (.*)/ );
+    if ( $line ne "\@RSYNCD: OK" ) {
+	return "unexpected response: '$line'";
+    }
+    $rs->log("Connected to module $service") if ( $rs->{logLevel} >= 1 );
+    return;
+}
+
+sub serverStart
+{
+    my($rs, $remoteSend, $remoteDir) = @_;
+
+    my @args = @{$rs->{rsyncArgs}};
+    unshift(@args, "--sender") if ( $remoteSend );
+    unshift(@args, "--server");
+    push(@args, ".", $remoteDir);
+    $rs->{remoteSend} = $remoteSend;
+    $rs->writeData(join("\n", @args) . "\n\n", 1);
+    $rs->log("Sending args: " . join(" ", @args)) if ( $rs->{logLevel} >= 1 );
+}
+
+sub encode_base64
+{
+    my($rs, $str) = @_;
+
+    my $s2 = pack('u', $str);
+    $s2 =~ tr|` -_|AA-Za-z0-9+/|;
+    return substr($s2, 1, int(1.0 - 1e-10 + length($str) * 8 / 6));
+}
+
+sub remoteStart
+{
+    my($rs, $remoteSend, $remoteDir) = @_;
+    local(*RSYNC);
+    my($pid, $cmd);
+
+    socketpair(RSYNC, FH, AF_UNIX, SOCK_STREAM, PF_UNSPEC)
+				      or die "socketpair: $!";
+    $rs->{remoteSend} = $remoteSend;
+    $rs->{remoteDir}  = $remoteDir;
+
+    $rs->{rsyncCmd} = [split(" ", $rs->{rsyncCmd})]
+		    if ( ref($rs->{rsyncCmd}) ne 'ARRAY'
+		      && ref($rs->{rsyncCmd}) ne 'CODE' );
+    if ( $rs->{rsyncCmdType} eq "full" || ref($rs->{rsyncCmd}) ne 'ARRAY' ) {
+        $cmd = $rs->{rsyncCmd};
+    } else {
+        $cmd = $rs->{rsyncArgs};
+        unshift(@$cmd, "--sender") if ( $remoteSend );
+        unshift(@$cmd, "--server");
+        if ( $rs->{rsyncCmdType} eq "shell" ) {
+            #
+            # Do shell escaping of rsync arguments
+            #
+            for ( my $i = 0 ; $i < @$cmd ; $i++ ) {
+                $cmd->[$i] = $rs->shellEscape($cmd->[$i]);
+            }
+            $remoteDir = $rs->shellEscape($remoteDir);
+        }
+        $cmd = [@{$rs->{rsyncCmd}}, @$cmd];
+	if ( $remoteSend ) {
+	    push(@$cmd, ".", $remoteDir);
+	} else {
+	    push(@$cmd, ".");
+	}
+    }
+    $rs->log("Running: " . join(" ", @$cmd))
+		    if ( ref($cmd) eq 'ARRAY' && $rs->{logLevel} >= 1 );
+    if ( !($pid = fork()) ) {
+	#
+	# The child execs rsync.
+	#
+	close(FH);
+	close(STDIN);
+	close(STDOUT);
+	close(STDERR);
+	open(STDIN, "<&RSYNC");
+	open(STDOUT, ">&RSYNC");
+	open(STDERR, ">&RSYNC");
+	if ( ref($cmd) eq 'CODE' ) {
+	    &$cmd();
+	} else {
+	    exec(@$cmd);
+	}
+	# not reached
+	# $rs->log("Failed to exec rsync command $cmd[0]");
+	# exit(0);
+    }
+    close(RSYNC);
+    $rs->{fh} = *FH;
+    $rs->muxStart;
+    $rs->{rsyncPID} = $pid;
+    $rs->{pidHandler}->($rs->{rsyncPID}, $rs->{childPID})
+			if ( defined($rs->{pidHandler}) );
+    #
+    # Write our version and get the remote version
+    #
+    $rs->writeData(pack("V", $rs->{protocol_version}), 1);
+    $rs->log("Rsync command pid is $pid") if ( $rs->{logLevel} >= 3 );
+    $rs->log("Fetching remote protocol") if ( $rs->{logLevel} >= 5 );
+    return -1 if ( $rs->getData(4) < 0 );
+    my $data = $rs->{reader}->rawGet(4);
+    my $version = unpack("V", $data);
+    $rs->{remote_protocol} = $version;
+    $rs->log("Got remote protocol $version") if ( $rs->{logLevel} >= 1 );
+    $rs->{protocol_version} = $rs->{remote_protocol}
+                    if ( $rs->{protocol_version} > $rs->{remote_protocol} );
+    $rs->{fio}->protocol_version($rs->{protocol_version})
+	    if ( $rs->{fio_version} >= 2 );
+    if ( $version < 20 || $version > 40 ) {
+        $rs->log("Fatal error (bad version): $data");
+        return -1;
+    }
+    $rs->log("Negotiated protocol version $rs->{protocol_version}")
+                    if ( $rs->{logLevel} >= 1 );
+    return;
+}
+
+sub serverClose
+{
+    my($rs) = @_;
+
+    return if ( !defined($rs->{fh}) );
+    close($rs->{fh});
+    $rs->{fh} = undef;
+    $rs->{reader}->fd(-1) if ( defined($rs->{reader}) );
+    $rs->{writer}->fd(-1) if ( defined($rs->{writer}) );
+}
+
+sub go
+{
+    my($rs, $localDir) = @_;
+
+    my $remoteDir = $rs->{remoteDir};
+    return $rs->{fatalErrorMsg} if ( $rs->getData(4) < 0 );
+    $rs->{checksumSeed} = unpack("V", $rs->{reader}->rawGet(4));
+    $rs->{fio}->checksumSeed($rs->{checksumSeed});
+    $rs->{fio}->dirs($localDir, $remoteDir);
+    $rs->log(sprintf("Got checksumSeed 0x%x", $rs->{checksumSeed}))
+		    if ( $rs->{logLevel} >= 2 );
+
+    if ( $rs->{remoteSend} ) {
+        #
+        # Get the file list from the remote sender
+        #
+        if ( $rs->fileListReceive() < 0 ) {
+	    $rs->log("fileListReceive() failed");
+	    return "fileListReceive failed";
+	}
+
+        #
+        # Sort and match inode data if hardlinks are enabled
+        #
+        if ( $rs->{rsyncOpts}{"hard-links"} ) {
+            $rs->{fileList}->init_hard_links();
+            ##my $cnt = $rs->{fileList}->count;
+            ##for ( my $n = 0 ; $n < $cnt ; $n++ ) {
+            ##  my $f = $rs->{fileList}->get($n);
+            ##  print Dumper($f);
+            ##}
+        }
+
+	if ( $rs->{logLevel} >= 2 ) {
+	    my $cnt = $rs->{fileList}->count;
+	    $rs->log("Got file list: $cnt entries");
+	}
+
+        #
+        # At this point the uid/gid list would be received,
+        # but with numeric-ids nothing is sent.  We currently
+        # only support the numeric-ids case.
+        #
+
+        #
+        # Skip a word: this is the io_error flag.
+        #
+	$rs->{reader}->dataSkip(4);
+
+	#
+	# If this is a partial, then check which files we are
+	# going to skip
+	#
+	$rs->partialFileListPopulate() if ( $rs->{doPartial} );
+
+	if ( $rs->{inProcess} ) {
+	    #
+	    # Generate the checksums and receive the file deltas in this
+	    # process, sharing the file list and FileIO object.  The
+	    # receiver runs whenever the generator would wait (see
+	    # receiverPoll).
+	    #
+	    # Like the child, the receiver's FileIO messages go to our log.
+	    #
+	    $rs->{fio}->logHandlerSet(sub { $rs->log($_[0]); });
+	    $rs->nonBlockSet($rs->{fh});
+	    $rs->{childDone} = 0;
+	    $rs->{rxPhase}   = 0;
+	    $rs->fileCsumSend(0);
+	    $rs->fileCsumSend(1);
+	    $rs->{fatalErrorMsg} = $rs->{abortReason}
+		    if ( $rs->{abort} && !defined($rs->{fatalErrorMsg}) );
+	    $rs->{fio}->finish(0);
+	    return $rs->{fatalErrorMsg} if ( defined($rs->{fatalErrorMsg}) );
+	    return;
+	}
+
+        #
+        # Dup the $rs->{fh} socket file handle into two pieces: read-only
+        # and write-only.  The child gets the read-only handle and
+        # we keep the write-only one.  We make the write-only handle
+        # non-blocking.
+        # 
+        my $pid;
+        local(*RH, *WH, *FHWr, *FHRd);
+
+	socketpair(RH, WH, AF_UNIX, SOCK_STREAM, PF_UNSPEC);
+	if ( $rs->{exactMatchDigest} ne "parent" ) {
+	    shutdown(RH, 1);
+	    shutdown(WH, 0);
+	}
+
+        open(FHWr, ">&$rs->{fh}");
+        open(FHRd, "<&$rs->{fh}");
+        close($rs->{fh});
+
+        if ( !($pid = fork()) ) {
+            #
+            # The child receives the file deltas in two passes.
+            # If a file needs to be repeated in phase 2 we send
+            # the file into the the parent via the pipe.
+	    #
+	    # Messages to the parent are queued in a File::RsyncP::Mux::Writer
+	    # and sent whenever we are about to wait for data.
+	    #
+	    # First the log handler for both us and fio has to forward
+	    # to the parent, so redefine them.
+	    #
+	    $rs->{childWriter} = File::RsyncP::Mux::Writer->new(fileno(WH));
+	    if ( $rs->{exactMatchDigest} eq "parent" ) {
+		$rs->{parentReader} = File::RsyncP::Mux::Reader->new(
+			fileno(WH), sub { $rs->parentMessage(@_); });
+	    }
+	    $rs->{logHandler} = sub { $rs->receiverEvent(*WH, "log", @_); };
+	    $rs->{fio}->logHandlerSet($rs->{logHandler});
+            close(RH);
+            close(FHWr);
+            $rs->{fh} = *FHRd;
+            $rs->{reader}->fd(fileno($rs->{fh}));
+            $rs->{writer}->fd(fileno($rs->{fh}));
+	    setsockopt($rs->{fh}, SOL_SOCKET, SO_RCVBUF, 8 * 65536);
+	    setsockopt(WH, SOL_SOCKET, SO_SNDBUF, 8 * 65536);
+            $rs->fileDeltaGet(*WH, 0);
+            $rs->log("Child is sending done")
+			    if ( $rs->{logLevel} >= 5 );
+            $rs->receiverEvent(*WH, "done");
+            $rs->fileDeltaGet(*WH, 1) if ( !$rs->{abort} );
+            #
+            # Get stats
+            #
+            $rs->statsGet(*WH);
+            #
+            # Final signoff
+            #
+            $rs->writeData(pack("V", 0xffffffff), 1);
+	    $rs->{fio}->finish(1);
+            $rs->log("Child is aborting") if ( $rs->{abort} );
+            $rs->receiverEvent(*WH, "exit");
+            exit(0);
+        }
+        close(WH);
+        close(FHRd);
+        $rs->{fh} = *FHWr;
+        $rs->{reader}->fd(-1);
+        $rs->{writer}->fd(fileno($rs->{fh}));
+	my $rsWeak = $rs;
+	weaken($rsWeak);
+	$rs->{childReader} = File::RsyncP::Mux::Reader->new(fileno(RH),
+			    sub { $rsWeak->childMessage(@_) if ( $rsWeak ); });
+
+	#
+	# Make our write handle non-blocking
+	#
+	$rs->nonBlockSet($rs->{fh});
+
+	$rs->{childFh}  = *RH;
+	$rs->{childPID} = $pid;
+	if ( $rs->{exactMatchDigest} eq "parent" ) {
+	    #
+	    # We send file digests to the child, without blocking
+	    #
+	    $rs->{childDigestWriter} = File::RsyncP::Mux::Writer->new(fileno(RH));
+	    my $flags = fcntl(RH, F_GETFL, 0);
+	    fcntl(RH, F_SETFL, $flags | O_NONBLOCK) if ( defined($flags) );
+	}
+	$rs->log("Child PID is $pid") if ( $rs->{logLevel} >= 2 );
+	$rs->{pidHandler}->($rs->{rsyncPID}, $rs->{childPID})
+			    if ( defined($rs->{pidHandler}) );
+	setsockopt($rs->{fh}, SOL_SOCKET, SO_SNDBUF, 8 * 65536);
+	setsockopt($rs->{childFh}, SOL_SOCKET, SO_RCVBUF, 8 * 65536);
+        #
+        # The parent generates the file checksums and waits for
+        # the child to finish.  The child tells us if any files
+        # need to be repeated for phase 2.
+        #
+        # Phase 1: csum length is 2 (or >= 2 for protocol_version >= 27)
+        #
+        $rs->fileCsumSend(0);
+
+        #
+        # Phase 2: csum length is 16
+        #
+        $rs->fileCsumSend(1);
+
+	if ( $rs->{abort} ) {
+	    #
+	    # If we are aborting, give the child a few seconds
+	    # to finish up.
+	    #
+	    for ( my $i = 0 ; $i < 10 ; $i++ ) {
+		last if ( $rs->{childDone} >= 3 || $rs->pollChild(1) < 0 );
+	    }
+	    $rs->{fatalErrorMsg} = $rs->{abortReason}
+			    if ( !defined($rs->{fatalErrorMsg}) );
+	}
+	
+	#
+	# Done
+	#
+	$rs->{fio}->finish(0);
+        close(RH);
+        return $rs->{fatalErrorMsg} if ( defined($rs->{fatalErrorMsg}) );
+        return;
+    } else {
+        #syswrite($rs->{fh}, pack("V", time));
+        #
+        # Send the file list to the remote server
+        #
+        $rs->fileListSend();
+        return $rs->{fatalErrorMsg} if ( $rs->{fatalError} );
+
+        #
+        # Phase 1: csum length is 2
+        #
+        $rs->fileCsumReceive(0);
+        return $rs->{fatalErrorMsg} if ( $rs->{fatalError} );
+
+        #
+        # Phase 2: csum length is 3
+        #
+        $rs->fileCsumReceive(1);
+        return $rs->{fatalErrorMsg} if ( $rs->{fatalError} );
+
+	#
+	# Get final int handshake, and wait for EOF
+	#
+	$rs->getData(4);
+	return -1 if ( $rs->{abort} );
+        sysread($rs->{fh}, my $data, 1);
+
+        return;
+    }
+}
+
+sub nonBlockSet
+{
+    my($rs, $fh) = @_;
+
+    my $flags = '';
+    if ( fcntl($fh, F_GETFL, $flags) ) {
+	$flags |= O_NONBLOCK;
+	if ( !fcntl($fh, F_SETFL, $flags) ) {
+	    $rs->log("Parent fcntl(F_SETFL) failed; non-block set failed");
+	}
+    } else {
+	$rs->log("Parent fcntl(F_GETFL) failed; non-block failed");
+    }
+}
+
+#
+# When a partial rsync is done (meaning selective per-file ignore-attr)
+# we pass through the file list and remember which files we should
+# skip.  This allows the child to callback the user on each skipped
+# file.
+#
+sub partialFileListPopulate
+{
+    my($rs) = @_;
+    my $cnt = $rs->{fileList}->count;
+    for ( my $n = 0 ; $n < $cnt ; $n++ ) {
+	my $f = $rs->{fileList}->get($n);
+	next if ( !defined($f) );
+        from_to($f->{name}, $rs->{clientCharset}, "utf8")
+                                if ( $rs->{clientCharset} ne "" );
+	my $attr = $rs->{fio}->attribGet($f);
+	my $thisIgnoreAttr = $rs->{fio}->ignoreAttrOnFile($f);
+
+	#
+	# check if we should skip this file: same type, size, mtime etc
+	#
+	if ( !$thisIgnoreAttr
+	      && $f->{size}  == $attr->{size}
+	      && $f->{mtime} == $attr->{mtime}
+	      && (!$rs->{rsyncOpts}{perms} || $f->{mode} == $attr->{mode})
+	      && (!$rs->{rsyncOpts}{group} || $f->{gid} == $attr->{gid})
+	      && (!$rs->{rsyncOpts}{owner} || $f->{uid} == $attr->{uid})
+	      && (!$rs->{rsyncOpts}{"hard-links"}
+                        || $f->{hlink_self} == $attr->{hlink_self}) ) {
+	    $rs->{fileList}->flagSet($n, 1);
+	}
+    }
+}
+
+sub fileListReceive
+{
+    my($rs) = @_;
+    my($flags, $l1, $l2, $namel1, $name, $length, $mode, $mtime,
+	$uid, $gid, $rdev);
+    my($data, $flData);
+
+    $rs->{fileList} = File::RsyncP::FileList->new({
+        preserve_uid        => $rs->{rsyncOpts}{owner},
+        preserve_gid        => $rs->{rsyncOpts}{group},
+        preserve_links      => $rs->{rsyncOpts}{links},
+        preserve_devices    => $rs->{rsyncOpts}{devices},
+        preserve_hard_links => $rs->{rsyncOpts}{"hard-links"},
+        always_checksum     => $rs->{rsyncOpts}{checksum},
+        protocol_version    => $rs->{protocol_version},
+    });
+
+    #
+    # Process the exclude/include arguments and send the
+    # exclude/include file list
+    #
+    foreach my $arg ( @{$rs->{excludeArgs}} ) {
+        if ( $arg->{name} eq "exclude" ) {
+            $rs->{fileList}->exclude_add($arg->{value}, 0);
+        } elsif ( $arg->{name} eq "include" ) {
+            $rs->{fileList}->exclude_add($arg->{value}, 2);
+        } elsif ( $arg->{name} eq "exclude-from" ) {
+            $rs->{fileList}->exclude_add_file($arg->{value}, 1);
+        } elsif ( $arg->{name} eq "include-from" ) {
+            $rs->{fileList}->exclude_add_file($arg->{value}, 3);
+        } elsif ( $arg->{name} eq "cvs-exclude" ) {
+            $rs->{fileList}->exclude_cvs_add();
+        } else {
+            $rs->log("Error: Don't recognize exclude argument $arg->{name}"
+                   . " ($arg->{value})");
+        }
+    }
+    $rs->{fileList}->exclude_list_send();
+    $rs->writeData($rs->{fileList}->encodeData(), 1);
+    if ( $rs->{logLevel} >= 1 ) {
+        foreach my $exc ( @{$rs->{fileList}->exclude_list_get()} ) {
+            from_to($exc->{pattern}, $rs->{clientCharset}, "utf8")
+                                    if ( $rs->{clientCharset} ne "" );
+            if ( $exc->{flags} & (1 << 4) ) {
+                $rs->log("Sent include: $exc->{pattern}");
+            } else {
+                $rs->log("Sent exclude: $exc->{pattern}");
+            }
+        }
+    }
+
+    #
+    # Now receive the file list
+    #
+    my $curr = 0;
+    while ( !$rs->{fileList}->decodeDone ) {
+        return -1 if ( $rs->{reader}->dataLen == 0 && $rs->getChunk(1) < 0 );
+        my $cnt = $rs->{fileList}->decode($rs->{reader}->dataPeek);
+	return -1 if ( $rs->{fileList}->fatalError );
+	if ( $rs->{logLevel} >= 4 ) {
+	    my $end = $rs->{fileList}->count;
+	    foreach my $name ( $rs->{fileList}->fieldGet("name", $curr,
+							  $end - $curr) ) {
+		if ( defined($name) ) {
+		    from_to($name, $rs->{clientCharset}, "utf8")
+					if ( $rs->{clientCharset} ne "" );
+		    $rs->log("Got file ($curr of $end): $name");
+		}
+		$curr++;
+	    }
+	}
+        if ( $cnt > 0 ) {
+            $rs->{reader}->dataSkip($cnt);
+	    return -1 if ( !$rs->{fileList}->decodeDone
+			&& $rs->getChunk($rs->{reader}->dataLen + 1) < 0 );
+        }
+    }
+
+    #
+    # Sort and clean the file list
+    #
+    $rs->{fileList}->clean;
+}
+
+#
+# Called by the child process to create directories, special files,
+# and optionally to set attributes on normal files.
+#
+sub fileSpecialCreate
+{
+    my($rs, $start, $end) = @_;
+
+    $end = $rs->{fileList}->count if ( !defined($end) );
+    for ( my $n = $start ; $n < $end ; $n++ ) {
+	my $f = $rs->{fileList}->get($n);
+	next if ( !defined($f) );
+        from_to($f->{name}, $rs->{clientCharset}, "utf8")
+                                if ( $rs->{clientCharset} ne "" );
+	my $attr = $rs->{fio}->attribGet($f);
+
+	if ( $rs->{doPartial} && $rs->{fileList}->flagGet($n) ) {
+	    $rs->{fio}->attrSkippedFile($f, $attr);
+	    next;
+	}
+
+	$rs->{fio}->attribSet($f, 1);
+
+	if ( ($f->{mode} & S_IFMT) != S_IFREG ) {
+	    #
+	    # A special file
+	    #
+	    if ( ($f->{mode} & S_IFMT) == S_IFDIR ) {
+		if ( $rs->{fio}->makePath($f) ) {
+		    # error
+                    $rs->log("Error: makePath($f->{name}) failed");
+		}
+	    } else {
+		if ( $rs->{fio}->makeSpecial($f) ) {
+		    # error
+                    $rs->log("Error: makeSpecial($f->{name}) failed");
+		}
+	    }
+	} elsif ( defined($f->{hlink}) && !$f->{hlink_self} ) {
+            if ( $rs->{fio}->makeHardLink($f, 0) ) {
+                $rs->log("Error: makeHardlink($f->{name} -> $f->{hlink}) failed");
+            }
+        }
+    }
+}
+
+sub fileCsumSend
+{
+    my($rs, $phase) = @_;
+    my $csumLen = $phase == 0 ? 2 : 16;
+    my $needMD4 = $rs->{exactMatchDigest} eq "parent" ? 1 : 0;
+
+    $rs->{phase} = $phase;
+    #
+    # Only regular files get checksums, so the others are skipped
+    # without fetching them from the file list.
+    #
+    $rs->{doList} = [$rs->{fileList}->indexGet("reg")] if ( $phase == 0 );
+    $rs->{redoList} = [];
+    $rs->{prefetchCnt} = 0;
+    $rs->{prefetchQueue} = [];
+    if ( $rs->{logLevel} >= 2 ) {
+	my $cnt = @{$rs->{doList}};
+	$rs->log("Sending csums, cnt = $cnt, phase = $phase");
+    }
+    while ( @{$rs->{doList}} || $phase == 1 && $rs->{childDone} < 3 ) {
+	if ( @{$rs->{doList}} ) {
+	    $rs->csumPrefetch($phase);
+	    my $n = shift(@{$rs->{doList}});
+	    my $file;
+	    if ( $rs->{prefetchCnt} > 0 ) {
+		$rs->{prefetchCnt}--;
+		$file = shift(@{$rs->{prefetchQueue}});
+	    } else {
+		$file = $rs->csumFileGet($n, $phase);
+	    }
+	    my($f, $attr, $skip) = @$file;
+	    next if ( !defined($f) );
+
+	    #
+	    # check if we should skip this file: same type, size, mtime etc
+	    #
+	    if ( defined($skip) ) {
+		$rs->log("Skipping $f->{name} ($skip)")
+			    if ( $rs->{logLevel} >= 3
+			       && ($f->{mode} & S_IFMT) == S_IFREG );
+		next;
+	    }
+
+            my $blkSize;
+            if ( ($f->{mode} & S_IFMT) != S_IFREG ) {
+                #
+                # Remote file is special: no checksum needed.
+                #
+                next;
+            } elsif ( $rs->{rsyncOpts}{"hard-links"}
+                            && defined($f->{hlink})
+                            && !$f->{hlink_self} ) {
+                #
+                # Skip any hardlinks; the child will create them later
+                #
+                next;
+            } elsif ( !defined($attr->{mode})
+			|| ($attr->{mode} & S_IFMT) != S_IFREG ) {
+                #
+                # Local file isn't a regular file but remote is.
+		# So delete the local file and send an empty
+		# checksum.
+                #
+		$rs->{fio}->unlink($f->{name}) if ( defined($attr->{mode}) );
+		$rs->log("Sending empty csums for $f->{name}")
+				    if ( $rs->{logLevel} >= 5 );
+                $rs->write_sum_head($n, 0, $rs->{blockSize}, $csumLen, 0);
+                $rs->childDigestSend($phase, $n) if ( $needMD4 );
+            } elsif ( ($blkSize = $rs->{fio}->csumStart($f, $needMD4,
+                                        $rs->{blockSize}, $phase)) < 0 ) {
+		#
+		# Can't open the file, so send an empty checksum
+		#
+		$rs->log("Sending empty csums for $f->{name}")
+				    if ( $rs->{logLevel} >= 5 );
+                $rs->write_sum_head($n, 0, $rs->{blockSize}, $csumLen, 0);
+                $rs->childDigestSend($phase, $n) if ( $needMD4 );
+	    } else {
+		#
+		# The local file is a regular file, so generate and
+		# send the checksums.
+                #
+
+                #
+                # Compute adaptive block size, from $rs->{blockSize}
+                # to 16384 based on file size.
+		#
+                if ( $blkSize <= 0 ) {
+                    $blkSize = int($attr->{size} / 10000);
+                    $blkSize = $rs->{blockSize}
+                                    if ( $blkSize < $rs->{blockSize} );
+                    $blkSize = 16384 if ( $blkSize > 16384 );
+                }
+		my $blkCnt = int(($attr->{size} + $blkSize - 1)
+						/ $blkSize);
+		$rs->log("Sending csums for $f->{name} (size=$attr->{size})")
+				if ( $rs->{logLevel} >= 5 );
+                $rs->write_sum_head($n, $blkCnt, $blkSize, $csumLen,
+                            $blkCnt > 0
+                                ? $attr->{size} - ($blkCnt - 1) * $blkSize
+                                : $attr->{size});
+		my $nWrite = ($csumLen + 4) * $blkCnt;
+		#
+		# Get the checksums at least 256 blocks or 1MB at a time,
+		# so large reads can be split across threads.
+		#
+		my $maxCnt = int(1048576 / $blkSize);
+		$maxCnt = 256 if ( $maxCnt < 256 );
+		while ( $blkCnt > 0 && $nWrite > 0 ) {
+		    my $thisCnt = $blkCnt > $maxCnt ? $maxCnt : $blkCnt;
+		    my $csum = $rs->{fio}->csumGet($thisCnt, $csumLen,
+						   $blkSize);
+		    $rs->writeData($csum);
+		    $nWrite -= length($csum);
+		    $blkCnt -= $thisCnt;
+		    return if ( $rs->{abort} );
+		}
+		#
+		# In case the reported file size was wrong, we need to
+		# send enough checksum data.  It's not clear that sending
+		# zeros is right, but this shouldn't happen in any case.
+		#
+                if ( $nWrite > 0 && !$rs->{abort} ) {
+		    $rs->writeData(pack("c", 0) x $nWrite);
+                }
+		my $md4 = $rs->{fio}->csumEnd;
+                $rs->childDigestSend($phase, $n, $md4) if ( $needMD4 );
+	    }
+	}
+	if ( !@{$rs->{doList}} && $phase == 1 && $rs->{childDone} == 1 ) {
+	    #
+	    # end of phase 1
+	    #
+	    $rs->writeData(pack("V", 0xffffffff), 1);
+	    $rs->{childDone} = 2;
+	}
+	#
+	# Now poll the pipe from the child to see if there are any
+	# files we need to redo on the second phase
+	#
+	# If there are no more files but we haven't seen "exit"
+	# from the child then block forever.
+	#
+        return if ( $rs->{abort} );
+	$rs->pollChild(($phase == 1 && !@{$rs->{doList}}) ? undef : 0);
+    }
+    if ( $phase == 0 ) {
+	#
+	# end of phase 0
+	#
+	$rs->writeData(pack("V", 0xffffffff), 1);
+	$rs->{doList} = $rs->{redoList};
+    }
+}
+
+#
+# Returns true if the local file's attributes match the remote file,
+# so it can be skipped (unless --ignore-times is set).
+#
+sub fileSameAttr
+{
+    my($rs, $f, $attr) = @_;
+
+    return $f->{size}  == $attr->{size}
+	&& $f->{mtime} == $attr->{mtime}
+	&& (!$rs->{rsyncOpts}{perms} || $f->{mode} == $attr->{mode})
+	&& (!$rs->{rsyncOpts}{group} || $f->{gid} == $attr->{gid})
+	&& (!$rs->{rsyncOpts}{owner} || $f->{uid} == $attr->{uid})
+	&& (!$rs->{rsyncOpts}{"hard-links"}
+		  || $f->{hlink_self} == $attr->{hlink_self});
+}
+
+#
+# Fetch file $n from the file list and its local attributes, for
+# fileCsumSend.  Returns [$f, $attr, $skip], where $skip is the reason
+# the file can be skipped, or undef.  $attr isn't fetched if the file
+# is skipped because it is partial, and the list is empty if $n isn't
+# in the file list.
+#
+sub csumFileGet
+{
+    my($rs, $n, $phase) = @_;
+
+    my $f = $rs->{fileList}->get($n);
+    return [] if ( !defined($f) );
+    from_to($f->{name}, $rs->{clientCharset}, "utf8")
+			    if ( $rs->{clientCharset} ne "" );
+    return [$f, undef, "same attr on partial"]
+		if ( $rs->{doPartial} && $rs->{fileList}->flagGet($n) );
+    my $attr = $rs->{fio}->attribGet($f);
+    return [$f, $attr, "same attr"]
+		if ( !$rs->{rsyncOpts}{"ignore-times"} && $phase == 0
+		    && $rs->fileSameAttr($f, $attr) );
+    return [$f, $attr];
+}
+
+#
+# Let FileIO start reading the next $rs->{csumPrefetch} files in
+# $rs->{doList} whose checksums will be sent, so the disk reads overlap
+# with sending the checksums of the current file.  The first
+# $rs->{prefetchCnt} entries of $rs->{doList} have already been seen,
+# and their csumFileGet() results are in $rs->{prefetchQueue}.
+#
+sub csumPrefetch
+{
+    my($rs, $phase) = @_;
+    my $doList = $rs->{doList};
+    my $fio    = $rs->{fio};
+
+    return if ( $rs->{csumPrefetch} <= 0 || !$fio->can("csumPrefetch") );
+    while ( $rs->{prefetchCnt} < $rs->{csumPrefetch}
+		&& $rs->{prefetchCnt} < @$doList ) {
+	my $file = $rs->csumFileGet($doList->[$rs->{prefetchCnt}++], $phase);
+	push(@{$rs->{prefetchQueue}}, $file);
+	my($f, $attr, $skip) = @$file;
+	next if ( !defined($f) || defined($skip)
+		    || ($f->{mode} & S_IFMT) != S_IFREG
+		    || $rs->{rsyncOpts}{"hard-links"} && defined($f->{hlink})
+			    && !$f->{hlink_self}
+		    || !defined($attr->{mode})
+		    || ($attr->{mode} & S_IFMT) != S_IFREG
+		    || $attr->{size} == 0 );
+	$fio->csumPrefetch($f, $attr);
+    }
+}
+
+#
+# See if there are any messges from the local child over the pipe.
+# These could be logging messages or requests to repeat files.
+#
+sub pollChild
+{
+    my($rs, $timeout) = @_;
+    my($FDread);
+
+    return $rs->receiverPoll($timeout) if ( $rs->{inProcess} );
+    return -1 if ( !defined($rs->{childFh}) );
+    $rs->log("pollChild($timeout)") if ( $rs->{logLevel} >= 12 );
+
+    vec($FDread, fileno($rs->{childFh}), 1) = 1;
+    my $ein = $FDread;
+    my $FDwrite;
+    vec($FDwrite, fileno($rs->{childFh}), 1) = 1
+                                if ( $rs->childSendLen );
+    #$rs->log("pollChild: select(timeout=$timeout)");
+    select(my $rout = $FDread, my $rwrite = $FDwrite, $ein, $timeout);
+    $rs->childSendFlush
+            if ( defined($FDwrite) && vec($rwrite, fileno($rs->{childFh}), 1) );
+    return if ( !vec($rout, fileno($rs->{childFh}), 1) );
+    my $n = $rs->{childReader}->fill;
+    if ( $n <= 0 ) {
+        close($rs->{childFh});
+        delete($rs->{childFh});
+	$rs->log("Parent read EOF from child: fatal error!")
+		if ( $rs->{logLevel} >= 1 );
+        $rs->{abort}         = 1;
+        $rs->{fatalError}    = 1;
+        $rs->{fatalErrorMsg} = "Child exited prematurely";
+	return -1;
+    }
+    $rs->log("Parent read: " . unpack("H*", $rs->{childReader}->lastRead))
+		if ( $rs->{logLevel} >= 20 );
+    #
+    # Process the complete messages from the child; they are all
+    # non-data messages, so they go to childMessage().
+    #
+    $rs->{childReader}->demux(1);
+}
+
+#
+# Handle a message from the child.
+#
+sub childMessage
+{
+    my($rs, $code, $msg) = @_;
+
+    if ( $code == CHILD_LOG ) {
+	$rs->log($msg);
+    } elsif ( $code == CHILD_REDO ) {
+	foreach my $n ( unpack("V*", $msg) ) {
+	    $rs->generatorEvent("redo", $n);
+	}
+    } elsif ( $code == CHILD_DONE ) {
+	$rs->generatorEvent("done");
+    } elsif ( $code == CHILD_STATS ) {
+	my($w, $r, $size, $errCnt, $frozen) = unpack("V4 a*", $msg);
+	my $childStats = thaw($frozen) || {};
+	$rs->log("Got stats: $w $r $size $errCnt "
+		    . join(" ", sort(keys(%$childStats))))
+		    if ( $rs->{logLevel} >= 4 );
+	$rs->generatorEvent("stats", $w, $r, $size, $errCnt, $childStats);
+    } elsif ( $code == CHILD_EXIT ) {
+	$rs->generatorEvent("exit");
+    } else {
+	$rs->log("Don't understand message $code from child");
+    }
+}
+
+#
+# Handle an event from the receiver: "done" at the end of phase 0,
+# "redo $fileNum" for a file to repeat in phase 1, "stats" with the
+# final stats, and "exit" when the receiver has finished.
+#
+sub generatorEvent
+{
+    my($rs, $type, @args) = @_;
+
+    if ( $type eq "done" ) {
+        $rs->log("Got done from child") if ( $rs->{logLevel} >= 4 );
+        $rs->{childDone} = 1;
+    } elsif ( $type eq "stats" ) {
+        $rs->{stats}{totalRead}     = $args[0];
+        $rs->{stats}{totalWritten}  = $args[1];
+        $rs->{stats}{totalSize}     = $args[2];
+        $rs->{stats}{remoteErrCnt} += $args[3];
+        $rs->{stats}{childStats}    = $args[4];
+        $rs->{stats}{parentStats}   = $rs->{inProcess} ? {}
+                                                       : $rs->{fio}->statsGet;
+    } elsif ( $type eq "exit" ) {
+        $rs->log("Got exit from child") if ( $rs->{logLevel} >= 4 );
+        $rs->{childDone} = 3;
+    } elsif ( $type eq "redo" ) {
+        if ( $rs->{phase} == 1 ) {
+            push(@{$rs->{doList}}, $args[0]);
+        } else {
+            push(@{$rs->{redoList}}, $args[0]);
+        }
+        $rs->log("Got redo $args[0]") if ( $rs->{logLevel} >= 4 );
+    }
+}
+
+#
+# Send an event from the receiver to the generator: as a message on
+# the pipe $fh from the child, or directly when they run in one process.
+# Redo requests are batched (up to 16384, so a batch fits in one
+# message) until the next message is sent; log messages wait until
+# childFlush(), unless a lot are queued.
+#
+sub receiverEvent
+{
+    my($rs, $fh, $type, @args) = @_;
+    my $w = $rs->{childWriter};
+
+    return $rs->generatorEvent($type, @args) if ( !defined($fh) );
+    if ( $type eq "redo" ) {
+	push(@{$rs->{childRedo}}, @args);
+	return if ( @{$rs->{childRedo}} < 16384 );
+    }
+    $w->addMsg(CHILD_REDO, pack("V*", splice(@{$rs->{childRedo}})))
+			if ( @{$rs->{childRedo} || []} );
+    if ( $type eq "log" ) {
+	$w->addMsg(CHILD_LOG, $args[0]);
+	return if ( $w->len < 65536 );
+    } elsif ( $type eq "stats" ) {
+	#
+	# The FileIO stats can be nested, so they are sent frozen
+	#
+	$w->addMsg(CHILD_STATS, pack("V4", @args[0..3])
+				. nfreeze($args[4] || {}));
+    } elsif ( $type eq "done" ) {
+	$w->addMsg(CHILD_DONE, "");
+    } elsif ( $type eq "exit" ) {
+	$w->addMsg(CHILD_EXIT, "");
+    }
+    $rs->childFlush;
+}
+
+#
+# In the child, send the queued messages to the parent.
+#
+sub childFlush
+{
+    my($rs) = @_;
+    my $w = $rs->{childWriter};
+
+    return if ( !defined($w) );
+    $w->addMsg(CHILD_REDO, pack("V*", splice(@{$rs->{childRedo}})))
+			if ( @{$rs->{childRedo} || []} );
+    while ( $w->len ) {
+	next if ( $w->flush >= 0 || $!{EINTR} );
+	delete($rs->{childWriter});
+	return -1;
+    }
+}
+
+#
+# With the inProcess option, the receiver runs in this process between
+# the generator's files, and whenever the generator would otherwise
+# wait (see pollChild and writeFlush).  It only uses data that has
+# already been read, so it never blocks.
+#
+sub receiverPoll
+{
+    my($rs, $timeout) = @_;
+
+    return -1 if ( $rs->receiverRun < 0 );
+    return if ( $rs->{childDone} >= 3 || $rs->{abort} );
+    my $ein;
+    vec($ein, fileno($rs->{fh}), 1) = 1;
+    select(my $rout = $ein, undef, undef, $timeout);
+    return if ( !vec($rout, fileno($rs->{fh}), 1) );
+    return -1 if ( $rs->receiverFill < 0 );
+    return -1 if ( $rs->receiverRun < 0 );
+}
+
+#
+# Read once from the socket for the in-process receiver.  Returns -1
+# on EOF or a read error.
+#
+sub receiverFill
+{
+    my($rs) = @_;
+
+    my $n = $rs->{reader}->fill;
+    return 0 if ( $n < 0 && ($!{EINTR} || $!{EAGAIN}) );
+    if ( $n <= 0 ) {
+        $rs->log("Read EOF: $!") if ( $rs->{logLevel} >= 1 );
+        $rs->{abort}         = 1;
+        $rs->{fatalError}    = 1;
+        $rs->{fatalErrorMsg} = "Unable to read from remote";
+        return -1;
+    }
+    $rs->log("Receiving: " . unpack("H*", $rs->{reader}->lastRead))
+                if ( $rs->{logLevel} >= 10 );
+    return $n;
+}
+
+#
+# Run the in-process receiver until it needs more data: the file
+# deltas for phases 0 and 1, then the final stats.
+#
+sub receiverRun
+{
+    my($rs) = @_;
+    my $reader = $rs->{reader};
+
+    while ( $rs->{childDone} < 3 && !$rs->{abort} ) {
+        if ( $rs->{rxPhase} < 2 ) {
+            my $phase = $rs->{rxPhase};
+            if ( !$rs->fileDeltaStep(undef, $phase) ) {
+                my $need = $reader->dataLen + $rs->{rxNeed};
+                return 0 if ( $reader->demux($need) < $need );
+                next;
+            }
+            $rs->receiverEvent(undef, "done") if ( $phase == 0 );
+            $rs->{rxPhase}++;
+        } else {
+            return 0 if ( $reader->demux(12) < 12 );
+            my($totalWritten, $totalRead, $totalSize) = $reader->dataInt(3);
+            $rs->receiverEvent(undef, "stats", $totalWritten, $totalRead,
+                               $totalSize, 0, $rs->{fio}->statsGet);
+            #
+            # Final signoff
+            #
+            $rs->writeData(pack("V", 0xffffffff), 1);
+            $rs->{fio}->finish(1);
+            $rs->receiverEvent(undef, "exit");
+        }
+    }
+    return $rs->{abort} ? -1 : 0;
+}
+
+#
+# With exactMatchDigest set to "parent", the parent computes the MD4
+# digest of each local file while generating its checksums, and sends
+# it to the child as a PARENT_DIGEST message: the packed phase and
+# file number, followed by the 16 byte digest if there is one.  The
+# child then doesn't need to reread a file whose blocks all match to
+# check its digest.
+#
+sub childDigestSend
+{
+    my($rs, $phase, $n, $md4) = @_;
+
+    if ( $rs->{inProcess} ) {
+        $rs->{fileDigests}{"$phase $n"} = $md4
+                            if ( !delete($rs->{digestSkip}{"$phase $n"}) );
+        return;
+    }
+    return if ( !defined($rs->{childFh}) );
+    $rs->{childDigestWriter}->addMsg(PARENT_DIGEST, pack("V2", $phase, $n)
+                                        . (defined($md4) ? $md4 : ""));
+    $rs->childSendFlush;
+}
+
+sub childSendLen
+{
+    my($rs) = @_;
+
+    return defined($rs->{childDigestWriter})
+                ? $rs->{childDigestWriter}->len : 0;
+}
+
+sub childSendFlush
+{
+    my($rs) = @_;
+
+    return if ( !defined($rs->{childFh}) || !$rs->childSendLen );
+    $rs->{childDigestWriter}->flush;
+}
+
+#
+# In the child, handle a message from the parent.
+#
+sub parentMessage
+{
+    my($rs, $code, $msg) = @_;
+
+    if ( $code == PARENT_DIGEST ) {
+        my($phase, $n, $md4) = unpack("V2 a*", $msg);
+        return if ( delete($rs->{digestSkip}{"$phase $n"}) );
+        $rs->{fileDigests}{"$phase $n"} = length($md4) ? $md4 : undef;
+    } else {
+        $rs->log("Don't understand message $code from parent");
+    }
+}
+
+#
+# In the child, return the digest of file $n in $phase sent by the
+# parent, or undef if there isn't one.
+#
+sub childDigestGet
+{
+    my($rs, $fh, $phase, $n) = @_;
+    my $key = "$phase $n";
+
+    while ( !$rs->{inProcess} && !exists($rs->{fileDigests}{$key}) ) {
+        $rs->childFlush;
+        my $nbytes = $rs->{parentReader}->fill;
+        next if ( $nbytes < 0 && $!{EINTR} );
+        return if ( $nbytes <= 0 );
+        $rs->{parentReader}->demux(1);
+    }
+    return delete($rs->{fileDigests}{$key});
+}
+
+#
+# In the child, drop the digest of file $n in $phase, which isn't
+# needed, now or when it arrives.  Digests that have already arrived
+# are read without waiting, so they don't queue up in the parent.
+#
+sub childDigestSkip
+{
+    my($rs, $phase, $n) = @_;
+    my $key = "$phase $n";
+
+    if ( exists($rs->{fileDigests}{$key}) ) {
+        delete($rs->{fileDigests}{$key});
+    } else {
+        $rs->{digestSkip}{$key} = 1;
+    }
+    return if ( $rs->{inProcess} || !defined($rs->{parentReader}) );
+    my $FDread;
+    vec($FDread, $rs->{parentReader}->fd, 1) = 1;
+    while ( select(my $rout = $FDread, undef, undef, 0) > 0 ) {
+        last if ( $rs->{parentReader}->fill <= 0 );
+        $rs->{parentReader}->demux(1);
+    }
+}
+
+sub fileCsumReceive
+{
+    my($rs, $phase) = @_;
+    my($fileNum, $blkCnt, $blkSize, $remainder);
+    my $csumLen = $phase == 0 ? 2 : 16;
+    #
+    # delete list -> disabled by argv
+    #
+    #  $rs->writeData(pack("V", 1));
+    #
+    while ( 1 ) {
+	return -1 if ( $rs->getChunk(4) < 0 );
+	$fileNum = $rs->{reader}->dataInt;
+	if ( $fileNum == 0xffffffff ) {
+	    $rs->log("Finished csumReceive")
+		    if ( $rs->{logLevel} >= 2 );
+	    last;
+	}
+        my $f = $rs->{fileList}->get($fileNum);
+	next if ( !defined($f) );
+        from_to($f->{name}, $rs->{clientCharset}, "utf8")
+                                if ( $rs->{clientCharset} ne "" );
+        if ( $rs->{protocol_version} >= 27 ) {
+            #
+            # For protocols >= 27 the remote picks the csum length
+            # for each file.
+            #
+            return -1 if ( $rs->getChunk(16) < 0 );
+            ($blkCnt, $blkSize, $csumLen, $remainder)
+                            = $rs->{reader}->dataInt(4);
+        } else {
+            return -1 if ( $rs->getChunk(12) < 0 );
+            ($blkCnt, $blkSize, $remainder) = $rs->{reader}->dataInt(3);
+        }
+	$rs->log("Got #$fileNum ($f->{name}), blkCnt=$blkCnt,"
+                 . " blkSize=$blkSize, csumLen=$csumLen, rem=$remainder")
+			if ( $rs->{logLevel} >= 5 );
+        #
+        # Read the remote block checksums
+        #
+        my $csums = "";
+	my $cnt = $blkCnt;
+        while ( $cnt > 0 ) {
+            my $thisCnt = $cnt > 256 ? 256 : $cnt;
+            my $len = $thisCnt * ($csumLen + 4);
+            return -1 if ( $rs->getChunk($len) < 0 );
+            $csums .= $rs->{reader}->dataGet($len);
+            $cnt -= $thisCnt;
+        }
+        next if ( ($f->{mode} & S_IFMT) != S_IFREG );
+
+        #
+        # Send the file number, numBlocks, blkSize and remainder
+        # (based on the old file size)
+        #
+        $rs->write_sum_head($fileNum, $blkCnt, $blkSize, $csumLen, $remainder);
+
+        #
+        # Generate the file delta against the remote blocks: matching
+        # blocks are sent as block numbers and everything else as
+        # literal data.  If the remote file is empty we just send the
+        # whole file.  The file MD4 digest is computed on the way
+        # through.
+        #
+        my $md4 = File::RsyncP::Digest->new($rs->{protocol_version});
+        $md4->add(pack("V", $rs->{checksumSeed}));
+        my $delta;
+        $delta = $md4->deltaNew($csums, $blkSize, $remainder, $csumLen,
+                                $rs->{checksumSeed}) if ( $blkCnt > 0 );
+        $rs->{fio}->readStart($f);
+        my $fd;
+        $fd = $rs->{fio}->readFd if ( !defined($delta)
+                                     && $rs->{fio}->can("readFd") );
+        while ( defined($fd) ) {
+            #
+            # Whole file: read the literal data tokens directly from
+            # the file, without copying the data through perl.
+            #
+            my $token = $md4->literalFd($fd, 4 * 65536);
+            last if ( !defined($token) );
+            $rs->writeData($token);
+            if ( $rs->{abort} ) {
+                $rs->{fio}->readEnd($f);
+                return;
+            }
+        }
+        while ( !defined($fd) ) {
+            my $dataR = $rs->{fio}->read(4 * 65536);
+            last if ( !defined($dataR) || length($$dataR) == 0 );
+            $md4->add($$dataR);
+            if ( defined($delta) ) {
+                $rs->writeData($delta->add($$dataR));
+            } else {
+                $rs->writeData(pack("V a*", length($$dataR), $$dataR));
+            }
+            if ( $rs->{abort} ) {
+                $rs->{fio}->readEnd($f);
+                return;
+            }
+        }
+        $rs->{fio}->readEnd($f);
+        if ( defined($delta) ) {
+            $rs->writeData($delta->finish);
+            $rs->log(sprintf("%s: %d of %d blocks matched, %.0f bytes literal",
+                             $f->{name}, $delta->matchCnt, $blkCnt,
+                             $delta->literalBytes))
+                                if ( $rs->{logLevel} >= 3 );
+        }
+
+        #
+        # Send a final 0 and the MD4 file digest
+        #
+        $rs->writeData(pack("V a16", 0, $md4->digest));
+    }
+
+    #
+    # Indicate end of this phase
+    #
+    $rs->writeData(pack("V", 0xffffffff), 1);
+}
+
+sub fileDeltaGet
+{
+    my($rs, $fh, $phase) = @_;
+
+    while ( 1 ) {
+        my $ret = $rs->fileDeltaStep($fh, $phase);
+        return $ret if ( $ret );
+        return -1 if ( $rs->getChunk($rs->{reader}->dataLen
+                                     + $rs->{rxNeed}) < 0 );
+    }
+}
+
+#
+# Receive as much of the file deltas for $phase as the demultiplexed
+# data allows.  Returns 1 at the end of the phase, or 0 if at least
+# $rs->{rxNeed} more bytes are needed.  The position in the phase is
+# kept in $rs->{rx}.
+#
+sub fileDeltaStep
+{
+    my($rs, $fh, $phase) = @_;
+    my $reader = $rs->{reader};
+    my $rx = $rs->{rx} ||= { fileStart => 0 };
+
+    while ( 1 ) {
+        if ( !defined($rx->{fileNum}) ) {
+            if ( $reader->dataLen < 4 ) {
+                $rs->{rxNeed} = 4 - $reader->dataLen;
+                return 0;
+            }
+            $rx->{fileNum} = $reader->dataInt;
+            last if ( $rx->{fileNum} == 0xffffffff );
+
+            #
+            # Make any intermediate dirs or special files
+            #
+            $rs->fileSpecialCreate($rx->{fileStart}, $rx->{fileNum})
+                                                    if ( $phase == 0 );
+            $rx->{fileStart} = $rx->{fileNum} + 1;
+
+            my $f = $rs->{fileList}->get($rx->{fileNum});
+            if ( !defined($f) ) {
+                delete($rx->{fileNum});
+                next;
+            }
+            from_to($f->{name}, $rs->{clientCharset}, "utf8")
+                                    if ( $rs->{clientCharset} ne "" );
+            $rx->{file} = $f;
+            $rx->{started} = 0;
+        }
+        my $fileNum = $rx->{fileNum};
+        my $f = $rx->{file};
+        if ( !$rx->{started} ) {
+            my($blkCnt, $blkSize, $remainder);
+            my $hdrLen = $rs->{protocol_version} >= 27 ? 16 : 12;
+            if ( $reader->dataLen < $hdrLen ) {
+                $rs->{rxNeed} = $hdrLen - $reader->dataLen;
+                return 0;
+            }
+            if ( $rs->{protocol_version} >= 27 ) {
+                my $thisCsumLen;
+                ($blkCnt, $blkSize, $thisCsumLen, $remainder)
+                                = $reader->dataInt(4);
+            } else {
+                ($blkCnt, $blkSize, $remainder) = $reader->dataInt(3);
+            }
+            $rs->log("Starting file $fileNum ($f->{name}),"
+                . " blkCnt=$blkCnt, blkSize=$blkSize, remainder=$remainder")
+                        if ( $rs->{logLevel} >= 5 );
+            $rs->{fio}->fileDeltaRxStart($f, $blkCnt, $blkSize, $remainder);
+            $rx->{started} = 1;
+            $rx->{fioRun}  = $rs->{fio}->can("fileDeltaRxRun");
+            #
+            # Whether the file is so far an exact match of the local
+            # file: all its blocks in order, with no literal data
+            #
+            $rx->{exact}   = 1;
+            $rx->{nextBlk} = 0;
+            $rx->{blkCnt}  = $blkCnt;
+        }
+
+        #
+        # The tokens are decoded in C, which returns runs of matching
+        # blocks rather than one block at a time.
+        #
+        while ( 1 ) {
+            my($type, @args) = $reader->deltaNext;
+            if ( $type eq "need" ) {
+                $rs->{rxNeed} = $args[0];
+                return 0;
+            } elsif ( $type eq "run" ) {
+                $rx->{exact}   = 0 if ( $args[0] != $rx->{nextBlk} );
+                $rx->{nextBlk} = $args[0] + $args[1];
+                if ( $rx->{fioRun} ) {
+                    $rs->{fio}->fileDeltaRxRun(@args);
+                } else {
+                    for ( my $b = 0 ; $b < $args[1] ; $b++ ) {
+                        $rs->{fio}->fileDeltaRxNext($args[0] + $b, undef);
+                    }
+                }
+            } elsif ( $type eq "data" ) {
+                $rx->{exact} = 0;
+                $rs->{fio}->fileDeltaRxNext(undef, $args[0]);
+            } else {
+                my $md4digest = $args[0];
+                my $localMd4;
+                #
+                # The parent's digest of the local file is only needed
+                # (and waited for) if the file is an exact match.
+                #
+                if ( $rs->{exactMatchDigest} eq "parent" ) {
+                    if ( $rx->{exact} && $rx->{nextBlk} == $rx->{blkCnt} ) {
+                        $localMd4 = $rs->childDigestGet($fh, $phase,
+                                                        $fileNum);
+                    } else {
+                        $rs->childDigestSkip($phase, $fileNum);
+                    }
+                }
+                my $ret = $rs->{fio}->fileDeltaRxNext(undef, undef)
+                       || $rs->{fio}->fileDeltaRxDone($md4digest, $phase,
+                                                      $localMd4);
+                if ( $ret == 1 ) {
+                    if ( $phase == 1 ) {
+                        $rs->log("MD4 does't agree: fatal error on #$fileNum ($f->{name})");
+                        last;
+                    }
+                    $rs->log("Must redo $fileNum ($f->{name})\n")
+			if ( $rs->{logLevel} >= 2 );
+                    $rs->receiverEvent($fh, "redo", $fileNum);
+                }
+                last;
+            }
+        }
+
+        #
+        # If this is 2nd phase, then set the attributes just for this file
+        #
+	$rs->{fio}->attribSet($f, 1) if ( $phase == 1 );
+        delete($rx->{fileNum});
+    }
+    #
+    # Make any remaining dirs or special files
+    #
+    $rs->fileSpecialCreate($rx->{fileStart}, undef) if ( $phase == 0 );
+    delete($rs->{rx});
+
+    $rs->log("Finished deltaGet phase $phase") if ( $rs->{logLevel} >= 2 );
+
+    #
+    # Finish up hardlinks at the very end
+    #
+    if ( $phase == 1 && $rs->{rsyncOpts}{"hard-links"} ) {
+        foreach my $n ( $rs->{fileList}->indexGet("hlink") ) {
+            my $f = $rs->{fileList}->get($n);
+            if ( $rs->{clientCharset} ne "" ) {
+                from_to($f->{name},  $rs->{clientCharset}, "utf8");
+                from_to($f->{hlink}, $rs->{clientCharset}, "utf8");
+            }
+            if ( $rs->{fio}->makeHardLink($f, 1) ) {
+                $rs->log("Error: makeHardlink($f->{name} -> $f->{hlink}) failed");
+            }
+        }
+    }
+    return 1;
+}
+
+sub fileListSend
+{
+    my($rs) = @_;
+
+    $rs->{fileList} = File::RsyncP::FileList->new({
+        preserve_uid        => $rs->{rsyncOpts}{owner},
+        preserve_gid        => $rs->{rsyncOpts}{group},
+        preserve_links      => $rs->{rsyncOpts}{links},
+        preserve_devices    => $rs->{rsyncOpts}{devices},
+        preserve_hard_links => $rs->{rsyncOpts}{"hard-links"},
+        always_checksum     => $rs->{rsyncOpts}{checksum},
+        protocol_version    => $rs->{protocol_version},
+    });
+
+    if ( $rs->{rsyncOpts}{"hard-links"} ) {
+        $rs->{fileList}->init_hard_links();
+    }
+
+    $rs->{fio}->fileListSend($rs->{fileList}, sub { $rs->writeData($_[0]); });
+
+    #
+    # Send trailing null byte to indicate end of file list
+    #
+    $rs->writeData(pack("C", 0));
+
+    #
+    # Send io_error flag
+    #
+    $rs->writeData(pack("V", 0), 1);
+
+    #
+    # At this point io buffering should be switched off
+    #
+    # Sort and clean the file list
+    #
+    $rs->{fileList}->clean;
+
+    #
+    # Print out the sorted file list
+    #
+    if ( $rs->{logLevel} >= 4 ) {
+        my $cnt = $rs->{fileList}->count;
+        $rs->log("Sorted file list has $cnt entries");
+        my $n = 0;
+        foreach my $name ( $rs->{fileList}->fieldGet("name") ) {
+            if ( defined($name) ) {
+                from_to($name, $rs->{clientCharset}, "utf8")
+                                        if ( $rs->{clientCharset} ne "" );
+                $rs->log("PostSortFile $n: $name");
+            }
+            $n++;
+        }
+    }
+}
+
+sub write_sum_head
+{
+    my($rs, $fileNum, $blkCnt, $blkSize, $csumLen, $remainder) = @_;
+
+    if ( $rs->{protocol_version} >= 27 ) {
+        #
+        # For protocols >= 27 we also send the csum length
+        # for this file.
+        #
+        $rs->writeData(pack("V5",
+                $fileNum,
+                $blkCnt,
+                $blkSize,
+                $csumLen,
+                $remainder), 0);
+    } else {
+        $rs->writeData(pack("V4",
+                $fileNum,
+                $blkCnt,
+                $blkSize,
+                $remainder), 0);
+    }
+}
+
+sub abort
+{
+    my($rs, $reason, $timeout) = @_;
+
+    $rs->{abort} = 1;
+    $rs->{timeout} = $timeout if ( defined($timeout) );
+    $rs->{abortReason} = $reason || "aborted by user request";
+    kill($rs->{sigName2Num}{ALRM}, $rs->{childPID})
+			     if ( defined($rs->{childPID}) );
+    alarm($rs->{timeout}) if ( $rs->{timeout} );
+}
+
+sub statsGet
+{
+    my($rs, $fh) = @_;
+
+    my($totalWritten, $totalRead, $totalSize) = (0, 0, 0);
+
+    if ( $rs->getChunk(12) >= 0 ) {
+	($totalWritten, $totalRead, $totalSize) = $rs->{reader}->dataInt(3);
+    }
+    
+    if ( defined($fh) ) {
+	$rs->receiverEvent($fh, "stats", $totalWritten, $totalRead, $totalSize,
+			   0 + $rs->{stats}{remoteErrCnt},
+			   $rs->{fio}->statsGet);
+    } else {
+	$rs->{stats}{totalRead}    = $totalRead;
+	$rs->{stats}{totalWritten} = $totalWritten;
+	$rs->{stats}{totalSize}    = $totalSize;
+	$rs->{stats}{fioStats}     = $rs->{fio}->statsGet;
+    }
+}
+
+#
+# Start reading and writing the socket $rs->{fh} with a
+# File::RsyncP::Mux::Reader and File::RsyncP::Mux::Writer, which
+# buffer (and demultiplex) the data in C.
+#
+sub muxStart
+{
+    my($rs) = @_;
+    my $rsWeak = $rs;
+
+    weaken($rsWeak);
+    $rs->{reader} = File::RsyncP::Mux::Reader->new(fileno($rs->{fh}),
+                        sub { $rsWeak->remoteMessage(@_) if ( $rsWeak ); });
+    $rs->{writer} = File::RsyncP::Mux::Writer->new(fileno($rs->{fh}));
+}
+
+#
+# Make sure at least $len bytes of raw (not demultiplexed) input
+# are buffered.
+#
+sub getData
+{
+    my($rs, $len) = @_;
+    my $reader = $rs->{reader};
+
+    return -1 if ( $rs->{abort} );
+    alarm($rs->{timeout}) if ( $rs->{timeout} );
+    while ( $reader->rawLen < $len ) {
+	return -1 if ( $rs->{abort} );
+	$rs->childFlush;
+	my $ein;
+	vec($ein, fileno($rs->{fh}), 1) = 1;
+	select(my $rout = $ein, undef, $ein, undef);
+	return -1 if ( $rs->{abort} );
+        my $n = $reader->fill;
+        next if ( $n < 0 && ($!{EINTR} || $!{EAGAIN}) );
+        if ( $n <= 0 ) {
+            $rs->log("Read EOF: $!") if ( $rs->{logLevel} >= 1 );
+	    return -1 if ( $rs->{abort} );
+	    $n = $reader->fill;
+            $rs->log(sprintf("Tried again: got %d bytes", $n > 0 ? $n : 0))
+			if ( $rs->{logLevel} >= 1 );
+            $rs->{abort}         = 1;
+            $rs->{fatalError}    = 1;
+            $rs->{fatalErrorMsg} = "Unable to read $len bytes";
+            return -1;
+        }
+        if ( $rs->{logLevel} >= 10 ) {
+            $rs->log("Receiving: " . unpack("H*", $reader->lastRead));
+        }
+    }
+}
+
+#
+# Make sure at least $len bytes of demultiplexed data are available.
+#
+sub getChunk
+{
+    my($rs, $len) = @_;
+    my $reader = $rs->{reader};
+
+    $len ||= 1;
+    while ( $reader->demux($len) < $len ) {
+	return -1 if ( $rs->getData($reader->rawLen + 1) < 0 );
+    }
+}
+
+#
+# Called by the reader for each message from the remote rsync
+#
+sub remoteMessage
+{
+    my($rs, $code, $d) = @_;
+
+    $d =~ s/[\n\r]+$//;
+    from_to($d, $rs->{clientCharset}, "utf8")
+                            if ( $rs->{clientCharset} ne "" );
+    $rs->log("Remote[$code]: $d");
+    if ( $code == 1
+            || $d =~ /^file has vanished: /
+        ) {
+        $rs->{stats}{remoteErrCnt}++
+    }
+}
+
+sub getLine
+{
+    my($rs) = @_;
+
+    while ( 1 ) {
+        my $line = $rs->{reader}->rawLine;
+	return $line if ( defined($line) );
+	return if ( $rs->getData($rs->{reader}->rawLen + 1) < 0 );
+    }
+}
+
+sub writeData
+{
+    my($rs, $data, $flush) = @_;    
+
+    $rs->log("Sending: " . unpack("H*", $data)) if ( $rs->{logLevel} >= 10 );
+    $rs->{writer}->add($data);
+    $rs->writeFlush() if ( $flush || $rs->{writer}->len > 32768 ); 
+}
+
+sub statsFinal
+{
+    my($rs) = @_;    
+
+    $rs->{stats}{parentStats} = $rs->{fio}->statsGet
+		    if ( !defined($rs->{stats}{parentStats}) );
+    return $rs->{stats};
+}
+
+sub writeFlush
+{
+    my($rs) = @_;    
+    my $writer = $rs->{writer};
+
+    return if ( $rs->{abort} );
+    alarm($rs->{timeout}) if ( $rs->{timeout} );
+    while ( $writer->len ) {
+	my $n = $writer->flush;
+	next if ( $n > 0 || ($n < 0 && $!{EINTR}) );
+	if ( $n < 0 ) {
+	    return $rs->log(sprintf("Can't write %d bytes to socket",
+				      $writer->len));
+	}
+	#
+	# The socket is full.  Wait until it can be written, meanwhile
+	# reading any messages from the child so it doesn't block
+	# writing to us.
+	#
+	my($FDread, $FDwrite);
+	vec($FDread, fileno($rs->{childFh}), 1) = 1
+			    if ( defined($rs->{childFh}) );
+	vec($FDwrite, fileno($rs->{fh}), 1) = 1;
+	vec($FDwrite, fileno($rs->{childFh}), 1) = 1
+			    if ( $rs->childSendLen );
+	#
+	# In one process we keep reading the socket instead, so the
+	# remote doesn't block writing to us.
+	#
+	my $rxFill = $rs->{inProcess} && $rs->{childDone} < 3;
+	vec($FDread, fileno($rs->{fh}), 1) = 1 if ( $rxFill );
+	my $ein = $FDread;
+	vec($ein, fileno($rs->{fh}), 1) = 1;
+	select(my $rout = $FDread, my $rwrite = $FDwrite, $ein, undef);
+	if ( defined($rs->{childFh})
+			&& vec($rout, fileno($rs->{childFh}), 1) ) {
+	    $rs->pollChild(0);
+	}
+	if ( $rxFill && vec($rout, fileno($rs->{fh}), 1) ) {
+	    return if ( $rs->receiverFill < 0 );
+	}
+	$rs->childSendFlush if ( $rs->childSendLen );
+	return if ( $rs->{abort} );
+    }
+}
+
+#
+# Default log handler
+#
+sub logHandler
+{
+    my($str) = @_;
+
+    print(STDERR $str, "\n");
+}
+
+sub log
+{
+    my($rs, @logStr) = @_;    
+
+    foreach my $str ( @logStr ) {
+	next if ( $str eq "" );
+	$rs->{logHandler}->($str);
+    }
+}
+
+#
+# Escape shell meta-characters with backslashes.
+# This should be applied to each argument seperately, not an
+# entire shell command.
+#
+sub shellEscape
+{
+    my($self, $cmd) = @_;
+
+    $cmd =~ s/([][;&()<>{}|^\n\r\t *\$\\'"`?])/\\$1/g;
+    return $cmd;
+}
+
+1;
+
+__END__
+
+=head1 NAME
+
+File::RsyncP - Perl Rsync client
+
+=head1 SYNOPSIS
+
+    use File::RsyncP;
+
+    my $rs = File::RsyncP->new({
+                logLevel   => 1,
+                rsyncCmd   => "/bin/rsync",
+                rsyncArgs  => [
+                        "--numeric-ids",
+                        "--perms",
+                        "--owner",
+                        "--group",
+                        "--devices",
+                        "--links",
+                        "--ignore-times",
+                        "--block-size=700",
+                        "--relative",
+                        "--recursive",
+                        "-v",
+                    ],
+            });
+
+    #
+    # Receive files from remote srcDirectory to local destDirectory
+    # by running rsyncCmd with rsyncArgs.
+    #
+    $rs->remoteStart(1, srcDirectory);
+    $rs->go(destDirectory);
+    $rs->serverClose;
+
+    #
+    # Send files to remote destDirectory from local srcDirectory
+    # by running rsyncCmd with rsyncArgs.
+    #
+    $rs->remoteStart(0, destDirectory);
+    $rs->go(srcDirectory);
+    $rs->serverClose;
+
+    #
+    # Receive files from a remote module to local destDirectory by
+    # connecting to an rsyncd server.  ($module is the name from
+    # /etc/rsyncd.conf.)
+    #
+    my $port = 873;
+    $rs->serverConnect($host, $port);
+    $rs->serverService($module, $authUser, $authPasswd, 0);
+    $rs->serverStart(1, ".");
+    $rs->go(destDirectory);
+    $rs->serverClose;
+
+    #
+    # Get finals stats.  This is a hashref containing elements
+    # totalRead, totalWritten, totalSize, plus whatever the FileIO
+    # module might add.
+    #
+    my $stats = $rs->statsFinal;
+
+=head1 DESCRIPTION
+
+File::RsyncP is a perl implementation of an Rsync client.  It is
+compatible with Rsync 2.5.5 - 2.6.3 (protocol versions 26-28).
+It can send or receive files, either by running rsync on the remote
+machine, or connecting to an rsyncd deamon on the remote machine.
+
+What use is File::RsyncP?  The main purpose is that File::RsyncP
+separates all file system I/O into a separate module, which can
+be replaced by any module of your own design.  This allows rsync 
+interfaces to non-filesystem data types (eg: databases) to be
+developed with relative ease.
+
+File::RsyncP was initially written to provide an Rsync interface
+for BackupPC, L<http://backuppc.sourceforge.net>.  See BackupPC
+for programming examples.
+
+File::RsyncP does not yet provide a command-line interface that
+mimics native Rsync.  Instead it provides an API that makes it
+possible to write simple scripts that talk to rsync or rsyncd.
+
+The File::RsyncP::FileIO module contains the default file system access
+functions.  File::RsyncP::FileIO may be subclassed or replaced by a
+custom module to provide access to non-filesystem data types.
+
+=head2 Getting Started
+
+First some background.  When you run rsync is parses its command-line
+arguments, then it either connects to a remote rsyncd daemon, or
+runs an rsync on the remote machine via ssh or rsh.  At this point
+there are two rsync processes: the one you invoked and the one
+on the remote machine.  The one on the local machine is called
+the client, and the one on the remote machine is the server.
+One side (either the client or server) will send files and the
+other will receive files.  The sending rsync generates a file 
+list and sends it to the receiving side.  The receiving rsync
+will fork a child process.
+
+File::RsyncP does not (yet) have a command-line script that mimics
+rsync's startup processing.  Think of File::RsyncP as one level below
+the command-line rsync.  File::RsyncP implements the client side
+of the connection, and File::RsyncP knows how to run the remote
+side (eg, via rsh or ssh) or to connect to a remote rsyncd daemon.
+File::RsyncP automatically adds the internal --server and --sender
+options (if necessary) to the options passed to the remote rsync.
+
+To initiate any rsync session the File::RsyncP->new function
+should be called.  It takes a hashref of parameters:
+
+=over 4
+
+=item logLevel
+
+An integer level of verbosity.  Zero means be quiet, 1 will give some
+general information, 2 will some output per file, higher values give
+more output.  10 will include byte dumps of all data read/written,
+which will make the log output huge.
+
+=item rsyncCmd
+
+The command to run the remote peer of rsync.  By default the
+rsyncArgs are appended to the rsyncCmd to create the complete
+command before it is run.  This behavior is affected by rsyncCmdType.
+
+rsyncCmd can either be a single string giving the path of the rsync
+command to run (eg: /bin/rsync) or a list containing the command and
+arguments, eg:
+
+    rsyncCmd => [qw(
+        /bin/ssh -l user host /bin/rsync
+    )],
+
+or:
+
+    rsyncCmd => ["/bin/ssh", "-l", $user, $host, "/bin/rsync"],
+
+Also, rsyncCmd can also be set to a code reference (ie: a perl sub).
+In this case the code is called without arguments or other processing.
+It is up to the perl code you supply to exec() the remote rsync.
+
+This option is ignored if you are connecting to an rsyncd daemon.
+
+=item rsyncCmdType
+
+By default the complete remote rsync command is created by taking
+rsyncCmd and appending rsyncArgs.  This beavhior can be modified
+by specifying certain values for rsyncCmdType:
+
+=over 4
+
+=item 'full'
+
+rsyncCmd is taken to be the complete command, including all
+rsync arguments.  It is the caller's responsibility to build the
+correct remote rsync command, togheter will all the rsync arguments.
+You still need to specify rsyncArgs, so the local File::RsyncP knows
+how to behave.
+
+=item 'shell'
+
+rsyncArgs are shell escaped before appending to rsyncCmd.
+
+=back
+
+This option is ignored if you are connecting to an rsyncd daemon.
+
+=item rsyncArgs
+
+A list of rsync arguments.  The full remote rsync command that is run
+will be rsyncCmd appended with --server (and optionally --sender if the
+remote is a sender) and finally all of rsyncArgs.
+
+=item protocol_version
+
+What we advertize our protocol version to be.  Default is 28.
+
+=item logHandler
+
+A subroutine reference to a function that handles all the log 
+messages.  The default is a subroutine that prints the messages
+to STDERR.
+
+=item pidHandler
+
+An optional subroutine reference to a function that expects two
+integers: the pid of the rsync process (ie: the pid on the local
+machine that is likely ssh) and the child pid when we are receiving
+files.  If defined, this function is called once when the rsync
+process is forked, and again when the child is forked during
+receive.
+
+=item fio
+
+The file IO object that will handle all the file system IO.
+The default is File::RsyncP::FileIO->new.
+
+This can be replaced with a new module of your choice, or you
+can subclass File::RsyncP::FileIO.
+
+=item timeout
+
+Timeout in seconds for IO.  Default is 0, meaning no timeout.
+Uses alarm() and it is the caller's responsbility to catch the
+alarm signal.
+
+=item doPartial
+
+If set, a partial rsync is done.  This is to support resuming full
+backups in BackupPC.  When doPartial is set, the --ignore-times
+option can be set on a per-file basis.  On each file in the
+file list, File::RsyncP::FileIO->ignoreAttrOnFile() is called
+on each file, and this returns whether or not attributes should
+be ignored on that file.  If ignoreAttrOnFile() returns 1 then
+it's as though --ignore-times was set for that file.
+
+=item csumPrefetch
+
+The number of files ahead of the current one for which FileIO's
+optional csumPrefetch() method is called while the block checksums
+are being generated, so the disk reads of the next files overlap with
+sending the checksums of the current one.  Only files whose checksums
+will be sent are prefetched.  Defaults to 8; set to 0 to disable.
+The checksums are still generated and sent in file list order.
+
+=item exactMatchDigest
+
+How a received file whose blocks all match the local file is checked.
+By default the file is reread to compute its MD4 digest.  If set to
+"parent", the parent computes the digest of each local file while it
+generates the block checksums and sends it to the child, so the file
+is only read once.  The digest is then of the file when its checksums
+were generated, like the checksums themselves.  The child only waits
+for the digest of a file whose blocks all match.  If FileIO's checksum
+cache (csumCacheDir) has a valid entry for a file, its checksums come
+from the cache without reading the file, so no digest is sent and the
+child rereads the file if it is an exact match.
+
+=item inProcess
+
+If set, the file checksums are generated and the file deltas received
+in a single process, instead of forking a child to receive the deltas.
+The receiver runs whenever the generator would otherwise wait for the
+remote, and the two share the file list and the FileIO object, which
+must allow calls for the file being received between the calls for
+the file whose checksums are being generated.  Redo requests and the
+file digests of the exactMatchDigest option are passed directly, and
+all the FileIO stats are returned in childStats.
+
+=back
+
+An example of calling File::RsyncP->new is:
+
+    my $rs = File::RsyncP->new({
+                logLevel   => 1,
+                rsyncCmd => ["/bin/rsh", $host,  "-l", $user, "/bin/rsync"],
+                rsyncArgs  => [
+                        "--numeric-ids",
+                        "--perms",
+                        "--owner",
+                        "--group",
+                        "--devices",
+                        "--links",
+                        "--ignore-times",
+                        "--block-size=700",
+                        "--relative",
+                        "--recursive",
+                        "-v",
+                    ],
+            });
+
+A fuller example showing most of the parameters and qw() for the
+rsyncArgs is:
+
+    my $rs = File::RsyncP->new({
+                logLevel   => 1,
+                rsyncCmd => ["/bin/rsh", $host,  "-l", $user, "/bin/rsync"],
+                rsyncArgs  => [qw(
+                        --numeric-ids
+                        --perms
+                        --owner
+                        --group
+                        --devices
+                        --links
+                        --ignore-times
+                        --block-size=700
+                        --relative
+                        --recursive
+                        -v
+                    )],
+                logHandler => sub {
+			my($str) = @_;    
+			print MyHandler "log: $str\n";
+		    };
+                fio        => File::RsyncP::FileIO->new({
+                                logLevel   => 1,
+                            });
+
+            });
+
+=head2 Talking to a remote Rsync
+
+File::RsyncP can talk to a remote rsync using this sequence of
+functions:
+
+=over 4
+
+=item remoteStart(remoteSend, remoteDir)
+
+Starts the remote server by executing the command specified
+in the rsyncCmd parameter to File::RsyncP->new, together with
+the rsyncArgs.
+
+If the client is receiving files from the server then remoteSend should
+be non-zero and remoteDir is the source directory on the remote machine.
+If the client is sending files to the remote server then remoteSend should
+be zero and remoteDir is the destination directory on the remote machine.
+Returns undef on success and non-zero on error.
+
+=item go(localDir)
+
+Run the client rsync.  localDir is the source directory on the
+local machine if the client is sending files, or it is the
+destination directory on the local machine if the client is
+receiving files.  Returns undef on success.
+
+=item serverClose()
+
+Call this after go() to finish up.  Returns undef on success.
+
+=item statsFinal()
+
+This can be optionally called to pickup the transfer stats.  It
+returns a hashref containing elements totalRead, totalWritten,
+totalSize, plus whatever the FileIO module might add.
+
+=item abort()
+
+Call this function to abort the transfer.
+
+=back
+
+An example of sending files to a remote rsync is:
+
+    #
+    # Send files to remote destDirectory from local srcDirectory
+    # by running rsyncCmd with rsyncArgs.
+    #
+    $rs->remoteStart(0, destDirectory);
+    $rs->go(srcDirectory);
+    $rs->serverClose;
+
+An example of receiving files from a remote rsync is:
+
+    #
+    # Receive files from remote srcDirectory to local destDirectory
+    # by running rsyncCmd with rsyncArgs.
+    #
+    $rs->remoteStart(1, srcDirectory);
+    $rs->go(destDirectory);
+    $rs->serverClose;
+
+=head2 Talking to a remote Rsync daemon
+
+File::RsyncP can connect to a remote Rsync daemon using this
+sequence of functions:
+
+=over 4
+
+=item serverConnect(host, port)
+
+Connect to the Rsync daemon on the given string host and integer
+port. The port argument is optional and it defaults to 873. On
+error serverConnect returns a string error message. On success it
+returns undef.
+
+=item serverService(module, authUser, authPasswd, authRequired)
+
+Specify which module to use (a "module" is the symbolic name that
+appears inside "[...]" /etc/rsyncd.conf), the user's credentials
+(authUser and authPasswd) and whether authorization is mandatory
+(authRequired). If set to a non-zero value, authRequired ensures
+that the remote Rsync daemon requires authentication.  If necessary,
+this is to ensure that you don't connect to an insecure Rsync daemon.
+The auth arguments are optional if the selected rsyncd module doesn't
+require authentication.
+
+See the rsyncd.conf manual page for more information.  For example, if a
+host called navajo had a /etc/rsyncd.conf contains these lines:
+
+   [test]
+           path = /data/test
+           comment = test module
+           auth users = craig, celia
+           secrets file = /etc/rsyncd.secrets
+
+and /etc/rsyncd.secrets contained:
+
+    craig:xxx
+
+then you could connect to this rsyncd using:
+
+    $rs->serverConnect("navajo", 873);
+    $rs->serverService("test", "craig", "xxx", 0);
+
+The value of the authRequired argument doesn't matter in this case.
+
+On error serverService returns a string error message.
+On success it returns undef.
+
+=item serverStart(remoteSend, remoteDir)
+
+Starts the remote server.  If the client is receiving files from
+the server then remoteSend should be non-zero.  If the client is
+sending files to the remote server then remoteSend should be zero.
+The remoteDir typically starts with the module name, followed by
+any directory below the module.  Or remoteDir can be just "."
+to refer to the top-level module directory.
+Returns undef on success.
+
+=item go(localDir)
+
+Run the client rsync.  localDir is the source directory on the
+local machine if the client is sending files, or it is the
+destination directory on the local machine if the client is
+receiving files.  Returns undef on success.
+
+=item serverClose()
+
+Call this after go() to finish up.  Returns undef on success.
+
+=item abort()
+
+Call this function to abort the transfer.
+
+=back
+
+An example of sending files to a remote rsyncd daemon is:
+
+    #
+    # Send files to a remote module from a local srcDirectory by
+    # connecting to an rsyncd server.  ($module is the name from
+    # /etc/rsyncd.conf.)
+    #
+    my $port = 873;
+    $rs->serverConnect($host, $port);
+    $rs->serverService($module, $authUser, $authPasswd);
+    $rs->serverStart(0, ".");
+    $rs->go(srcDirectory);
+    $rs->serverClose;
+
+An example of receiving files from a remote rsyncd daemon is:
+
+    #
+    # Receive files from a remote module to local destDirectory by
+    # connecting to an rsyncd server.  ($module is the name from
+    # /etc/rsyncd.conf.)
+    #
+    my $port = 873;
+    $rs->serverConnect($host, $port);
+    $rs->serverService($module, $authUser, $authPasswd);
+    $rs->serverStart(1, ".");
+    $rs->go(destDirectory);
+    $rs->serverClose;
+
+=head1 LIMITATIONS
+
+The initial version of File::RsyncP (0.10) has a number of limitations:
+
+=over 4
+
+=item *
+
+File::RsyncP only implements a modest subset of Rsync options and
+features.  In particular, as of 0.10 only these options are supported:
+
+        --numeric-ids
+        --perms|-p
+        --owner|-o
+        --group|-g
+        --devices|D
+        --links|-l
+        --ignore-times|I
+        --inplace
+        --block-size=i
+        --verbose|-v
+        --recursive|-r
+        --relative|-R
+
+Hardlinks are currently not supported.  Other options that only
+affect the remote side will work correctly since they are passed
+to the remote Rsync unchanged.
+
+=item *
+
+Also, --relative semantics are not implemented to match rsync,
+and the trailing "/" behavior of rsync (meaning directory contents,
+not the directory itself) are not implemented in File::RsyncP.
+
+=item *
+
+File::RsyncP does not yet provide a command-line interface that mimics
+native Rsync.
+
+=item *
+
+File::RsyncP might work with slightly earlier versions of Rsync
+but has not been tested.  It certainly will not work with antique
+versions of Rsync.
+
+=item *
+
+File::RsyncP does not implement exclude or include options when
+sending files.  File::RsyncP does handle exclude and include options
+when receiving files.
+
+=item *
+
+File::RsyncP does not yet implement server functionality (acting like
+the remote end of a connection or a daemon).  Since the protocol is
+relatively symmetric this is not difficult to add, so it should appear
+in a future version.
+
+=back
+
+=head1 AUTHOR
+
+File::RsyncP::FileList was written by Craig Barratt
+<cbarratt@users.sourceforge.net> based on rsync 2.5.5.
+
+Rsync was written by Andrew Tridgell <tridge@samba.org>
+and Paul Mackerras.  It is available under a GPL license.
+See http://rsync.samba.org.
+
+=head1 LICENSE
+
+This program is free software; you can redistribute it and/or modify it
+under the terms of the GNU General Public License as published by the
+Free Software Foundation; either version 2 of the License, or (at your
+option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+General Public License for more details.
+
+You should have received a copy of the GNU General Public License in the
+LICENSE file along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
+
+=head1 SEE ALSO
+
+See L<http://perlrsync.sourceforge.net> for File::RsyncP's SourceForge
+home page.
+
+See L<File::RsyncP::FileIO>, L<File::RsyncP::Digest>, and
+L<File::RsyncP::FileList>.
+
+Also see BackupPC's lib/BackupPC/Xfer/Rsync.pm for other examples.
+
+=cut
@@ -0,0 +1,431 @@
+#============================================================= -*-perl-*-
+#
+# File::RsyncP::CsumCache package
+#
+# DESCRIPTION
+#   On-disk cache of the seed-independent block digest state for
+#   File::RsyncP::FileIO.
+#
+# AUTHOR
+#   Craig Barratt  <cbarratt@users.sourceforge.net>
+#
+# COPYRIGHT
+#   File::RsyncP is Copyright (C) 2002-2010  Craig Barratt.
+#
+#   This program is free software; you can redistribute it and/or modify
+#   it under the terms of the GNU General Public License as published by
+#   the Free Software Foundation; either version 2 of the License, or
+#   (at your option) any later version.
+#
+#   This program is distributed in the hope that it will be useful,
+#   but WITHOUT ANY WARRANTY; without even the implied warranty of
+#   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#   GNU General Public License for more details.
+#
+#   You should have received a copy of the GNU General Public License
+#   along with this program; if not, write to the Free Software
+#   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+#
+#========================================================================
+#
+# Version 0.70, released 25 Jul 2010.
+#
+# See http://perlrsync.sourceforge.net.
+#
+#========================================================================
+
+package File::RsyncP::CsumCache;
+
+use strict;
+use File::Path;
+use File::RsyncP::Digest;
+
+use vars qw($VERSION);
+$VERSION = '0.70';
+
+#
+# Each directory's store starts with a fixed length magic string and
+# ends with the index and a trailer giving the index offset and length
+#
+use constant HEADER_LEN   => 32;
+use constant HEADER_MAGIC => "RsyncP csum cache 2\n";
+use constant TRAILER_LEN  => 16;
+
+sub new
+{
+    my($class, $dir) = @_;
+
+    my $cache = bless {
+        dir    => $dir,
+        hits   => 0,
+        misses => 0,
+    }, $class;
+    return $cache;
+}
+
+#
+# The store for a source directory is named by the MD4 digest of the
+# directory's name, in one of 256 subdirectories so no directory gets
+# too big.
+#
+sub storePath
+{
+    my($cache, $srcDir) = @_;
+    my $md4 = File::RsyncP::Digest->new(28);
+
+    $md4->add($srcDir);
+    my $hex = unpack("H*", $md4->digest);
+    return sprintf("%s/%s/%s", $cache->{dir}, substr($hex, 0, 2), $hex);
+}
+
+#
+# Switch to the store for the directory of $path, saving any new
+# entries for the previous directory first.  The index of the store
+# is read once, so every file in the directory is looked up without
+# opening anything else.
+#
+sub dirSet
+{
+    my($cache, $path) = @_;
+    my($srcDir, $name) = $path =~ m{^(.*)/([^/]*)$} ? ($1, $2) : (".", $path);
+    local(*F);
+
+    return $name if ( defined($cache->{srcDir}) && $cache->{srcDir} eq $srcDir );
+    $cache->flush;
+    $cache->{srcDir} = $srcDir;
+    $cache->{store}  = $cache->storePath($srcDir);
+    $cache->{index}  = {};
+    $cache->{new}    = {};
+    return $name if ( !CORE::open(F, "<", $cache->{store}) );
+    binmode(F);
+    my($hdr, $trailer, $index);
+    my $size = -s F;
+    if ( $size >= HEADER_LEN + TRAILER_LEN
+            && sysread(F, $hdr, HEADER_LEN) == HEADER_LEN
+            && $hdr eq HEADER_MAGIC . ("\0" x (HEADER_LEN - length(HEADER_MAGIC)))
+            && sysseek(F, $size - TRAILER_LEN, 0)
+            && sysread(F, $trailer, TRAILER_LEN) == TRAILER_LEN ) {
+        my($lo, $hi, $len) = unpack("V3", $trailer);
+        my $offset = $hi * 4294967296 + $lo;
+        if ( $offset + $len + TRAILER_LEN == $size
+                && sysseek(F, $offset, 0)
+                && sysread(F, $index, $len) == $len ) {
+            my @e = unpack("(n/a* w7)*", $index);
+            while ( @e ) {
+                my($n, @attr) = splice(@e, 0, 8);
+                $cache->{index}{$n} = \@attr;
+            }
+            $cache->{fh} = *F;
+            return $name;
+        }
+    }
+    CORE::close(F);
+    return $name;
+}
+
+#
+# Open the cache entry for the file $path with stat() info $st, if
+# the entry has the same device, inode, size, mtime and block size.
+# Returns an entry to pass to read(), or undef on a miss.
+#
+sub open
+{
+    my($cache, $path, $st, $blockSize) = @_;
+    my $name = $cache->dirSet($path);
+    my $new  = $cache->{new}{$name};
+    my $a    = $new || $cache->{index}{$name};
+    my $fh   = $new ? $cache->{newFh} : $cache->{fh};
+
+    #
+    # $a is [dev, inode, size, mtime, blockSize, offset, length]
+    #
+    if ( !defined($a) || !defined($fh)
+            || $a->[0] != $st->[0] || $a->[1] != $st->[1]
+            || $a->[2] != $st->[7] || $a->[3] != $st->[9]
+            || $a->[4] != $blockSize ) {
+        $cache->{misses}++;
+        return;
+    }
+    $cache->{hits}++;
+    return {
+        fh        => $fh,
+        blockSize => $blockSize,
+        size      => $st->[7],
+        offset    => 0,
+        posn      => $a->[5],
+    };
+}
+
+#
+# Return the cached state for up to $num blocks from an entry
+# returned by open(), and the length of the last of those blocks.
+# The state can be passed to File::RsyncP::Digest->blockDigestUpdate.
+# Returns an empty list at the end of the file or on error.
+#
+sub read
+{
+    my($cache, $e, $num) = @_;
+    my($state, $len, $lastLen);
+    my $blockSize = $e->{blockSize};
+
+    return if ( $e->{offset} >= $e->{size} );
+    $len = $e->{size} - $e->{offset};
+    $len = $num * $blockSize if ( $len > $num * $blockSize );
+    $num = int(($len + $blockSize - 1) / $blockSize);
+    $lastLen = $len - ($num - 1) * $blockSize;
+    my $stateLen = (20 + $blockSize % 64) * ($num - 1)
+                 + 20 + $lastLen % 64;
+    return if ( !sysseek($e->{fh}, $e->{posn}, 0)
+             || sysread($e->{fh}, $state, $stateLen) != $stateLen );
+    $e->{offset} += $len;
+    $e->{posn}   += $stateLen;
+    return ($state, $lastLen);
+}
+
+#
+# Start a new cache entry for the file $path with stat() info $st.
+# The state (from blockDigest with a digest length of -1 and a
+# zero seed) is added with write() and the entry is only kept
+# if close() is called with $commit set.  New entries are written
+# to a new store for the directory, which flush() completes.
+#
+sub create
+{
+    my($cache, $path, $st, $blockSize) = @_;
+    my $name = $cache->dirSet($path);
+    local(*F);
+
+    return if ( grep($_ < 0, @$st[0, 1, 7, 9]) );
+    if ( !defined($cache->{newFh}) ) {
+        my $dir = $cache->{store};
+
+        $dir =~ s{/[^/]*$}{};
+        File::Path::mkpath($dir, 0, 0700) if ( !-d $dir );
+        return if ( !CORE::open(F, "+>", "$cache->{store}.$$") );
+        binmode(F);
+        if ( syswrite(F, HEADER_MAGIC . ("\0" x (HEADER_LEN
+                                - length(HEADER_MAGIC)))) != HEADER_LEN ) {
+            CORE::close(F);
+            unlink("$cache->{store}.$$");
+            return;
+        }
+        $cache->{newFh}   = *F;
+        $cache->{newPosn} = HEADER_LEN;
+        $cache->{newPid}  = $$;
+    }
+    return {
+        name  => $name,
+        attr  => [$st->[0], $st->[1], $st->[7], $st->[9], $blockSize],
+        start => $cache->{newPosn},
+        write => 1,
+    };
+}
+
+sub write
+{
+    my($cache, $e, $state) = @_;
+
+    return if ( !$e->{write} || $e->{error} );
+    #
+    # Entries in the new store can be read, so seek back to its end
+    #
+    if ( !sysseek($cache->{newFh}, $cache->{newPosn}, 0)
+            || syswrite($cache->{newFh}, $state) != length($state) ) {
+        $e->{error} = 1;
+    } else {
+        $cache->{newPosn} += length($state);
+    }
+}
+
+sub close
+{
+    my($cache, $e, $commit) = @_;
+
+    return if ( !$e->{write} || $e->{closed}++ );
+    if ( $commit && !$e->{error} ) {
+        $cache->{new}{$e->{name}} = [@{$e->{attr}}, $e->{start},
+                                     $cache->{newPosn} - $e->{start}];
+    } else {
+        #
+        # Drop the partial entry's state from the new store
+        #
+        truncate($cache->{newFh}, $e->{start});
+        sysseek($cache->{newFh}, $e->{start}, 0);
+        $cache->{newPosn} = $e->{start};
+    }
+}
+
+#
+# Complete the new store for the current directory, if any entries
+# were added: the old entries that weren't replaced are copied over
+# (unless their file has gone), the index and trailer are written and
+# the new store is renamed into place.  Then close the current store.
+#
+sub flush
+{
+    my($cache) = @_;
+
+    if ( defined($cache->{newFh}) && $cache->{newPid} == $$ ) {
+        my $fh  = $cache->{newFh};
+        my $ok  = 1;
+        my %new = %{$cache->{new}};
+
+        foreach my $name ( sort(keys(%{$cache->{index}})) ) {
+            my $a = $cache->{index}{$name};
+            next if ( $new{$name} || !defined($cache->{fh})
+                   || !-e "$cache->{srcDir}/$name" );
+            my($data, $done) = ("", 0);
+            $ok = 0 if ( !sysseek($cache->{fh}, $a->[5], 0) );
+            while ( $ok && $done < $a->[6] ) {
+                my $len = $a->[6] - $done;
+                $len = 1 << 20 if ( $len > 1 << 20 );
+                if ( sysread($cache->{fh}, $data, $len) != $len
+                        || syswrite($fh, $data) != $len ) {
+                    $ok = 0;
+                }
+                $done += $len;
+            }
+            last if ( !$ok );
+            $new{$name} = [@$a[0..4], $cache->{newPosn}, $a->[6]];
+            $cache->{newPosn} += $a->[6];
+        }
+        my $index = pack("(n/a* w7)*", map { ($_, @{$new{$_}}) }
+                                           sort(keys(%new)));
+        my $offset = $cache->{newPosn};
+        $ok = 0 if ( !$ok || !%{$cache->{new}}
+                   || syswrite($fh, $index) != length($index)
+                   || syswrite($fh, pack("V4", $offset % 4294967296,
+                                         int($offset / 4294967296),
+                                         length($index), 0)) != TRAILER_LEN );
+        CORE::close($fh);
+        if ( $ok ) {
+            rename("$cache->{store}.$$", $cache->{store});
+        } else {
+            unlink("$cache->{store}.$$");
+        }
+    }
+    CORE::close($cache->{fh}) if ( defined($cache->{fh}) );
+    delete(@$cache{qw(fh newFh newPosn newPid srcDir store index new)});
+}
+
+sub statsGet
+{
+    my($cache) = @_;
+
+    return {
+        csumCacheHits   => $cache->{hits},
+        csumCacheMisses => $cache->{misses},
+    };
+}
+
+sub DESTROY
+{
+    my($cache) = @_;
+
+    $cache->flush;
+}
+
+1;
+__END__
+
+=head1 NAME
+
+File::RsyncP::CsumCache - On-disk cache of rsync block digest state
+
+=head1 SYNOPSIS
+
+    use File::RsyncP::FileIO;
+
+    my $fio = File::RsyncP::FileIO->new({
+                    csumCacheDir => "/var/cache/rsyncp",
+                });
+
+=head1 DESCRIPTION
+
+File::RsyncP::CsumCache saves the seed-independent block digest state
+of files (File::RsyncP::Digest->blockDigest with a digest length of
+-1 and a zero seed), so the block digests of an unchanged file can be
+generated with blockDigestUpdate, without reading the file.
+
+It is used by File::RsyncP::FileIO when the csumCacheDir option is set.
+The entries for all the files in a source directory are kept in one
+store, named by the digest of the directory name.  A store holds the
+state of each file, followed by an index (file name, device, inode,
+size, mtime, block size and the position of the state) that is read
+once when the first file in the directory is looked up.  So checking
+an unchanged tree costs one open per directory, rather than one per
+file, and the cache only uses one inode per directory.
+
+An entry is only used if the file's device, inode, size and mtime
+and the block size all match; otherwise it is replaced the next time
+the file's checksums are generated.  New entries are written to a
+temporary copy of the store, which is completed (with the old entries
+that weren't replaced, except for files that no longer exist) and
+renamed into place by flush() when the next directory is used or the
+FileIO finishes.  An entry is only added once the whole file has been
+read, so a partial entry is never used.  Files are best looked up a
+directory at a time, as File::RsyncP does, since a store is rewritten
+each time its directory is left after a miss.
+
+Like rsync without --ignore-times, this assumes a file whose size and
+mtime have not changed has the same contents.
+
+=over 4
+
+=item new($dir)
+
+Create a cache in the directory $dir.
+
+=item open($path, $st, $blockSize)
+
+Return the cache entry for the file $path with stat() information $st
+(an arrayref), or undef if there is no valid entry.
+
+=item read($entry, $num)
+
+Return the cached state for the next $num blocks, and the length of
+the last of those blocks.
+
+=item create($path, $st, $blockSize)
+
+Start a new cache entry.  The state is added with write($entry, $state)
+and the entry is saved with close($entry, 1).
+
+=item close($entry, $commit)
+
+Close an entry.  A new entry is only saved if $commit is set.
+
+=item flush
+
+Save the new entries for the current directory's store.  This is
+called by FileIO's finish(), and when the cache is destroyed.
+
+=item statsGet
+
+Return a hashref with the number of cache hits and misses.
+
+=back
+
+=head1 AUTHOR
+
+File::RsyncP::CsumCache was written by Craig Barratt
+<cbarratt@users.sourceforge.net> based on rsync.
+
+=head1 LICENSE
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+=head1 SEE ALSO
+
+See L<File::RsyncP>, L<File::RsyncP::FileIO> and
+L<File::RsyncP::Digest>.
+
+=cut
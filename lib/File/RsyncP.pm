@@ -46,8 +46,10 @@ use Socket;
 use File::RsyncP::Digest;
 use File::RsyncP::FileIO;
 use File::RsyncP::FileList;
+use File::RsyncP::Mux;
+use Scalar::Util qw(weaken);
+use Storable qw(nfreeze thaw);
 use Getopt::Long;
-use Data::Dumper;
 use Config;
 use Encode qw/from_to/;
 use Fcntl;
@@ -64,6 +66,21 @@ use constant S_IFLNK      => 0120000; 	# symbolic link
 use constant S_IFSOCK     => 0140000; 	# socket
 use constant S_IFIFO      => 0010000; 	# fifo
 
+#
+# Message codes from the child to the parent, sent with the rsync
+# multiplexing header (see File::RsyncP::Mux)
+#
+use constant CHILD_DONE   => 1;		# end of phase 0
+use constant CHILD_REDO   => 2;		# packed file numbers to redo
+use constant CHILD_STATS  => 3;		# final stats
+use constant CHILD_LOG    => 4;		# log message
+use constant CHILD_EXIT   => 5;		# child has finished
+
+#
+# Message from the parent to the child (with exactMatchDigest "parent")
+#
+use constant PARENT_DIGEST => 1;	# phase, file number and MD4 digest
+
 sub new
 {
     my($class, $options) = @_;
@@ -73,6 +90,7 @@ sub new
         protocol_version => 28,
 	logHandler       => \&logHandler,
 	abort		 => 0,
+	csumPrefetch     => 8,
 	%$options,
     }, $class;
 
@@ -130,6 +148,7 @@ sub new
 		    "group|g",
 		    "hard-links|H",
 		    "ignore-times|I",
+		    "inplace",
 		    "links|l",
 		    "numeric-ids",
 		    "owner|o",
@@ -151,6 +170,7 @@ sub new
 			logLevel            => $rs->{logLevel},
                         protocol_version    => $rs->{protocol_version},
                         preserve_hard_links => $rs->{rsyncOpts}{"hard-links"},
+			inplace             => $rs->{rsyncOpts}{inplace},
 			clientCharset       => $rs->{clientCharset},
 		    });
 	eval { $rs->{fio_version} = $rs->{fio}->version; };
@@ -164,6 +184,8 @@ sub new
 	if ( $rs->{fio_version} >= 2 ) {
 	    $rs->{fio}->protocol_version($rs->{protocol_version});
 	    $rs->{fio}->preserve_hard_links($rs->{rsyncOpts}{"hard-links"});
+	    $rs->{fio}->inplace($rs->{rsyncOpts}{inplace})
+			if ( $rs->{fio}->can("inplace") );
 	} else {
 	    #
 	    # old version of FileIO: only supports version 26
@@ -232,6 +254,7 @@ sub serverConnect
 				    || return "inet socket: $!";
     connect(FH, $paddr)             || return "inet connect: $!";
     $rs->{fh} = *FH;
+    $rs->muxStart;
     $rs->writeData("\@RSYNCD: $rs->{protocol_version}\n", 1);
     my $line = $rs->getLine;
     alarm(0) if ( $rs->{timeout} );
@@ -386,6 +409,7 @@ sub remoteStart
     }
     close(RSYNC);
     $rs->{fh} = *FH;
+    $rs->muxStart;
     $rs->{rsyncPID} = $pid;
     $rs->{pidHandler}->($rs->{rsyncPID}, $rs->{childPID})
 			if ( defined($rs->{pidHandler}) );
@@ -396,9 +420,8 @@ sub remoteStart
     $rs->log("Rsync command pid is $pid") if ( $rs->{logLevel} >= 3 );
     $rs->log("Fetching remote protocol") if ( $rs->{logLevel} >= 5 );
     return -1 if ( $rs->getData(4) < 0 );
-    my $data = $rs->{readData};
-    my $version = unpack("V", $rs->{readData});
-    $rs->{readData} = substr($rs->{readData}, 4);
+    my $data = $rs->{reader}->rawGet(4);
+    my $version = unpack("V", $data);
     $rs->{remote_protocol} = $version;
     $rs->log("Got remote protocol $version") if ( $rs->{logLevel} >= 1 );
     $rs->{protocol_version} = $rs->{remote_protocol}
@@ -421,6 +444,8 @@ sub serverClose
     return if ( !defined($rs->{fh}) );
     close($rs->{fh});
     $rs->{fh} = undef;
+    $rs->{reader}->fd(-1) if ( defined($rs->{reader}) );
+    $rs->{writer}->fd(-1) if ( defined($rs->{writer}) );
 }
 
 sub go
@@ -429,8 +454,7 @@ sub go
 
     my $remoteDir = $rs->{remoteDir};
     return $rs->{fatalErrorMsg} if ( $rs->getData(4) < 0 );
-    $rs->{checksumSeed} = unpack("V", $rs->{readData});
-    $rs->{readData} = substr($rs->{readData}, 4);
+    $rs->{checksumSeed} = unpack("V", $rs->{reader}->rawGet(4));
     $rs->{fio}->checksumSeed($rs->{checksumSeed});
     $rs->{fio}->dirs($localDir, $remoteDir);
     $rs->log(sprintf("Got checksumSeed 0x%x", $rs->{checksumSeed}))
@@ -471,7 +495,7 @@ sub go
         #
         # Skip a word: this is the io_error flag.
         #
-	$rs->{chunkData} = substr($rs->{chunkData}, 4);
+	$rs->{reader}->dataSkip(4);
 
 	#
 	# If this is a partial, then check which files we are
@@ -479,6 +503,28 @@ sub go
 	#
 	$rs->partialFileListPopulate() if ( $rs->{doPartial} );
 
+	if ( $rs->{inProcess} ) {
+	    #
+	    # Generate the checksums and receive the file deltas in this
+	    # process, sharing the file list and FileIO object.  The
+	    # receiver runs whenever the generator would wait (see
+	    # receiverPoll).
+	    #
+	    # Like the child, the receiver's FileIO messages go to our log.
+	    #
+	    $rs->{fio}->logHandlerSet(sub { $rs->log($_[0]); });
+	    $rs->nonBlockSet($rs->{fh});
+	    $rs->{childDone} = 0;
+	    $rs->{rxPhase}   = 0;
+	    $rs->fileCsumSend(0);
+	    $rs->fileCsumSend(1);
+	    $rs->{fatalErrorMsg} = $rs->{abortReason}
+		    if ( $rs->{abort} && !defined($rs->{fatalErrorMsg}) );
+	    $rs->{fio}->finish(0);
+	    return $rs->{fatalErrorMsg} if ( defined($rs->{fatalErrorMsg}) );
+	    return;
+	}
+
         #
         # Dup the $rs->{fh} socket file handle into two pieces: read-only
         # and write-only.  The child gets the read-only handle and
@@ -489,8 +535,10 @@ sub go
         local(*RH, *WH, *FHWr, *FHRd);
 
 	socketpair(RH, WH, AF_UNIX, SOCK_STREAM, PF_UNSPEC);
-	shutdown(RH, 1);
-	shutdown(WH, 0);
+	if ( $rs->{exactMatchDigest} ne "parent" ) {
+	    shutdown(RH, 1);
+	    shutdown(WH, 0);
+	}
 
         open(FHWr, ">&$rs->{fh}");
         open(FHRd, "<&$rs->{fh}");
@@ -502,31 +550,30 @@ sub go
             # If a file needs to be repeated in phase 2 we send
             # the file into the the parent via the pipe.
 	    #
+	    # Messages to the parent are queued in a File::RsyncP::Mux::Writer
+	    # and sent whenever we are about to wait for data.
+	    #
 	    # First the log handler for both us and fio has to forward
 	    # to the parent, so redefine them.
 	    #
-	    $rs->{logHandler} = sub {
-			my($str) = @_;    
-                        $str =~ s/\n/\\n/g;
-                        $str =~ s/\r/\\r/g;
-			print WH "log $str\n";
-		    };
-	    $rs->{fio}->logHandlerSet(sub {
-			my($str) = @_;    
-                        $str =~ s/\n/\\n/g;
-                        $str =~ s/\r/\\r/g;
-			print WH "log $str\n";
-		    });
+	    $rs->{childWriter} = File::RsyncP::Mux::Writer->new(fileno(WH));
+	    if ( $rs->{exactMatchDigest} eq "parent" ) {
+		$rs->{parentReader} = File::RsyncP::Mux::Reader->new(
+			fileno(WH), sub { $rs->parentMessage(@_); });
+	    }
+	    $rs->{logHandler} = sub { $rs->receiverEvent(*WH, "log", @_); };
+	    $rs->{fio}->logHandlerSet($rs->{logHandler});
             close(RH);
             close(FHWr);
             $rs->{fh} = *FHRd;
+            $rs->{reader}->fd(fileno($rs->{fh}));
+            $rs->{writer}->fd(fileno($rs->{fh}));
 	    setsockopt($rs->{fh}, SOL_SOCKET, SO_RCVBUF, 8 * 65536);
 	    setsockopt(WH, SOL_SOCKET, SO_SNDBUF, 8 * 65536);
-            my $oldFH = select(WH); $| = 1; select($oldFH);
             $rs->fileDeltaGet(*WH, 0);
             $rs->log("Child is sending done")
 			    if ( $rs->{logLevel} >= 5 );
-            print(WH "done\n");
+            $rs->receiverEvent(*WH, "done");
             $rs->fileDeltaGet(*WH, 1) if ( !$rs->{abort} );
             #
             # Get stats
@@ -538,28 +585,34 @@ sub go
             $rs->writeData(pack("V", 0xffffffff), 1);
 	    $rs->{fio}->finish(1);
             $rs->log("Child is aborting") if ( $rs->{abort} );
-            print(WH "exit\n");
+            $rs->receiverEvent(*WH, "exit");
             exit(0);
         }
         close(WH);
         close(FHRd);
         $rs->{fh} = *FHWr;
+        $rs->{reader}->fd(-1);
+        $rs->{writer}->fd(fileno($rs->{fh}));
+	my $rsWeak = $rs;
+	weaken($rsWeak);
+	$rs->{childReader} = File::RsyncP::Mux::Reader->new(fileno(RH),
+			    sub { $rsWeak->childMessage(@_) if ( $rsWeak ); });
 
 	#
 	# Make our write handle non-blocking
 	#
-	my $flags = '';
-	if ( fcntl($rs->{fh}, F_GETFL, $flags) ) {
-	    $flags |= O_NONBLOCK;
-	    if ( !fcntl($rs->{fh}, F_SETFL, $flags) ) {
-		$rs->log("Parent fcntl(F_SETFL) failed; non-block set failed");
-	    }
-	} else {
-	    $rs->log("Parent fcntl(F_GETFL) failed; non-block failed");
-	}
+	$rs->nonBlockSet($rs->{fh});
 
 	$rs->{childFh}  = *RH;
 	$rs->{childPID} = $pid;
+	if ( $rs->{exactMatchDigest} eq "parent" ) {
+	    #
+	    # We send file digests to the child, without blocking
+	    #
+	    $rs->{childDigestWriter} = File::RsyncP::Mux::Writer->new(fileno(RH));
+	    my $flags = fcntl(RH, F_GETFL, 0);
+	    fcntl(RH, F_SETFL, $flags | O_NONBLOCK) if ( defined($flags) );
+	}
 	$rs->log("Child PID is $pid") if ( $rs->{logLevel} >= 2 );
 	$rs->{pidHandler}->($rs->{rsyncPID}, $rs->{childPID})
 			    if ( defined($rs->{pidHandler}) );
@@ -629,6 +682,21 @@ sub go
     }
 }
 
+sub nonBlockSet
+{
+    my($rs, $fh) = @_;
+
+    my $flags = '';
+    if ( fcntl($fh, F_GETFL, $flags) ) {
+	$flags |= O_NONBLOCK;
+	if ( !fcntl($fh, F_SETFL, $flags) ) {
+	    $rs->log("Parent fcntl(F_SETFL) failed; non-block set failed");
+	}
+    } else {
+	$rs->log("Parent fcntl(F_GETFL) failed; non-block failed");
+    }
+}
+
 #
 # When a partial rsync is done (meaning selective per-file ignore-attr)
 # we pass through the file list and remember which files we should
@@ -719,24 +787,25 @@ sub fileListReceive
     #
     my $curr = 0;
     while ( !$rs->{fileList}->decodeDone ) {
-        return -1 if ( $rs->{chunkData} eq "" && $rs->getChunk(1) < 0 );
-        my $cnt = $rs->{fileList}->decode($rs->{chunkData});
+        return -1 if ( $rs->{reader}->dataLen == 0 && $rs->getChunk(1) < 0 );
+        my $cnt = $rs->{fileList}->decode($rs->{reader}->dataPeek);
 	return -1 if ( $rs->{fileList}->fatalError );
 	if ( $rs->{logLevel} >= 4 ) {
 	    my $end = $rs->{fileList}->count;
-	    while ( $curr < $end ) {
-		my $f = $rs->{fileList}->get($curr);
-		next if ( !defined($f) );
-                from_to($f->{name}, $rs->{clientCharset}, "utf8")
-                                        if ( $rs->{clientCharset} ne "" );
-		$rs->log("Got file ($curr of $end): $f->{name}");
+	    foreach my $name ( $rs->{fileList}->fieldGet("name", $curr,
+							  $end - $curr) ) {
+		if ( defined($name) ) {
+		    from_to($name, $rs->{clientCharset}, "utf8")
+					if ( $rs->{clientCharset} ne "" );
+		    $rs->log("Got file ($curr of $end): $name");
+		}
 		$curr++;
 	    }
 	}
         if ( $cnt > 0 ) {
-            $rs->{chunkData} = substr($rs->{chunkData}, $cnt);
+            $rs->{reader}->dataSkip($cnt);
 	    return -1 if ( !$rs->{fileList}->decodeDone
-			&& $rs->getChunk(length($rs->{chunkData}) + 1) < 0 );
+			&& $rs->getChunk($rs->{reader}->dataLen + 1) < 0 );
         }
     }
 
@@ -796,46 +865,40 @@ sub fileCsumSend
 {
     my($rs, $phase) = @_;
     my $csumLen = $phase == 0 ? 2 : 16;
-    my $ignoreAttr = $rs->{rsyncOpts}{"ignore-times"};
+    my $needMD4 = $rs->{exactMatchDigest} eq "parent" ? 1 : 0;
 
     $rs->{phase} = $phase;
-    my $cnt = $rs->{fileList}->count;
-    $rs->{doList} = [0..($cnt-1)] if ( $phase == 0 );
+    #
+    # Only regular files get checksums, so the others are skipped
+    # without fetching them from the file list.
+    #
+    $rs->{doList} = [$rs->{fileList}->indexGet("reg")] if ( $phase == 0 );
     $rs->{redoList} = [];
+    $rs->{prefetchCnt} = 0;
+    $rs->{prefetchQueue} = [];
     if ( $rs->{logLevel} >= 2 ) {
 	my $cnt = @{$rs->{doList}};
 	$rs->log("Sending csums, cnt = $cnt, phase = $phase");
     }
     while ( @{$rs->{doList}} || $phase == 1 && $rs->{childDone} < 3 ) {
 	if ( @{$rs->{doList}} ) {
+	    $rs->csumPrefetch($phase);
 	    my $n = shift(@{$rs->{doList}});
-            my $f = $rs->{fileList}->get($n);
-	    next if ( !defined($f) );
-            from_to($f->{name}, $rs->{clientCharset}, "utf8")
-                                    if ( $rs->{clientCharset} ne "" );
-
-	    if ( $rs->{doPartial} && $rs->{fileList}->flagGet($n) ) {
-		$rs->log("Skipping $f->{name} (same attr on partial)")
-			    if ( $rs->{logLevel} >= 3
-			       && ($f->{mode} & S_IFMT) == S_IFREG );
-		next;
+	    my $file;
+	    if ( $rs->{prefetchCnt} > 0 ) {
+		$rs->{prefetchCnt}--;
+		$file = shift(@{$rs->{prefetchQueue}});
+	    } else {
+		$file = $rs->csumFileGet($n, $phase);
 	    }
+	    my($f, $attr, $skip) = @$file;
+	    next if ( !defined($f) );
 
 	    #
 	    # check if we should skip this file: same type, size, mtime etc
 	    #
-            my $attr = $rs->{fio}->attribGet($f);
-
-	    if ( !$ignoreAttr
-                  && $phase == 0
-		  && $f->{size}  == $attr->{size}
-		  && $f->{mtime} == $attr->{mtime}
-		  && (!$rs->{rsyncOpts}{perms} || $f->{mode} == $attr->{mode})
-		  && (!$rs->{rsyncOpts}{group} || $f->{gid} == $attr->{gid})
-		  && (!$rs->{rsyncOpts}{owner} || $f->{uid} == $attr->{uid})
-                  && (!$rs->{rsyncOpts}{"hard-links"}
-                            || $f->{hlink_self} == $attr->{hlink_self}) ) {
-		$rs->log("Skipping $f->{name} (same attr)")
+	    if ( defined($skip) ) {
+		$rs->log("Skipping $f->{name} ($skip)")
 			    if ( $rs->{logLevel} >= 3
 			       && ($f->{mode} & S_IFMT) == S_IFREG );
 		next;
@@ -865,14 +928,16 @@ sub fileCsumSend
 		$rs->log("Sending empty csums for $f->{name}")
 				    if ( $rs->{logLevel} >= 5 );
                 $rs->write_sum_head($n, 0, $rs->{blockSize}, $csumLen, 0);
-            } elsif ( ($blkSize = $rs->{fio}->csumStart($f, 0, $rs->{blockSize},
-                                                        $phase)) < 0 ) {
+                $rs->childDigestSend($phase, $n) if ( $needMD4 );
+            } elsif ( ($blkSize = $rs->{fio}->csumStart($f, $needMD4,
+                                        $rs->{blockSize}, $phase)) < 0 ) {
 		#
 		# Can't open the file, so send an empty checksum
 		#
 		$rs->log("Sending empty csums for $f->{name}")
 				    if ( $rs->{logLevel} >= 5 );
                 $rs->write_sum_head($n, 0, $rs->{blockSize}, $csumLen, 0);
+                $rs->childDigestSend($phase, $n) if ( $needMD4 );
 	    } else {
 		#
 		# The local file is a regular file, so generate and
@@ -898,8 +963,14 @@ sub fileCsumSend
                                 ? $attr->{size} - ($blkCnt - 1) * $blkSize
                                 : $attr->{size});
 		my $nWrite = ($csumLen + 4) * $blkCnt;
+		#
+		# Get the checksums at least 256 blocks or 1MB at a time,
+		# so large reads can be split across threads.
+		#
+		my $maxCnt = int(1048576 / $blkSize);
+		$maxCnt = 256 if ( $maxCnt < 256 );
 		while ( $blkCnt > 0 && $nWrite > 0 ) {
-		    my $thisCnt = $blkCnt > 256 ? 256 : $blkCnt;
+		    my $thisCnt = $blkCnt > $maxCnt ? $maxCnt : $blkCnt;
 		    my $csum = $rs->{fio}->csumGet($thisCnt, $csumLen,
 						   $blkSize);
 		    $rs->writeData($csum);
@@ -915,7 +986,8 @@ sub fileCsumSend
                 if ( $nWrite > 0 && !$rs->{abort} ) {
 		    $rs->writeData(pack("c", 0) x $nWrite);
                 }
-		$rs->{fio}->csumEnd;
+		my $md4 = $rs->{fio}->csumEnd;
+                $rs->childDigestSend($phase, $n, $md4) if ( $needMD4 );
 	    }
 	}
 	if ( !@{$rs->{doList}} && $phase == 1 && $rs->{childDone} == 1 ) {
@@ -944,6 +1016,77 @@ sub fileCsumSend
     }
 }
 
+#
+# Returns true if the local file's attributes match the remote file,
+# so it can be skipped (unless --ignore-times is set).
+#
+sub fileSameAttr
+{
+    my($rs, $f, $attr) = @_;
+
+    return $f->{size}  == $attr->{size}
+	&& $f->{mtime} == $attr->{mtime}
+	&& (!$rs->{rsyncOpts}{perms} || $f->{mode} == $attr->{mode})
+	&& (!$rs->{rsyncOpts}{group} || $f->{gid} == $attr->{gid})
+	&& (!$rs->{rsyncOpts}{owner} || $f->{uid} == $attr->{uid})
+	&& (!$rs->{rsyncOpts}{"hard-links"}
+		  || $f->{hlink_self} == $attr->{hlink_self});
+}
+
+#
+# Fetch file $n from the file list and its local attributes, for
+# fileCsumSend.  Returns [$f, $attr, $skip], where $skip is the reason
+# the file can be skipped, or undef.  $attr isn't fetched if the file
+# is skipped because it is partial, and the list is empty if $n isn't
+# in the file list.
+#
+sub csumFileGet
+{
+    my($rs, $n, $phase) = @_;
+
+    my $f = $rs->{fileList}->get($n);
+    return [] if ( !defined($f) );
+    from_to($f->{name}, $rs->{clientCharset}, "utf8")
+			    if ( $rs->{clientCharset} ne "" );
+    return [$f, undef, "same attr on partial"]
+		if ( $rs->{doPartial} && $rs->{fileList}->flagGet($n) );
+    my $attr = $rs->{fio}->attribGet($f);
+    return [$f, $attr, "same attr"]
+		if ( !$rs->{rsyncOpts}{"ignore-times"} && $phase == 0
+		    && $rs->fileSameAttr($f, $attr) );
+    return [$f, $attr];
+}
+
+#
+# Let FileIO start reading the next $rs->{csumPrefetch} files in
+# $rs->{doList} whose checksums will be sent, so the disk reads overlap
+# with sending the checksums of the current file.  The first
+# $rs->{prefetchCnt} entries of $rs->{doList} have already been seen,
+# and their csumFileGet() results are in $rs->{prefetchQueue}.
+#
+sub csumPrefetch
+{
+    my($rs, $phase) = @_;
+    my $doList = $rs->{doList};
+    my $fio    = $rs->{fio};
+
+    return if ( $rs->{csumPrefetch} <= 0 || !$fio->can("csumPrefetch") );
+    while ( $rs->{prefetchCnt} < $rs->{csumPrefetch}
+		&& $rs->{prefetchCnt} < @$doList ) {
+	my $file = $rs->csumFileGet($doList->[$rs->{prefetchCnt}++], $phase);
+	push(@{$rs->{prefetchQueue}}, $file);
+	my($f, $attr, $skip) = @$file;
+	next if ( !defined($f) || defined($skip)
+		    || ($f->{mode} & S_IFMT) != S_IFREG
+		    || $rs->{rsyncOpts}{"hard-links"} && defined($f->{hlink})
+			    && !$f->{hlink_self}
+		    || !defined($attr->{mode})
+		    || ($attr->{mode} & S_IFMT) != S_IFREG
+		    || $attr->{size} == 0 );
+	$fio->csumPrefetch($f, $attr);
+    }
+}
+
 #
 # See if there are any messges from the local child over the pipe.
 # These could be logging messages or requests to repeat files.
@@ -953,19 +1096,22 @@ sub pollChild
     my($rs, $timeout) = @_;
     my($FDread);
 
+    return $rs->receiverPoll($timeout) if ( $rs->{inProcess} );
     return -1 if ( !defined($rs->{childFh}) );
     $rs->log("pollChild($timeout)") if ( $rs->{logLevel} >= 12 );
 
     vec($FDread, fileno($rs->{childFh}), 1) = 1;
     my $ein = $FDread;
+    my $FDwrite;
+    vec($FDwrite, fileno($rs->{childFh}), 1) = 1
+                                if ( $rs->childSendLen );
     #$rs->log("pollChild: select(timeout=$timeout)");
-    select(my $rout = $FDread, undef, $ein, $timeout);
+    select(my $rout = $FDread, my $rwrite = $FDwrite, $ein, $timeout);
+    $rs->childSendFlush
+            if ( defined($FDwrite) && vec($rwrite, fileno($rs->{childFh}), 1) );
     return if ( !vec($rout, fileno($rs->{childFh}), 1) );
-    #$rs->log("pollChild: reading from child");
-    my $nbytes = sysread($rs->{childFh}, my $mesg, 65536);
-    #$rs->log("pollChild: done reading from child");
-    $rs->{childMesg} .= $mesg if ( $nbytes > 0 );
-    if ( $nbytes <= 0 ) {
+    my $n = $rs->{childReader}->fill;
+    if ( $n <= 0 ) {
         close($rs->{childFh});
         delete($rs->{childFh});
 	$rs->log("Parent read EOF from child: fatal error!")
@@ -975,50 +1121,303 @@ sub pollChild
         $rs->{fatalErrorMsg} = "Child exited prematurely";
 	return -1;
     }
+    $rs->log("Parent read: " . unpack("H*", $rs->{childReader}->lastRead))
+		if ( $rs->{logLevel} >= 20 );
     #
-    # Process any complete lines of output from the child.
-    #
-    # Because some regexps are very slow in 5.8.0, this old code:
-    #
-    #    while ( $rs->{childMesg} =~ /(.*?)[\n\r]+(.*)/s ) {
-    #        $mesg = $1;
-    #        $rs->{childMesg} = $2;
+    # Process the complete messages from the child; they are all
+    # non-data messages, so they go to childMessage().
     #
-    # was replaced with the split() below.
-    #
-    while ( $rs->{childMesg} =~ /[\n\r]/ ) {
-	($mesg, $rs->{childMesg}) = split(/[\n\r]+/, $rs->{childMesg}, 2);
-	$rs->log("Parent read: $mesg")
-		    if ( $rs->{logLevel} >= 20 );
-	if ( $mesg =~ /^done$/ ) {
-	    $rs->log("Got done from child")
-			if ( $rs->{logLevel} >= 4 );
-	    $rs->{childDone} = 1;
-	} elsif ( $mesg =~ /^stats (\d+) (\d+) (\d+) (\d+) (.*)/ ) {
-	    $rs->{stats}{totalRead}    = $1;
-	    $rs->{stats}{totalWritten} = $2;
-	    $rs->{stats}{totalSize}    = $3;
-	    $rs->{stats}{remoteErrCnt} += $4;
-	    my %childStats = eval($5);
-	    $rs->log("Got stats: $1 $2 $3 $4 $5")
-			if ( $rs->{logLevel} >= 4 );
-	    $rs->{stats}{childStats}   = \%childStats;
-	    $rs->{stats}{parentStats}  = $rs->{fio}->statsGet;
-	} elsif ( $mesg =~ /^exit/ ) {
-	    $rs->log("Got exit from child") if ( $rs->{logLevel} >= 4 );
-	    $rs->{childDone} = 3;
-	} elsif ( $mesg =~ /^redo (\d+)/ ) {
-	    if ( $rs->{phase} == 1 ) {
-		push(@{$rs->{doList}}, $1);
-	    } else {
-		push(@{$rs->{redoList}}, $1);
-	    }
-	    $rs->log("Got redo $1") if ( $rs->{logLevel} >= 4 );
-	} elsif ( $mesg =~ /^log (.*)/ ) {
-	    $rs->log($1);
-	} else {
-	    $rs->log("Don't understand '$mesg' from child");
+    $rs->{childReader}->demux(1);
+}
+
+#
+# Handle a message from the child.
+#
+sub childMessage
+{
+    my($rs, $code, $msg) = @_;
+
+    if ( $code == CHILD_LOG ) {
+	$rs->log($msg);
+    } elsif ( $code == CHILD_REDO ) {
+	foreach my $n ( unpack("V*", $msg) ) {
+	    $rs->generatorEvent("redo", $n);
 	}
+    } elsif ( $code == CHILD_DONE ) {
+	$rs->generatorEvent("done");
+    } elsif ( $code == CHILD_STATS ) {
+	my($w, $r, $size, $errCnt, $frozen) = unpack("V4 a*", $msg);
+	my $childStats = thaw($frozen) || {};
+	$rs->log("Got stats: $w $r $size $errCnt "
+		    . join(" ", sort(keys(%$childStats))))
+		    if ( $rs->{logLevel} >= 4 );
+	$rs->generatorEvent("stats", $w, $r, $size, $errCnt, $childStats);
+    } elsif ( $code == CHILD_EXIT ) {
+	$rs->generatorEvent("exit");
+    } else {
+	$rs->log("Don't understand message $code from child");
+    }
+}
+
+#
+# Handle an event from the receiver: "done" at the end of phase 0,
+# "redo $fileNum" for a file to repeat in phase 1, "stats" with the
+# final stats, and "exit" when the receiver has finished.
+#
+sub generatorEvent
+{
+    my($rs, $type, @args) = @_;
+
+    if ( $type eq "done" ) {
+        $rs->log("Got done from child") if ( $rs->{logLevel} >= 4 );
+        $rs->{childDone} = 1;
+    } elsif ( $type eq "stats" ) {
+        $rs->{stats}{totalRead}     = $args[0];
+        $rs->{stats}{totalWritten}  = $args[1];
+        $rs->{stats}{totalSize}     = $args[2];
+        $rs->{stats}{remoteErrCnt} += $args[3];
+        $rs->{stats}{childStats}    = $args[4];
+        $rs->{stats}{parentStats}   = $rs->{inProcess} ? {}
+                                                       : $rs->{fio}->statsGet;
+    } elsif ( $type eq "exit" ) {
+        $rs->log("Got exit from child") if ( $rs->{logLevel} >= 4 );
+        $rs->{childDone} = 3;
+    } elsif ( $type eq "redo" ) {
+        if ( $rs->{phase} == 1 ) {
+            push(@{$rs->{doList}}, $args[0]);
+        } else {
+            push(@{$rs->{redoList}}, $args[0]);
+        }
+        $rs->log("Got redo $args[0]") if ( $rs->{logLevel} >= 4 );
+    }
+}
+
+#
+# Send an event from the receiver to the generator: as a message on
+# the pipe $fh from the child, or directly when they run in one process.
+# Redo requests are batched (up to 16384, so a batch fits in one
+# message) until the next message is sent; log messages wait until
+# childFlush(), unless a lot are queued.
+#
+sub receiverEvent
+{
+    my($rs, $fh, $type, @args) = @_;
+    my $w = $rs->{childWriter};
+
+    return $rs->generatorEvent($type, @args) if ( !defined($fh) );
+    if ( $type eq "redo" ) {
+	push(@{$rs->{childRedo}}, @args);
+	return if ( @{$rs->{childRedo}} < 16384 );
+    }
+    $w->addMsg(CHILD_REDO, pack("V*", splice(@{$rs->{childRedo}})))
+			if ( @{$rs->{childRedo} || []} );
+    if ( $type eq "log" ) {
+	$w->addMsg(CHILD_LOG, $args[0]);
+	return if ( $w->len < 65536 );
+    } elsif ( $type eq "stats" ) {
+	#
+	# The FileIO stats can be nested, so they are sent frozen
+	#
+	$w->addMsg(CHILD_STATS, pack("V4", @args[0..3])
+				. nfreeze($args[4] || {}));
+    } elsif ( $type eq "done" ) {
+	$w->addMsg(CHILD_DONE, "");
+    } elsif ( $type eq "exit" ) {
+	$w->addMsg(CHILD_EXIT, "");
+    }
+    $rs->childFlush;
+}
+
+#
+# In the child, send the queued messages to the parent.
+#
+sub childFlush
+{
+    my($rs) = @_;
+    my $w = $rs->{childWriter};
+
+    return if ( !defined($w) );
+    $w->addMsg(CHILD_REDO, pack("V*", splice(@{$rs->{childRedo}})))
+			if ( @{$rs->{childRedo} || []} );
+    while ( $w->len ) {
+	next if ( $w->flush >= 0 || $!{EINTR} );
+	delete($rs->{childWriter});
+	return -1;
+    }
+}
+
+#
+# With the inProcess option, the receiver runs in this process between
+# the generator's files, and whenever the generator would otherwise
+# wait (see pollChild and writeFlush).  It only uses data that has
+# already been read, so it never blocks.
+#
+sub receiverPoll
+{
+    my($rs, $timeout) = @_;
+
+    return -1 if ( $rs->receiverRun < 0 );
+    return if ( $rs->{childDone} >= 3 || $rs->{abort} );
+    my $ein;
+    vec($ein, fileno($rs->{fh}), 1) = 1;
+    select(my $rout = $ein, undef, undef, $timeout);
+    return if ( !vec($rout, fileno($rs->{fh}), 1) );
+    return -1 if ( $rs->receiverFill < 0 );
+    return -1 if ( $rs->receiverRun < 0 );
+}
+
+#
+# Read once from the socket for the in-process receiver.  Returns -1
+# on EOF or a read error.
+#
+sub receiverFill
+{
+    my($rs) = @_;
+
+    my $n = $rs->{reader}->fill;
+    return 0 if ( $n < 0 && ($!{EINTR} || $!{EAGAIN}) );
+    if ( $n <= 0 ) {
+        $rs->log("Read EOF: $!") if ( $rs->{logLevel} >= 1 );
+        $rs->{abort}         = 1;
+        $rs->{fatalError}    = 1;
+        $rs->{fatalErrorMsg} = "Unable to read from remote";
+        return -1;
+    }
+    $rs->log("Receiving: " . unpack("H*", $rs->{reader}->lastRead))
+                if ( $rs->{logLevel} >= 10 );
+    return $n;
+}
+
+#
+# Run the in-process receiver until it needs more data: the file
+# deltas for phases 0 and 1, then the final stats.
+#
+sub receiverRun
+{
+    my($rs) = @_;
+    my $reader = $rs->{reader};
+
+    while ( $rs->{childDone} < 3 && !$rs->{abort} ) {
+        if ( $rs->{rxPhase} < 2 ) {
+            my $phase = $rs->{rxPhase};
+            if ( !$rs->fileDeltaStep(undef, $phase) ) {
+                my $need = $reader->dataLen + $rs->{rxNeed};
+                return 0 if ( $reader->demux($need) < $need );
+                next;
+            }
+            $rs->receiverEvent(undef, "done") if ( $phase == 0 );
+            $rs->{rxPhase}++;
+        } else {
+            return 0 if ( $reader->demux(12) < 12 );
+            my($totalWritten, $totalRead, $totalSize) = $reader->dataInt(3);
+            $rs->receiverEvent(undef, "stats", $totalWritten, $totalRead,
+                               $totalSize, 0, $rs->{fio}->statsGet);
+            #
+            # Final signoff
+            #
+            $rs->writeData(pack("V", 0xffffffff), 1);
+            $rs->{fio}->finish(1);
+            $rs->receiverEvent(undef, "exit");
+        }
+    }
+    return $rs->{abort} ? -1 : 0;
+}
+
+#
+# With exactMatchDigest set to "parent", the parent computes the MD4
+# digest of each local file while generating its checksums, and sends
+# it to the child as a PARENT_DIGEST message: the packed phase and
+# file number, followed by the 16 byte digest if there is one.  The
+# child then doesn't need to reread a file whose blocks all match to
+# check its digest.
+#
+sub childDigestSend
+{
+    my($rs, $phase, $n, $md4) = @_;
+
+    if ( $rs->{inProcess} ) {
+        $rs->{fileDigests}{"$phase $n"} = $md4
+                            if ( !delete($rs->{digestSkip}{"$phase $n"}) );
+        return;
+    }
+    return if ( !defined($rs->{childFh}) );
+    $rs->{childDigestWriter}->addMsg(PARENT_DIGEST, pack("V2", $phase, $n)
+                                        . (defined($md4) ? $md4 : ""));
+    $rs->childSendFlush;
+}
+
+sub childSendLen
+{
+    my($rs) = @_;
+
+    return defined($rs->{childDigestWriter})
+                ? $rs->{childDigestWriter}->len : 0;
+}
+
+sub childSendFlush
+{
+    my($rs) = @_;
+
+    return if ( !defined($rs->{childFh}) || !$rs->childSendLen );
+    $rs->{childDigestWriter}->flush;
+}
+
+#
+# In the child, handle a message from the parent.
+#
+sub parentMessage
+{
+    my($rs, $code, $msg) = @_;
+
+    if ( $code == PARENT_DIGEST ) {
+        my($phase, $n, $md4) = unpack("V2 a*", $msg);
+        return if ( delete($rs->{digestSkip}{"$phase $n"}) );
+        $rs->{fileDigests}{"$phase $n"} = length($md4) ? $md4 : undef;
+    } else {
+        $rs->log("Don't understand message $code from parent");
+    }
+}
+
+#
+# In the child, return the digest of file $n in $phase sent by the
+# parent, or undef if there isn't one.
+#
+sub childDigestGet
+{
+    my($rs, $fh, $phase, $n) = @_;
+    my $key = "$phase $n";
+
+    while ( !$rs->{inProcess} && !exists($rs->{fileDigests}{$key}) ) {
+        $rs->childFlush;
+        my $nbytes = $rs->{parentReader}->fill;
+        next if ( $nbytes < 0 && $!{EINTR} );
+        return if ( $nbytes <= 0 );
+        $rs->{parentReader}->demux(1);
+    }
+    return delete($rs->{fileDigests}{$key});
+}
+
+#
+# In the child, drop the digest of file $n in $phase, which isn't
+# needed, now or when it arrives.  Digests that have already arrived
+# are read without waiting, so they don't queue up in the parent.
+#
+sub childDigestSkip
+{
+    my($rs, $phase, $n) = @_;
+    my $key = "$phase $n";
+
+    if ( exists($rs->{fileDigests}{$key}) ) {
+        delete($rs->{fileDigests}{$key});
+    } else {
+        $rs->{digestSkip}{$key} = 1;
+    }
+    return if ( $rs->{inProcess} || !defined($rs->{parentReader}) );
+    my $FDread;
+    vec($FDread, $rs->{parentReader}->fd, 1) = 1;
+    while ( select(my $rout = $FDread, undef, undef, 0) > 0 ) {
+        last if ( $rs->{parentReader}->fill <= 0 );
+        $rs->{parentReader}->demux(1);
     }
 }
 
@@ -1034,8 +1433,7 @@ sub fileCsumReceive
     #
     while ( 1 ) {
 	return -1 if ( $rs->getChunk(4) < 0 );
-	$fileNum = unpack("V", $rs->{chunkData});
-	$rs->{chunkData} = substr($rs->{chunkData}, 4);
+	$fileNum = $rs->{reader}->dataInt;
 	if ( $fileNum == 0xffffffff ) {
 	    $rs->log("Finished csumReceive")
 		    if ( $rs->{logLevel} >= 2 );
@@ -1046,83 +1444,96 @@ sub fileCsumReceive
         from_to($f->{name}, $rs->{clientCharset}, "utf8")
                                 if ( $rs->{clientCharset} ne "" );
         if ( $rs->{protocol_version} >= 27 ) {
+            #
+            # For protocols >= 27 the remote picks the csum length
+            # for each file.
+            #
             return -1 if ( $rs->getChunk(16) < 0 );
-            my $thisCsumLen;
-            ($blkCnt, $blkSize, $thisCsumLen, $remainder)
-                            = unpack("V4", $rs->{chunkData});
-            $rs->{chunkData} = substr($rs->{chunkData}, 16);
+            ($blkCnt, $blkSize, $csumLen, $remainder)
+                            = $rs->{reader}->dataInt(4);
         } else {
             return -1 if ( $rs->getChunk(12) < 0 );
-            ($blkCnt, $blkSize, $remainder) = unpack("V3", $rs->{chunkData});
-            $rs->{chunkData} = substr($rs->{chunkData}, 12);
+            ($blkCnt, $blkSize, $remainder) = $rs->{reader}->dataInt(3);
         }
 	$rs->log("Got #$fileNum ($f->{name}), blkCnt=$blkCnt,"
-                 . " blkSize=$blkSize, rem=$remainder")
+                 . " blkSize=$blkSize, csumLen=$csumLen, rem=$remainder")
 			if ( $rs->{logLevel} >= 5 );
         #
-        # For now we just check if the file is identical or not.
-        # We don't do clever differential restores; we effectively
-        # do --whole-file for sending to the remote machine.
-	#
-	# All this code needs to be replaced with proper file delta
-	# generation...
-        # 
-        next if ( ($f->{mode} & S_IFMT) != S_IFREG );
-        $rs->{fio}->csumStart($f, 1, $blkSize, $phase);
-        my $attr = $rs->{fio}->attribGet($f);
-        my $fileSame = $attr->{size} == ($blkCnt > 0
-				        ? ($blkCnt - 1) * $blkSize + $remainder
-				        : 0);
+        # Read the remote block checksums
+        #
+        my $csums = "";
 	my $cnt = $blkCnt;
         while ( $cnt > 0 ) {
             my $thisCnt = $cnt > 256 ? 256 : $cnt;
             my $len = $thisCnt * ($csumLen + 4);
-            my $csum = $rs->{fio}->csumGet($thisCnt, $csumLen, $blkSize)
-					if ( $fileSame );
-            $rs->getChunk($len);
-            my $csumRem = unpack("a$len", $rs->{chunkData});
-	    $rs->{chunkData} = substr($rs->{chunkData}, $len);
-            $fileSame = 0 if ( $csum ne $csumRem );
-            $rs->log(sprintf("   got same=%d, local=%s, remote=%s",
-                    $fileSame, unpack("H*", $csum), unpack("H*", $csumRem)))
-                                if ( $rs->{logLevel} >= 8 );
+            return -1 if ( $rs->getChunk($len) < 0 );
+            $csums .= $rs->{reader}->dataGet($len);
             $cnt -= $thisCnt;
         }
+        next if ( ($f->{mode} & S_IFMT) != S_IFREG );
 
-        my $md4 = $rs->{fio}->csumEnd;
         #
         # Send the file number, numBlocks, blkSize and remainder
         # (based on the old file size)
         #
-        ##$blkCnt = int(($attr->{size} + $blkSize - 1) / $blkSize);
-        ##$remainder = $attr->{size} - ($blkCnt - 1) * $blkSize;
         $rs->write_sum_head($fileNum, $blkCnt, $blkSize, $csumLen, $remainder);
 
-        if ( $fileSame ) {
-	    $rs->log("$f->{name}: unchanged") if ( $rs->{logLevel} >= 3 );
-	    #
-	    # The file is the same, so just send a bunch of block numbers
-	    #
-	    for ( my $blk = 1 ; $blk <= $blkCnt ; $blk++ ) {
-		$rs->writeData(pack("V", -$blk));
-	    }
-	} else { 
-	    #
-	    # File doesn't match: send the file
-	    #
-	    $rs->{fio}->readStart($f);
-	    while ( 1 ) {
-		my $dataR = $rs->{fio}->read(4 * 65536);
-		last if ( !defined($dataR) || length($$dataR) == 0 );
-		$rs->writeData(pack("V a*", length($$dataR), $$dataR));
-	    }
-	    $rs->{fio}->readEnd($f);
-	}
+        #
+        # Generate the file delta against the remote blocks: matching
+        # blocks are sent as block numbers and everything else as
+        # literal data.  If the remote file is empty we just send the
+        # whole file.  The file MD4 digest is computed on the way
+        # through.
+        #
+        my $md4 = File::RsyncP::Digest->new($rs->{protocol_version});
+        $md4->add(pack("V", $rs->{checksumSeed}));
+        my $delta;
+        $delta = $md4->deltaNew($csums, $blkSize, $remainder, $csumLen,
+                                $rs->{checksumSeed}) if ( $blkCnt > 0 );
+        $rs->{fio}->readStart($f);
+        my $fd;
+        $fd = $rs->{fio}->readFd if ( !defined($delta)
+                                     && $rs->{fio}->can("readFd") );
+        while ( defined($fd) ) {
+            #
+            # Whole file: read the literal data tokens directly from
+            # the file, without copying the data through perl.
+            #
+            my $token = $md4->literalFd($fd, 4 * 65536);
+            last if ( !defined($token) );
+            $rs->writeData($token);
+            if ( $rs->{abort} ) {
+                $rs->{fio}->readEnd($f);
+                return;
+            }
+        }
+        while ( !defined($fd) ) {
+            my $dataR = $rs->{fio}->read(4 * 65536);
+            last if ( !defined($dataR) || length($$dataR) == 0 );
+            $md4->add($$dataR);
+            if ( defined($delta) ) {
+                $rs->writeData($delta->add($$dataR));
+            } else {
+                $rs->writeData(pack("V a*", length($$dataR), $$dataR));
+            }
+            if ( $rs->{abort} ) {
+                $rs->{fio}->readEnd($f);
+                return;
+            }
+        }
+        $rs->{fio}->readEnd($f);
+        if ( defined($delta) ) {
+            $rs->writeData($delta->finish);
+            $rs->log(sprintf("%s: %d of %d blocks matched, %.0f bytes literal",
+                             $f->{name}, $delta->matchCnt, $blkCnt,
+                             $delta->literalBytes))
+                                if ( $rs->{logLevel} >= 3 );
+        }
 
         #
         # Send a final 0 and the MD4 file digest
         #
-        $rs->writeData(pack("V a16", 0, $md4));
+        $rs->writeData(pack("V a16", 0, $md4->digest));
     }
 
     #
@@ -1134,51 +1545,124 @@ sub fileCsumReceive
 sub fileDeltaGet
 {
     my($rs, $fh, $phase) = @_;
-    my($fileNum, $blkCnt, $blkSize, $remainder, $len, $d, $token);
-    my $fileStart = 0;
 
     while ( 1 ) {
-	return -1 if ( $rs->getChunk(4) < 0 );
-	$fileNum = unpack("V", $rs->{chunkData});
-	$rs->{chunkData} = substr($rs->{chunkData}, 4);
-	last if ( $fileNum == 0xffffffff );
+        my $ret = $rs->fileDeltaStep($fh, $phase);
+        return $ret if ( $ret );
+        return -1 if ( $rs->getChunk($rs->{reader}->dataLen
+                                     + $rs->{rxNeed}) < 0 );
+    }
+}
 
-	#
-	# Make any intermediate dirs or special files
-	#
-	$rs->fileSpecialCreate($fileStart, $fileNum) if ( $phase == 0 );
-	$fileStart = $fileNum + 1;
+#
+# Receive as much of the file deltas for $phase as the demultiplexed
+# data allows.  Returns 1 at the end of the phase, or 0 if at least
+# $rs->{rxNeed} more bytes are needed.  The position in the phase is
+# kept in $rs->{rx}.
+#
+sub fileDeltaStep
+{
+    my($rs, $fh, $phase) = @_;
+    my $reader = $rs->{reader};
+    my $rx = $rs->{rx} ||= { fileStart => 0 };
 
-        my $f = $rs->{fileList}->get($fileNum);
-	next if ( !defined($f) );
-        from_to($f->{name}, $rs->{clientCharset}, "utf8")
-                                if ( $rs->{clientCharset} ne "" );
-        if ( $rs->{protocol_version} >= 27 ) {
-            return -1 if ( $rs->getChunk(16) < 0 );
-            my $thisCsumLen;
-            ($blkCnt, $blkSize, $thisCsumLen, $remainder)
-                            = unpack("V4", $rs->{chunkData});
-            $rs->{chunkData} = substr($rs->{chunkData}, 16);
-        } else {
-            return -1 if ( $rs->getChunk(12) < 0 );
-            ($blkCnt, $blkSize, $remainder) = unpack("V3", $rs->{chunkData});
-            $rs->{chunkData} = substr($rs->{chunkData}, 12);
+    while ( 1 ) {
+        if ( !defined($rx->{fileNum}) ) {
+            if ( $reader->dataLen < 4 ) {
+                $rs->{rxNeed} = 4 - $reader->dataLen;
+                return 0;
+            }
+            $rx->{fileNum} = $reader->dataInt;
+            last if ( $rx->{fileNum} == 0xffffffff );
+
+            #
+            # Make any intermediate dirs or special files
+            #
+            $rs->fileSpecialCreate($rx->{fileStart}, $rx->{fileNum})
+                                                    if ( $phase == 0 );
+            $rx->{fileStart} = $rx->{fileNum} + 1;
+
+            my $f = $rs->{fileList}->get($rx->{fileNum});
+            if ( !defined($f) ) {
+                delete($rx->{fileNum});
+                next;
+            }
+            from_to($f->{name}, $rs->{clientCharset}, "utf8")
+                                    if ( $rs->{clientCharset} ne "" );
+            $rx->{file} = $f;
+            $rx->{started} = 0;
+        }
+        my $fileNum = $rx->{fileNum};
+        my $f = $rx->{file};
+        if ( !$rx->{started} ) {
+            my($blkCnt, $blkSize, $remainder);
+            my $hdrLen = $rs->{protocol_version} >= 27 ? 16 : 12;
+            if ( $reader->dataLen < $hdrLen ) {
+                $rs->{rxNeed} = $hdrLen - $reader->dataLen;
+                return 0;
+            }
+            if ( $rs->{protocol_version} >= 27 ) {
+                my $thisCsumLen;
+                ($blkCnt, $blkSize, $thisCsumLen, $remainder)
+                                = $reader->dataInt(4);
+            } else {
+                ($blkCnt, $blkSize, $remainder) = $reader->dataInt(3);
+            }
+            $rs->log("Starting file $fileNum ($f->{name}),"
+                . " blkCnt=$blkCnt, blkSize=$blkSize, remainder=$remainder")
+                        if ( $rs->{logLevel} >= 5 );
+            $rs->{fio}->fileDeltaRxStart($f, $blkCnt, $blkSize, $remainder);
+            $rx->{started} = 1;
+            $rx->{fioRun}  = $rs->{fio}->can("fileDeltaRxRun");
+            #
+            # Whether the file is so far an exact match of the local
+            # file: all its blocks in order, with no literal data
+            #
+            $rx->{exact}   = 1;
+            $rx->{nextBlk} = 0;
+            $rx->{blkCnt}  = $blkCnt;
         }
-	$rs->log("Starting file $fileNum ($f->{name}),"
-	    . " blkCnt=$blkCnt, blkSize=$blkSize, remainder=$remainder")
-		    if ( $rs->{logLevel} >= 5 );
-        $rs->{fio}->fileDeltaRxStart($f, $blkCnt, $blkSize, $remainder);
-        
+
+        #
+        # The tokens are decoded in C, which returns runs of matching
+        # blocks rather than one block at a time.
+        #
         while ( 1 ) {
-	    return -1 if ( $rs->getChunk(4) < 0 );
-            $len = unpack("V", $rs->{chunkData});
-	    $rs->{chunkData} = substr($rs->{chunkData}, 4);
-            if ( $len == 0 ) {
-		return -1 if ( $rs->getChunk(16) < 0 );
-                my $md4digest = unpack("a16", $rs->{chunkData});
-		$rs->{chunkData} = substr($rs->{chunkData}, 16);
+            my($type, @args) = $reader->deltaNext;
+            if ( $type eq "need" ) {
+                $rs->{rxNeed} = $args[0];
+                return 0;
+            } elsif ( $type eq "run" ) {
+                $rx->{exact}   = 0 if ( $args[0] != $rx->{nextBlk} );
+                $rx->{nextBlk} = $args[0] + $args[1];
+                if ( $rx->{fioRun} ) {
+                    $rs->{fio}->fileDeltaRxRun(@args);
+                } else {
+                    for ( my $b = 0 ; $b < $args[1] ; $b++ ) {
+                        $rs->{fio}->fileDeltaRxNext($args[0] + $b, undef);
+                    }
+                }
+            } elsif ( $type eq "data" ) {
+                $rx->{exact} = 0;
+                $rs->{fio}->fileDeltaRxNext(undef, $args[0]);
+            } else {
+                my $md4digest = $args[0];
+                my $localMd4;
+                #
+                # The parent's digest of the local file is only needed
+                # (and waited for) if the file is an exact match.
+                #
+                if ( $rs->{exactMatchDigest} eq "parent" ) {
+                    if ( $rx->{exact} && $rx->{nextBlk} == $rx->{blkCnt} ) {
+                        $localMd4 = $rs->childDigestGet($fh, $phase,
+                                                        $fileNum);
+                    } else {
+                        $rs->childDigestSkip($phase, $fileNum);
+                    }
+                }
                 my $ret = $rs->{fio}->fileDeltaRxNext(undef, undef)
-                       || $rs->{fio}->fileDeltaRxDone($md4digest, $phase);
+                       || $rs->{fio}->fileDeltaRxDone($md4digest, $phase,
+                                                      $localMd4);
                 if ( $ret == 1 ) {
                     if ( $phase == 1 ) {
                         $rs->log("MD4 does't agree: fatal error on #$fileNum ($f->{name})");
@@ -1186,17 +1670,9 @@ sub fileDeltaGet
                     }
                     $rs->log("Must redo $fileNum ($f->{name})\n")
 			if ( $rs->{logLevel} >= 2 );
-                    print($fh "redo $fileNum\n");
+                    $rs->receiverEvent($fh, "redo", $fileNum);
                 }
                 last;
-            } elsif ( $len > 0x80000000 ) {
-                $len = 0xffffffff - $len;
-                my $ret = $rs->{fio}->fileDeltaRxNext($len, undef);
-            } else {
-		return -1 if ( $rs->getChunk($len) < 0 );
-                $d = unpack("a$len", $rs->{chunkData});
-		$rs->{chunkData} = substr($rs->{chunkData}, $len);
-                my $ret = $rs->{fio}->fileDeltaRxNext(undef, $d);
             }
         }
 
@@ -1204,11 +1680,13 @@ sub fileDeltaGet
         # If this is 2nd phase, then set the attributes just for this file
         #
 	$rs->{fio}->attribSet($f, 1) if ( $phase == 1 );
+        delete($rx->{fileNum});
     }
     #
     # Make any remaining dirs or special files
     #
-    $rs->fileSpecialCreate($fileStart, undef) if ( $phase == 0 );
+    $rs->fileSpecialCreate($rx->{fileStart}, undef) if ( $phase == 0 );
+    delete($rs->{rx});
 
     $rs->log("Finished deltaGet phase $phase") if ( $rs->{logLevel} >= 2 );
 
@@ -1216,11 +1694,8 @@ sub fileDeltaGet
     # Finish up hardlinks at the very end
     #
     if ( $phase == 1 && $rs->{rsyncOpts}{"hard-links"} ) {
-        my $cnt = $rs->{fileList}->count;
-        for ( my $n = 0 ; $n < $cnt ; $n++ ) {
+        foreach my $n ( $rs->{fileList}->indexGet("hlink") ) {
             my $f = $rs->{fileList}->get($n);
-	    next if ( !defined($f) );
-            next if ( !defined($f->{hlink}) || $f->{hlink_self} );
             if ( $rs->{clientCharset} ne "" ) {
                 from_to($f->{name},  $rs->{clientCharset}, "utf8");
                 from_to($f->{hlink}, $rs->{clientCharset}, "utf8");
@@ -1230,6 +1705,7 @@ sub fileDeltaGet
             }
         }
     }
+    return 1;
 }
 
 sub fileListSend
@@ -1275,12 +1751,14 @@ sub fileListSend
     if ( $rs->{logLevel} >= 4 ) {
         my $cnt = $rs->{fileList}->count;
         $rs->log("Sorted file list has $cnt entries");
-        for ( my $n = 0 ; $n < $cnt ; $n++ ) {
-            my $f = $rs->{fileList}->get($n);
-	    next if ( !defined($f) );
-            from_to($f->{name}, $rs->{clientCharset}, "utf8")
-                                    if ( $rs->{clientCharset} ne "" );
-            $rs->log("PostSortFile $n: $f->{name}");
+        my $n = 0;
+        foreach my $name ( $rs->{fileList}->fieldGet("name") ) {
+            if ( defined($name) ) {
+                from_to($name, $rs->{clientCharset}, "utf8")
+                                        if ( $rs->{clientCharset} ne "" );
+                $rs->log("PostSortFile $n: $name");
+            }
+            $n++;
         }
     }
 }
@@ -1328,18 +1806,13 @@ sub statsGet
     my($totalWritten, $totalRead, $totalSize) = (0, 0, 0);
 
     if ( $rs->getChunk(12) >= 0 ) {
-	($totalWritten, $totalRead, $totalSize)
-			= unpack("V3", $rs->{chunkData});
+	($totalWritten, $totalRead, $totalSize) = $rs->{reader}->dataInt(3);
     }
     
     if ( defined($fh) ) {
-	my $fioStats = $rs->{fio}->statsGet;
-	my $dump = Data::Dumper->new([$fioStats], [qw(*fioStats)]);
-	$dump->Terse(1);
-	$dump->Indent(0);
-	my $remoteErrCnt = 0 + $rs->{stats}{remoteErrCnt};
-	print($fh "stats $totalWritten $totalRead $totalSize $remoteErrCnt ",
-		  $dump->Dump, "\n");
+	$rs->receiverEvent($fh, "stats", $totalWritten, $totalRead, $totalSize,
+			   0 + $rs->{stats}{remoteErrCnt},
+			   $rs->{fio}->statsGet);
     } else {
 	$rs->{stats}{totalRead}    = $totalRead;
 	$rs->{stats}{totalWritten} = $totalWritten;
@@ -1348,25 +1821,47 @@ sub statsGet
     }
 }
 
+#
+# Start reading and writing the socket $rs->{fh} with a
+# File::RsyncP::Mux::Reader and File::RsyncP::Mux::Writer, which
+# buffer (and demultiplex) the data in C.
+#
+sub muxStart
+{
+    my($rs) = @_;
+    my $rsWeak = $rs;
+
+    weaken($rsWeak);
+    $rs->{reader} = File::RsyncP::Mux::Reader->new(fileno($rs->{fh}),
+                        sub { $rsWeak->remoteMessage(@_) if ( $rsWeak ); });
+    $rs->{writer} = File::RsyncP::Mux::Writer->new(fileno($rs->{fh}));
+}
+
+#
+# Make sure at least $len bytes of raw (not demultiplexed) input
+# are buffered.
+#
 sub getData
 {
     my($rs, $len) = @_;
-    my($data);
+    my $reader = $rs->{reader};
 
     return -1 if ( $rs->{abort} );
     alarm($rs->{timeout}) if ( $rs->{timeout} );
-    while ( length($rs->{readData}) < $len ) {
+    while ( $reader->rawLen < $len ) {
 	return -1 if ( $rs->{abort} );
+	$rs->childFlush;
 	my $ein;
 	vec($ein, fileno($rs->{fh}), 1) = 1;
 	select(my $rout = $ein, undef, $ein, undef);
 	return -1 if ( $rs->{abort} );
-        sysread($rs->{fh}, $data, 65536);
-        if ( length($data) == 0 ) {
+        my $n = $reader->fill;
+        next if ( $n < 0 && ($!{EINTR} || $!{EAGAIN}) );
+        if ( $n <= 0 ) {
             $rs->log("Read EOF: $!") if ( $rs->{logLevel} >= 1 );
 	    return -1 if ( $rs->{abort} );
-	    sysread($rs->{fh}, $data, 65536);
-            $rs->log(sprintf("Tried again: got %d bytes", length($data)))
+	    $n = $reader->fill;
+            $rs->log(sprintf("Tried again: got %d bytes", $n > 0 ? $n : 0))
 			if ( $rs->{logLevel} >= 1 );
             $rs->{abort}         = 1;
             $rs->{fatalError}    = 1;
@@ -1374,39 +1869,40 @@ sub getData
             return -1;
         }
         if ( $rs->{logLevel} >= 10 ) {
-            $rs->log("Receiving: " . unpack("H*", $data));
+            $rs->log("Receiving: " . unpack("H*", $reader->lastRead));
         }
-        $rs->{readData} .= $data;
     }
 }
 
+#
+# Make sure at least $len bytes of demultiplexed data are available.
+#
 sub getChunk
 {
     my($rs, $len) = @_;
+    my $reader = $rs->{reader};
 
     $len ||= 1;
-    while ( length($rs->{chunkData}) < $len ) {
-	return -1 if ( $rs->getData(4) < 0 );
-	my $d = unpack("V", $rs->{readData});
-	$rs->{readData} = substr($rs->{readData}, 4);
-	my $code = ($d >> 24) - 7;
-	my $len  = $d & 0xffffff;
-        return -1 if ( $rs->getData($len) < 0 );
-	$d = substr($rs->{readData}, 0, $len);
-	$rs->{readData} = substr($rs->{readData}, $len);
-        if ( $code == 0 ) {
-            $rs->{chunkData} .= $d;
-        } else {
-	    $d =~ s/[\n\r]+$//;
-            from_to($d, $rs->{clientCharset}, "utf8")
-                                    if ( $rs->{clientCharset} ne "" );
-            $rs->log("Remote[$code]: $d");
-            if ( $code == 1
-                    || $d =~ /^file has vanished: /
-                ) {
-                $rs->{stats}{remoteErrCnt}++
-            }
-        }
+    while ( $reader->demux($len) < $len ) {
+	return -1 if ( $rs->getData($reader->rawLen + 1) < 0 );
+    }
+}
+
+#
+# Called by the reader for each message from the remote rsync
+#
+sub remoteMessage
+{
+    my($rs, $code, $d) = @_;
+
+    $d =~ s/[\n\r]+$//;
+    from_to($d, $rs->{clientCharset}, "utf8")
+                            if ( $rs->{clientCharset} ne "" );
+    $rs->log("Remote[$code]: $d");
+    if ( $code == 1
+            || $d =~ /^file has vanished: /
+        ) {
+        $rs->{stats}{remoteErrCnt}++
     }
 }
 
@@ -1415,11 +1911,9 @@ sub getLine
     my($rs) = @_;
 
     while ( 1 ) {
-	if ( $rs->{readData} =~ /(.*?)[\n\r]+(.*)/s ) {
-	    $rs->{readData} = $2;
-	    return $1;
-	}
-	return if ( $rs->getData(length($rs->{readData}) + 1) < 0 );
+        my $line = $rs->{reader}->rawLine;
+	return $line if ( defined($line) );
+	return if ( $rs->getData($rs->{reader}->rawLen + 1) < 0 );
     }
 }
 
@@ -1427,8 +1921,9 @@ sub writeData
 {
     my($rs, $data, $flush) = @_;    
 
-    $rs->{writeBuf} .= $data;
-    $rs->writeFlush() if ( $flush || length($rs->{writeBuf}) > 32768 ); 
+    $rs->log("Sending: " . unpack("H*", $data)) if ( $rs->{logLevel} >= 10 );
+    $rs->{writer}->add($data);
+    $rs->writeFlush() if ( $flush || $rs->{writer}->len > 32768 ); 
 }
 
 sub statsFinal
@@ -1443,17 +1938,34 @@ sub statsFinal
 sub writeFlush
 {
     my($rs) = @_;    
-
-    my($FDread, $FDwrite);
+    my $writer = $rs->{writer};
 
     return if ( $rs->{abort} );
     alarm($rs->{timeout}) if ( $rs->{timeout} );
-    while ( $rs->{writeBuf} ne "" ) {
-	#(my $chunk, $rs->{writeBuf}) = unpack("a4092 a*", $rs->{writeBuf});
-	#$chunk = pack("V", (7 << 24) | length($chunk)) . $chunk;
+    while ( $writer->len ) {
+	my $n = $writer->flush;
+	next if ( $n > 0 || ($n < 0 && $!{EINTR}) );
+	if ( $n < 0 ) {
+	    return $rs->log(sprintf("Can't write %d bytes to socket",
+				      $writer->len));
+	}
+	#
+	# The socket is full.  Wait until it can be written, meanwhile
+	# reading any messages from the child so it doesn't block
+	# writing to us.
+	#
+	my($FDread, $FDwrite);
 	vec($FDread, fileno($rs->{childFh}), 1) = 1
 			    if ( defined($rs->{childFh}) );
 	vec($FDwrite, fileno($rs->{fh}), 1) = 1;
+	vec($FDwrite, fileno($rs->{childFh}), 1) = 1
+			    if ( $rs->childSendLen );
+	#
+	# In one process we keep reading the socket instead, so the
+	# remote doesn't block writing to us.
+	#
+	my $rxFill = $rs->{inProcess} && $rs->{childDone} < 3;
+	vec($FDread, fileno($rs->{fh}), 1) = 1 if ( $rxFill );
 	my $ein = $FDread;
 	vec($ein, fileno($rs->{fh}), 1) = 1;
 	select(my $rout = $FDread, my $rwrite = $FDwrite, $ein, undef);
@@ -1461,19 +1973,11 @@ sub writeFlush
 			&& vec($rout, fileno($rs->{childFh}), 1) ) {
 	    $rs->pollChild(0);
 	}
-	return if ( $rs->{abort} );
-	if ( vec($rwrite, fileno($rs->{fh}), 1) ) {
-	    my $n = syswrite($rs->{fh}, $rs->{writeBuf});
-	    if ( $n <= 0 ) {
-		return $rs->log(sprintf("Can't write %d bytes to socket",
-					  length($rs->{writeBuf})));
-	    }
-	    if ( $rs->{logLevel} >= 10 ) {
-		my $chunk = substr($rs->{writeBuf}, 0, $n);
-		$rs->log("Sending: " . unpack("H*", $chunk));
-	    }
-	    $rs->{writeBuf} = substr($rs->{writeBuf}, $n);
+	if ( $rxFill && vec($rout, fileno($rs->{fh}), 1) ) {
+	    return if ( $rs->receiverFill < 0 );
 	}
+	$rs->childSendFlush if ( $rs->childSendLen );
+	return if ( $rs->{abort} );
     }
 }
 
@@ -1730,6 +2234,39 @@ on each file, and this returns whether or not attributes should
 be ignored on that file.  If ignoreAttrOnFile() returns 1 then
 it's as though --ignore-times was set for that file.
 
+=item csumPrefetch
+
+The number of files ahead of the current one for which FileIO's
+optional csumPrefetch() method is called while the block checksums
+are being generated, so the disk reads of the next files overlap with
+sending the checksums of the current one.  Only files whose checksums
+will be sent are prefetched.  Defaults to 8; set to 0 to disable.
+The checksums are still generated and sent in file list order.
+
+=item exactMatchDigest
+
+How a received file whose blocks all match the local file is checked.
+By default the file is reread to compute its MD4 digest.  If set to
+"parent", the parent computes the digest of each local file while it
+generates the block checksums and sends it to the child, so the file
+is only read once.  The digest is then of the file when its checksums
+were generated, like the checksums themselves.  The child only waits
+for the digest of a file whose blocks all match.  If FileIO's checksum
+cache (csumCacheDir) has a valid entry for a file, its checksums come
+from the cache without reading the file, so no digest is sent and the
+child rereads the file if it is an exact match.
+
+=item inProcess
+
+If set, the file checksums are generated and the file deltas received
+in a single process, instead of forking a child to receive the deltas.
+The receiver runs whenever the generator would otherwise wait for the
+remote, and the two share the file list and the FileIO object, which
+must allow calls for the file being received between the calls for
+the file whose checksums are being generated.  Redo requests and the
+file digests of the exactMatchDigest option are passed directly, and
+all the FileIO stats are returned in childStats.
+
 =back
 
 An example of calling File::RsyncP->new is:
@@ -1964,6 +2501,7 @@ features.  In particular, as of 0.10 only these options are supported:
         --devices|D
         --links|-l
         --ignore-times|I
+        --inplace
         --block-size=i
         --verbose|-v
         --recursive|-r
@@ -1992,10 +2530,9 @@ versions of Rsync.
 
 =item *
 
-File::RsyncP does not compute file deltas (ie: it behaves as though
---whole-file is specified) or implement exclude or include options
-when sending files.  File::RsyncP does handle file deltas and exclude
-and include options when receiving files.
+File::RsyncP does not implement exclude or include options when
+sending files.  File::RsyncP does handle exclude and include options
+when receiving files.
 
 =item *
 
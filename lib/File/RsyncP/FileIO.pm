@@ -40,6 +40,7 @@ package File::RsyncP::FileIO;
 
 use strict;
 use File::RsyncP::Digest;
+use File::RsyncP::CsumCache;
 use File::Path;
 use File::Find;
 
@@ -65,9 +66,12 @@ sub new
         logLevel     => 0,
         digest       => File::RsyncP::Digest->new($options->{protocol_version}),
         checksumSeed => 0,
+        csumThreads  => 1,
 	logHandler   => \&logHandler,
 	%$options,
     }, $class;
+    $self->{csumCache} = File::RsyncP::CsumCache->new($self->{csumCacheDir})
+                    if ( defined($self->{csumCacheDir}) );
     return $self;
 }
 
@@ -101,6 +105,14 @@ sub preserve_hard_links
     return $fio->{preserve_hard_links};
 }
 
+sub inplace
+{
+    my($fio, $value) = @_;
+
+    $fio->{inplace} = $value if ( defined($value) );
+    return $fio->{inplace};
+}
+
 sub protocol_version
 {
     my($fio, $value) = @_;
@@ -133,6 +145,20 @@ sub localName
     return $name;
 }
 
+#
+# Ask the kernel to start reading a file whose checksums will be
+# needed soon.  Files might be in the checksum cache, so they aren't
+# prefetched when it is enabled.
+#
+sub csumPrefetch
+{
+    my($fio, $f, $attr) = @_;
+
+    return if ( defined($fio->{csumCache}) );
+    File::RsyncP::Digest->prefetchFile($fio->localName($f->{name}),
+                                       $attr->{size});
+}
+
 #
 # Setup rsync checksum computation for the given file.
 #
@@ -156,29 +182,87 @@ sub csumStart
     } else {
 	delete($fio->{csumDigest});
     }
+    if ( defined($fio->{csumCache}) ) {
+        $fio->{csumPath} = $localName;
+        $fio->{csumStat} = [stat(F)];
+        delete($fio->{csumCacheEntry});
+    }
     $fio->{fh} = *F;
 }
 
 sub csumGet
 {
     my($fio, $num, $csumLen, $blockSize) = @_;
-    my($fileData);
 
     $num     ||= 100;
     $csumLen ||= 16;
 
     return if ( !defined($fio->{fh}) );
-    if ( sysread($fio->{fh}, $fileData, $blockSize * $num) <= 0 ) {
-        return;
-    }
-    $fio->{csumDigest}->add($fileData) if ( defined($fio->{csumDigest}) );
+    return $fio->csumCacheGet($num, $csumLen, $blockSize)
+                    if ( defined($fio->{csumCache}) );
+    #
+    # The file is read in C, which computes the block digests and
+    # adds the same data to the file digest in one pass.
+    #
+    my $csum = $fio->{digest}->blockDigestFd(fileno($fio->{fh}), $num,
+                                    $blockSize, $csumLen,
+                                    $fio->{checksumSeed}, $fio->{csumDigest},
+                                    $fio->{csumThreads});
     $fio->log(sprintf("%s: getting csum ($num,$csumLen,%d,0x%x)",
                             $fio->{file}{name},
-                            length($fileData),
+                            length($csum),
+                            $fio->{checksumSeed}))
+                if ( defined($csum) && $fio->{logLevel} >= 10 );
+    return $csum;
+}
+
+#
+# csumGet() using the checksum cache.  If the file has a valid cache
+# entry the checksums come from the cached block state without reading
+# the file; the file MD4 isn't computed then, so csumEnd() returns
+# undef even if it was asked for.  Otherwise the block state is
+# computed from the file, saved in a new cache entry and then updated
+# with the checksum seed.
+#
+sub csumCacheGet
+{
+    my($fio, $num, $csumLen, $blockSize) = @_;
+    my $cache = $fio->{csumCache};
+    my($state, $lastLen);
+
+    if ( !defined($fio->{csumCacheEntry}) ) {
+        my $e = $cache->open($fio->{csumPath}, $fio->{csumStat}, $blockSize);
+        if ( defined($e) && defined($fio->{csumDigest}) ) {
+            $fio->log("$fio->{file}{name}: using cached csums,"
+                    . " so no file MD4")
+                        if ( $fio->{logLevel} >= 5 );
+            delete($fio->{csumDigest});
+        }
+        $e ||= $cache->create($fio->{csumPath}, $fio->{csumStat},
+                              $blockSize) || {};
+        $fio->{csumCacheEntry} = $e;
+    }
+    my $e = $fio->{csumCacheEntry};
+    if ( defined($e->{fh}) && !$e->{write} ) {
+        ($state, $lastLen) = $cache->read($e, $num);
+        return if ( !defined($state) );
+    } else {
+        my $offset = sysseek($fio->{fh}, 0, 1);
+        $state = $fio->{digest}->blockDigestFd(fileno($fio->{fh}), $num,
+                                    $blockSize, -1, 0, $fio->{csumDigest},
+                                    $fio->{csumThreads});
+        return if ( !defined($state) );
+        $cache->write($e, $state);
+        $e->{offset} = sysseek($fio->{fh}, 0, 1);
+        $lastLen = ($e->{offset} - $offset) % $blockSize || $blockSize;
+    }
+    $fio->log(sprintf("%s: getting cached csum ($num,$csumLen,%d,0x%x)",
+                            $fio->{file}{name},
+                            length($state),
                             $fio->{checksumSeed}))
                 if ( $fio->{logLevel} >= 10 );
-    return $fio->{digest}->blockDigest($fileData, $blockSize,
-                                         $csumLen, $fio->{checksumSeed});
+    return $fio->{digest}->blockDigestUpdate($state, $blockSize, $lastLen,
+                                    $csumLen, $fio->{checksumSeed});
 }
 
 sub csumEnd
@@ -186,17 +270,27 @@ sub csumEnd
     my($fio) = @_;
 
     return if ( !defined($fio->{fh}) );
+    if ( defined(my $e = $fio->{csumCacheEntry}) ) {
+        #
+        # Only save a new cache entry if the state of the whole file
+        # was computed and the file didn't change while we read it.
+        #
+        my @s = stat($fio->{fh});
+        $fio->{csumCache}->close($e,
+                    $e->{write}
+                    && $e->{offset} == $fio->{csumStat}[7]
+                    && $s[7] == $fio->{csumStat}[7]
+                    && $s[9] == $fio->{csumStat}[9]);
+        delete($fio->{csumCacheEntry});
+    }
     #
     # make sure we read the entire file for the file MD4 digest
     #
-    if ( defined($fio->{csumDigest}) ) {
-	while ( sysread($fio->{fh}, my $fileData, 65536) > 0 ) {
-	    $fio->{csumDigest}->add($fileData);
-	}
-    }
+    $fio->{csumDigest}->addFd(fileno($fio->{fh}))
+                if ( defined($fio->{csumDigest}) );
     close($fio->{fh});
     delete($fio->{fh});
-    return $fio->{csumDigest}->digest if ( defined($fio->{csumDigest}) );
+    return defined($fio->{csumDigest}) ? $fio->{csumDigest}->digest : undef;
 }
 
 sub readStart
@@ -228,6 +322,18 @@ sub read
     return \$fileData;
 }
 
+#
+# Return the file descriptor being read, so the caller can read
+# the file directly in C.
+#
+sub readFd
+{
+    my($fio) = @_;
+
+    return if ( !defined($fio->{fh}) );
+    return fileno($fio->{fh});
+}
+
 sub readEnd
 {
     my($fio) = @_;
@@ -314,6 +420,7 @@ sub statsGet
 {
     my($fio) = @_;
 
+    return $fio->{csumCache}->statsGet if ( defined($fio->{csumCache}) );
     return {};
 }
 
@@ -438,7 +545,34 @@ sub fileDeltaRxStart
     delete($fio->{rxInFd});
     delete($fio->{rxOutFd});
     delete($fio->{rxDigest});
+    delete($fio->{rxTmpFile});
     $fio->{rxFile}{localName} = $fio->localName($fio->{rxFile}{name});
+    #
+    # In-place updates aren't used for a file that previously failed
+    # in place, since the file will have been partly updated.
+    #
+    $fio->{rxInplace} = $fio->{inplace}
+                && !$fio->{rxInplaceFailed}{$fio->{rxFile}{localName}};
+    $fio->{rxInplaceBad} = 0;
+    $fio->{rxWritten}    = [];          # ranges written in place
+    $fio->{rxCopyState}  = 0;           # kernel copies that failed
+}
+
+#
+# Process a run of $cnt consecutive matching blocks starting at $blk.
+#
+sub fileDeltaRxRun
+{
+    my($fio, $blk, $cnt) = @_;
+
+    if ( defined($fio->{rxMatchBlk}) && $fio->{rxMatchNext} == $blk ) {
+        $fio->{rxMatchNext} += $cnt;
+        return;
+    }
+    my $ret = $fio->fileDeltaRxNext($blk, undef);
+    $fio->{rxMatchNext} = $blk + $cnt
+                if ( defined($fio->{rxMatchBlk}) && $fio->{rxMatchBlk} == $blk );
+    return $ret;
 }
 
 #
@@ -474,6 +608,27 @@ sub fileDeltaRxNext
 	    return;
 	}
 
+        local(*F);
+        if ( $fio->{rxInplace} ) {
+            #
+            # Update the file in place; fall back to a temporary
+            # file if it can't be written.
+            #
+            if ( open(F, "+<", $fio->{rxFile}{localName})
+                    || (!-e $fio->{rxFile}{localName}
+                        && open(F, "+>", $fio->{rxFile}{localName})) ) {
+                binmode(F);
+                $fio->log("$fio->{rxFile}{name}: updating in place")
+                                if ( $fio->{logLevel} >= 10 );
+                $fio->{rxOutFd} = *F;
+            } else {
+                $fio->log("$fio->{rxFile}{name}: can't update in place")
+                                if ( $fio->{logLevel} >= 3 );
+                $fio->{rxInplace} = 0;
+            }
+        }
+    }
+    if ( !defined($fio->{rxOutFd}) ) {
         #
         # need to open a temporary output file where we will build the
         # new version.
@@ -492,10 +647,16 @@ sub fileDeltaRxNext
                         if ( $fio->{logLevel} >= 10 );
         $fio->{rxOutFd} = *F;
         $fio->{rxTmpFile} = $rxTmpFile;
-
+    }
+    if ( !defined($fio->{rxDigest}) ) {
         $fio->{rxDigest} = File::RsyncP::Digest->new($fio->{protocol_version});
         $fio->{rxDigest}->add(pack("V", $fio->{checksumSeed}));
     }
+    #
+    # After a failed in-place update the rest of the file is skipped;
+    # fileDeltaRxDone reports the error.
+    #
+    return if ( $fio->{rxInplaceBad} );
     if ( defined($fio->{rxMatchBlk})
                 && $fio->{rxMatchBlk} != $fio->{rxMatchNext} ) {
         #
@@ -514,32 +675,43 @@ sub fileDeltaRxNext
                   . "$lastBlk")
                         if ( $fio->{logLevel} >= 10 );
         my $seekPosn = $fio->{rxMatchBlk} * $fio->{rxBlkSize};
-        if ( !sysseek($fio->{rxInFd}, $seekPosn, 0) ) {
-            $fio->log("Unable to seek $fio->{rxFile}{localName} to $seekPosn");
-            return -1;
-        }
         my $cnt = $fio->{rxMatchNext} - $fio->{rxMatchBlk};
-        my($thisCnt, $len, $data);
-        for ( my $i = 0 ; $i < $cnt ; $i += $thisCnt ) {
-            $thisCnt = $cnt - $i;
-            $thisCnt = 512 if ( $thisCnt > 512 );
-            if ( $fio->{rxMatchBlk} + $i + $thisCnt == $fio->{rxBlkCnt} ) {
-                $len = ($thisCnt - 1) * $fio->{rxBlkSize} + $fio->{rxRemainder};
-            } else {
-                $len = $thisCnt * $fio->{rxBlkSize};
+        my $len = $cnt * $fio->{rxBlkSize};
+        $len += $fio->{rxRemainder} - $fio->{rxBlkSize}
+                if ( $fio->{rxMatchNext} == $fio->{rxBlkCnt} );
+        my $outFd = fileno($fio->{rxOutFd});
+        if ( $fio->{rxInplace} ) {
+            if ( $seekPosn == $fio->{rxSize} ) {
+                #
+                # The blocks are already in the right place
+                #
+                $outFd = -1;
+            } elsif ( !$fio->inplaceCopyOk($seekPosn, $len) ) {
+                $fio->log("$fio->{rxFile}{name}: blocks $fio->{rxMatchBlk}.."
+                        . "$lastBlk were overwritten before being copied;"
+                        . " can't update in place")
+                                if ( $fio->{logLevel} >= 1 );
+                $fio->{rxInplaceBad} = 1;
+                return;
             }
-            if ( sysread($fio->{rxInFd}, $data, $len) != $len ) {
-                $fio->log("Unable to read $len bytes from"
-                          . " $fio->{rxFile}{localName} ($i,$thisCnt,$fio->{rxBlkCnt})");
-                return -1;
-            }
-            if ( syswrite($fio->{rxOutFd}, $data) != $len ) {
-                $fio->log("Unable to write $len bytes to"
-                          . " $fio->{rxTmpFile}");
-            }
-            $fio->{rxDigest}->add($data);
-	    $fio->{rxSize} += length($data);
         }
+        #
+        # The blocks are copied in C, which clones or copies them in
+        # the kernel where possible, and adds them to the digest.
+        # rxCopyState remembers which kernel copies failed for this
+        # file, so they aren't retried for every run.
+        #
+        if ( !defined($fio->{rxDigest}->copyRangeFd(fileno($fio->{rxInFd}),
+                                $seekPosn, $len, $outFd,
+                                $fio->{rxCopyState})) ) {
+            $fio->log("Unable to copy $len bytes at $seekPosn from"
+                      . " $fio->{rxFile}{localName}");
+            return -1;
+        }
+        $fio->inplaceWritten($fio->{rxSize}, $len)
+                                if ( $fio->{rxInplace} && $outFd >= 0 );
+        $fio->{rxSize} += $len;
+        sysseek($fio->{rxOutFd}, $fio->{rxSize}, 0) if ( $outFd < 0 );
         $fio->{rxMatchBlk} = undef;
     }
     if ( defined($blk) ) {
@@ -557,24 +729,81 @@ sub fileDeltaRxNext
         $fio->log("$fio->{rxFile}{name}: writing $len bytes new data")
                         if ( $fio->{logLevel} >= 10 );
         if ( syswrite($fio->{rxOutFd}, $newData) != $len ) {
-            $fio->log("Unable to write $len bytes to $fio->{rxTmpFile}");
+            $fio->log("Unable to write $len bytes to"
+                    . " $fio->{rxFile}{localName}");
             return -1;
         }
+        $fio->inplaceWritten($fio->{rxSize}, $len) if ( $fio->{rxInplace} );
         $fio->{rxDigest}->add($newData);
 	$fio->{rxSize} += length($newData);
     }
     return;
 }
 
+#
+# When updating in place, a run of matching blocks can only be copied
+# if none of it has been overwritten yet (the ranges written so far
+# are in $fio->{rxWritten}, sorted and merged), and it doesn't overlap
+# the later part of the destination (which would be overwritten as
+# it is copied).
+#
+sub inplaceCopyOk
+{
+    my($fio, $offset, $len) = @_;
+    my $w = $fio->{rxWritten};
+
+    return 0 if ( $offset < $fio->{rxSize}
+                    && $offset + $len > $fio->{rxSize} );
+    #
+    # Find the last written range starting before the end of the copy
+    #
+    my($lo, $hi) = (0, scalar(@$w));
+    while ( $lo < $hi ) {
+        my $mid = int(($lo + $hi) / 2);
+        if ( $w->[$mid][0] < $offset + $len ) {
+            $lo = $mid + 1;
+        } else {
+            $hi = $mid;
+        }
+    }
+    return $lo == 0 || $w->[$lo - 1][1] <= $offset;
+}
+
+#
+# Remember that $len bytes at $offset were written in place.  Writes
+# are in increasing order, so they are merged with the last range.
+#
+sub inplaceWritten
+{
+    my($fio, $offset, $len) = @_;
+    my $w = $fio->{rxWritten};
+
+    return if ( $len == 0 );
+    if ( @$w && $w->[-1][1] == $offset ) {
+        $w->[-1][1] += $len;
+    } else {
+        push(@$w, [$offset, $offset + $len]);
+    }
+}
+
 #
 # Finish up the current receive file.  Returns undef if ok, -1 if not.
 # Returns 1 if the md4 digest doesn't match.
 #
 sub fileDeltaRxDone
 {
-    my($fio, $md4) = @_;
+    my($fio, $md4, $phase, $localMd4) = @_;
+    my $newDigest;
 
-    if ( !defined($fio->{rxDigest}) ) {
+    if ( !defined($fio->{rxDigest}) && defined($localMd4) ) {
+        #
+        # File was exact match, and we were given the MD4 digest of
+        # the local file, so there is no need to read it again.
+        #
+        $fio->log("$fio->{rxFile}{name}: got exact match (known digest)")
+                        if ( $fio->{logLevel} >= 5 );
+        $newDigest = $localMd4;
+    } elsif ( !defined($fio->{rxDigest}) ) {
         local(*F);
         #
         # File was exact match, but we still need to verify the
@@ -594,9 +823,35 @@ sub fileDeltaRxDone
         $fio->log("$fio->{rxFile}{name}: got exact match")
                         if ( $fio->{logLevel} >= 5 );
     }
+    if ( $fio->{rxInplace} && defined($fio->{rxOutFd}) ) {
+        #
+        # Remove anything after the end of the new file
+        #
+        if ( !$fio->{rxInplaceBad} && -s $fio->{rxOutFd} > $fio->{rxSize}
+                && !truncate($fio->{rxOutFd}, $fio->{rxSize}) ) {
+            $fio->log("Can't truncate $fio->{rxFile}{localName}");
+            $fio->{rxInplaceBad} = 1;
+        }
+    }
     close($fio->{rxInFd})  if ( defined($fio->{rxInFd}) );
     close($fio->{rxOutFd}) if ( defined($fio->{rxOutFd}) );
-    my $newDigest = $fio->{rxDigest}->digest;
+    if ( $fio->{rxInplace} && defined($fio->{rxOutFd}) ) {
+        $newDigest = $fio->{rxInplaceBad} ? "" : $fio->{rxDigest}->digest;
+        delete($fio->{rxDigest});
+        if ( $md4 ne $newDigest ) {
+            #
+            # The file has been partly updated, so it has to be
+            # redone using a temporary file.
+            #
+            $fio->log("$fio->{rxFile}{name}: md4 doesn't match")
+                        if ( $fio->{logLevel} >= 1 );
+            $fio->{rxInplaceFailed}{$fio->{rxFile}{localName}} = 1;
+            return 1;
+        }
+        $fio->{rxFile}{size} = $fio->{rxSize};
+        return $fio->attribSet($fio->{rxFile});
+    }
+    $newDigest = $fio->{rxDigest}->digest if ( !defined($newDigest) );
     if ( $fio->{logLevel} >= 3 ) {
         my $md4Str = unpack("H*", $md4);
         my $newStr = unpack("H*", $newDigest);
@@ -713,6 +968,10 @@ sub finish
 {
     my($fio, $isChild) = @_;
 
+    #
+    # Save the checksum cache's new entries for the last directory
+    #
+    $fio->{csumCache}->flush if ( defined($fio->{csumCache}) && !$isChild );
     return;
 }
 
@@ -816,6 +1075,37 @@ The server-side Rsync generates a checksum seed and sends it to
 the client.  This value is usually set later, after the checksum
 seed is received from the remote rsync, via the checksumSeed function.
 
+=item csumThreads
+
+The number of threads used to compute the block checksums in csumGet.
+Defaults to 1.  Set to 0 to use one thread per CPU.  Threads are
+only used for large reads (at least 256K per thread).
+
+=item csumCacheDir
+
+If set, the seed-independent block checksum state of each file is
+saved in this directory (see L<File::RsyncP::CsumCache>).  The next
+time checksums are needed for a file with the same device, inode,
+size and mtime, csumGet computes them from the saved state without
+reading the file.  The file MD4 digest isn't computed then, so
+csumEnd returns undef even if csumStart asked for it.  The
+cache keeps one indexed store per directory, which is saved when the
+next directory is used and by finish().  Not set by default.
+
+=item inplace
+
+If set, received files are updated in place, like rsync's --inplace,
+rather than being rebuilt in a temporary file that is renamed over
+the original.  Only literal data and blocks that have moved are
+written, so a small change to a large file only writes the changed
+parts.  File::RsyncP sets it from the --inplace option.
+
+A block can only be copied if it hasn't already been overwritten;
+the remote rsync avoids sending such deltas when it is also given
+--inplace.  If one is received anyway, the rest of the file is
+skipped, fileDeltaRxDone returns 1, and the file is redone in phase 2
+using a temporary file.  Not set by default.
+
 =item logHandler
 
 A subroutine reference to a function that handles all the log
@@ -851,7 +1141,9 @@ Save one (or more) messages for logging purposes.
 =item statsGet
 
 Return an optional hashref of statistics compiled by the FileIO object.
-These values are opaquely passed up to File::RsyncP.
+These values are opaquely passed up to File::RsyncP; the child's
+hashref is sent to the parent with Storable, so it may be nested but
+must not hold code refs or file handles.
 
 =item finish($isChild)
 
@@ -872,13 +1164,24 @@ Get ready to generate block checksums for the given file.  The argument
 is a hashref typically returned by File::RsyncP::FileList->get.
 Typically this opens the underlying file and creates a
 File::RsyncP::Digest object.  If $needMD4 is non-zero, then csumEnd()
-will return the file MD4 digest.
+will return the file MD4 digest, unless the checksums come from the
+checksum cache, when it returns undef.
+
+=item csumPrefetch($f, $attr)
+
+Optional.  Called for each of the next few files whose checksums will
+be generated (see the csumPrefetch option of File::RsyncP), with the
+attributes returned by attribGet().  Typically this starts reading the
+file in the background, with File::RsyncP::Digest->prefetchFile, so
+that csumGet() doesn't wait for the disk.  csumStart() for the files
+is still called in order.
 
 =item csumGet($num, $csumLen, $blockSize)
 
 Return $num bkocks work of checksums with the MD4 checksum length of
 $csumLen (typically 2 or 16), with a block size of $blockSize.
-Typically this reads the file and calls File::RsyncP::Digest->blockDigest.
+Typically this reads the file with File::RsyncP::Digest->blockDigestFd,
+or uses the checksum cache if csumCacheDir is set.
 
 =item csumEnd()
 
@@ -886,14 +1189,14 @@ Finish up the checksum calculation.  Typically closes the underlying file.
 Note that csumStart, csumGet, csumEnd are called in strict order so they
 don't need to be reentrant (ie: there is only one csum done at a time).
 If csumStart() was called with $needMD4 then csumEnd() will return the
-file MD4 digest.
+file MD4 digest, or undef if it wasn't computed.
 
 =back
 
 =head2 File reading functions
 
-There are used for sending files (currently sending files doesn't
-implement deltas; it behaves as though --whole-file was specified):
+There are used for sending files.  The file is read once and the
+deltas against the remote file are computed on the fly:
 
 =over 4
 
@@ -907,6 +1210,13 @@ Typically this opens the underlying file.
 
 Read $num bytes from the file.
 
+=item readFd()
+
+Optional.  Return the file descriptor of the file being read, or undef
+if there isn't one.  If this exists and returns a file descriptor,
+File::RsyncP reads files it sends whole directly from it (with
+File::RsyncP::Digest->literalFd) instead of calling read().
+
 =item readEnd()
 
 Finish up the read operation.  Typically closes the underlying file.
@@ -981,11 +1291,22 @@ should be written at this point.  If $newData is defined, it is
 literal data (that didn't match any blocks) that should be written
 at this point.
 
-=item fileDeltaRxDone($md4)
+=item fileDeltaRxRun($blk, $cnt)
+
+Optional.  Like calling fileDeltaRxNext($blk + $i, undef) for each
+$i from 0 to $cnt - 1.  File::RsyncP decodes the file deltas in C and
+passes each run of consecutive matching blocks with one call, if this
+method exists, rather than one call per block.
+
+=item fileDeltaRxDone($md4, $phase, $localMd4)
 
 Finish processing of the file deltas for this file.  $md4 is the MD4
 digest of the sent file.  It should be compared against the MD4 digest
-of the reconstructed file.
+of the reconstructed file.  If every block matched the local file in
+order, $localMd4, if defined, is the MD4 digest of the local file
+computed when its checksums were generated (see the exactMatchDigest
+option of File::RsyncP), and is used instead of reading the file
+again.
 Returns undef on success, 1 if the file's MD4 didn't agree (meaning
 it should be repeated for phase 2), and negative on error.
 
@@ -1035,8 +1356,8 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307 USA.
 See L<http://perlrsync.sourceforge.net> for File::RsyncP's SourceForge
 home page.
 
-See L<File::RsyncP>, L<File::RsyncP::Digest>, and
-L<File::RsyncP::FileList>.
+See L<File::RsyncP>, L<File::RsyncP::Digest>,
+L<File::RsyncP::FileList> and L<File::RsyncP::CsumCache>.
 
 Also see BackupPC's lib/BackupPC/Xfer/RsyncFileIO.pm for an example
 of another implementation of File::RsyncP::FileIO, in fact one that
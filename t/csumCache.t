@@ -0,0 +1,155 @@
+#!/bin/perl
+
+#
+# Check that FileIO's checksum cache returns the same checksums as
+# reading the file, and that it is only used for unchanged files.
+#
+
+BEGIN {print "1..5\n";}
+END {print "not ok 1\n" unless $loaded;}
+use File::RsyncP::FileIO;
+use File::RsyncP::Digest;
+use File::Path;
+$loaded = 1;
+print "ok 1\n";
+
+my $dir      = "csumCache.tmp";
+my $file     = "$dir/data";
+my $cacheDir = "$dir/cache";
+
+File::Path::rmtree($dir);
+File::Path::mkpath($dir);
+srand(1);
+my $data = join("", map { chr(int(rand(256))) } (1..100000));
+writeFile($data);
+
+sub writeFile
+{
+    my($d) = @_;
+    open(F, ">", $file) || return;
+    binmode(F);
+    print F $d;
+    close(F);
+}
+
+#
+# Return the checksums for the file using $fio, with the given
+# seed, checksum length and block size.
+#
+sub csums
+{
+    my($fio, $seed, $csumLen, $blockSize) = @_;
+    my $csum = "";
+
+    $fio->checksumSeed($seed);
+    $fio->csumStart({name => $file}, 0);
+    while ( defined(my $c = $fio->csumGet(7, $csumLen, $blockSize)) ) {
+        $csum .= $c;
+    }
+    $fio->csumEnd;
+    return $csum;
+}
+
+my $plain = File::RsyncP::FileIO->new({protocol_version => 28});
+my $fio   = File::RsyncP::FileIO->new({protocol_version => 28,
+                                       csumCacheDir     => $cacheDir});
+
+#
+# The first pass fills the cache; the others use it, with any seed
+# and checksum length.
+#
+my $failed = 0;
+foreach my $t ( [0x1234, 16], [0x1234, 16], [7, 2], [0, 16] ) {
+    $failed++ if ( csums($fio, $t->[0], $t->[1], 700)
+                        ne csums($plain, $t->[0], $t->[1], 700) );
+}
+my $stats = $fio->statsGet;
+$failed++ if ( $stats->{csumCacheHits} != 3
+            || $stats->{csumCacheMisses} != 1 );
+print $failed ? "not ok 2\n" : "ok 2\n";
+
+#
+# A different block size or a changed file is a miss.
+#
+$failed = 0;
+$failed++ if ( csums($fio, 5, 16, 1024) ne csums($plain, 5, 16, 1024) );
+$failed++ if ( $fio->statsGet->{csumCacheMisses} != 2 );
+writeFile(substr($data, 0, 54321));
+utime(1000000000, 1000000000, $file);
+$failed++ if ( csums($fio, 5, 16, 1024) ne csums($plain, 5, 16, 1024) );
+$failed++ if ( csums($fio, 5, 16, 1024) ne csums($plain, 5, 16, 1024) );
+$failed++ if ( $fio->statsGet->{csumCacheMisses} != 3
+            || $fio->statsGet->{csumCacheHits} != 4 );
+print $failed ? "not ok 3\n" : "ok 3\n";
+
+#
+# The file MD4 digest is still computed when needed on a miss, and the
+# cache isn't saved if the file isn't read completely.  On a hit the
+# file isn't read, so there is no MD4 digest.
+#
+$failed = 0;
+$fio->checksumSeed(9);
+$fio->csumStart({name => $file}, 1);
+$fio->csumGet(2, 16, 512);
+my $md4 = File::RsyncP::Digest->new(28);
+$md4->add(pack("V", 9), substr($data, 0, 54321));
+$failed++ if ( $fio->csumEnd ne $md4->digest );
+$failed++ if ( csums($fio, 5, 16, 512) ne csums($plain, 5, 16, 512) );
+$failed++ if ( $fio->statsGet->{csumCacheMisses} != 5 );
+$fio->checksumSeed(5);
+$fio->csumStart({name => $file}, 1);
+my $csum = "";
+while ( defined(my $c = $fio->csumGet(7, 16, 512)) ) {
+    $csum .= $c;
+}
+$failed++ if ( defined($fio->csumEnd) || $csum ne csums($plain, 5, 16, 512)
+            || $fio->statsGet->{csumCacheHits} != 5 );
+print $failed ? "not ok 4\n" : "ok 4\n";
+
+#
+# The entries for a directory are saved in one indexed store when the
+# FileIO finishes.  Another FileIO then finds them all, and entries
+# for removed files are dropped when the store is next rewritten.
+#
+$failed = 0;
+$cacheDir = "$dir/cache2";
+my @files = map { "$dir/f$_" } (0..9);
+my %plainCsum;
+$fio = File::RsyncP::FileIO->new({protocol_version => 28,
+                                  csumCacheDir     => $cacheDir});
+foreach my $f ( @files ) {
+    $file = $f;
+    writeFile(substr($data, 0, 1000 * (1 + length($f))) . $f);
+    $plainCsum{$f} = csums($plain, 3, 16, 700);
+    $failed++ if ( csums($fio, 3, 16, 700) ne $plainCsum{$f} );
+}
+$fio->finish(0);
+my @stores = glob("$cacheDir/*/*");
+$failed++ if ( @stores != 1 );
+$fio = File::RsyncP::FileIO->new({protocol_version => 28,
+                                  csumCacheDir     => $cacheDir});
+foreach my $f ( @files ) {
+    $file = $f;
+    $failed++ if ( csums($fio, 4, 16, 700) ne csums($plain, 4, 16, 700) );
+}
+$failed++ if ( $fio->statsGet->{csumCacheHits} != @files
+            || $fio->statsGet->{csumCacheMisses} != 0 );
+unlink($files[0]);
+$file = $files[1];
+$failed++ if ( csums($fio, 4, 16, 1024) ne csums($plain, 4, 16, 1024) );
+$fio->finish(0);
+$fio = File::RsyncP::FileIO->new({protocol_version => 28,
+                                  csumCacheDir     => $cacheDir});
+foreach my $f ( @files[1..9] ) {
+    $file = $f;
+    csums($fio, 4, 16, $f eq $files[1] ? 1024 : 700);
+}
+my $cache = $fio->{csumCache};
+$cache->dirSet($files[0]);
+$failed++ if ( $fio->statsGet->{csumCacheHits} != 9
+            || defined($cache->{index}{"f0"})
+            || keys(%{$cache->{index}}) != 9
+            || (@stores = glob("$cacheDir/*/*")) != 1 );
+print $failed ? "not ok 5\n" : "ok 5\n";
+
+File::Path::rmtree($dir);
@@ -0,0 +1,183 @@
+#!/bin/perl
+
+#
+# Check that FileIO rebuilds a file from a delta of matching blocks
+# and new data, and checks the file MD4 digest.
+#
+
+BEGIN {print "1..7\n";}
+END {print "not ok 1\n" unless $loaded;}
+use File::RsyncP::FileIO;
+use File::RsyncP::Digest;
+use File::Path;
+$loaded = 1;
+print "ok 1\n";
+
+my $dir  = "fileDeltaRx.tmp";
+my $file = "$dir/data";
+
+File::Path::rmtree($dir);
+File::Path::mkpath($dir);
+srand(1);
+my $data = join("", map { chr(int(rand(256))) } (1..1000000));
+
+sub writeFile
+{
+    my($d) = @_;
+    open(F, ">", $file) || return;
+    binmode(F);
+    print F $d;
+    close(F);
+}
+
+sub readFile
+{
+    open(F, "<", $file) || return;
+    binmode(F);
+    my $d = join("", <F>);
+    close(F);
+    return $d;
+}
+
+#
+# Receive a new version of $file described by @$delta (block numbers,
+# [$blk, $cnt] runs of blocks and new data strings) against the current contents $old.  Returns
+# the result of fileDeltaRxDone.
+#
+sub receive
+{
+    my($fio, $old, $blkSize, $delta, $md4, $localMd4) = @_;
+    my $blkCnt = int((length($old) + $blkSize - 1) / $blkSize);
+    my $f = {
+        name  => $file,
+        size  => length($old),
+        mode  => 0100644,
+        uid   => $<,
+        gid   => (split(/ /, $())[0],
+        mtime => 1000000000,
+    };
+
+    $fio->fileDeltaRxStart($f, $blkCnt, $blkSize,
+                           length($old) - ($blkCnt - 1) * $blkSize);
+    #
+    # Like File::RsyncP::fileDeltaGet, errors are only reported by
+    # the final calls.
+    #
+    foreach my $d ( @$delta ) {
+        if ( ref($d) eq "ARRAY" ) {
+            $fio->fileDeltaRxRun(@$d);
+        } elsif ( ref($d) ) {
+            $fio->fileDeltaRxNext(undef, $$d);
+        } else {
+            $fio->fileDeltaRxNext($d, undef);
+        }
+    }
+    return $fio->fileDeltaRxNext(undef, undef)
+        || $fio->fileDeltaRxDone($md4, 0, $localMd4);
+}
+
+sub md4
+{
+    my($d) = @_;
+    return File::RsyncP::Digest->new(28)->add(pack("V", 0), $d)->digest;
+}
+
+#
+# Long runs of matching blocks (including the short last block),
+# with changes in between, give the new file.
+#
+my $fio = File::RsyncP::FileIO->new({protocol_version => 28});
+my $failed = 0;
+my $blkSize = 700;
+my $blkCnt  = int((length($data) + $blkSize - 1) / $blkSize);
+my $new = substr($data, 0, 500 * $blkSize) . "new data"
+        . substr($data, 600 * $blkSize, 700 * $blkSize)
+        . substr($data, 0, 3 * $blkSize)
+        . "more" . substr($data, 1300 * $blkSize);
+writeFile($data);
+$failed++ if ( receive($fio, $data, $blkSize,
+                       [0..499, \"new data", 600..1299, 0..2,
+                        \"more", 1300..($blkCnt - 1)], md4($new)) );
+$failed++ if ( readFile() ne $new );
+print $failed ? "not ok 2\n" : "ok 2\n";
+
+#
+# A bad digest leaves the file alone.
+#
+$failed = 0;
+writeFile($data);
+$failed++ if ( receive($fio, $data, $blkSize, [5..10, \"x"], md4($data)) != 1 );
+$failed++ if ( readFile() ne $data );
+my @tmp = glob("$file*");
+$failed++ if ( @tmp != 1 );
+print $failed ? "not ok 3\n" : "ok 3\n";
+
+#
+# In place, the same delta gives the same file, without replacing it.
+# Blocks 0..2 are copied after being passed, but were never written.
+#
+my $inplace = File::RsyncP::FileIO->new({protocol_version => 28,
+                                         inplace          => 1});
+$failed = 0;
+writeFile($data);
+my $ino = (stat($file))[1];
+$failed++ if ( receive($inplace, $data, $blkSize,
+                       [0..499, \"new data", 600..1299, 0..2,
+                        \"more", 1300..($blkCnt - 1)], md4($new)) );
+$failed++ if ( readFile() ne $new || (stat($file))[1] != $ino );
+my $short = substr($data, 700, 14 * $blkSize) . "x";
+$failed++ if ( receive($inplace, $new, $blkSize, [1..14, \"x"], md4($short)) );
+$failed++ if ( readFile() ne $short || (stat($file))[1] != $ino );
+print $failed ? "not ok 4\n" : "ok 4\n";
+
+#
+# A block that was overwritten before being copied fails the file,
+# which is then redone with a temporary file.
+#
+$failed = 0;
+writeFile($data);
+$new = ("y" x 1400) . substr($data, 0, 700);
+$failed++ if ( receive($inplace, $data, $blkSize, [\("y" x 1400), 0],
+                       md4($new)) != 1 );
+my $partial = readFile();
+$failed++ if ( receive($inplace, $partial, $blkSize,
+                       [\("y" x 1400), \substr($data, 0, 700)],
+                       md4($new)) );
+$failed++ if ( readFile() ne $new );
+print $failed ? "not ok 5\n" : "ok 5\n";
+
+#
+# An exact match is checked with the local digest, if given, instead
+# of reading the file.
+#
+$failed = 0;
+writeFile($data);
+$failed++ if ( receive($fio, $data, $blkSize, [0..($blkCnt - 1)],
+                       md4($data), md4($data)) );
+$failed++ if ( receive($fio, $data, $blkSize, [0..($blkCnt - 1)],
+                       md4($data), md4("other")) != 1 );
+$failed++ if ( receive($fio, $data, $blkSize, [0..($blkCnt - 1)],
+                       md4($data)) );
+$failed++ if ( readFile() ne $data );
+print $failed ? "not ok 6\n" : "ok 6\n";
+
+#
+# Runs of blocks, as passed by File::RsyncP, give the same file,
+# including runs that continue the previous one.
+#
+$failed = 0;
+$new = substr($data, 0, 500 * $blkSize) . "new data"
+     . substr($data, 600 * $blkSize, 700 * $blkSize)
+     . substr($data, 0, 3 * $blkSize)
+     . "more" . substr($data, 1300 * $blkSize);
+foreach my $f ( $fio, $inplace ) {
+    writeFile($data);
+    $failed++ if ( receive($f, $data, $blkSize,
+                           [[0, 200], [200, 300], \"new data", [600, 700],
+                            [0, 1], 1, [2, 1], \"more",
+                            [1300, $blkCnt - 1300]], md4($new)) );
+    $failed++ if ( readFile() ne $new );
+}
+print $failed ? "not ok 7\n" : "ok 7\n";
+
+File::Path::rmtree($dir);
@@ -0,0 +1,211 @@
+#!/bin/perl
+
+#
+# Receive a directory tree from a minimal rsync sender written with
+# File::RsyncP's own pieces, and check the result.  The sender runs
+# as the rsync command (a code reference), so no rsync is needed.
+#
+
+BEGIN {print "1..7\n";}
+END {print "not ok 1\n" unless $loaded;}
+use File::RsyncP;
+use File::RsyncP::Digest;
+use File::RsyncP::FileIO;
+use File::RsyncP::FileList;
+use File::RsyncP::Mux;
+use File::Path;
+use POSIX;
+$loaded = 1;
+$| = 1;
+print "ok 1\n";
+
+#
+# A FileIO whose stats are nested, to check that they reach the parent
+#
+package NestedStatsIO;
+use vars qw(@ISA);
+@ISA = qw(File::RsyncP::FileIO);
+
+sub statsGet
+{
+    my($fio) = @_;
+
+    return { %{$fio->SUPER::statsGet || {}}, nested => {list => [1, 2]} };
+}
+
+package main;
+
+my $dir  = "loopback.tmp";
+my $src  = "$dir/src";
+my $dst  = "$dir/dst";
+my $seed = 0x1234567;
+
+sub writeFile
+{
+    my($file, $d) = @_;
+    open(F, ">", $file) || return;
+    binmode(F);
+    print F $d;
+    close(F);
+}
+
+sub readFile
+{
+    my($file) = @_;
+    open(F, "<", $file) || return;
+    binmode(F);
+    my $d = join("", <F>);
+    close(F);
+    return $d;
+}
+
+#
+# The remote sender: the client's data isn't multiplexed, ours is.
+# The digest of $badFile is wrong in phase 0, so it has to be redone.
+#
+sub sender
+{
+    my($badFile) = @_;
+    my $reader = File::RsyncP::Mux::Reader->new(fileno(STDIN));
+    my $writer = File::RsyncP::Mux::Writer->new(fileno(STDOUT));
+    my $get = sub {
+        my($len) = @_;
+        while ( $reader->rawLen < $len ) {
+            POSIX::_exit(1) if ( $reader->fill <= 0 );
+        }
+        return $reader->rawGet($len);
+    };
+    my $getInt = sub { return unpack("V*", $get->(4 * ($_[0] || 1))); };
+    my $send = sub {
+        my($d, $raw) = @_;
+        $raw ? $writer->add($d) : $writer->addMsg(0, $d);
+        while ( $writer->len ) {
+            POSIX::_exit(1) if ( $writer->flush < 0 );
+        }
+    };
+
+    $send->(pack("V", 28), 1);
+    $getInt->();
+    $send->(pack("V", $seed), 1);
+    while ( my $len = $getInt->() ) {
+        $get->($len);
+    }
+    my $flist = File::RsyncP::FileList->new({protocol_version => 28});
+    my $fio   = File::RsyncP::FileIO->new({protocol_version => 28});
+    my $out   = "";
+    $fio->dirs($src, "src");
+    $fio->fileListSend($flist, sub { $out .= $_[0]; });
+    $send->($out . pack("C V", 0, 0));
+    $flist->clean;
+
+    foreach my $phase ( 0, 1 ) {
+        while ( (my $n = $getInt->()) != 0xffffffff ) {
+            my($cnt, $blkSize, $csumLen, $rem) = $getInt->(4);
+            my $sums = $get->($cnt * (4 + $csumLen));
+            my $f    = $flist->get($n);
+            my $data = readFile($fio->localName($f->{name}));
+            my $md4  = File::RsyncP::Digest->new(28);
+            my $tokens;
+
+            $md4->add(pack("V", $seed));
+            if ( $cnt ) {
+                my $delta = $md4->deltaNew($sums, $blkSize, $rem, $csumLen,
+                                           $seed);
+                $tokens = $delta->add($data) . $delta->finish;
+            } else {
+                $tokens = join("", map { pack("V a*", length($_), $_) }
+                                        ($data =~ /(.{1,32768})/gs));
+            }
+            $md4->add($data);
+            my $digest = $md4->digest;
+            $digest = ~$digest if ( $phase == 0 && $f->{name} eq $badFile );
+            $send->(pack("V5", $n, $cnt, $blkSize, $csumLen, $rem)
+                    . $tokens . pack("V", 0) . $digest);
+        }
+        $send->(pack("V", 0xffffffff));
+    }
+    $send->(pack("V3", 10, 20, 30));
+    $getInt->();
+    POSIX::_exit(0);
+}
+
+#
+# Receive $src into $dst with the given File::RsyncP options and
+# check that the trees are the same.
+#
+sub receive
+{
+    my($opts, $badFile) = @_;
+    my @logs;
+    my $rs = File::RsyncP->new({
+                rsyncCmd   => sub { sender($badFile); },
+                rsyncArgs  => ["--recursive", "--block-size=512"],
+                logLevel   => 5,
+                logHandler => sub { push(@logs, $_[0]); },
+                fio        => NestedStatsIO->new({logLevel => 5}),
+                %$opts,
+            });
+    return "remoteStart" if ( $rs->remoteStart(1, "src") );
+    my $err = $rs->go($dst);
+    $rs->serverClose;
+    waitpid($rs->{rsyncPID}, 0);
+    return "go: $err" if ( defined($err) );
+    return "sender exit $?" if ( $? );
+    return "no redo"
+        if ( defined($badFile) && !grep(/Must redo/, @logs) );
+    #
+    # The unchanged file e is checked with the parent's digest
+    #
+    return "no known digest"
+        if ( $opts->{exactMatchDigest} eq "parent"
+                && !grep(/src\/e: got exact match \(known digest\)/, @logs) );
+    my $stats = $rs->statsFinal;
+    return "stats" if ( $stats->{totalRead} != 10
+                     || $stats->{totalWritten} != 20
+                     || $stats->{totalSize} != 30
+                     || ref($stats->{childStats}) ne "HASH"
+                     || $stats->{childStats}{nested}{list}[1] != 2 );
+    foreach my $name ( "a", "b", "c", "sub/d", "e" ) {
+        return "$name differs"
+            if ( readFile("$src/$name") ne readFile("$dst/$name") );
+    }
+    return;
+}
+
+sub setup
+{
+    File::Path::rmtree($dir);
+    File::Path::mkpath(["$src/sub", $dst]);
+    srand(1);
+    my $a = join("", map { chr(int(rand(256))) } (1..300000));
+    writeFile("$src/a", $a);
+    writeFile("$src/b", "");
+    writeFile("$src/c", "some text\n" x 1000);
+    writeFile("$src/sub/d", substr($a, 1000, 50000));
+    #
+    # The old version of a has some changes; c and sub/d are new
+    #
+    writeFile("$dst/a", substr($a, 0, 100000) . "changed"
+                        . substr($a, 120000));
+    #
+    # e is the same, but has a different mtime
+    #
+    writeFile("$src/e", substr($a, 5000, 20000));
+    writeFile("$dst/e", substr($a, 5000, 20000));
+    utime(1000000000, 1000000000, "$dst/e");
+}
+
+my $testNum = 2;
+foreach my $t ( [{}, undef],
+                [{}, "src/a"],
+                [{exactMatchDigest => "parent"}, "src/c"],
+                [{inProcess => 1}, undef],
+                [{inProcess => 1}, "src/a"],
+                [{inProcess => 1, exactMatchDigest => "parent"}, "src/c"] ) {
+    setup();
+    my $err = receive(@$t);
+    print defined($err) ? "not ok $testNum # $err\n" : "ok $testNum\n";
+    $testNum++;
+}
+
+File::Path::rmtree($dir);